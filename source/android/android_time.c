@@ -52,3 +52,12 @@ uint64_t Sys_Microseconds( void ) {
 int64_t Sys_Milliseconds( void ) {
 	return Sys_Microseconds() / ( ( uint64_t )1000 );
 }
+
+/*
+* Sys_Nanoseconds
+*/
+uint64_t Sys_Nanoseconds( void ) {
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec * ( ( uint64_t )1000000000 ) + now.tv_nsec;
+}
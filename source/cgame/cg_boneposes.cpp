@@ -394,43 +394,26 @@ bool CG_SkeletalPoseGetAttachment( orientation_t *orient, cgs_skeleton_t *skel,
 //
 //========================================================================
 
-#define TBC_Block_Size      1024
-static int TBC_Size;
-
-bonepose_t *TBC;        //Temporary Boneposes Cache
-static int TBC_Count;
-
+// temporary boneposes live in scratch memory, which is freed back to
+// the mark taken by the first registration of the frame
+static bool TBC_Marked;
+static size_t TBC_Mark;
 
 /*
 * CG_InitTemporaryBoneposesCache
-* allocate space for temporary boneposes
 */
 void CG_InitTemporaryBoneposesCache( void ) {
-	TBC_Size = TBC_Block_Size;
-	TBC = ( bonepose_t * )CG_Malloc( sizeof( bonepose_t ) * TBC_Size );
-	TBC_Count = 0;
-}
-
-/*
-* CG_ExpandTemporaryBoneposesCache
-*/
-static void CG_ExpandTemporaryBoneposesCache( int num ) {
-	bonepose_t *temp;
-
-	temp = TBC;
-
-	TBC = ( bonepose_t * )CG_Malloc( sizeof( bonepose_t ) * ( TBC_Size + fmax( num, TBC_Block_Size ) ) );
-	memcpy( TBC, temp, sizeof( bonepose_t ) * TBC_Size );
-	TBC_Size += fmax( num, TBC_Block_Size );
-
-	CG_Free( temp );
+	TBC_Marked = false;
 }
 
 /*
 * CG_ResetTemporaryBoneposesCache
 */
 void CG_ResetTemporaryBoneposesCache( void ) {
-	TBC_Count = 0;
+	if( TBC_Marked ) {
+		CG_ScratchFreeToMark( TBC_Mark );
+		TBC_Marked = false;
+	}
 }
 
 /*
@@ -438,15 +421,12 @@ void CG_ResetTemporaryBoneposesCache( void ) {
 * These boneposes are RESET after drawing EACH FRAME
 */
 bonepose_t *CG_RegisterTemporaryExternalBoneposes( cgs_skeleton_t *skel ) {
-	bonepose_t *boneposes;
-	if( ( TBC_Count + skel->numBones ) > TBC_Size ) {
-		CG_ExpandTemporaryBoneposesCache( skel->numBones );
+	if( !TBC_Marked ) {
+		TBC_Mark = CG_ScratchMark();
+		TBC_Marked = true;
 	}
 
-	boneposes = &TBC[TBC_Count];
-	TBC_Count += skel->numBones;
-
-	return boneposes;
+	return ( bonepose_t * )CG_ScratchMalloc( sizeof( bonepose_t ) * skel->numBones );
 }
 
 /*
@@ -473,7 +453,5 @@ cgs_skeleton_t *CG_SetBoneposesForTemporaryEntity( entity_t *ent ) {
 * CG_FreeTemporaryBoneposesCache
 */
 void CG_FreeTemporaryBoneposesCache( void ) {
-	CG_Free( TBC );
-	TBC_Size = 0;
-	TBC_Count = 0;
+	CG_ResetTemporaryBoneposesCache();
 }
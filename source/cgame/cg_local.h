@@ -946,6 +946,11 @@ extern cvar_t *cg_flashWindowCount;
 #define CG_Malloc( size ) trap_MemAlloc( size, __FILE__, __LINE__ )
 #define CG_Free( data ) trap_MemFree( data, __FILE__, __LINE__ )
 
+// scratch memory, valid until the end of the frame unless freed earlier with CG_ScratchFreeToMark
+#define CG_ScratchMalloc( size ) trap_MemScratchAlloc( size, __FILE__, __LINE__ )
+#define CG_ScratchMark() trap_MemScratchMark()
+#define CG_ScratchFreeToMark( mark ) trap_MemScratchFreeToMark( mark )
+
 int CG_API( void );
 void CG_Init( const char *serverName, unsigned int playerNum,
 			  int vidWidth, int vidHeight, float pixelRatio,
@@ -401,6 +401,45 @@ static void CG_RegisterWeaponModels( void ) {
 	}
 }
 
+/*
+* CG_PrefetchMedia
+*
+* Submits all model and sound files referenced by configstrings to the filesystem
+* up front, so they're decompressed in the background while the world model loads.
+*/
+static void CG_PrefetchMedia( void ) {
+	int i, numFiles;
+	const char *name;
+	const char *files[MAX_MODELS + MAX_SOUNDS];
+
+	numFiles = 0;
+	for( i = 1; i < MAX_MODELS; i++ ) {
+		name = cgs.configStrings[CS_MODELS + i];
+		if( !name[0] ) {
+			break;
+		}
+		if( name[0] == '#' || name[0] == '$' || name[0] == '*' ) {
+			continue;
+		}
+		files[numFiles++] = name;
+	}
+
+	for( i = 1; i < MAX_SOUNDS; i++ ) {
+		name = cgs.configStrings[CS_SOUNDS + i];
+		if( !name[0] ) {
+			break;
+		}
+		if( name[0] == '*' ) {
+			continue;
+		}
+		files[numFiles++] = name;
+	}
+
+	if( numFiles ) {
+		trap_FS_PrefetchFiles( files, numFiles );
+	}
+}
+
 /*
 * CG_RegisterModels
 */
@@ -418,6 +457,7 @@ static void CG_RegisterModels( void ) {
 			if( !CG_LoadingItemName( name ) ) {
 				return;
 			}
+			CG_PrefetchMedia();
 			CG_LoadingString( name );
 			trap_R_RegisterWorldModel( name );
 		}
@@ -43,7 +43,7 @@ typedef void ( *cg_fdrawchar_t )( int x, int y, int w, int h, float s1, float t1
 
 // cg_public.h -- client game dll information visible to engine
 
-#define CGAME_API_VERSION   104
+#define CGAME_API_VERSION   109
 
 //
 // structs and variables shared with the main engine
@@ -126,6 +126,7 @@ typedef struct {
 	bool ( *FS_RemoveFile )( const char *filename );
 	int ( *FS_GetFileList )( const char *dir, const char *extension, char *buf, size_t bufsize, int start, int end );
 	const char *( *FS_FirstExtension )( const char *filename, const char *extensions[], int num_extensions );
+	void ( *FS_PrefetchFiles )( const char **filenames, int numFiles );
 	bool ( *FS_IsPureFile )( const char *filename );
 	bool ( *FS_MoveFile )( const char *src, const char *dst );
 	bool ( *FS_IsUrl )( const char *url );
@@ -252,6 +253,11 @@ typedef struct {
 	void *( *Mem_Alloc )( size_t size, const char *filename, int fileline );
 	void ( *Mem_Free )( void *data, const char *filename, int fileline );
 
+	// per-thread scratch memory, released at the end of the frame or by freeing to a mark
+	void *( *Mem_ScratchAlloc )( size_t size, const char *filename, int fileline );
+	size_t ( *Mem_ScratchMark )( void );
+	void ( *Mem_ScratchFreeToMark )( size_t mark );
+
 	// l10n
 	void ( *L10n_ClearDomain )( void );
 	void ( *L10n_LoadLangPOFile )( const char *filepath );
@@ -269,6 +275,16 @@ typedef struct {
 
 	// angelscript api
 	struct angelwrap_api_s *( *asGetAngelExport )( void );
+
+	// job system
+	int ( *Jobs_NumWorkers )( void );
+	void ( *Jobs_Schedule )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+							 unsigned items, unsigned granularity, volatile int *counter );
+	void ( *Jobs_Wait )( volatile int *counter );
+
+	// profiler
+	void ( *Prof_Enter )( const char *name );
+	void ( *Prof_Leave )( void );
 } cgame_import_t;
 
 //
@@ -147,6 +147,10 @@ static inline const char *trap_FS_FirstExtension( const char *filename, const ch
 	return CGAME_IMPORT.FS_FirstExtension( filename, extensions, num_extensions );
 }
 
+static inline void trap_FS_PrefetchFiles( const char **filenames, int numFiles ) {
+	CGAME_IMPORT.FS_PrefetchFiles( filenames, numFiles );
+}
+
 static inline bool trap_FS_IsPureFile( const char *filename ) {
 	return CGAME_IMPORT.FS_IsPureFile( filename ) == true;
 }
@@ -519,6 +523,18 @@ static inline void trap_MemFree( void *data, const char *filename, int fileline
 	CGAME_IMPORT.Mem_Free( data, filename, fileline );
 }
 
+static inline ATTRIBUTE_MALLOC void *trap_MemScratchAlloc( size_t size, const char *filename, int fileline ) {
+	return CGAME_IMPORT.Mem_ScratchAlloc( size, filename, fileline );
+}
+
+static inline size_t trap_MemScratchMark( void ) {
+	return CGAME_IMPORT.Mem_ScratchMark();
+}
+
+static inline void trap_MemScratchFreeToMark( size_t mark ) {
+	CGAME_IMPORT.Mem_ScratchFreeToMark( mark );
+}
+
 static inline void trap_AsyncStream_UrlEncode( const char *src, char *dst, size_t size ) {
 	CGAME_IMPORT.AsyncStream_UrlEncode( src, dst, size );
 }
@@ -569,3 +585,26 @@ static inline unsigned int trap_IN_SupportedDevices( void ) {
 static inline struct angelwrap_api_s *trap_asGetAngelExport( void ) {
 	return CGAME_IMPORT.asGetAngelExport();
 }
+
+// job system
+static inline int trap_Jobs_NumWorkers( void ) {
+	return CGAME_IMPORT.Jobs_NumWorkers();
+}
+
+static inline void trap_Jobs_Schedule( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+									   unsigned items, unsigned granularity, volatile int *counter ) {
+	CGAME_IMPORT.Jobs_Schedule( func, arg, items, granularity, counter );
+}
+
+static inline void trap_Jobs_Wait( volatile int *counter ) {
+	CGAME_IMPORT.Jobs_Wait( counter );
+}
+
+// profiler
+static inline void trap_Prof_Enter( const char *name ) {
+	CGAME_IMPORT.Prof_Enter( name );
+}
+
+static inline void trap_Prof_Leave( void ) {
+	CGAME_IMPORT.Prof_Leave();
+}
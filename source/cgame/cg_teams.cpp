@@ -182,6 +182,35 @@ bool CG_PModelForCentity( centity_t *cent, pmodelinfo_t **pmodelinfo, struct ski
 	return false;
 }
 
+static int cg_teamColorModCount[GS_MAX_TEAMS][2];
+
+/*
+* CG_TeamColorModified
+*
+* Compares the team color cvars against the counters seen by the last CG_RegisterTeamColor call.
+*/
+static bool CG_TeamColorModified( int team, const cvar_t *color, const cvar_t *toggle, bool update ) {
+	int *counts;
+	bool modified = false;
+
+	if( team != TEAM_ALPHA && team != TEAM_BETA ) {
+		team = TEAM_PLAYERS;
+	}
+	counts = cg_teamColorModCount[team];
+
+	if( color->modificationCount != counts[0] ) {
+		modified = true;
+	}
+	if( toggle && toggle->modificationCount != counts[1] ) {
+		modified = true;
+	}
+	if( modified && update ) {
+		counts[0] = color->modificationCount;
+		counts[1] = toggle ? toggle->modificationCount : 0;
+	}
+	return modified;
+}
+
 /*
 * CG_RegisterTeamColor
 */
@@ -214,7 +243,7 @@ void CG_RegisterTeamColor( int team ) {
 		break;
 	}
 
-	if( teamForceColor->modified || ( teamForceColorToggle && teamForceColorToggle->modified ) ) {
+	if( CG_TeamColorModified( team, teamForceColor, teamForceColorToggle, true ) ) {
 		// load default one if in team based gametype
 		if( team >= TEAM_ALPHA ) {
 			rgbcolor = COM_ReadColorRGBString( teamForceColor->dvalue );
@@ -236,11 +265,6 @@ void CG_RegisterTeamColor( int team ) {
 				}
 			}
 		}
-
-		teamForceColor->modified = false;
-		if( teamForceColorToggle ) {
-			teamForceColorToggle->modified = false;
-		}
 	}
 }
 
@@ -270,7 +294,7 @@ vec_t *CG_TeamColor( int team, vec4_t color ) {
 			break;
 	}
 
-	if( teamForceColor->modified || ( teamForceColorToggle && teamForceColorToggle->modified ) ) {
+	if( CG_TeamColorModified( forcedteam, teamForceColor, teamForceColorToggle, false ) ) {
 		CG_RegisterTeamColor( forcedteam );
 	}
 
@@ -329,7 +353,7 @@ uint8_t *_ColorForEntity( int entNum, byte_vec4_t color, bool player ) {
 		break;
 	}
 
-	if( teamForceColor->modified || ( teamForceColorToggle && teamForceColorToggle->modified ) ) {
+	if( CG_TeamColorModified( team, teamForceColor, teamForceColorToggle, false ) ) {
 		CG_RegisterTeamColor( team );
 	}
 
@@ -1007,6 +1007,7 @@ void CG_RenderView( int frameTime, int realFrameTime, int64_t realTime, int64_t
 
 	CG_FireEvents( false );
 
+	trap_Prof_Enter( "CG_AddEntities" );
 	CG_AddEntities();
 	CG_AddViewWeapon( &cg.weapon );
 	CG_AddLocalEntities();
@@ -1020,6 +1021,7 @@ void CG_RenderView( int frameTime, int realFrameTime, int64_t realTime, int64_t
 #ifndef PUBLIC_BUILD
 	CG_AddTest();
 #endif
+	trap_Prof_Leave();
 
 	CG_AddLocalSounds();
 
@@ -1027,13 +1029,17 @@ void CG_RenderView( int frameTime, int realFrameTime, int64_t realTime, int64_t
 
 	CG_SetupRefDef( &cg.view );
 
+	trap_Prof_Enter( "R_RenderScene" );
 	trap_R_RenderScene( &cg.view.refdef );
+	trap_Prof_Leave();
 
 	cg.oldAreabits = true;
 
 	trap_S_Update( cg.view.origin, cg.view.velocity, cg.view.axis, cgs.clientInfo[cgs.playerNum].name );
 
+	trap_Prof_Enter( "CG_Draw2D" );
 	CG_Draw2D();
+	trap_Prof_Leave();
 
 	CG_ResetTemporaryBoneposesCache(); // clear for next frame
 }
@@ -0,0 +1,301 @@
+/*
+Copyright (C) 2017 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// cl_bench.c -- renderer benchmark along a scripted camera path
+#include "client.h"
+
+#define CL_BENCH_DEFAULT_FRAMES     1000
+#define CL_BENCH_SEGMENT_FRAMES     60      // frames spent between two waypoints
+#define CL_BENCH_MAX_WAYPOINTS      256
+#define CL_BENCH_MAX_MODELS         16
+#define CL_BENCH_MODEL_COPIES       8       // instances of each extra model around the camera
+#define CL_BENCH_EYE_HEIGHT         40
+#define CL_BENCH_FRAME_MSEC         16
+
+typedef struct {
+	int numWaypoints;
+	vec3_t waypoints[CL_BENCH_MAX_WAYPOINTS];
+
+	int numInlineModels;
+	struct model_s **inlineModels;
+
+	int numModels;
+	struct model_s *models[CL_BENCH_MAX_MODELS];
+} cl_bench_t;
+
+/*
+* CL_Bench_IsWaypoint
+*
+* Spawn points and items are spread all over the playable space of a map.
+*/
+static bool CL_Bench_IsWaypoint( const char *classname ) {
+	return !Q_strnicmp( classname, "info_player_", 12 ) || !Q_strnicmp( classname, "weapon_", 7 )
+		   || !Q_strnicmp( classname, "item_", 5 ) || !Q_strnicmp( classname, "ammo_", 5 );
+}
+
+/*
+* CL_Bench_ParseWaypoints
+*/
+static void CL_Bench_ParseWaypoints( cl_bench_t *bench, cmodel_state_t *cms ) {
+	char *data;
+	char token[MAX_TOKEN_CHARS];
+	char classname[MAX_TOKEN_CHARS];
+	vec3_t origin;
+	bool hasOrigin;
+	vec3_t mins, maxs;
+
+	bench->numWaypoints = 0;
+
+	for( data = CM_EntityString( cms ); COM_Parse_r( token, sizeof( token ), &data ) && token[0] == '{'; ) {
+		classname[0] = '\0';
+		hasOrigin = false;
+
+		while( 1 ) {
+			COM_Parse_r( token, sizeof( token ), &data );
+			if( !token[0] || token[0] == '}' ) {
+				break;
+			}
+
+			if( !Q_stricmp( token, "classname" ) ) {
+				COM_Parse_r( classname, sizeof( classname ), &data );
+			} else if( !Q_stricmp( token, "origin" ) ) {
+				COM_Parse_r( token, sizeof( token ), &data );
+				hasOrigin = sscanf( token, "%f %f %f", &origin[0], &origin[1], &origin[2] ) == 3;
+			} else {
+				COM_Parse_r( token, sizeof( token ), &data );
+			}
+		}
+
+		if( hasOrigin && CL_Bench_IsWaypoint( classname ) && bench->numWaypoints < CL_BENCH_MAX_WAYPOINTS ) {
+			origin[2] += CL_BENCH_EYE_HEIGHT;
+			VectorCopy( origin, bench->waypoints[bench->numWaypoints] );
+			bench->numWaypoints++;
+		}
+	}
+
+	if( !bench->numWaypoints ) {
+		// fly through the middle of the map
+		CM_InlineModelBounds( cms, CM_InlineModel( cms, 0 ), mins, maxs );
+		VectorLerp( mins, 0.25f, maxs, bench->waypoints[0] );
+		VectorLerp( mins, 0.75f, maxs, bench->waypoints[1] );
+		bench->numWaypoints = 2;
+	}
+}
+
+/*
+* CL_Bench_SetupView
+*
+* The camera travels from waypoint to waypoint, turning around once per segment.
+*/
+static void CL_Bench_SetupView( const cl_bench_t *bench, int frameNum, refdef_t *rd ) {
+	int segment = frameNum / CL_BENCH_SEGMENT_FRAMES;
+	float frac = (float)( frameNum % CL_BENCH_SEGMENT_FRAMES ) / CL_BENCH_SEGMENT_FRAMES;
+	const float *from = bench->waypoints[segment % bench->numWaypoints];
+	const float *to = bench->waypoints[( segment + 1 ) % bench->numWaypoints];
+	vec3_t angles;
+
+	memset( rd, 0, sizeof( *rd ) );
+
+	rd->x = rd->scissor_x = 0;
+	rd->y = rd->scissor_y = 0;
+	rd->width = rd->scissor_width = viddef.width;
+	rd->height = rd->scissor_height = viddef.height;
+	rd->fov_x = 90;
+	rd->fov_y = CalcVerticalFov( rd->fov_x, rd->width, rd->height );
+	rd->time = (int64_t)frameNum * CL_BENCH_FRAME_MSEC;
+	rd->minLight = 0.3f;
+
+	VectorLerp( from, frac, to, rd->vieworg );
+
+	angles[PITCH] = 15.0f * sin( frac * M_TWOPI );
+	angles[YAW] = segment * 37.0f + frac * 360.0f;
+	angles[ROLL] = 0;
+	AnglesToAxis( angles, rd->viewaxis );
+}
+
+/*
+* CL_Bench_AddEntities
+*/
+static void CL_Bench_AddEntities( const cl_bench_t *bench, int frameNum, const refdef_t *rd ) {
+	int i, j;
+	entity_t ent;
+
+	memset( &ent, 0, sizeof( ent ) );
+	ent.rtype = RT_MODEL;
+	ent.scale = 1.0f;
+	ent.shaderTime = rd->time;
+	Vector4Set( ent.shaderRGBA, 255, 255, 255, 255 );
+	Matrix3_Identity( ent.axis );
+
+	// brush models are placed in world space already
+	for( i = 0; i < bench->numInlineModels; i++ ) {
+		ent.model = bench->inlineModels[i];
+		re.AddEntityToScene( &ent );
+	}
+
+	// a ring of extra models around the camera
+	for( i = 0; i < bench->numModels; i++ ) {
+		for( j = 0; j < CL_BENCH_MODEL_COPIES; j++ ) {
+			float angle = ( j + (float)i / bench->numModels ) * M_TWOPI / CL_BENCH_MODEL_COPIES + frameNum * 0.01f;
+
+			ent.model = bench->models[i];
+			VectorSet( ent.origin, rd->vieworg[0] + 128 * cos( angle ), rd->vieworg[1] + 128 * sin( angle ), rd->vieworg[2] - 16 );
+			VectorCopy( ent.origin, ent.origin2 );
+			VectorCopy( ent.origin, ent.lightingOrigin );
+			ent.frame = ent.oldframe = 0;
+			re.AddEntityToScene( &ent );
+		}
+	}
+}
+
+/*
+* CL_Bench_CmpTimes
+*/
+static int CL_Bench_CmpTimes( const void *a, const void *b ) {
+	int64_t ta = *( const int64_t * )a, tb = *( const int64_t * )b;
+	return ta < tb ? -1 : ( ta > tb ? 1 : 0 );
+}
+
+/*
+* CL_Bench_f
+*
+* r_benchmark <map> [frames] [model1 model2 ...]
+*
+* Loads the map, registers the given models and renders the scene along a fixed
+* camera path through spawn points and items, timing every frame. When the
+* renderer is built against the null GL driver, only CPU-side work is measured
+* and the driver statistics are printed as well.
+*/
+void CL_Bench_f( void ) {
+	int i, numFrames;
+	char mapname[MAX_QPATH];
+	unsigned checksum;
+	cmodel_state_t *cms;
+	cl_bench_t *bench;
+	int64_t *frameTimes;
+	int64_t start, total, frameStart;
+	refdef_t rd;
+	bool nullStats;
+
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <map> [frames] [model1 model2 ...]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	if( cls.state > CA_DISCONNECTED || cls.demo.playing || !VID_RefreshIsActive() ) {
+		Com_Printf( "Can't run the renderer benchmark while connected\n" );
+		return;
+	}
+
+	Q_snprintfz( mapname, sizeof( mapname ), "maps/%s.bsp", Cmd_Argv( 1 ) );
+	COM_SanitizeFilePath( mapname );
+	if( !COM_ValidateRelativeFilename( mapname ) || FS_FOpenFile( mapname, NULL, FS_READ ) == -1 ) {
+		Com_Printf( "Couldn't find map: %s\n", mapname );
+		return;
+	}
+
+	numFrames = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : CL_BENCH_DEFAULT_FRAMES;
+	numFrames = max( numFrames, 1 );
+
+	bench = Mem_ZoneMalloc( sizeof( *bench ) );
+
+	cms = CM_New( NULL );
+	CM_AddReference( cms );
+	CM_LoadMap( cms, mapname, true, &checksum );
+	CL_Bench_ParseWaypoints( bench, cms );
+
+	re.BeginRegistration();
+
+	re.RegisterWorldModel( mapname );
+
+	bench->numInlineModels = CM_NumInlineModels( cms ) - 1;
+	if( bench->numInlineModels > 0 ) {
+		bench->inlineModels = Mem_ZoneMalloc( sizeof( *bench->inlineModels ) * bench->numInlineModels );
+		for( i = 0; i < bench->numInlineModels; i++ ) {
+			bench->inlineModels[i] = re.RegisterModel( va( "*%i", i + 1 ) );
+		}
+	}
+
+	for( i = 3; i < Cmd_Argc() && bench->numModels < CL_BENCH_MAX_MODELS; i++ ) {
+		struct model_s *model = re.RegisterModel( Cmd_Argv( i ) );
+		if( !model ) {
+			Com_Printf( "Couldn't load model: %s\n", Cmd_Argv( i ) );
+			continue;
+		}
+		bench->models[bench->numModels++] = model;
+	}
+
+	re.EndRegistration();
+
+	CM_ReleaseReference( cms );
+
+	Com_Printf( "Benchmarking %s: %i frames, %i waypoints, %i brush models, %i extra models\n",
+				mapname, numFrames, bench->numWaypoints, bench->numInlineModels, bench->numModels );
+
+	nullStats = Cmd_Exists( "gl_nullstats" );
+	if( nullStats ) {
+		Cbuf_ExecuteText( EXEC_NOW, "gl_nullstats reset\n" );
+	}
+
+	frameTimes = Mem_ZoneMalloc( sizeof( *frameTimes ) * numFrames );
+
+	start = frameStart = Sys_Microseconds();
+	for( i = 0; i < numFrames; i++ ) {
+		int64_t now;
+
+		re.BeginFrame( 0.0f, false, false, true );
+
+		CL_Bench_SetupView( bench, i, &rd );
+
+		re.ClearScene();
+		CL_Bench_AddEntities( bench, i, &rd );
+		re.RenderScene( &rd );
+
+		re.EndFrame();
+
+		now = Sys_Microseconds();
+		frameTimes[i] = now - frameStart;
+		frameStart = now;
+	}
+	re.Finish();
+	total = Sys_Microseconds() - start;
+
+	qsort( frameTimes, numFrames, sizeof( *frameTimes ), CL_Bench_CmpTimes );
+
+	Com_Printf( "Rendered %i frames in %.3f sec (%.1f fps)\n", numFrames, total / 1000000.0, numFrames * 1000000.0 / max( total, 1 ) );
+	Com_Printf( "Frame time: avg %.1f, median %" PRIi64 ", 99th %" PRIi64 ", max %" PRIi64 " usec\n",
+				(double)total / numFrames, frameTimes[numFrames / 2],
+				frameTimes[( numFrames * 99 ) / 100], frameTimes[numFrames - 1] );
+
+	if( nullStats ) {
+		Cbuf_ExecuteText( EXEC_NOW, "gl_nullstats\n" );
+	}
+
+	Mem_ZoneFree( frameTimes );
+	if( bench->inlineModels ) {
+		Mem_ZoneFree( bench->inlineModels );
+	}
+	Mem_ZoneFree( bench );
+
+	// free the benchmark map and restore the menu assets
+	re.BeginRegistration();
+	CL_RestartMedia();
+	re.EndRegistration();
+}
@@ -403,6 +403,7 @@ void CL_GameModule_Init( void ) {
 	import.FS_RemoveFile = FS_RemoveFile;
 	import.FS_GetFileList = FS_GetFileList;
 	import.FS_FirstExtension = FS_FirstExtension;
+	import.FS_PrefetchFiles = FS_PrefetchFiles;
 	import.FS_IsPureFile = FS_IsPureFile;
 	import.FS_MoveFile = FS_MoveFile;
 	import.FS_IsUrl = FS_IsUrl;
@@ -515,6 +516,9 @@ void CL_GameModule_Init( void ) {
 
 	import.Mem_Alloc = CL_GameModule_MemAlloc;
 	import.Mem_Free = CL_GameModule_MemFree;
+	import.Mem_ScratchAlloc = _Mem_ScratchAlloc;
+	import.Mem_ScratchMark = Mem_ScratchMark;
+	import.Mem_ScratchFreeToMark = Mem_ScratchFreeToMark;
 
 	import.L10n_LoadLangPOFile = &CL_GameModule_L10n_LoadLangPOFile;
 	import.L10n_TranslateString = &CL_GameModule_L10n_TranslateString;
@@ -528,6 +532,13 @@ void CL_GameModule_Init( void ) {
 
 	import.asGetAngelExport = Com_asGetAngelExport;
 
+	import.Jobs_NumWorkers = QJobs_NumWorkers;
+	import.Jobs_Schedule = QJobs_Schedule;
+	import.Jobs_Wait = QJobs_Wait;
+
+	import.Prof_Enter = Prof_Enter;
+	import.Prof_Leave = Prof_Leave;
+
 	if( builtinAPIfunc ) {
 		cge = builtinAPIfunc( &import );
 	} else {
@@ -1951,6 +1951,7 @@ static void CL_InitLocal( void ) {
 	Cmd_AddCommand( "showserverip", CL_ShowServerIP_f );
 	Cmd_AddCommand( "downloadstatus", CL_DownloadStatus_f );
 	Cmd_AddCommand( "downloadcancel", CL_DownloadCancel_f );
+	Cmd_AddCommand( "r_benchmark", CL_Bench_f );
 
 	Cmd_SetCompletionFunc( "demo", CL_DemoComplete );
 	Cmd_SetCompletionFunc( "demoavi", CL_DemoComplete );
@@ -1987,6 +1988,7 @@ static void CL_ShutdownLocal( void ) {
 	Cmd_RemoveCommand( "showserverip" );
 	Cmd_RemoveCommand( "downloadstatus" );
 	Cmd_RemoveCommand( "downloadcancel" );
+	Cmd_RemoveCommand( "r_benchmark" );
 }
 
 //============================================================================
@@ -279,9 +279,18 @@ void CL_SoundModule_Init( bool verbose ) {
 	import.BufPipe_Destroy = QBufPipe_Destroy;
 	import.BufPipe_Finish = QBufPipe_Finish;
 	import.BufPipe_WriteCmd = QBufPipe_WriteCmd;
+	import.BufPipe_AllocCmd = QBufPipe_AllocCmd;
+	import.BufPipe_CommitCmd = QBufPipe_CommitCmd;
 	import.BufPipe_ReadCmds = QBufPipe_ReadCmds;
 	import.BufPipe_Wait = QBufPipe_Wait;
 
+	import.Jobs_NumWorkers = QJobs_NumWorkers;
+	import.Jobs_Schedule = QJobs_Schedule;
+	import.Jobs_Wait = QJobs_Wait;
+
+	import.Prof_Enter = Prof_Enter;
+	import.Prof_Leave = Prof_Leave;
+
 	sm = Q_bound( 1, s_module->integer, num_sound_modules );
 	smfb = Q_bound( 0, s_module_fallback->integer, num_sound_modules );
 
@@ -383,6 +383,7 @@ static bool VID_LoadRefresh( const char *name ) {
 	import.FS_GetFileList = &FS_GetFileList;
 	import.FS_GetGameDirectoryList = &FS_GetGameDirectoryList;
 	import.FS_FirstExtension = &FS_FirstExtension;
+	import.FS_PrefetchFiles = &FS_PrefetchFiles;
 	import.FS_MoveFile = &FS_MoveFile;
 	import.FS_IsUrl = &FS_IsUrl;
 	import.FS_FileMTime = &FS_FileMTime;
@@ -422,6 +423,13 @@ static bool VID_LoadRefresh( const char *name ) {
 	import.BufPipe_ReadCmds = QBufPipe_ReadCmds;
 	import.BufPipe_Wait = QBufPipe_Wait;
 
+	import.Jobs_NumWorkers = QJobs_NumWorkers;
+	import.Jobs_Schedule = QJobs_Schedule;
+	import.Jobs_Wait = QJobs_Wait;
+
+	import.Prof_Enter = Prof_Enter;
+	import.Prof_Leave = Prof_Leave;
+
 	file_size = strlen( LIB_DIRECTORY "/" LIB_PREFIX ) + strlen( name ) + strlen( LIB_SUFFIX ) + 1;
 	file = Mem_TempMalloc( file_size );
 	Q_snprintfz( file, file_size, LIB_DIRECTORY "/" LIB_PREFIX "%s" LIB_SUFFIX, name );
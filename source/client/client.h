@@ -535,6 +535,11 @@ char **CL_DemoComplete( const char *partial );
 #define CL_WriteAvi() ( cls.demo.avi && cls.state == CA_ACTIVE && cls.demo.playing && !cls.demo.play_jump )
 #define CL_SetDemoMetaKeyValue( k,v ) cls.demo.meta_data_realsize = SNAP_SetDemoMetaKeyValue( cls.demo.meta_data, sizeof( cls.demo.meta_data ), cls.demo.meta_data_realsize, k, v )
 
+//
+// cl_bench.c
+//
+void CL_Bench_f( void );
+
 //
 // cl_parse.c
 //
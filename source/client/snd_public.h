@@ -20,7 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // snd_public.h -- sound dll information visible to engine
 
-#define SOUND_API_VERSION   40
+#define SOUND_API_VERSION   44
 
 #define ATTN_NONE 0
 
@@ -105,9 +105,21 @@ typedef struct {
 	void ( *BufPipe_Destroy )( struct qbufPipe_s **pqueue );
 	void ( *BufPipe_Finish )( struct qbufPipe_s *queue );
 	void ( *BufPipe_WriteCmd )( struct qbufPipe_s *queue, const void *cmd, unsigned cmd_size );
+	void *( *BufPipe_AllocCmd )( struct qbufPipe_s *queue, unsigned cmd_size );
+	void ( *BufPipe_CommitCmd )( struct qbufPipe_s *queue, unsigned cmd_size );
 	int ( *BufPipe_ReadCmds )( struct qbufPipe_s *queue, unsigned( **cmdHandlers )( const void * ) );
 	void ( *BufPipe_Wait )( struct qbufPipe_s *queue, int ( *read )( struct qbufPipe_s *, unsigned( ** )( const void * ), bool ),
 							unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec );
+
+	// job system
+	int ( *Jobs_NumWorkers )( void );
+	void ( *Jobs_Schedule )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+							 unsigned items, unsigned granularity, volatile int *counter );
+	void ( *Jobs_Wait )( volatile int *counter );
+
+	// profiler
+	void ( *Prof_Enter )( const char *name );
+	void ( *Prof_Leave )( void );
 } sound_import_t;
 
 //
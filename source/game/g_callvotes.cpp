@@ -167,6 +167,19 @@ static int G_VoteCompareWeightedPlayers( const void *a, const void *b ) {
 
 #define MAPLIST_SEPS " ,"
 
+/*
+* G_ScratchMapPool
+*
+* Returns a copy of g_map_pool for strtok, the caller frees it to its scratch mark.
+*/
+static char *G_ScratchMapPool( void ) {
+	size_t size = strlen( g_map_pool->string ) + 1;
+	char *s = ( char * )G_ScratchMalloc( size );
+
+	memcpy( s, g_map_pool->string, size );
+	return s;
+}
+
 static void G_VoteMapExtraHelp( edict_t *ent ) {
 	char *s;
 	char buffer[MAX_STRING_CHARS];
@@ -266,24 +279,25 @@ static bool G_VoteMapValidate( callvotedata_t *data, bool first ) {
 
 		// check if valid map is in map pool when on
 		if( g_enforce_map_pool->integer ) {
-			char *s, *tok;
+			char *tok;
+			size_t mark;
 
 			// if map pool is empty, basically turn it off
 			if( strlen( g_map_pool->string ) < 2 ) {
 				return true;
 			}
 
-			s = G_CopyString( g_map_pool->string );
-			tok = strtok( s, MAPLIST_SEPS );
+			mark = G_ScratchMark();
+			tok = strtok( G_ScratchMapPool(), MAPLIST_SEPS );
 			while( tok != NULL ) {
 				if( !Q_stricmp( tok, mapname ) ) {
-					G_Free( s );
+					G_ScratchFreeToMark( mark );
 					goto valid_map;
 				} else {
 					tok = strtok( NULL, MAPLIST_SEPS );
 				}
 			}
-			G_Free( s );
+			G_ScratchFreeToMark( mark );
 			G_PrintMsg( data->caller, "%sMap is not in map pool.\n", S_COLOR_RED );
 			return false;
 		}
@@ -331,10 +345,10 @@ static http_response_code_t G_VoteMapWebRequest( http_query_method_t method, con
 	trap_ML_Update();
 
 	if( g_enforce_map_pool->integer && strlen( g_map_pool->string ) > 2 ) {
-		char *s, *tok;
+		char *tok;
+		size_t mark = G_ScratchMark();
 
-		s = G_CopyString( g_map_pool->string );
-		tok = strtok( s, MAPLIST_SEPS );
+		tok = strtok( G_ScratchMapPool(), MAPLIST_SEPS );
 		while( tok != NULL ) {
 			const char *fullname = trap_ML_GetFullname( tok );
 
@@ -350,7 +364,7 @@ static http_response_code_t G_VoteMapWebRequest( http_query_method_t method, con
 			tok = strtok( NULL, MAPLIST_SEPS );
 		}
 
-		G_Free( s );
+		G_ScratchFreeToMark( mark );
 	} else {
 		for( i = 0; trap_ML_GetMapByNum( i, buffer, sizeof( buffer ) ); i++ ) {
 			G_AppendString( &msg, va(
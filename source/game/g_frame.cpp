@@ -186,7 +186,7 @@ static void G_UpdateServerInfo( void ) {
 		} else {
 			char *votable;
 			char *name;
-			size_t len;
+			size_t len, mark;
 			int count;
 
 			len = 0;
@@ -198,7 +198,8 @@ static void G_UpdateServerInfo( void ) {
 			}
 
 			len++;
-			votable = ( char * )G_Malloc( len );
+			mark = G_ScratchMark();
+			votable = ( char * )G_ScratchMalloc( len );
 			votable[0] = 0;
 
 			for( count = 0; ( name = COM_ListNameForPosition( g_gametypes_list->string, count, CHAR_GAMETYPE_SEPARATOR ) ) != NULL; count++ ) {
@@ -210,7 +211,7 @@ static void G_UpdateServerInfo( void ) {
 
 			//votable[ strlen( votable )-2 ] = 0; // remove the last space
 			trap_Cvar_ForceSet( "g_gametypes_available", votable );
-			G_Free( votable );
+			G_ScratchFreeToMark( mark );
 		}
 
 		g_votable_gametypes->modified = false;
@@ -746,11 +747,24 @@ void G_RunFrame( unsigned int msec, int64_t serverTime ) {
 
 	// run the world
 	G_asCallMapPreThink();
+
+	trap_Prof_Enter( "AI_CommonFrame" );
 	AI_SetSightClient();
 	AI_CommonFrame();
+	trap_Prof_Leave();
+
+	trap_Prof_Enter( "G_RunClients" );
 	G_RunClients();
+	trap_Prof_Leave();
+
+	trap_Prof_Enter( "G_RunEntities" );
 	G_RunEntities();
+	trap_Prof_Leave();
+
+	trap_Prof_Enter( "G_RunGametype" );
 	G_RunGametype();
+	trap_Prof_Leave();
+
 	G_asCallMapPostThink();
 	GClip_BackUpCollisionFrame();
 
@@ -1018,6 +1018,11 @@ int G_BoxSlideMove( edict_t *ent, int contentmask, float slideBounce, float fric
 #define G_Malloc( size ) trap_MemAlloc( size, __FILE__, __LINE__ )
 #define G_Free( mem ) trap_MemFree( mem, __FILE__, __LINE__ )
 
+// scratch memory, valid until the end of the frame unless freed earlier with G_ScratchFreeToMark
+#define G_ScratchMalloc( size ) trap_MemScratchAlloc( size, __FILE__, __LINE__ )
+#define G_ScratchMark() trap_MemScratchMark()
+#define G_ScratchFreeToMark( mark ) trap_MemScratchFreeToMark( mark )
+
 #define G_LevelMalloc( size ) _G_LevelMalloc( ( size ), __FILE__, __LINE__ )
 #define G_LevelFree( data ) _G_LevelFree( ( data ), __FILE__, __LINE__ )
 #define G_LevelCopyString( in ) _G_LevelCopyString( ( in ), __FILE__, __LINE__ )
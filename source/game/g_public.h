@@ -20,7 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // g_public.h -- game dll information visible to server
 
-#define GAME_API_VERSION    51
+#define GAME_API_VERSION    54
 
 //===============================================================
 
@@ -118,6 +118,11 @@ typedef struct {
 	void *( *Mem_Alloc )( size_t size, const char *filename, int fileline );
 	void ( *Mem_Free )( void *data, const char *filename, int fileline );
 
+	// per-thread scratch memory, released at the end of the frame or by freeing to a mark
+	void *( *Mem_ScratchAlloc )( size_t size, const char *filename, int fileline );
+	size_t ( *Mem_ScratchMark )( void );
+	void ( *Mem_ScratchFreeToMark )( size_t mark );
+
 	// console variable interaction
 	cvar_t *( *Cvar_Get )( const char *name, const char *value, int flags );
 	cvar_t *( *Cvar_Set )( const char *name, const char *value );
@@ -185,6 +190,16 @@ typedef struct {
 	struct stat_query_api_s *( *GetStatQueryAPI )( void );
 	void ( *MM_SendQuery )( struct stat_query_s *query );
 	void ( *MM_GameState )( bool state );
+
+	// job system
+	int ( *Jobs_NumWorkers )( void );
+	void ( *Jobs_Schedule )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+							 unsigned items, unsigned granularity, volatile int *counter );
+	void ( *Jobs_Wait )( volatile int *counter );
+
+	// profiler
+	void ( *Prof_Enter )( const char *name );
+	void ( *Prof_Leave )( void );
 } game_import_t;
 
 //
@@ -142,6 +142,18 @@ static inline void trap_MemFree( void *data, const char *filename, int fileline
 	GAME_IMPORT.Mem_Free( data, filename, fileline );
 }
 
+static inline ATTRIBUTE_MALLOC void *trap_MemScratchAlloc( size_t size, const char *filename, int fileline ) {
+	return GAME_IMPORT.Mem_ScratchAlloc( size, filename, fileline );
+}
+
+static inline size_t trap_MemScratchMark( void ) {
+	return GAME_IMPORT.Mem_ScratchMark();
+}
+
+static inline void trap_MemScratchFreeToMark( size_t mark ) {
+	GAME_IMPORT.Mem_ScratchFreeToMark( mark );
+}
+
 // cvars
 static inline cvar_t *trap_Cvar_Get( const char *name, const char *value, int flags ) {
 	return GAME_IMPORT.Cvar_Get( name, value, flags );
@@ -300,3 +312,26 @@ static inline void trap_MM_SendQuery( struct stat_query_s *query ) {
 static inline void trap_MM_GameState( bool state ) {
 	GAME_IMPORT.MM_GameState( state == true ? true : false );
 }
+
+// job system
+static inline int trap_Jobs_NumWorkers( void ) {
+	return GAME_IMPORT.Jobs_NumWorkers();
+}
+
+static inline void trap_Jobs_Schedule( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+									   unsigned items, unsigned granularity, volatile int *counter ) {
+	GAME_IMPORT.Jobs_Schedule( func, arg, items, granularity, counter );
+}
+
+static inline void trap_Jobs_Wait( volatile int *counter ) {
+	GAME_IMPORT.Jobs_Wait( counter );
+}
+
+// profiler
+static inline void trap_Prof_Enter( const char *name ) {
+	GAME_IMPORT.Prof_Enter( name );
+}
+
+static inline void trap_Prof_Leave( void ) {
+	GAME_IMPORT.Prof_Leave();
+}
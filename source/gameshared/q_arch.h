@@ -395,6 +395,13 @@ typedef int socket_handle_t;
 #define ATTRIBUTE_NAKED
 #endif
 
+// thread-local storage, left undefined if the compiler doesn't support it
+#if defined ( __GNUC__ )
+#define ATTRIBUTE_TLS __thread
+#elif defined ( _MSC_VER )
+#define ATTRIBUTE_TLS __declspec( thread )
+#endif
+
 #ifdef HAVE___STRTOI64
 #define strtoll _strtoi64
 #define strtoull _strtoi64
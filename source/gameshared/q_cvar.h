@@ -58,8 +58,23 @@ typedef struct cvar_s {
 	bool modified;          // set each time the cvar is changed
 	float value;
 	int integer;
+	int modificationCount;  // incremented each time the cvar is changed
 } cvar_t;
 
+/*
+* Cvar_CheckModificationCount
+*
+* Returns true if the cvar was changed since the counter was last updated. Unlike
+* the modified flag, which only works for a single observer, each caller keeps its own counter.
+*/
+static inline bool Cvar_CheckModificationCount( const cvar_t *var, int *count ) {
+	if( var->modificationCount == *count ) {
+		return false;
+	}
+	*count = var->modificationCount;
+	return true;
+}
+
 #ifdef __cplusplus
 };
 #endif
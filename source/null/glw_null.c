@@ -0,0 +1,202 @@
+/*
+Copyright (C) 2017 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// glw_null.c -- windowless GL binding for the null OpenGL driver
+
+#include "../ref_gl/r_local.h"
+#include "glw_null.h"
+
+static bool glw_initialized;
+
+/*
+** GLimp_NullStats_f
+**
+** gl_nullstats [reset]
+*/
+static void GLimp_NullStats_f( void ) {
+	qgl_null_stats_t stats;
+	unsigned frames;
+
+	QGL_Null_GetStats( &stats, ri.Cmd_Argc() > 1 && !Q_stricmp( ri.Cmd_Argv( 1 ), "reset" ) );
+
+	frames = max( stats.frames, 1 );
+
+	Com_Printf( "Frames: %u\n", stats.frames );
+	Com_Printf( "Draw calls: %u (%.1f per frame), %u instanced, %.0f elements per frame\n",
+				stats.drawCalls, (double)stats.drawCalls / frames, stats.instancedDrawCalls, (double)stats.drawElements / frames );
+	Com_Printf( "Binds per frame: %.1f programs, %.1f textures, %.1f buffers\n",
+				(double)stats.programBinds / frames, (double)stats.textureBinds / frames, (double)stats.bufferBinds / frames );
+	Com_Printf( "Texture uploads: %u, %.1f KB\n", stats.textureUploads, stats.textureUploadBytes / 1024.0 );
+	Com_Printf( "Buffer uploads: %u, %.1f KB (%.1f KB per frame)\n",
+				stats.bufferUploads, stats.bufferUploadBytes / 1024.0, stats.bufferUploadBytes / 1024.0 / frames );
+	Com_Printf( "Memory: %.1f MB textures, %.1f MB buffers\n",
+				stats.textureMemory / ( 1024.0 * 1024.0 ), stats.bufferMemory / ( 1024.0 * 1024.0 ) );
+}
+
+/*
+** GLimp_SetFullscreen
+*/
+rserr_t GLimp_SetFullscreen( bool fullscreen, int xpos, int ypos ) {
+	glConfig.fullScreen = fullscreen;
+	return rserr_ok;
+}
+
+/*
+** GLimp_SetMode
+*/
+rserr_t GLimp_SetMode( int x, int y, int width, int height, bool fullscreen, bool stereo, bool borderless ) {
+	ri.Com_Printf( "Initializing null OpenGL display\n" );
+	ri.Com_Printf( "...setting mode: %d %d\n", width, height );
+
+	glConfig.width = width;
+	glConfig.height = height;
+	glConfig.borderless = borderless;
+	glConfig.fullScreen = fullscreen;
+	glConfig.stencilBits = max( 0, r_stencilbits->integer );
+	glConfig.stereoEnabled = false;
+
+	return rserr_ok;
+}
+
+/*
+** GLimp_Shutdown
+*/
+void GLimp_Shutdown( void ) {
+	if( glw_initialized ) {
+		ri.Cmd_RemoveCommand( "gl_nullstats" );
+		glw_initialized = false;
+	}
+
+	glConfig.width = 0;
+	glConfig.height = 0;
+}
+
+/*
+** GLimp_Init
+*/
+bool GLimp_Init( const char *applicationName, void *hinstance, void *wndproc, void *parenthWnd,
+				 int iconResource, const int *iconXPM ) {
+	if( !glw_initialized ) {
+		ri.Cmd_AddCommand( "gl_nullstats", GLimp_NullStats_f );
+		glw_initialized = true;
+	}
+	return true;
+}
+
+/*
+** GLimp_BeginFrame
+*/
+void GLimp_BeginFrame( void ) {
+}
+
+/*
+** GLimp_EndFrame
+*/
+void GLimp_EndFrame( void ) {
+	QGL_Null_FrameDone();
+}
+
+/*
+** GLimp_GetGammaRamp
+*/
+bool GLimp_GetGammaRamp( size_t stride, unsigned short *psize, unsigned short *ramp ) {
+	return false;
+}
+
+/*
+** GLimp_SetGammaRamp
+*/
+void GLimp_SetGammaRamp( size_t stride, unsigned short size, unsigned short *ramp ) {
+}
+
+/*
+** GLimp_AppActivate
+*/
+void GLimp_AppActivate( bool active, bool minimize, bool destroy ) {
+}
+
+/*
+** GLimp_SetWindow
+*/
+rserr_t GLimp_SetWindow( void *hinstance, void *wndproc, void *parenthWnd, bool *surfaceChangePending ) {
+	if( surfaceChangePending ) {
+		*surfaceChangePending = false;
+	}
+	return rserr_ok;
+}
+
+/*
+** GLimp_RenderingEnabled
+*/
+bool GLimp_RenderingEnabled( void ) {
+	return true;
+}
+
+/*
+** GLimp_SetSwapInterval
+*/
+void GLimp_SetSwapInterval( int swapInterval ) {
+}
+
+/*
+** GLimp_MakeCurrent
+*/
+bool GLimp_MakeCurrent( void *context, void *surface ) {
+	return true;
+}
+
+/*
+** GLimp_EnableMultithreadedRendering
+*/
+void GLimp_EnableMultithreadedRendering( bool enable ) {
+}
+
+/*
+** GLimp_GetWindowSurface
+*/
+void *GLimp_GetWindowSurface( bool *renderable ) {
+	if( renderable ) {
+		*renderable = true;
+	}
+	return NULL;
+}
+
+/*
+** GLimp_UpdatePendingWindowSurface
+*/
+void GLimp_UpdatePendingWindowSurface( void ) {
+}
+
+/*
+** GLimp_SharedContext_Create
+*/
+bool GLimp_SharedContext_Create( void **context, void **surface ) {
+	*context = (void *)1;
+	if( surface ) {
+		*surface = NULL;
+	}
+	return true;
+}
+
+/*
+** GLimp_SharedContext_Destroy
+*/
+void GLimp_SharedContext_Destroy( void *context, void *surface ) {
+}
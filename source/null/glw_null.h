@@ -0,0 +1,47 @@
+/*
+Copyright (C) 2017 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifndef __GLW_NULL_H_
+#define __GLW_NULL_H_
+
+typedef struct {
+	unsigned frames;
+
+	unsigned drawCalls;
+	unsigned instancedDrawCalls;
+	uint64_t drawElements;          // indices or vertices submitted
+
+	unsigned programBinds;
+	unsigned textureBinds;
+	unsigned bufferBinds;
+
+	unsigned textureUploads;
+	uint64_t textureUploadBytes;
+	unsigned bufferUploads;
+	uint64_t bufferUploadBytes;
+
+	size_t textureMemory;           // estimated storage of all live objects
+	size_t bufferMemory;
+} qgl_null_stats_t;
+
+void QGL_Null_GetStats( qgl_null_stats_t *stats, bool reset );
+void QGL_Null_FrameDone( void );
+
+#endif // __GLW_NULL_H_
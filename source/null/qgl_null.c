@@ -0,0 +1,767 @@
+/*
+Copyright (C) 2017 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+/*
+** QGL_NULL.C
+**
+** Binds the qgl function pointers to a stub GL implementation, so that the
+** renderer can run without a GPU or a window. Draw calls are no-ops, object
+** names are handed out sequentially, shaders always compile and link, and
+** buffer and texture uploads are tracked so that the amount of data the
+** frontend pushes to the driver can be measured.
+**
+** Every function that returns a value or takes floating point arguments
+** has a stub with the matching signature. The remaining ones return void
+** and take only integers and pointers, and are bound to a single no-op
+** that relies on the caller cleaning up the stack.
+*/
+
+#include "../qcommon/qcommon.h"
+#include "glw_null.h"
+
+#if defined ( _WIN32 ) && !defined ( _WIN64 )
+#error "The null GL stubs are not compatible with the stdcall calling convention"
+#endif
+
+#define QGL_EXTERN
+
+#define QGL_FUNC( type, name, params ) type( APIENTRY *q ## name ) params;
+#define QGL_FUNC_OPT( type, name, params ) type( APIENTRY *q ## name ) params;
+#define QGL_EXT( type, name, params ) type( APIENTRY *q ## name ) params;
+#define QGL_WGL( type, name, params )
+#define QGL_WGL_EXT( type, name, params )
+#define QGL_GLX( type, name, params )
+#define QGL_GLX_EXT( type, name, params )
+#define QGL_EGL( type, name, params )
+#define QGL_EGL_EXT( type, name, params )
+
+#include "../ref_gl/qgl.h"
+
+#undef QGL_EGL_EXT
+#undef QGL_EGL
+#undef QGL_GLX_EXT
+#undef QGL_GLX
+#undef QGL_WGL_EXT
+#undef QGL_WGL
+#undef QGL_EXT
+#undef QGL_FUNC_OPT
+#undef QGL_FUNC
+
+#define QGL_NULL_MAX_TEXTURE_UNITS  32
+
+#define QGL_NULL_EXTENSIONS \
+	"GL_ARB_multitexture GL_ARB_vertex_buffer_object GL_ARB_vertex_shader GL_ARB_fragment_shader " \
+	"GL_ARB_shader_objects GL_ARB_shading_language_100 GL_EXT_draw_range_elements " \
+	"GL_EXT_framebuffer_object GL_EXT_framebuffer_blit GL_EXT_texture_edge_clamp " \
+	"GL_SGIS_texture_edge_clamp GL_ARB_texture_cube_map GL_ARB_depth_texture GL_ARB_shadow " \
+	"GL_ARB_texture_non_power_of_two GL_ARB_draw_instanced GL_ARB_instanced_arrays " \
+	"GL_ARB_half_float_vertex GL_EXT_blend_func_separate GL_EXT_texture3D GL_EXT_texture_array " \
+	"GL_ARB_draw_buffers GL_EXT_packed_depth_stencil GL_SGIS_texture_lod " \
+	"GL_EXT_texture_filter_anisotropic GL_EXT_bgra"
+
+// sizes of GL objects, indexed by their names
+typedef struct {
+	size_t *sizes;
+	unsigned maxNames;
+	size_t totalSize;
+} qgl_null_objects_t;
+
+typedef struct {
+	qgl_null_stats_t stats;
+
+	qgl_null_objects_t textures;
+	qgl_null_objects_t buffers;
+	GLuint nextName;
+
+	int activeTexture;
+	GLuint boundTextures[QGL_NULL_MAX_TEXTURE_UNITS];
+	GLuint boundArrayBuffer, boundElementBuffer;
+} qgl_null_state_t;
+
+static qgl_null_state_t qgl_null;
+
+static const char *_qglGetGLWExtensionsString( void );
+
+/*
+* QGL_Null_ObjectSize
+*
+* Returns a pointer to the tracked size of the named object, growing the table as needed.
+*/
+static size_t *QGL_Null_ObjectSize( qgl_null_objects_t *objects, GLuint name ) {
+	if( !name ) {
+		return NULL;
+	}
+
+	if( name >= objects->maxNames ) {
+		unsigned newMax = max( name + 1, objects->maxNames * 2 );
+		size_t *newSizes = realloc( objects->sizes, newMax * sizeof( *newSizes ) );
+
+		if( !newSizes ) {
+			return NULL;
+		}
+		memset( newSizes + objects->maxNames, 0, ( newMax - objects->maxNames ) * sizeof( *newSizes ) );
+		objects->sizes = newSizes;
+		objects->maxNames = newMax;
+	}
+
+	return &objects->sizes[name];
+}
+
+/*
+* QGL_Null_SetObjectSize
+*/
+static void QGL_Null_SetObjectSize( qgl_null_objects_t *objects, GLuint name, size_t size, bool add ) {
+	size_t *psize = QGL_Null_ObjectSize( objects, name );
+
+	if( !psize ) {
+		return;
+	}
+
+	objects->totalSize -= *psize;
+	*psize = add ? *psize + size : size;
+	objects->totalSize += *psize;
+}
+
+/*
+* QGL_Null_DeleteObjects
+*/
+static void QGL_Null_DeleteObjects( qgl_null_objects_t *objects, GLsizei n, const GLuint *names ) {
+	GLsizei i;
+
+	for( i = 0; i < n; i++ ) {
+		QGL_Null_SetObjectSize( objects, names[i], 0, false );
+	}
+}
+
+/*
+* QGL_Null_PixelSize
+*/
+static size_t QGL_Null_PixelSize( GLenum format, GLenum type ) {
+	int components;
+
+	switch( type ) {
+		case GL_UNSIGNED_SHORT_4_4_4_4:
+		case GL_UNSIGNED_SHORT_5_5_5_1:
+		case GL_UNSIGNED_SHORT_5_6_5:
+			return 2;
+		case GL_UNSIGNED_INT_24_8_EXT:
+			return 4;
+	}
+
+	switch( format ) {
+		case GL_RGBA:
+		case GL_BGRA_EXT:
+			components = 4;
+			break;
+		case GL_RGB:
+		case GL_BGR_EXT:
+			components = 3;
+			break;
+		case GL_LUMINANCE_ALPHA:
+			components = 2;
+			break;
+		default:
+			components = 1;
+			break;
+	}
+
+	switch( type ) {
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+		case GL_HALF_FLOAT:
+			return components * 2;
+		case GL_INT:
+		case GL_UNSIGNED_INT:
+		case GL_FLOAT:
+			return components * 4;
+		default:
+			return components;
+	}
+}
+
+/*
+* QGL_Null_TexImage
+*/
+static void QGL_Null_TexImage( GLenum target, GLint level, size_t size ) {
+	GLuint texture;
+	bool add;
+
+	texture = qgl_null.boundTextures[qgl_null.activeTexture];
+
+	// uploading the base level of a texture replaces all of its storage
+	add = level > 0 || ( target > GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z_ARB );
+	QGL_Null_SetObjectSize( &qgl_null.textures, texture, size, add );
+
+	qgl_null.stats.textureUploads++;
+	qgl_null.stats.textureUploadBytes += size;
+}
+
+/*
+* QGL_Null_GenNames
+*/
+static void APIENTRY QGL_Null_GenNames( GLsizei n, GLuint *names ) {
+	GLsizei i;
+
+	for( i = 0; i < n; i++ ) {
+		names[i] = ++qgl_null.nextName;
+	}
+}
+
+/*
+* QGL_Null_CreateObject
+*/
+static GLuint APIENTRY QGL_Null_CreateObject( void ) {
+	return ++qgl_null.nextName;
+}
+
+/*
+* QGL_Null_GetString
+*/
+static const GLubyte * APIENTRY QGL_Null_GetString( GLenum name ) {
+	switch( name ) {
+		case GL_VENDOR:
+			return (const GLubyte *)"qfusion";
+		case GL_RENDERER:
+			return (const GLubyte *)"null";
+		case GL_VERSION:
+			return (const GLubyte *)"2.1";
+		case GL_EXTENSIONS:
+			return (const GLubyte *)QGL_NULL_EXTENSIONS;
+		case GL_SHADING_LANGUAGE_VERSION_ARB:
+			return (const GLubyte *)"1.20";
+	}
+	return NULL;
+}
+
+/*
+* QGL_Null_GetIntegerv
+*/
+static void APIENTRY QGL_Null_GetIntegerv( GLenum pname, GLint *params ) {
+	switch( pname ) {
+		case GL_MAX_TEXTURE_SIZE:
+		case GL_MAX_CUBE_MAP_TEXTURE_SIZE_ARB:
+		case GL_MAX_RENDERBUFFER_SIZE_EXT:
+			*params = 8192;
+			break;
+		case GL_MAX_3D_TEXTURE_SIZE_EXT:
+		case GL_MAX_ARRAY_TEXTURE_LAYERS_EXT:
+			*params = 2048;
+			break;
+		case GL_MAX_TEXTURE_IMAGE_UNITS_ARB:
+		case GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS_ARB:
+		case GL_MAX_VERTEX_ATTRIBS_ARB:
+		case GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT:
+			*params = 16;
+			break;
+		case GL_MAX_VERTEX_UNIFORM_COMPONENTS_ARB:
+		case GL_MAX_FRAGMENT_UNIFORM_COMPONENTS_ARB:
+			*params = 4096;
+			break;
+		case GL_MAX_VARYING_FLOATS_ARB:
+			*params = 64;
+			break;
+		default:
+			*params = 0;
+			break;
+	}
+}
+
+/*
+* QGL_Null_GetObjectiv
+*
+* Every shader compiles and every program links.
+*/
+static void APIENTRY QGL_Null_GetObjectiv( GLuint object, GLenum pname, GLint *params ) {
+	switch( pname ) {
+		case GL_OBJECT_COMPILE_STATUS_ARB:
+		case GL_OBJECT_LINK_STATUS_ARB:
+			*params = GL_TRUE;
+			break;
+		default:
+			*params = 0;
+			break;
+	}
+}
+
+/*
+* QGL_Null_GetInfoLog
+*/
+static void APIENTRY QGL_Null_GetInfoLog( GLuint object, GLsizei maxLength, GLsizei *length, GLcharARB *infoLog ) {
+	if( length ) {
+		*length = 0;
+	}
+	if( infoLog && maxLength > 0 ) {
+		infoLog[0] = '\0';
+	}
+}
+
+/*
+* QGL_Null_GetLocation
+*/
+static GLint APIENTRY QGL_Null_GetLocation( GLuint program, const GLcharARB *name ) {
+	return ++qgl_null.nextName;
+}
+
+/*
+* QGL_Null_CheckFramebufferStatus
+*/
+static GLenum APIENTRY QGL_Null_CheckFramebufferStatus( GLenum target ) {
+	return GL_FRAMEBUFFER_COMPLETE_EXT;
+}
+
+/*
+* QGL_Null_ActiveTexture
+*/
+static void APIENTRY QGL_Null_ActiveTexture( GLenum texture ) {
+	qgl_null.activeTexture = Q_bound( 0, (int)( texture - GL_TEXTURE0_ARB ), QGL_NULL_MAX_TEXTURE_UNITS - 1 );
+}
+
+/*
+* QGL_Null_BindTexture
+*/
+static void APIENTRY QGL_Null_BindTexture( GLenum target, GLuint texture ) {
+	qgl_null.boundTextures[qgl_null.activeTexture] = texture;
+	qgl_null.stats.textureBinds++;
+}
+
+/*
+* QGL_Null_DeleteTextures
+*/
+static void APIENTRY QGL_Null_DeleteTextures( GLsizei n, const GLuint *textures ) {
+	QGL_Null_DeleteObjects( &qgl_null.textures, n, textures );
+}
+
+/*
+* QGL_Null_TexImage2D
+*/
+static void APIENTRY QGL_Null_TexImage2D( GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+										  GLint border, GLenum format, GLenum type, const GLvoid *pixels ) {
+	QGL_Null_TexImage( target, level, (size_t)width * height * QGL_Null_PixelSize( format, type ) );
+}
+
+/*
+* QGL_Null_TexSubImage2D
+*/
+static void APIENTRY QGL_Null_TexSubImage2D( GLenum target, GLint level, GLint xoffset, GLint yoffset,
+											 GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *pixels ) {
+	qgl_null.stats.textureUploads++;
+	qgl_null.stats.textureUploadBytes += (size_t)width * height * QGL_Null_PixelSize( format, type );
+}
+
+/*
+* QGL_Null_TexImage3D
+*/
+static void APIENTRY QGL_Null_TexImage3D( GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+										  GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid *pixels ) {
+	QGL_Null_TexImage( target, level, (size_t)width * height * depth * QGL_Null_PixelSize( format, type ) );
+}
+
+/*
+* QGL_Null_TexSubImage3D
+*/
+static void APIENTRY QGL_Null_TexSubImage3D( GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+											 GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid *pixels ) {
+	qgl_null.stats.textureUploads++;
+	qgl_null.stats.textureUploadBytes += (size_t)width * height * depth * QGL_Null_PixelSize( format, type );
+}
+
+/*
+* QGL_Null_CompressedTexImage2D
+*/
+static void APIENTRY QGL_Null_CompressedTexImage2D( GLenum target, GLint level, GLenum internalformat,
+													GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid *data ) {
+	QGL_Null_TexImage( target, level, imageSize );
+}
+
+/*
+* QGL_Null_CompressedTexSubImage2D
+*/
+static void APIENTRY QGL_Null_CompressedTexSubImage2D( GLenum target, GLint level, GLint xoffset, GLint yoffset,
+													   GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const GLvoid *data ) {
+	qgl_null.stats.textureUploads++;
+	qgl_null.stats.textureUploadBytes += imageSize;
+}
+
+/*
+* QGL_Null_BindBuffer
+*/
+static void APIENTRY QGL_Null_BindBuffer( GLenum target, GLuint buffer ) {
+	if( target == GL_ELEMENT_ARRAY_BUFFER_ARB ) {
+		qgl_null.boundElementBuffer = buffer;
+	} else {
+		qgl_null.boundArrayBuffer = buffer;
+	}
+	qgl_null.stats.bufferBinds++;
+}
+
+/*
+* QGL_Null_DeleteBuffers
+*/
+static void APIENTRY QGL_Null_DeleteBuffers( GLsizei n, const GLuint *buffers ) {
+	QGL_Null_DeleteObjects( &qgl_null.buffers, n, buffers );
+}
+
+/*
+* QGL_Null_BufferData
+*/
+static void APIENTRY QGL_Null_BufferData( GLenum target, GLsizeiptrARB size, const GLvoid *data, GLenum usage ) {
+	GLuint buffer = target == GL_ELEMENT_ARRAY_BUFFER_ARB ? qgl_null.boundElementBuffer : qgl_null.boundArrayBuffer;
+
+	QGL_Null_SetObjectSize( &qgl_null.buffers, buffer, size, false );
+
+	if( data ) {
+		qgl_null.stats.bufferUploads++;
+		qgl_null.stats.bufferUploadBytes += size;
+	}
+}
+
+/*
+* QGL_Null_BufferSubData
+*/
+static void APIENTRY QGL_Null_BufferSubData( GLenum target, GLintptrARB offset, GLsizeiptrARB size, const GLvoid *data ) {
+	qgl_null.stats.bufferUploads++;
+	qgl_null.stats.bufferUploadBytes += size;
+}
+
+/*
+* QGL_Null_UseProgram
+*/
+static void APIENTRY QGL_Null_UseProgram( GLuint program ) {
+	qgl_null.stats.programBinds++;
+}
+
+/*
+* QGL_Null_DrawArrays
+*/
+static void APIENTRY QGL_Null_DrawArrays( GLenum mode, GLint first, GLsizei count ) {
+	qgl_null.stats.drawCalls++;
+	qgl_null.stats.drawElements += count;
+}
+
+/*
+* QGL_Null_DrawElements
+*/
+static void APIENTRY QGL_Null_DrawElements( GLenum mode, GLsizei count, GLenum type, const GLvoid *indices ) {
+	qgl_null.stats.drawCalls++;
+	qgl_null.stats.drawElements += count;
+}
+
+/*
+* QGL_Null_DrawRangeElements
+*/
+static void APIENTRY QGL_Null_DrawRangeElements( GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const GLvoid *indices ) {
+	qgl_null.stats.drawCalls++;
+	qgl_null.stats.drawElements += count;
+}
+
+/*
+* QGL_Null_DrawArraysInstanced
+*/
+static void APIENTRY QGL_Null_DrawArraysInstanced( GLenum mode, GLint first, GLsizei count, GLsizei primcount ) {
+	qgl_null.stats.drawCalls++;
+	qgl_null.stats.instancedDrawCalls++;
+	qgl_null.stats.drawElements += (uint64_t)count * primcount;
+}
+
+/*
+* QGL_Null_DrawElementsInstanced
+*/
+static void APIENTRY QGL_Null_DrawElementsInstanced( GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei primcount ) {
+	qgl_null.stats.drawCalls++;
+	qgl_null.stats.instancedDrawCalls++;
+	qgl_null.stats.drawElements += (uint64_t)count * primcount;
+}
+
+/*
+* QGL_Null_GetError
+*/
+static GLenum APIENTRY QGL_Null_GetError( void ) {
+	return GL_NO_ERROR;
+}
+
+/*
+* QGL_Null_IsObject
+*/
+static GLboolean APIENTRY QGL_Null_IsObject( GLuint object ) {
+	return object && object <= qgl_null.nextName ? GL_TRUE : GL_FALSE;
+}
+
+/*
+* QGL_Null_Float1
+*/
+static void APIENTRY QGL_Null_Float1( GLfloat f0 ) {
+}
+
+/*
+* QGL_Null_Float2
+*/
+static void APIENTRY QGL_Null_Float2( GLfloat f0, GLfloat f1 ) {
+}
+
+/*
+* QGL_Null_Float4
+*/
+static void APIENTRY QGL_Null_Float4( GLfloat f0, GLfloat f1, GLfloat f2, GLfloat f3 ) {
+}
+
+/*
+* QGL_Null_Double1
+*/
+static void APIENTRY QGL_Null_Double1( GLdouble d0 ) {
+}
+
+/*
+* QGL_Null_Double2
+*/
+static void APIENTRY QGL_Null_Double2( GLdouble d0, GLdouble d1 ) {
+}
+
+/*
+* QGL_Null_Uniform1f
+*/
+static void APIENTRY QGL_Null_Uniform1f( GLint location, GLfloat v0 ) {
+}
+
+/*
+* QGL_Null_Uniform2f
+*/
+static void APIENTRY QGL_Null_Uniform2f( GLint location, GLfloat v0, GLfloat v1 ) {
+}
+
+/*
+* QGL_Null_Uniform3f
+*/
+static void APIENTRY QGL_Null_Uniform3f( GLint location, GLfloat v0, GLfloat v1, GLfloat v2 ) {
+}
+
+/*
+* QGL_Null_Uniform4f
+*/
+static void APIENTRY QGL_Null_Uniform4f( GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3 ) {
+}
+
+/*
+* QGL_Null_SampleCoverage
+*/
+static void APIENTRY QGL_Null_SampleCoverage( GLfloat value, GLboolean invert ) {
+}
+
+/*
+* QGL_Null_NoOp
+*/
+static void APIENTRY QGL_Null_NoOp( void ) {
+}
+
+typedef struct {
+	const char *name;
+	void *func;
+} qgl_null_func_t;
+
+// names without the ARB/EXT/OES suffixes
+static const qgl_null_func_t qgl_null_funcs[] =
+{
+	{ "glGetString", (void *)QGL_Null_GetString },
+	{ "glGetIntegerv", (void *)QGL_Null_GetIntegerv },
+	{ "glGetError", (void *)QGL_Null_GetError },
+	{ "glIsRenderbuffer", (void *)QGL_Null_IsObject },
+	{ "glIsFramebuffer", (void *)QGL_Null_IsObject },
+
+	{ "glClearColor", (void *)QGL_Null_Float4 },
+	{ "glPolygonOffset", (void *)QGL_Null_Float2 },
+	{ "glClearDepth", (void *)QGL_Null_Double1 },
+	{ "glDepthRange", (void *)QGL_Null_Double2 },
+	{ "glClearDepthf", (void *)QGL_Null_Float1 },
+	{ "glDepthRangef", (void *)QGL_Null_Float2 },
+	{ "glSampleCoverage", (void *)QGL_Null_SampleCoverage },
+	{ "glUniform1f", (void *)QGL_Null_Uniform1f },
+	{ "glUniform2f", (void *)QGL_Null_Uniform2f },
+	{ "glUniform3f", (void *)QGL_Null_Uniform3f },
+	{ "glUniform4f", (void *)QGL_Null_Uniform4f },
+
+	{ "glGenTextures", (void *)QGL_Null_GenNames },
+	{ "glGenBuffers", (void *)QGL_Null_GenNames },
+	{ "glGenFramebuffers", (void *)QGL_Null_GenNames },
+	{ "glGenRenderbuffers", (void *)QGL_Null_GenNames },
+	{ "glCreateShader", (void *)QGL_Null_CreateObject },
+	{ "glCreateShaderObject", (void *)QGL_Null_CreateObject },
+	{ "glCreateProgram", (void *)QGL_Null_CreateObject },
+	{ "glCreateProgramObject", (void *)QGL_Null_CreateObject },
+
+	{ "glGetShaderiv", (void *)QGL_Null_GetObjectiv },
+	{ "glGetProgramiv", (void *)QGL_Null_GetObjectiv },
+	{ "glGetObjectParameteriv", (void *)QGL_Null_GetObjectiv },
+	{ "glGetShaderInfoLog", (void *)QGL_Null_GetInfoLog },
+	{ "glGetProgramInfoLog", (void *)QGL_Null_GetInfoLog },
+	{ "glGetInfoLog", (void *)QGL_Null_GetInfoLog },
+	{ "glGetUniformLocation", (void *)QGL_Null_GetLocation },
+	{ "glGetAttribLocation", (void *)QGL_Null_GetLocation },
+	{ "glCheckFramebufferStatus", (void *)QGL_Null_CheckFramebufferStatus },
+
+	{ "glActiveTexture", (void *)QGL_Null_ActiveTexture },
+	{ "glBindTexture", (void *)QGL_Null_BindTexture },
+	{ "glDeleteTextures", (void *)QGL_Null_DeleteTextures },
+	{ "glTexImage2D", (void *)QGL_Null_TexImage2D },
+	{ "glTexSubImage2D", (void *)QGL_Null_TexSubImage2D },
+	{ "glTexImage3D", (void *)QGL_Null_TexImage3D },
+	{ "glTexSubImage3D", (void *)QGL_Null_TexSubImage3D },
+	{ "glCompressedTexImage2D", (void *)QGL_Null_CompressedTexImage2D },
+	{ "glCompressedTexSubImage2D", (void *)QGL_Null_CompressedTexSubImage2D },
+
+	{ "glBindBuffer", (void *)QGL_Null_BindBuffer },
+	{ "glDeleteBuffers", (void *)QGL_Null_DeleteBuffers },
+	{ "glBufferData", (void *)QGL_Null_BufferData },
+	{ "glBufferSubData", (void *)QGL_Null_BufferSubData },
+
+	{ "glUseProgram", (void *)QGL_Null_UseProgram },
+	{ "glUseProgramObject", (void *)QGL_Null_UseProgram },
+	{ "glDrawArrays", (void *)QGL_Null_DrawArrays },
+	{ "glDrawElements", (void *)QGL_Null_DrawElements },
+	{ "glDrawRangeElements", (void *)QGL_Null_DrawRangeElements },
+	{ "glDrawArraysInstanced", (void *)QGL_Null_DrawArraysInstanced },
+	{ "glDrawElementsInstanced", (void *)QGL_Null_DrawElementsInstanced },
+
+	{ NULL, NULL }
+};
+
+/*
+** QGL_Shutdown
+**
+** Nulls out all the proc pointers and forgets all tracked objects.
+*/
+void QGL_Shutdown( void ) {
+#define QGL_FUNC( type, name, params ) ( q ## name ) = NULL;
+#define QGL_FUNC_OPT( type, name, params ) ( q ## name ) = NULL;
+#define QGL_EXT( type, name, params ) ( q ## name ) = NULL;
+#define QGL_WGL( type, name, params )
+#define QGL_WGL_EXT( type, name, params )
+#define QGL_GLX( type, name, params )
+#define QGL_GLX_EXT( type, name, params )
+#define QGL_EGL( type, name, params )
+#define QGL_EGL_EXT( type, name, params )
+
+#include "../ref_gl/qgl.h"
+
+#undef QGL_EGL_EXT
+#undef QGL_EGL
+#undef QGL_GLX_EXT
+#undef QGL_GLX
+#undef QGL_WGL_EXT
+#undef QGL_WGL
+#undef QGL_EXT
+#undef QGL_FUNC_OPT
+#undef QGL_FUNC
+
+	free( qgl_null.textures.sizes );
+	free( qgl_null.buffers.sizes );
+	memset( &qgl_null, 0, sizeof( qgl_null ) );
+}
+
+/*
+** QGL_Init
+**
+** Binds all qgl function pointers to the stubs.
+*/
+qgl_initerr_t QGL_Init( const char *dllname ) {
+	memset( &qgl_null, 0, sizeof( qgl_null ) );
+
+#define QGL_FUNC( type, name, params ) *( (void **)&q ## name ) = qglGetProcAddress( (const GLubyte *)#name );
+#define QGL_FUNC_OPT( type, name, params ) *( (void **)&q ## name ) = qglGetProcAddress( (const GLubyte *)#name );
+#define QGL_EXT( type, name, params ) ( q ## name ) = NULL;
+#define QGL_WGL( type, name, params )
+#define QGL_WGL_EXT( type, name, params )
+#define QGL_GLX( type, name, params )
+#define QGL_GLX_EXT( type, name, params )
+#define QGL_EGL( type, name, params )
+#define QGL_EGL_EXT( type, name, params )
+
+#include "../ref_gl/qgl.h"
+
+#undef QGL_EGL_EXT
+#undef QGL_EGL
+#undef QGL_GLX_EXT
+#undef QGL_GLX
+#undef QGL_WGL_EXT
+#undef QGL_WGL
+#undef QGL_EXT
+#undef QGL_FUNC_OPT
+#undef QGL_FUNC
+
+	qglGetGLWExtensionsString = _qglGetGLWExtensionsString;
+
+	Com_Printf( "Using the null OpenGL driver\n" );
+
+	return qgl_initerr_ok;
+}
+
+/*
+** QGL_GetDriverInfo
+*/
+const qgl_driverinfo_t *QGL_GetDriverInfo( void ) {
+	return NULL;
+}
+
+/*
+** qglGetProcAddress
+*/
+void *qglGetProcAddress( const GLubyte *procName ) {
+	char name[64];
+	size_t len;
+	const qgl_null_func_t *func;
+
+	Q_strncpyz( name, (const char *)procName, sizeof( name ) );
+	len = strlen( name );
+	if( len > 3 && ( !strcmp( name + len - 3, "ARB" ) || !strcmp( name + len - 3, "EXT" ) || !strcmp( name + len - 3, "OES" ) ) ) {
+		name[len - 3] = '\0';
+	}
+
+	for( func = qgl_null_funcs; func->name; func++ ) {
+		if( !strcmp( func->name, name ) ) {
+			return func->func;
+		}
+	}
+	return (void *)QGL_Null_NoOp;
+}
+
+/*
+** QGL_Null_GetStats
+*/
+void QGL_Null_GetStats( qgl_null_stats_t *stats, bool reset ) {
+	*stats = qgl_null.stats;
+	stats->textureMemory = qgl_null.textures.totalSize;
+	stats->bufferMemory = qgl_null.buffers.totalSize;
+
+	if( reset ) {
+		memset( &qgl_null.stats, 0, sizeof( qgl_null.stats ) );
+	}
+}
+
+/*
+** QGL_Null_FrameDone
+*/
+void QGL_Null_FrameDone( void ) {
+	qgl_null.stats.frames++;
+}
+
+/*
+** qglGetGLWExtensionsString
+*/
+static const char *_qglGetGLWExtensionsString( void ) {
+	return NULL;
+}
@@ -26,83 +26,177 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 /* Trie structure definitions */
 
+/*
+* The trie is a path-compressed radix tree. Nodes, child vectors and edge labels
+* live in three contiguous pools and refer to each other by index, so a lookup
+* touches one small node and one short vector of first letters per edge instead
+* of chasing a heap pointer for every character of the key.
+*/
+
+#define TRIE_NONE               0xFFFFFFFFu
+#define TRIE_MAX_CHILD_BITS     8           // a node has at most 256 children
+#define TRIE_MIN_GARBAGE        4096        // don't bother compacting labels below this
+
 struct trie_node_s {
-	int depth;
-	char letter;
-	struct trie_node_s *child;
-	struct trie_node_s *sibling;
-	int data_is_set;
+	unsigned int label;         // offset of the edge label in trie->labels
+	unsigned int labellen;
+	unsigned int children;      // offset of the child vector in trie->edges, next free node if unused
+	unsigned short numchildren;
+	unsigned char childbits;    // capacity of the child vector is 1<<childbits
+	unsigned char data_is_set;
 	void *data;
 };
 
 struct trie_s {
-	struct trie_node_s *root;
+	struct trie_node_s *nodes;  // nodes[0] is the root, which has an empty label
+	unsigned int numnodes;
+	unsigned int maxnodes;
+	unsigned int freenodes;
+
+	unsigned int *edges;        // child node numbers
+	unsigned char *letters;     // (case folded) first letters of the children, sorted
+	unsigned int numedges;
+	unsigned int maxedges;
+	unsigned int freeedges[TRIE_MAX_CHILD_BITS + 1];
+
+	char *labels;
+	unsigned int labelslen;
+	unsigned int maxlabels;
+	unsigned int garbage;       // bytes of labels no longer referenced by any node
+
 	unsigned int size;
 	trie_casing_t casing;
 };
 
-typedef enum trie_remove_result_t {
-	TRIE_REMOVE_NO_CHILDREN_OR_DATA_LEFT = 0,
-	TRIE_REMOVE_CHILDREN_OR_DATA_LEFT = 1,
-	TRIE_REMOVE_DATA_LEFT,
-	TRIE_REMOVE_KEY_NOT_FOUND
-} trie_remove_result_t;
+typedef struct trie_keybuf_s {
+	char *buf;
+	size_t len;
+	size_t size;
+} trie_keybuf_t;
+
+typedef struct trie_dumpstate_s {
+	trie_dump_what_t what;
+	int ( *predicate )( void *value, void *cookie );
+	void *cookie;
+	trie_keybuf_t path;
+	trie_keybuf_t keys;
+	struct trie_key_value_s *vector;
+	unsigned int size;
+	unsigned int maxsize;
+} trie_dumpstate_t;
 
 /* Forward declarations of internal implementation */
 
-static struct trie_node_s *Trie_CreateNode(
-	int depth,
-	char letter,
-	struct trie_node_s *child,
-	struct trie_node_s *sibling,
-	int data_is_set,
-	void *data
+static void Trie_Reset(
+	struct trie_s *trie
 	);
 
-static void Trie_Destroy_Rec(
-	struct trie_node_s *node
+static unsigned int Trie_AllocNode(
+	struct trie_s *trie
 	);
 
-static struct trie_node_s *TRIE_Find_Rec(
-	struct trie_node_s *node,
-	const char *key,
-	trie_find_mode_t mode,
-	trie_casing_t casing,
-	int ( *predicate )( void *value, void *cookie ),
-	void *cookie
+static void Trie_FreeNode(
+	struct trie_s *trie,
+	unsigned int node
 	);
 
-static int Trie_Insert_Rec(
-	struct trie_node_s *node,
-	const char *key,
-	trie_casing_t casing,
-	void *data
+static unsigned int Trie_AllocEdges(
+	struct trie_s *trie,
+	unsigned int bits
 	);
 
-static trie_remove_result_t Trie_Remove_Rec(
-	struct trie_node_s *node,
+static void Trie_FreeEdges(
+	struct trie_s *trie,
+	unsigned int offset,
+	unsigned int bits
+	);
+
+static void Trie_ReserveLabels(
+	struct trie_s *trie,
+	size_t len
+	);
+
+static unsigned int Trie_AddLabel(
+	struct trie_s *trie,
+	const char *label,
+	size_t len
+	);
+
+static void Trie_CompactLabels(
+	struct trie_s *trie
+	);
+
+static unsigned int Trie_FindChild(
+	const struct trie_s *trie,
+	unsigned int node,
+	unsigned char letter
+	);
+
+static void Trie_AddChild(
+	struct trie_s *trie,
+	unsigned int node,
+	unsigned char letter,
+	unsigned int child
+	);
+
+static void Trie_RemoveChild(
+	struct trie_s *trie,
+	unsigned int node,
+	unsigned int pos
+	);
+
+static void Trie_SplitNode(
+	struct trie_s *trie,
+	unsigned int node,
+	unsigned int len
+	);
+
+static void Trie_MergeChild(
+	struct trie_s *trie,
+	unsigned int node
+	);
+
+static unsigned int Trie_FindNode(
+	const struct trie_s *trie,
 	const char *key,
-	trie_casing_t casing,
-	void **data
+	trie_find_mode_t mode,
+	unsigned int *parent,
+	trie_keybuf_t *path
+	);
+
+static unsigned int Trie_FindFirst_Rec(
+	const struct trie_s *trie,
+	unsigned int node,
+	int ( *predicate )( void *value, void *cookie ),
+	void *cookie
 	);
 
 static unsigned int Trie_NoOfKeys(
-	const struct trie_node_s *node,
-	trie_casing_t casing,
+	const struct trie_s *trie,
+	unsigned int node,
 	int ( *predicate )( void *value, void *cookie ),
-	void *cookie,
-	int addSiblings
+	void *cookie
 	);
 
 static void Trie_Dump_Rec(
-	const struct trie_node_s *node,
-	trie_dump_what_t what,
-	trie_casing_t casing,
-	int ( *predicate )( void *value, void *cookie ),
-	void *cookie,
-	int dumpSiblings,
-	const char *key_prev,
-	struct trie_key_value_s **key_value_vector
+	const struct trie_s *trie,
+	unsigned int node,
+	trie_dumpstate_t *state
+	);
+
+static void Trie_Build_Rec(
+	struct trie_s *trie,
+	unsigned int node,
+	struct trie_key_value_s *items,
+	struct trie_key_value_s *temp,
+	unsigned int numitems,
+	size_t depth
+	);
+
+static void Trie_KeyAppend(
+	trie_keybuf_t *keybuf,
+	const char *str,
+	size_t len
 	);
 
 static int Trie_AlwaysTrue(
@@ -110,9 +204,8 @@ static int Trie_AlwaysTrue(
 	void *
 	);
 
-static inline int Trie_LetterCompare(
-	char left,
-	char right,
+static inline unsigned char Trie_Fold(
+	char c,
 	trie_casing_t casing
 	);
 
@@ -124,9 +217,10 @@ trie_error_t Trie_Create(
 	) {
 	if( trie ) {
 		*trie = (struct trie_s *) malloc( sizeof( struct trie_s ) );
-		( *trie )->root = Trie_CreateNode( 0, '\0', NULL, NULL, 0, NULL );
-		( *trie )->size = 0;
+		assert( *trie );
+		memset( *trie, 0, sizeof( struct trie_s ) );
 		( *trie )->casing = casing;
+		Trie_Reset( *trie );
 		return TRIE_OK;
 	} else {
 		return TRIE_INVALID_ARGUMENT;
@@ -137,7 +231,10 @@ trie_error_t Trie_Destroy(
 	struct trie_s *trie
 	) {
 	if( trie ) {
-		Trie_Destroy_Rec( trie->root );
+		free( trie->nodes );
+		free( trie->edges );
+		free( trie->letters );
+		free( trie->labels );
 		free( trie );
 		return TRIE_OK;
 	} else {
@@ -149,9 +246,7 @@ trie_error_t Trie_Clear(
 	struct trie_s *trie
 	) {
 	if( trie ) {
-		Trie_Destroy_Rec( trie->root );
-		trie->root = Trie_CreateNode( 0, '\0', NULL, NULL, 0, NULL );
-		trie->size = 0;
+		Trie_Reset( trie );
 		return TRIE_OK;
 	} else {
 		return TRIE_INVALID_ARGUMENT;
@@ -170,23 +265,159 @@ trie_error_t Trie_GetSize(
 	}
 }
 
+trie_error_t Trie_GetMemoryUsage(
+	struct trie_s *trie,
+	size_t *bytes
+	) {
+	if( trie && bytes ) {
+		*bytes = sizeof( struct trie_s )
+				 + trie->maxnodes * sizeof( struct trie_node_s )
+				 + trie->maxedges * ( sizeof( unsigned int ) + sizeof( unsigned char ) )
+				 + trie->maxlabels;
+		return TRIE_OK;
+	} else {
+		return TRIE_INVALID_ARGUMENT;
+	}
+}
+
 trie_error_t Trie_Insert(
 	struct trie_s *trie,
 	const char *key,
 	void *data
 	) {
-	if( trie && key ) {
-		if( !Trie_Insert_Rec( trie->root, key, trie->casing, data ) ) {
-			// insertion successful
+	unsigned int node, child, i;
+	struct trie_node_s *n;
+	const char *label;
+	unsigned char letter;
+	size_t len;
+
+	if( !trie || !key ) {
+		return TRIE_INVALID_ARGUMENT;
+	}
+
+	len = strlen( key );
+	if( len >= TRIE_NONE ) {
+		return TRIE_INVALID_ARGUMENT;
+	}
+
+	Trie_CompactLabels( trie );
+
+	node = 0;
+	for(;; ) {
+		n = &trie->nodes[node];
+		label = trie->labels + n->label;
+
+		// match as much of the edge label as we can
+		for( i = 0; i < n->labellen && key[i]; i++ ) {
+			if( Trie_Fold( label[i], trie->casing ) != Trie_Fold( key[i], trie->casing ) ) {
+				break;
+			}
+		}
+		if( i < n->labellen ) {
+			// the key diverges or ends in the middle of the label
+			Trie_SplitNode( trie, node, i );
+			n = &trie->nodes[node];
+		}
+		key += i;
+
+		if( !*key ) {
+			// end of key reached, set data
+			if( n->data_is_set ) {
+				return TRIE_DUPLICATE_KEY;
+			}
+			n->data = data;
+			n->data_is_set = 1;
 			++trie->size;
 			return TRIE_OK;
-		} else {
-			// key already in trie
-			return TRIE_DUPLICATE_KEY;
 		}
-	} else {
+
+		letter = Trie_Fold( *key, trie->casing );
+		i = Trie_FindChild( trie, node, letter );
+		if( i == TRIE_NONE ) {
+			break;
+		}
+
+		// descend to matching child
+		node = trie->edges[n->children + i];
+	}
+
+	// no matching child, the rest of the key becomes a new leaf
+	child = Trie_AllocNode( trie );
+	n = &trie->nodes[child];
+	n->label = Trie_AddLabel( trie, key, strlen( key ) );
+	n->labellen = (unsigned int)strlen( key );
+	n->data = data;
+	n->data_is_set = 1;
+	Trie_AddChild( trie, node, letter, child );
+
+	++trie->size;
+	return TRIE_OK;
+}
+
+trie_error_t Trie_InsertBulk(
+	struct trie_s *trie,
+	const struct trie_key_value_s *key_value_vector,
+	unsigned int count
+	) {
+	unsigned int i;
+	size_t labelslen;
+	struct trie_key_value_s *items;
+
+	if( !trie || ( count && !key_value_vector ) ) {
 		return TRIE_INVALID_ARGUMENT;
 	}
+	for( i = 0; i < count; i++ ) {
+		if( !key_value_vector[i].key ) {
+			return TRIE_INVALID_ARGUMENT;
+		}
+	}
+
+	if( trie->size ) {
+		// can only build from scratch, merge the keys one by one
+		for( i = 0; i < count; i++ ) {
+			void *data_old;
+			const struct trie_key_value_s *kv = &key_value_vector[i];
+			if( Trie_Replace( trie, kv->key, kv->value, &data_old ) == TRIE_KEY_NOT_FOUND ) {
+				Trie_Insert( trie, kv->key, kv->value );
+			}
+		}
+		return TRIE_OK;
+	}
+
+	if( !count ) {
+		return TRIE_OK;
+	}
+
+	// the keys are radix sorted on the way down, which needs a second vector
+	items = (struct trie_key_value_s *) malloc( sizeof( struct trie_key_value_s ) * count * 2 );
+	assert( items );
+	memcpy( items, key_value_vector, sizeof( struct trie_key_value_s ) * count );
+
+	labelslen = 0;
+	for( i = 0; i < count; i++ )
+		labelslen += strlen( items[i].key );
+
+	// a radix tree with n keys never has more than 2n nodes, so the pools
+	// are allocated once and the whole tree ends up laid out in key order
+	Trie_Reset( trie );
+	if( trie->maxnodes < 2 * count + 1 ) {
+		trie->maxnodes = 2 * count + 1;
+		trie->nodes = (struct trie_node_s *) realloc( trie->nodes, sizeof( struct trie_node_s ) * trie->maxnodes );
+		assert( trie->nodes );
+	}
+	Trie_ReserveLabels( trie, labelslen );
+
+	Trie_Build_Rec( trie, 0, items, items + count, count, 0 );
+
+	// nothing will be wasted until the next insertion or removal
+	trie->maxnodes = trie->numnodes;
+	trie->nodes = (struct trie_node_s *) realloc( trie->nodes, sizeof( struct trie_node_s ) * trie->maxnodes );
+	trie->maxlabels = trie->labelslen ? trie->labelslen : 1;
+	trie->labels = (char *) realloc( trie->labels, trie->maxlabels );
+	assert( trie->nodes && trie->labels );
+
+	free( items );
+	return TRIE_OK;
 }
 
 trie_error_t Trie_Remove(
@@ -194,17 +425,48 @@ trie_error_t Trie_Remove(
 	const char *key,
 	void **data
 	) {
-	if( trie && key && data ) {
-		if( Trie_Remove_Rec( trie->root, key, trie->casing, data ) != TRIE_REMOVE_KEY_NOT_FOUND ) {
-			// removal successful
-			--trie->size;
+	unsigned int node, parent;
+	struct trie_node_s *n;
+
+	if( !trie || !key || !data ) {
+		return TRIE_INVALID_ARGUMENT;
+	}
+
+	Trie_CompactLabels( trie );
+
+	node = Trie_FindNode( trie, key, TRIE_EXACT_MATCH, &parent, NULL );
+	if( node == TRIE_NONE ) {
+		return TRIE_KEY_NOT_FOUND;
+	}
+
+	n = &trie->nodes[node];
+	*data = n->data;
+	n->data = NULL;
+	n->data_is_set = 0;
+	--trie->size;
+
+	if( !node ) {
+		// the root always stays
+		return TRIE_OK;
+	}
+
+	if( !n->numchildren ) {
+		// drop the leaf, its parent may now be left with a single child
+		Trie_RemoveChild( trie, parent, Trie_FindChild( trie, parent, Trie_Fold( trie->labels[n->label], trie->casing ) ) );
+		trie->garbage += n->labellen;
+		Trie_FreeNode( trie, node );
+		node = parent;
+		if( !node ) {
 			return TRIE_OK;
-		} else {
-			return TRIE_KEY_NOT_FOUND;
 		}
-	} else {
-		return TRIE_INVALID_ARGUMENT;
+		n = &trie->nodes[node];
+	}
+
+	if( !n->data_is_set && n->numchildren == 1 ) {
+		Trie_MergeChild( trie, node );
 	}
+
+	return TRIE_OK;
 }
 
 trie_error_t Trie_Replace(
@@ -214,11 +476,11 @@ trie_error_t Trie_Replace(
 	void **data_old
 	) {
 	if( trie && key ) {
-		struct trie_node_s *result = TRIE_Find_Rec( trie->root, key, TRIE_EXACT_MATCH, trie->casing, Trie_AlwaysTrue, NULL );
-		if( result ) {
+		unsigned int node = Trie_FindNode( trie, key, TRIE_EXACT_MATCH, NULL, NULL );
+		if( node != TRIE_NONE ) {
 			// key found, replace data pointer
-			*data_old = result->data;
-			result->data = data_new;
+			*data_old = trie->nodes[node].data;
+			trie->nodes[node].data = data_new;
 			return TRIE_OK;
 		} else {
 			return TRIE_KEY_NOT_FOUND;
@@ -245,23 +507,24 @@ trie_error_t Trie_FindIf(
 	void *cookie,
 	void **data
 	) {
-	if( trie && key && data ) {
-		const struct trie_node_s *result = TRIE_Find_Rec( trie->root, key, mode, trie->casing, predicate, cookie );
-		if( result ) {
-			while( result->child && !result->data_is_set ) {
-				const struct trie_node_s *sibling;
-				for( sibling = result; sibling->sibling && !sibling->data_is_set; sibling = sibling->sibling )
-					/* search for sibling with data */;
-				if( sibling->data_is_set ) {
-					// sibling found, make it the result
-					result = sibling;
-					break;
-				}
-				// descend
-				result = result->child;
+	if( trie && key && data && predicate ) {
+		unsigned int node = Trie_FindNode( trie, key, mode, NULL, NULL );
+		if( node == 0 && mode == TRIE_PREFIX_MATCH && !trie->size ) {
+			// the empty prefix always matches the root, even when the trie is empty
+			*data = NULL;
+			return TRIE_OK;
+		}
+		if( node != TRIE_NONE ) {
+			if( mode == TRIE_PREFIX_MATCH ) {
+				// the first key in order which begins with the prefix
+				node = Trie_FindFirst_Rec( trie, node, predicate, cookie );
+			} else if( !predicate( trie->nodes[node].data, cookie ) ) {
+				node = TRIE_NONE;
 			}
-			assert( result->data_is_set );
-			*data = result->data;
+		}
+		if( node != TRIE_NONE ) {
+			assert( trie->nodes[node].data_is_set );
+			*data = trie->nodes[node].data;
 			return TRIE_OK;
 		} else {
 			*data = NULL;
@@ -287,10 +550,10 @@ trie_error_t Trie_NoOfMatchesIf(
 	void *cookie,
 	unsigned int *matches
 	) {
-	if( trie && prefix && matches ) {
-		struct trie_node_s *node = TRIE_Find_Rec( trie->root, prefix, TRIE_PREFIX_MATCH, trie->casing, predicate, cookie );
-		*matches = node
-				   ? Trie_NoOfKeys( node, trie->casing, predicate, cookie, 0 )
+	if( trie && prefix && matches && predicate ) {
+		unsigned int node = Trie_FindNode( trie, prefix, TRIE_PREFIX_MATCH, NULL, NULL );
+		*matches = node != TRIE_NONE
+				   ? Trie_NoOfKeys( trie, node, predicate, cookie )
 				   : 0;
 		return TRIE_OK;
 	} else {
@@ -315,20 +578,44 @@ trie_error_t Trie_DumpIf(
 	void *cookie,
 	struct trie_dump_s **dump
 	) {
-	if( prefix && dump && predicate ) {
-		struct trie_node_s *result = TRIE_Find_Rec( trie->root, prefix, TRIE_PREFIX_MATCH, trie->casing, predicate, cookie );
-		*dump = (struct trie_dump_s *) malloc( sizeof( struct trie_dump_s ) );
-		// prefix matches some nodes, begin dump
-		if( result ) {
-			( *dump )->size = Trie_NoOfKeys( result, trie->casing, predicate, cookie, 0 );
-			( *dump )->what = what;
-			( *dump )->key_value_vector = (struct trie_key_value_s *) malloc( sizeof( struct trie_key_value_s ) * ( ( *dump )->size + 1 ) );
-			Trie_Dump_Rec( result, what, trie->casing, predicate, cookie, 0, prefix, &( *dump )->key_value_vector );
-			( *dump )->key_value_vector -= ( *dump )->size;
-		} else {
-			( *dump )->key_value_vector = NULL;
-			( *dump )->size = 0;
+	if( trie && prefix && dump && predicate ) {
+		unsigned int i, node;
+		trie_dumpstate_t state;
+
+		memset( &state, 0, sizeof( state ) );
+		state.what = what;
+		state.predicate = predicate;
+		state.cookie = cookie;
+
+		node = Trie_FindNode( trie, prefix, TRIE_PREFIX_MATCH, NULL, &state.path );
+		if( node != TRIE_NONE ) {
+			// prefix matches some nodes, begin dump
+			Trie_Dump_Rec( trie, node, &state );
 		}
+
+		if( what & TRIE_DUMP_KEYS ) {
+			size_t prefixlen = strlen( prefix );
+
+			// keys were stored as offsets as the storage may have moved while growing
+			for( i = 0; i < state.size; i++ ) {
+				char *key = state.keys.buf + (size_t)state.vector[i].key;
+
+				// all but the last letter of the prefix keep the casing they were asked with
+				if( prefixlen > 1 ) {
+					memcpy( key, prefix, prefixlen - 1 );
+				}
+				state.vector[i].key = key;
+			}
+		}
+
+		*dump = (struct trie_dump_s *) malloc( sizeof( struct trie_dump_s ) );
+		assert( *dump );
+		( *dump )->size = state.size;
+		( *dump )->what = what;
+		( *dump )->key_value_vector = state.vector;
+		( *dump )->key_storage = state.keys.buf;
+
+		free( state.path.buf );
 		return TRIE_OK;
 	} else {
 		return TRIE_INVALID_ARGUMENT;
@@ -339,11 +626,7 @@ trie_error_t Trie_FreeDump(
 	struct trie_dump_s *dump
 	) {
 	if( dump ) {
-		unsigned int i;
-		for( i = 0; i < dump->size; ++i )
-			if( dump->key_value_vector[i].key ) {
-				free( (char *) dump->key_value_vector[i].key );
-			}
+		free( dump->key_storage );
 		free( dump->key_value_vector );
 		free( dump );
 	}
@@ -352,267 +635,556 @@ trie_error_t Trie_FreeDump(
 
 /* Internal implementations */
 
-static struct trie_node_s *Trie_CreateNode(
-	int depth,
-	char letter,
-	struct trie_node_s *child,
-	struct trie_node_s *sibling,
-	int data_is_set,
-	void *data
+static void Trie_Reset(
+	struct trie_s *trie
+	) {
+	unsigned int i;
+
+	trie->numnodes = 0;
+	trie->freenodes = TRIE_NONE;
+	trie->numedges = 0;
+	for( i = 0; i <= TRIE_MAX_CHILD_BITS; i++ )
+		trie->freeedges[i] = TRIE_NONE;
+	trie->labelslen = 0;
+	trie->garbage = 0;
+	trie->size = 0;
+
+	// the root
+	Trie_AllocNode( trie );
+}
+
+static unsigned int Trie_AllocNode(
+	struct trie_s *trie
 	) {
-	struct trie_node_s *result = (struct trie_node_s *) malloc( sizeof( struct trie_node_s ) );
-	assert( result );
-	result->depth = depth;
-	result->letter = letter;
-	result->child = child;
-	result->sibling = sibling;
-	result->data_is_set = data_is_set;
-	result->data = data;
-	return result;
+	unsigned int node;
+	struct trie_node_s *n;
+
+	if( trie->freenodes != TRIE_NONE ) {
+		node = trie->freenodes;
+		trie->freenodes = trie->nodes[node].children;
+	} else {
+		if( trie->numnodes == trie->maxnodes ) {
+			trie->maxnodes = trie->maxnodes ? trie->maxnodes * 2 : 16;
+			trie->nodes = (struct trie_node_s *) realloc( trie->nodes, sizeof( struct trie_node_s ) * trie->maxnodes );
+			assert( trie->nodes );
+		}
+		node = trie->numnodes++;
+	}
+
+	n = &trie->nodes[node];
+	n->label = 0;
+	n->labellen = 0;
+	n->children = TRIE_NONE;
+	n->numchildren = 0;
+	n->childbits = 0;
+	n->data_is_set = 0;
+	n->data = NULL;
+	return node;
+}
+
+static void Trie_FreeNode(
+	struct trie_s *trie,
+	unsigned int node
+	) {
+	assert( node && !trie->nodes[node].numchildren );
+	trie->nodes[node].children = trie->freenodes;
+	trie->freenodes = node;
 }
 
-static void Trie_Destroy_Rec(
-	struct trie_node_s *node
+static unsigned int Trie_AllocEdges(
+	struct trie_s *trie,
+	unsigned int bits
 	) {
-	assert( node );
-	if( node->sibling ) {
-		Trie_Destroy_Rec( node->sibling );
+	unsigned int offset;
+	unsigned int count = 1u << bits;
+
+	assert( bits <= TRIE_MAX_CHILD_BITS );
+
+	if( trie->freeedges[bits] != TRIE_NONE ) {
+		offset = trie->freeedges[bits];
+		trie->freeedges[bits] = trie->edges[offset];
+		return offset;
 	}
-	if( node->child ) {
-		Trie_Destroy_Rec( node->child );
+
+	if( trie->numedges + count > trie->maxedges ) {
+		while( trie->numedges + count > trie->maxedges )
+			trie->maxedges = trie->maxedges ? trie->maxedges * 2 : 32;
+		trie->edges = (unsigned int *) realloc( trie->edges, sizeof( unsigned int ) * trie->maxedges );
+		trie->letters = (unsigned char *) realloc( trie->letters, sizeof( unsigned char ) * trie->maxedges );
+		assert( trie->edges && trie->letters );
 	}
-	free( node );
+
+	offset = trie->numedges;
+	trie->numedges += count;
+	return offset;
 }
 
-static struct trie_node_s *TRIE_Find_Rec(
-	struct trie_node_s *node,
-	const char *key,
-	trie_find_mode_t mode,
-	trie_casing_t casing,
-	int ( *predicate )( void *value, void *cookie ),
-	void *cookie
+static void Trie_FreeEdges(
+	struct trie_s *trie,
+	unsigned int offset,
+	unsigned int bits
 	) {
-	assert( key );
-	assert( node );
-	if( !Trie_LetterCompare( *key, node->letter, casing ) ) {
-		// prefix matches
-		if( !*key || !*( key + 1 ) ) {
-			// end of key reached, see if node contains data
-			if( mode == TRIE_PREFIX_MATCH || node->data_is_set ) {
-				// node contains data or prefix match only, key is valid
-				return node;
-			} else {
-				// no data supplied, key only matches prefix of some node in trie
-				return NULL;
-			}
-		} else if( node->child ) {
-			// end of key not reached, continue with child
-			return TRIE_Find_Rec( node->child, key + 1, mode, casing, predicate, cookie );
-		} else {
-			// end of key not reached, but current node is a leaf
-			return NULL;
+	trie->edges[offset] = trie->freeedges[bits];
+	trie->freeedges[bits] = offset;
+}
+
+static void Trie_ReserveLabels(
+	struct trie_s *trie,
+	size_t len
+	) {
+	if( trie->labelslen + len > trie->maxlabels ) {
+		size_t maxlabels = trie->maxlabels ? trie->maxlabels : 256;
+		while( trie->labelslen + len > maxlabels )
+			maxlabels *= 2;
+		assert( maxlabels < TRIE_NONE );
+		trie->maxlabels = (unsigned int)maxlabels;
+		trie->labels = (char *) realloc( trie->labels, trie->maxlabels );
+		assert( trie->labels );
+	}
+}
+
+static unsigned int Trie_AddLabel(
+	struct trie_s *trie,
+	const char *label,
+	size_t len
+	) {
+	unsigned int offset;
+
+	Trie_ReserveLabels( trie, len );
+
+	offset = trie->labelslen;
+	memcpy( trie->labels + offset, label, len );
+	trie->labelslen += (unsigned int)len;
+	return offset;
+}
+
+static void Trie_CompactLabels(
+	struct trie_s *trie
+	) {
+	char *labels;
+	unsigned int i, labelslen;
+
+	if( trie->garbage < TRIE_MIN_GARBAGE || trie->garbage * 2 < trie->labelslen ) {
+		return;
+	}
+
+	// nodes on the free list have no label, clear them so they can be told apart
+	for( i = trie->freenodes; i != TRIE_NONE; i = trie->nodes[i].children )
+		trie->nodes[i].labellen = 0;
+
+	labels = (char *) malloc( trie->labelslen - trie->garbage + 1 );
+	assert( labels );
+
+	labelslen = 0;
+	for( i = 0; i < trie->numnodes; i++ ) {
+		struct trie_node_s *n = &trie->nodes[i];
+		if( n->labellen ) {
+			memcpy( labels + labelslen, trie->labels + n->label, n->labellen );
+			n->label = labelslen;
+			labelslen += n->labellen;
 		}
-	} else if( node->sibling && Trie_LetterCompare( node->sibling->letter, *key, casing ) <= 0 ) {
-		// prefix does not match, but we might have a matching sibling
-		return TRIE_Find_Rec( node->sibling, key, mode, casing, predicate, cookie );
-	} else if( !node->depth ) {
-		// node is root
-		if( !*key ) {
-			if( mode == TRIE_PREFIX_MATCH || node->data_is_set ) {
-				// key is "", return root
-				return node;
-			} else {
-				// key is "", but root does not contain data
-				return NULL;
-			}
-		} else if( node->child ) {
-			return TRIE_Find_Rec( node->child, key, mode, casing, predicate, cookie );
-		} else {
-			return NULL;
+	}
+	assert( labelslen == trie->labelslen - trie->garbage );
+
+	free( trie->labels );
+	trie->labels = labels;
+	trie->labelslen = labelslen;
+	trie->maxlabels = labelslen + 1;
+	trie->garbage = 0;
+}
+
+static unsigned int Trie_FindChild(
+	const struct trie_s *trie,
+	unsigned int node,
+	unsigned char letter
+	) {
+	unsigned int i;
+	const unsigned char *letters;
+	const struct trie_node_s *n = &trie->nodes[node];
+
+	if( !n->numchildren ) {
+		return TRIE_NONE;
+	}
+
+	// the vector is sorted and rarely longer than a cache line
+	letters = trie->letters + n->children;
+	for( i = 0; i < n->numchildren; i++ ) {
+		if( letters[i] >= letter ) {
+			return letters[i] == letter ? i : TRIE_NONE;
 		}
-	} else {
-		// prefix does not match, no matching siblings
-		return NULL;
 	}
+	return TRIE_NONE;
+}
+
+static void Trie_AddChild(
+	struct trie_s *trie,
+	unsigned int node,
+	unsigned char letter,
+	unsigned int child
+	) {
+	int i;
+	struct trie_node_s *n = &trie->nodes[node];
+
+	if( !n->numchildren ) {
+		n->children = Trie_AllocEdges( trie, 0 );
+		n->childbits = 0;
+	} else if( n->numchildren == ( 1u << n->childbits ) ) {
+		// grow the vector into the next size class
+		unsigned int children = Trie_AllocEdges( trie, n->childbits + 1 );
+		memcpy( trie->edges + children, trie->edges + n->children, sizeof( unsigned int ) * n->numchildren );
+		memcpy( trie->letters + children, trie->letters + n->children, sizeof( unsigned char ) * n->numchildren );
+		Trie_FreeEdges( trie, n->children, n->childbits );
+		n->children = children;
+		n->childbits++;
+	}
+
+	// keep the children sorted by letter
+	for( i = n->numchildren; i > 0 && trie->letters[n->children + i - 1] > letter; i-- ) {
+		trie->edges[n->children + i] = trie->edges[n->children + i - 1];
+		trie->letters[n->children + i] = trie->letters[n->children + i - 1];
+	}
+	trie->edges[n->children + i] = child;
+	trie->letters[n->children + i] = letter;
+	n->numchildren++;
+}
+
+static void Trie_RemoveChild(
+	struct trie_s *trie,
+	unsigned int node,
+	unsigned int pos
+	) {
+	struct trie_node_s *n = &trie->nodes[node];
+
+	assert( pos < n->numchildren );
+
+	n->numchildren--;
+	memmove( trie->edges + n->children + pos, trie->edges + n->children + pos + 1,
+			 sizeof( unsigned int ) * ( n->numchildren - pos ) );
+	memmove( trie->letters + n->children + pos, trie->letters + n->children + pos + 1,
+			 sizeof( unsigned char ) * ( n->numchildren - pos ) );
+
+	if( !n->numchildren ) {
+		Trie_FreeEdges( trie, n->children, n->childbits );
+		n->children = TRIE_NONE;
+		n->childbits = 0;
+	}
+}
+
+static void Trie_SplitNode(
+	struct trie_s *trie,
+	unsigned int node,
+	unsigned int len
+	) {
+	unsigned int tail;
+	struct trie_node_s *n, *t;
+
+	// the tail of the label, along with the children and data, moves to a new node
+	tail = Trie_AllocNode( trie );
+	n = &trie->nodes[node];
+	t = &trie->nodes[tail];
+
+	assert( len < n->labellen );
+	t->label = n->label + len;
+	t->labellen = n->labellen - len;
+	t->children = n->children;
+	t->numchildren = n->numchildren;
+	t->childbits = n->childbits;
+	t->data = n->data;
+	t->data_is_set = n->data_is_set;
+
+	n->labellen = len;
+	n->children = TRIE_NONE;
+	n->numchildren = 0;
+	n->childbits = 0;
+	n->data = NULL;
+	n->data_is_set = 0;
+
+	Trie_AddChild( trie, node, Trie_Fold( trie->labels[t->label], trie->casing ), tail );
 }
 
-static int Trie_Insert_Rec(
-	struct trie_node_s *node,
+static void Trie_MergeChild(
+	struct trie_s *trie,
+	unsigned int node
+	) {
+	unsigned int child, label;
+	struct trie_node_s *n, *c;
+
+	n = &trie->nodes[node];
+	assert( node && n->numchildren == 1 && !n->data_is_set );
+
+	child = trie->edges[n->children];
+	c = &trie->nodes[child];
+
+	// concatenate the labels, the old ones become garbage
+	Trie_ReserveLabels( trie, n->labellen + c->labellen );
+	label = Trie_AddLabel( trie, trie->labels + n->label, n->labellen );
+	Trie_AddLabel( trie, trie->labels + c->label, c->labellen );
+	trie->garbage += n->labellen + c->labellen;
+
+	Trie_FreeEdges( trie, n->children, n->childbits );
+
+	n->label = label;
+	n->labellen += c->labellen;
+	n->children = c->children;
+	n->numchildren = c->numchildren;
+	n->childbits = c->childbits;
+	n->data = c->data;
+	n->data_is_set = c->data_is_set;
+
+	c->numchildren = 0;
+	Trie_FreeNode( trie, child );
+}
+
+static unsigned int Trie_FindNode(
+	const struct trie_s *trie,
 	const char *key,
-	trie_casing_t casing,
-	void *data
+	trie_find_mode_t mode,
+	unsigned int *parent,
+	trie_keybuf_t *path
 	) {
+	unsigned int i, node, prev;
+	const struct trie_node_s *n;
+	const char *label;
+
 	assert( key );
-	assert( node );
-	if( !node->depth || !Trie_LetterCompare( *key, node->letter, casing ) ) {
-		// node is root or prefix matches
-		if( ( !node->depth && !*key ) || ( node->depth && !*( key + 1 ) ) ) {
-			// end of key reached, set data
-			if( !node->data_is_set ) {
-				node->data = data;
-				node->data_is_set = 1;
-				return TRIE_OK;
-			} else {
-				return TRIE_DUPLICATE_KEY;
+
+	node = 0;
+	prev = TRIE_NONE;
+	for(;; ) {
+		n = &trie->nodes[node];
+		label = trie->labels + n->label;
+
+		for( i = 0; i < n->labellen; i++ ) {
+			if( !key[i] ) {
+				// key ends in the middle of the label, only matches as a prefix
+				if( mode != TRIE_PREFIX_MATCH ) {
+					return TRIE_NONE;
+				}
+				break;
 			}
-		} else {
-			// not end of key, descend to child
-			const char *const nextKey = node->depth
-										? key + 1
-										: key;
-			if( !node->child || Trie_LetterCompare( node->child->letter, *nextKey, casing ) > 0 ) {
-				// no matching child, create one
-				node->child = Trie_CreateNode( node->depth + 1, *nextKey, NULL, node->child, 0, NULL );
+			if( Trie_Fold( label[i], trie->casing ) != Trie_Fold( key[i], trie->casing ) ) {
+				return TRIE_NONE;
 			}
-			// descend to matching child
-			return Trie_Insert_Rec( node->child, nextKey, casing, data );
 		}
-	} else {
-		assert( node->depth );
-		if( !node->sibling || Trie_LetterCompare( node->sibling->letter, *key, casing ) > 0 ) {
-			node->sibling = Trie_CreateNode( node->depth, *key, NULL, node->sibling, 0, NULL );
+		key += i;
+
+		if( !*key ) {
+			// end of key reached, see if node contains data
+			if( mode == TRIE_PREFIX_MATCH || n->data_is_set ) {
+				break;
+			}
+			return TRIE_NONE;
+		}
+
+		i = Trie_FindChild( trie, node, Trie_Fold( *key, trie->casing ) );
+		if( i == TRIE_NONE ) {
+			return TRIE_NONE;
+		}
+
+		if( path ) {
+			Trie_KeyAppend( path, label, n->labellen );
 		}
-		return Trie_Insert_Rec( node->sibling, key, casing, data );
+		prev = node;
+		node = trie->edges[n->children + i];
 	}
+
+	if( parent ) {
+		*parent = prev;
+	}
+	return node;
 }
 
-static trie_remove_result_t Trie_Remove_Rec(
-	struct trie_node_s *node,
-	const char *key,
-	trie_casing_t casing,
-	void **data
+static unsigned int Trie_FindFirst_Rec(
+	const struct trie_s *trie,
+	unsigned int node,
+	int ( *predicate )( void *value, void *cookie ),
+	void *cookie
 	) {
-	trie_remove_result_t status;
-	assert( node );
-	assert( key );
-	if( node->depth && Trie_LetterCompare( node->letter, *key, casing ) < 0 ) {
-		// node is not root and prefix does not match
-		if( node->sibling ) {
-			// call recursively for sibling
-			status = Trie_Remove_Rec( node->sibling, key, casing, data );
-			if( status == TRIE_REMOVE_NO_CHILDREN_OR_DATA_LEFT ) {
-				// sibling node has no children or data, free it and preserve siblings
-				struct trie_node_s *sibling = node->sibling->sibling;
-				free( node->sibling );
-				node->sibling = sibling;
-				// ch : is this right?
-				// return ( node->child != NULL ) || ( node->data_is_set );
-				return ( node->child != NULL ) || ( node->data_is_set ) ? TRIE_REMOVE_CHILDREN_OR_DATA_LEFT : TRIE_REMOVE_NO_CHILDREN_OR_DATA_LEFT;
-			} else {
-				return status;
-			}
-		} else {
-			// key not found
-			return TRIE_REMOVE_KEY_NOT_FOUND;
-		}
-	} else if( !node->depth || !Trie_LetterCompare( node->letter, *key, casing ) ) {
-		// prefix matches or node is root, check for end of key
-		if( !( !node->depth && !*key ) && !( node->depth && !*( key + 1 ) ) ) {
-			// not end of key, descend
-			if( node->child ) {
-				status = Trie_Remove_Rec( node->child, node->depth ? key + 1 : key, casing, data );
-				if( !status ) {
-					// child node has no children, free it and preserve siblings
-					struct trie_node_s *sibling = node->child->sibling;
-					free( node->child );
-					node->child = sibling;
-					// ch : is this right?
-					// return ( node->child != NULL ) || ( node->data_is_set );
-					return ( node->child != NULL ) || ( node->data_is_set ) ? TRIE_REMOVE_CHILDREN_OR_DATA_LEFT : TRIE_REMOVE_NO_CHILDREN_OR_DATA_LEFT;
-				} else {
-					return status;
-				}
-			} else {
-				// key not found
-				return TRIE_REMOVE_KEY_NOT_FOUND;
-			}
-		} else {
-			// end of key
-			*data = node->data;
-			node->data = NULL;
-			node->data_is_set = 0;
-			// ch : is this right?
-			// return ( node->child != 0 );
-			return ( node->child != 0 ) ? TRIE_REMOVE_CHILDREN_OR_DATA_LEFT : TRIE_REMOVE_NO_CHILDREN_OR_DATA_LEFT;
+	unsigned int i, found;
+	const struct trie_node_s *n = &trie->nodes[node];
+
+	if( n->data_is_set && predicate( n->data, cookie ) ) {
+		return node;
+	}
+	for( i = 0; i < n->numchildren; i++ ) {
+		found = Trie_FindFirst_Rec( trie, trie->edges[n->children + i], predicate, cookie );
+		if( found != TRIE_NONE ) {
+			return found;
 		}
-	} else {
-		// key not found
-		return TRIE_REMOVE_KEY_NOT_FOUND;
 	}
+	return TRIE_NONE;
 }
 
 static unsigned int Trie_NoOfKeys(
-	const struct trie_node_s *node,
-	trie_casing_t casing,
+	const struct trie_s *trie,
+	unsigned int node,
 	int ( *predicate )( void *value, void *cookie ),
-	void *cookie,
-	int addSiblings
+	void *cookie
 	) {
-	unsigned int noOfKeys;
-	assert( node );
+	unsigned int i, noOfKeys;
+	const struct trie_node_s *n = &trie->nodes[node];
+
 	assert( predicate );
+
 	// if data is set, we have a data node, otherwise just a prefix node
-	if( node->data_is_set && predicate( node->data, cookie ) ) {
+	if( n->data_is_set && predicate( n->data, cookie ) ) {
 		noOfKeys = 1;
 	} else {
 		noOfKeys = 0;
 	}
-	// recursively add siblings and children
-	if( addSiblings && node->sibling ) {
-		noOfKeys += Trie_NoOfKeys( node->sibling, casing, predicate, cookie, 1 );
-	}
-	if( node->child ) {
-		noOfKeys += Trie_NoOfKeys( node->child, casing, predicate, cookie, 1 );
-	}
+	for( i = 0; i < n->numchildren; i++ )
+		noOfKeys += Trie_NoOfKeys( trie, trie->edges[n->children + i], predicate, cookie );
 	return noOfKeys;
 }
 
 static void Trie_Dump_Rec(
-	const struct trie_node_s *node,
-	trie_dump_what_t what,
-	trie_casing_t casing,
-	int ( *predicate )( void *value, void *cookie ),
-	void *cookie,
-	int dumpSiblings,
-	const char *key_prev,
-	struct trie_key_value_s **key_value_vector
-	) {
-	char *key = NULL;
-	int keyDumped = 0;
-	if( what & TRIE_DUMP_KEYS ) {
-		key = (char *) malloc( sizeof( char ) * ( node->depth + 1 ) );
-		strncpy( key, key_prev, node->depth ); // copy previous key
-		if( node->depth ) {
-			key[node->depth - 1] = node->letter; // append/replace letter
+	const struct trie_s *trie,
+	unsigned int node,
+	trie_dumpstate_t *state
+	) {
+	unsigned int i;
+	const struct trie_node_s *n = &trie->nodes[node];
+
+	Trie_KeyAppend( &state->path, trie->labels + n->label, n->labellen );
+
+	if( n->data_is_set && state->predicate( n->data, state->cookie ) ) {
+		struct trie_key_value_s *kv;
+
+		if( state->size == state->maxsize ) {
+			state->maxsize = state->maxsize ? state->maxsize * 2 : 16;
+			state->vector = (struct trie_key_value_s *) realloc( state->vector, sizeof( struct trie_key_value_s ) * state->maxsize );
+			assert( state->vector );
+		}
+
+		kv = &state->vector[state->size++];
+		kv->key = NULL;
+		kv->value = ( state->what & TRIE_DUMP_VALUES )
+					? n->data
+					: NULL;
+
+		if( state->what & TRIE_DUMP_KEYS ) {
+			// dump key, remember its offset for now
+			kv->key = (const char *)state->keys.len;
+			Trie_KeyAppend( &state->keys, state->path.buf, state->path.len + 1 );
 		}
-		key[node->depth] = '\0';        // terminate key string
 	}
-	if( node->data_is_set && predicate( node->data, cookie ) ) {
-		// dump key and values if requested
-		if( what & TRIE_DUMP_KEYS ) {
-			keyDumped = 1;
-			( *key_value_vector )->key = key;
+
+	// dump children, they are sorted already
+	for( i = 0; i < n->numchildren; i++ )
+		Trie_Dump_Rec( trie, trie->edges[n->children + i], state );
+
+	state->path.len -= n->labellen;
+	state->path.buf[state->path.len] = '\0';
+}
+
+static void Trie_Build_Rec(
+	struct trie_s *trie,
+	unsigned int node,
+	struct trie_key_value_s *items,
+	struct trie_key_value_s *temp,
+	unsigned int numitems,
+	size_t depth
+	) {
+	unsigned int i, j, k, first, bits;
+	unsigned int counts[256];
+	unsigned char letter;
+	struct trie_node_s *n;
+
+	// all items share the first depth characters, keys that end here put data
+	// on this node and the last one inserted wins, like with Trie_Replace
+	for( i = 0, j = 0; i < numitems; i++ ) {
+		if( !items[i].key[depth] ) {
+			n = &trie->nodes[node];
+			if( !n->data_is_set ) {
+				trie->size++;
+			}
+			n->data = items[i].value;
+			n->data_is_set = 1;
 		} else {
-			( *key_value_vector )->key = NULL;
+			items[j++] = items[i];
+		}
+	}
+	numitems = j;
+	if( !numitems ) {
+		return;
+	}
+
+	// stable counting sort on the next letter, each bucket becomes a child
+	memset( counts, 0, sizeof( counts ) );
+	for( i = 0; i < numitems; i++ )
+		counts[Trie_Fold( items[i].key[depth], trie->casing )]++;
+	for( i = 0, j = 0, k = 0; i < 256; i++ ) {
+		unsigned int count = counts[i];
+		counts[i] = j;
+		j += count;
+		k += count ? 1 : 0;
+	}
+	for( i = 0; i < numitems; i++ )
+		temp[counts[Trie_Fold( items[i].key[depth], trie->casing )]++] = items[i];
+	memcpy( items, temp, sizeof( *items ) * numitems );
+
+	for( bits = 0; ( 1u << bits ) < k; bits++ ) ;
+
+	n = &trie->nodes[node];
+	n->children = Trie_AllocEdges( trie, bits );
+	n->childbits = bits;
+
+	// allocate all siblings first so they are adjacent in memory
+	first = trie->numnodes;
+	for( i = 0, k = 0; i < numitems; i = j, k++ ) {
+		unsigned int child;
+		size_t lcp, m;
+		const char *key = items[i].key + depth;
+
+		letter = Trie_Fold( *key, trie->casing );
+
+		// the edge label is the prefix shared by the whole bucket
+		lcp = strlen( key );
+		for( j = i + 1; j < numitems && Trie_Fold( items[j].key[depth], trie->casing ) == letter; j++ ) {
+			const char *other = items[j].key + depth;
+			for( m = 1; m < lcp && Trie_Fold( key[m], trie->casing ) == Trie_Fold( other[m], trie->casing ); m++ ) ;
+			lcp = m;
 		}
-		( *key_value_vector )->value = ( what & TRIE_DUMP_VALUES )
-									   ? node->data
-									   : NULL;
-		// increment key_vector
-		++( *key_value_vector );
+
+		child = Trie_AllocNode( trie );
+		trie->nodes[child].label = Trie_AddLabel( trie, key, lcp );
+		trie->nodes[child].labellen = (unsigned int)lcp;
+
+		n = &trie->nodes[node];
+		trie->edges[n->children + k] = child;
+		trie->letters[n->children + k] = letter;
+		n->numchildren++;
 	}
-	// dump children
-	if( node->child ) {
-		Trie_Dump_Rec( node->child, what, casing, predicate, cookie, 1, key, key_value_vector );
+
+	for( i = 0, k = 0; i < numitems; i = j, k++ ) {
+		unsigned int child = first + k;
+
+		letter = Trie_Fold( items[i].key[depth], trie->casing );
+		for( j = i + 1; j < numitems && Trie_Fold( items[j].key[depth], trie->casing ) == letter; j++ ) ;
+
+		assert( trie->edges[trie->nodes[node].children + k] == child );
+		Trie_Build_Rec( trie, child, items + i, temp + i, j - i, depth + trie->nodes[child].labellen );
 	}
-	// dump siblings
-	if( dumpSiblings && node->sibling ) {
-		Trie_Dump_Rec( node->sibling, what, casing, predicate, cookie, 1, key, key_value_vector );
+}
+
+static void Trie_KeyAppend(
+	trie_keybuf_t *keybuf,
+	const char *str,
+	size_t len
+	) {
+	if( keybuf->len + len + 1 > keybuf->size ) {
+		size_t size = keybuf->size ? keybuf->size : 64;
+		while( keybuf->len + len + 1 > size )
+			size *= 2;
+		keybuf->buf = (char *) realloc( keybuf->buf, size );
+		assert( keybuf->buf );
+		keybuf->size = size;
 	}
-	if( ( what & TRIE_DUMP_KEYS ) && !keyDumped ) {
-		assert( key );
-		free( key );
+	if( len ) {
+		memcpy( keybuf->buf + keybuf->len, str, len );
+		keybuf->len += len;
 	}
+	keybuf->buf[keybuf->len] = '\0';
 }
 
 static int Trie_AlwaysTrue(
@@ -622,14 +1194,12 @@ static int Trie_AlwaysTrue(
 	return 1;
 }
 
-static inline int Trie_LetterCompare(
-	char left,
-	char right,
+static inline unsigned char Trie_Fold(
+	char c,
 	trie_casing_t casing
 	) {
-	if( casing == TRIE_CASE_SENSITIVE ) {
-		return ( (int) left ) - ( (int) right );
-	} else {
-		return ( (int) tolower( left ) ) - ( (int) tolower( right ) );
+	if( casing == TRIE_CASE_INSENSITIVE && c >= 'A' && c <= 'Z' ) {
+		return (unsigned char) ( c - 'A' + 'a' );
 	}
+	return (unsigned char) c;
 }
@@ -41,6 +41,7 @@ typedef struct trie_dump_s {
 	unsigned int size;
 	trie_dump_what_t what;
 	struct trie_key_value_s *key_value_vector;
+	char *key_storage;          // the dumped keys point into this
 } trie_dump_t;
 
 /* Trie life-cycle functions */
@@ -63,6 +64,11 @@ trie_error_t Trie_GetSize(
 	unsigned int *size          // output parameter, size of trie
 	);
 
+trie_error_t Trie_GetMemoryUsage(
+	struct trie_s *trie,
+	size_t *bytes               // output parameter, bytes allocated by the trie
+	);
+
 /* Key/data insertion and removal */
 
 trie_error_t Trie_Insert(
@@ -71,6 +77,12 @@ trie_error_t Trie_Insert(
 	void *data                  // data to insert
 	);
 
+trie_error_t Trie_InsertBulk(
+	struct trie_s *trie,
+	const struct trie_key_value_s *key_value_vector,    // keys and data to insert, in any order
+	unsigned int count          // when a key is repeated, the last one wins like with Trie_Replace
+	);
+
 trie_error_t Trie_Remove(
 	struct trie_s *trie,
 	const char *key,            // key to match
@@ -87,8 +99,8 @@ trie_error_t Trie_Replace(
 trie_error_t Trie_Find(
 	const struct trie_s *trie,
 	const char *key,            // key to match
-	trie_find_mode_t mode,      // mode (exact or prefix only)
-	void **data                 // output parameter, data of node found
+	trie_find_mode_t mode,      // mode (exact or prefix only), the prefix "" always matches
+	void **data                 // output parameter, data of node found, NULL if the trie is empty
 	);
 
 trie_error_t Trie_FindIf(
@@ -114,7 +126,7 @@ trie_error_t Trie_NoOfMatchesIf(
 	unsigned int *matches       // output parameter, number of matches
 	);
 
-/* Dump by prefix */
+/* Dump by prefix, keys keep the casing of the prefix up to its last letter */
 
 trie_error_t Trie_Dump(
 	const struct trie_s *trie,
@@ -114,6 +114,11 @@ struct cmodel_state_s {
 	struct cmodel_state_s *parent;
 	struct mempool_s *mempool;
 
+	// read-only map data shared between all instances of the same map,
+	// each instance owns its areaportals, flood state and checkcounts
+	struct cmodel_state_s *shared;
+	struct cmodel_state_s *nextShared;  // link in the list of loaded maps
+
 	const bspFormatDesc_t *cmap_bspFormat;
 
 	char map_name[MAX_CONFIGSTRING_CHARS];
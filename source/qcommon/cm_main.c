@@ -27,6 +27,9 @@ static bool cm_initialized = false;
 
 static mempool_t *cmap_mempool;
 
+static cmodel_state_t *cm_sharedMaps;   // loaded maps, possibly used by several instances
+static qmutex_t *cm_sharedMapsLock;
+
 static cvar_t *cm_noAreas;
 cvar_t *cm_noCurves;
 
@@ -50,6 +53,8 @@ static const modelFormatDescr_t cm_supportedformats[] =
 };
 
 static void CM_AllocateCheckCounts( cmodel_state_t *cms );
+static void CM_FreeCheckCounts( cmodel_state_t *cms );
+static cmodel_state_t *CM_New_( cmodel_state_t *parent, void *mempool );
 
 /*
 ===============================================================================
@@ -85,12 +90,56 @@ static void CM_FreeCheckCounts( cmodel_state_t *cms ) {
 	}
 }
 
+/*
+* CM_ClearInstance
+*
+* Frees the per-instance state and drops the reference to the shared map data.
+*/
+static void CM_ClearInstance( cmodel_state_t *cms ) {
+	cmodel_state_t *shared = cms->shared;
+	int refcount = cms->refcount;
+	qmutex_t *refcount_mutex = cms->refcount_mutex;
+	cmodel_state_t *parent = cms->parent;
+	mempool_t *mempool = cms->mempool;
+
+	if( cms->map_areas != &cms->map_area_empty ) {
+		Mem_Free( cms->map_areas );
+	}
+	if( cms->map_areaportals ) {
+		Mem_Free( cms->map_areaportals );
+	}
+	CM_FreeCheckCounts( cms );
+
+	memset( cms, 0, sizeof( *cms ) );
+	cms->refcount = refcount;
+	cms->refcount_mutex = refcount_mutex;
+	cms->parent = parent;
+	cms->mempool = mempool;
+	cms->map_cmodels = &cms->map_cmodel_empty;
+	cms->map_leafs = &cms->map_leaf_empty;
+	cms->map_areas = &cms->map_area_empty;
+	cms->map_entitystring = &cms->map_entitystring_empty;
+
+	ClearBounds( cms->world_mins, cms->world_maxs );
+
+	CM_InitBoxHull( cms );
+
+	CM_InitOctagonHull( cms );
+
+	CM_ReleaseReference( shared );
+}
+
 /*
 * CM_Clear
 */
 static void CM_Clear( cmodel_state_t *cms ) {
 	int i;
 
+	if( cms->shared ) {
+		CM_ClearInstance( cms );
+		return;
+	}
+
 	if( cms->map_shaderrefs ) {
 		Mem_Free( cms->map_shaderrefs[0].name );
 		Mem_Free( cms->map_shaderrefs );
@@ -209,43 +258,17 @@ MAP LOADING
 */
 
 /*
-* CM_LoadMap
-* Loads in the map and all submodels
+* CM_LoadMapData
 *
-*  for spawning a server with no map at all, call like this:
-*  CM_LoadMap( "", false, &checksum );	// no real map
+* Loads the read-only map data which can be shared between instances.
 */
-cmodel_t *CM_LoadMap( cmodel_state_t *cms, const char *name, bool clientload, unsigned *checksum ) {
+static void CM_LoadMapData( cmodel_state_t *cms, const char *name ) {
 	int length;
 	unsigned *buf;
 	char *header;
 	const modelFormatDescr_t *descr;
 	bspFormatDesc_t *bspFormat = NULL;
 
-	assert( cms );
-	assert( name && strlen( name ) < MAX_CONFIGSTRING_CHARS );
-	assert( checksum );
-
-	if( name && !strcmp( cms->map_name, name ) && ( clientload || !Cvar_Value( "flushmap" ) ) ) {
-		*checksum = cms->checksum;
-
-		if( !clientload ) {
-			memset( cms->map_areaportals, 0, cms->numareas * cms->numareas * sizeof( *cms->map_areaportals ) );
-			CM_FloodAreaConnections( cms );
-		}
-
-		return cms->map_cmodels; // still have the right version
-	}
-
-	CM_Clear( cms );
-
-	if( !name || !name[0] ) {
-		cms->numleafs = 1;
-		cms->numcmodels = 2;
-		*checksum = 0;
-		return cms->map_cmodels;    // cinematic servers won't have anything at all
-	}
-
 	//
 	// load the file
 	//
@@ -255,7 +278,6 @@ cmodel_t *CM_LoadMap( cmodel_state_t *cms, const char *name, bool clientload, un
 	}
 
 	cms->checksum = md5_digest32( ( const uint8_t * )buf, length );
-	*checksum = cms->checksum;
 
 	// call the apropriate loader
 	descr = Q_FindFormatDescriptor( cm_supportedformats, ( const uint8_t * )buf, (const bspFormatDesc_t **)&bspFormat );
@@ -280,6 +302,88 @@ cmodel_t *CM_LoadMap( cmodel_state_t *cms, const char *name, bool clientload, un
 
 	descr->loader( cms, NULL, buf, bspFormat );
 
+	memset( cms->nullrow, 255, MAX_CM_LEAFS / 8 );
+
+	Q_strncpyz( cms->map_name, name, sizeof( cms->map_name ) );
+}
+
+/*
+* CM_FindSharedMap
+*
+* Returns a referenced, already loaded copy of the map or NULL.
+*/
+static cmodel_state_t *CM_FindSharedMap( const char *name ) {
+	int refcount;
+	cmodel_state_t *shared;
+
+	QMutex_Lock( cm_sharedMapsLock );
+	for( shared = cm_sharedMaps; shared; shared = shared->nextShared ) {
+		if( strcmp( shared->map_name, name ) ) {
+			continue;
+		}
+
+		// references are released without the lock, so only take one if
+		// the count is still above zero at the moment it is incremented.
+		// the map can't be freed meanwhile, as it is unlinked under the lock
+		do {
+			refcount = shared->refcount;
+		} while( refcount > 0 && !QAtomic_CAS( &shared->refcount, refcount, refcount + 1 ) );
+
+		if( refcount > 0 ) {
+			break;
+		}
+	}
+	QMutex_Unlock( cm_sharedMapsLock );
+
+	return shared;
+}
+
+/*
+* CM_UnlinkSharedMap
+*/
+static void CM_UnlinkSharedMap( cmodel_state_t *cms ) {
+	cmodel_state_t **prev;
+
+	QMutex_Lock( cm_sharedMapsLock );
+	for( prev = &cm_sharedMaps; *prev; prev = &( *prev )->nextShared ) {
+		if( *prev == cms ) {
+			*prev = cms->nextShared;
+			break;
+		}
+	}
+	QMutex_Unlock( cm_sharedMapsLock );
+
+	cms->nextShared = NULL;
+}
+
+/*
+* CM_Instantiate
+*
+* Makes the state an instance of the shared map data, with
+* its own areaportals, area flood state and checkcounts.
+*/
+static void CM_Instantiate( cmodel_state_t *cms ) {
+	cmodel_state_t *shared = cms->shared;
+	int refcount = cms->refcount;
+	qmutex_t *refcount_mutex = cms->refcount_mutex;
+	cmodel_state_t *parent = cms->parent;
+	mempool_t *mempool = cms->mempool;
+
+	*cms = *shared;
+	cms->refcount = refcount;
+	cms->refcount_mutex = refcount_mutex;
+	cms->parent = parent;
+	cms->mempool = mempool;
+	cms->shared = shared;
+	cms->nextShared = NULL;
+	cms->floodvalid = 0;
+
+	CM_InitBoxHull( cms );
+
+	CM_InitOctagonHull( cms );
+
+	cms->map_areas = &cms->map_area_empty;
+	cms->map_areaportals = NULL;
 	if( cms->numareas ) {
 		cms->map_areas = Mem_Alloc( cms->mempool, cms->numareas * sizeof( *cms->map_areas ) );
 		cms->map_areaportals = Mem_Alloc( cms->mempool, cms->numareas * cms->numareas * sizeof( *cms->map_areaportals ) );
@@ -289,11 +393,62 @@ cmodel_t *CM_LoadMap( cmodel_state_t *cms, const char *name, bool clientload, un
 	}
 
 	CM_AllocateCheckCounts( cms );
+}
 
-	memset( cms->nullrow, 255, MAX_CM_LEAFS / 8 );
+/*
+* CM_LoadMap
+* Loads in the map and all submodels
+*
+*  for spawning a server with no map at all, call like this:
+*  CM_LoadMap( "", false, &checksum );	// no real map
+*/
+cmodel_t *CM_LoadMap( cmodel_state_t *cms, const char *name, bool clientload, unsigned *checksum ) {
+	cmodel_state_t *shared;
 
-	Q_strncpyz( cms->map_name, name, sizeof( cms->map_name ) );
+	assert( cms );
+	assert( name && strlen( name ) < MAX_CONFIGSTRING_CHARS );
+	assert( checksum );
+
+	if( name && !strcmp( cms->map_name, name ) && ( clientload || !Cvar_Value( "flushmap" ) ) ) {
+		*checksum = cms->checksum;
 
+		if( !clientload ) {
+			memset( cms->map_areaportals, 0, cms->numareas * cms->numareas * sizeof( *cms->map_areaportals ) );
+			CM_FloodAreaConnections( cms );
+		}
+
+		return cms->map_cmodels; // still have the right version
+	}
+
+	CM_Clear( cms );
+
+	if( !name || !name[0] ) {
+		cms->numleafs = 1;
+		cms->numcmodels = 2;
+		*checksum = 0;
+		return cms->map_cmodels;    // cinematic servers won't have anything at all
+	}
+
+	shared = Cvar_Value( "flushmap" ) ? NULL : CM_FindSharedMap( name );
+	if( !shared ) {
+		// hold the reference before loading, so that a failed load
+		// gets cleaned up on the next CM_Clear
+		shared = CM_New_( NULL, cmap_mempool );
+		CM_AddReference( shared );
+		cms->shared = shared;
+
+		CM_LoadMapData( shared, name );
+
+		QMutex_Lock( cm_sharedMapsLock );
+		shared->nextShared = cm_sharedMaps;
+		cm_sharedMaps = shared;
+		QMutex_Unlock( cm_sharedMapsLock );
+	}
+
+	cms->shared = shared;
+	CM_Instantiate( cms );
+
+	*checksum = cms->checksum;
 	return cms->map_cmodels;
 }
 
@@ -932,6 +1087,8 @@ static cmodel_state_t *CM_New_( cmodel_state_t *parent, void *mempool ) {
 
 	if( parent ) {
 		*cms = *parent;
+		cms->shared = NULL;
+		cms->nextShared = NULL;
 		CM_AddReference( parent );
 	}
 
@@ -963,6 +1120,7 @@ static void CM_Free( cmodel_state_t *cms ) {
 	if( parent ) {
 		CM_FreeCheckCounts( cms );
 	} else {
+		CM_UnlinkSharedMap( cms );
 		CM_Clear( cms );
 	}
 
@@ -1000,7 +1158,8 @@ void CM_ReleaseReference( cmodel_state_t *cms ) {
 		return;
 	}
 
-	if( QAtomic_Add( &cms->refcount, 0 ) == 0 ) {
+	// only the thread which dropped the last reference may free it
+	if( rc == 1 ) {
 		CM_Free( cms );
 	}
 }
@@ -1028,6 +1187,7 @@ void CM_Init( void ) {
 	assert( !cm_initialized );
 
 	cmap_mempool = Mem_AllocPool( NULL, "Collision Map" );
+	cm_sharedMapsLock = QMutex_Create();
 
 	cm_noAreas =        Cvar_Get( "cm_noAreas", "0", CVAR_CHEAT );
 	cm_noCurves =       Cvar_Get( "cm_noCurves", "0", CVAR_CHEAT );
@@ -1043,6 +1203,9 @@ void CM_Shutdown( void ) {
 		return;
 	}
 
+	QMutex_Destroy( &cm_sharedMapsLock );
+	cm_sharedMaps = NULL;
+
 	Mem_FreePool( &cmap_mempool );
 
 	cm_initialized = false;
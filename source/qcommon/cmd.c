@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "qcommon.h"
 #include "../qalgo/q_trie.h"
+#include "nameindex.h"
 #include "../client/console.h"
 
 #define MAX_ALIAS_NAME      64
@@ -35,12 +36,18 @@ typedef struct cmdalias_s {
 static bool cmd_preinitialized = false;
 static bool cmd_initialized = false;
 
+// tries are used for listing and completion, exact lookups go through the indexes
 static trie_t *cmd_alias_trie = NULL;
+static nameindex_t *cmd_alias_index = NULL;
 static const trie_casing_t CMD_ALIAS_TRIE_CASING = CON_CASE_SENSITIVE ? TRIE_CASE_SENSITIVE : TRIE_CASE_INSENSITIVE;
 
 static bool cmd_wait;
 static int alias_count;    // for detecting runaway loops
 
+static const char *Cmd_AliasIndexKey( const void *alias ) {
+	return ( (const cmd_alias_t *) alias )->name;
+}
+
 static int Cmd_Archive( void *alias, void *ignored ) {
 	assert( alias );
 	return ( (cmd_alias_t *) alias )->archive;
@@ -555,8 +562,8 @@ static void Cmd_Alias_f_( bool archive ) {
 		return;
 	}
 
-	assert( cmd_alias_trie );
-	Trie_Find( cmd_alias_trie, s, TRIE_EXACT_MATCH, (void **)&a );
+	assert( cmd_alias_index );
+	a = ( cmd_alias_t * )NameIndex_Find( cmd_alias_index, s );
 	if( a ) {
 		if( Cmd_Argc() == 2 ) {
 			if( archive ) {
@@ -571,6 +578,7 @@ static void Cmd_Alias_f_( bool archive ) {
 		a->name = (char *) ( (uint8_t *)a + sizeof( cmd_alias_t ) );
 		strcpy( a->name, s );
 		Trie_Insert( cmd_alias_trie, s, a );
+		NameIndex_Insert( cmd_alias_index, a );
 	}
 
 	if( archive ) {
@@ -626,6 +634,7 @@ static void Cmd_Unalias_f( void ) {
 
 	assert( cmd_alias_trie );
 	if( Trie_Remove( cmd_alias_trie, s, (void **)&a ) == TRIE_OK ) {
+		NameIndex_Remove( cmd_alias_index, s );
 		Mem_ZoneFree( a->value );
 		Mem_ZoneFree( a );
 	} else {
@@ -651,6 +660,7 @@ static void Cmd_UnaliasAll_f( void ) {
 	}
 	Trie_FreeDump( dump );
 	Trie_Clear( cmd_alias_trie );
+	NameIndex_Clear( cmd_alias_index );
 }
 
 /*
@@ -698,8 +708,13 @@ static char *cmd_null_string = "";
 static char cmd_args[MAX_STRING_CHARS];
 
 static trie_t *cmd_function_trie = NULL;
+static nameindex_t *cmd_function_index = NULL;
 static const trie_casing_t CMD_FUNCTION_TRIE_CASING = CON_CASE_SENSITIVE ? TRIE_CASE_SENSITIVE : TRIE_CASE_INSENSITIVE;
 
+static const char *Cmd_FunctionIndexKey( const void *cmd ) {
+	return ( (const cmd_function_t *) cmd )->name;
+}
+
 static int Cmd_PatternMatchesFunction( void *cmd, void *pattern ) {
 	assert( cmd );
 	return !pattern || Com_GlobMatch( (const char *) pattern, ( (cmd_function_t *) cmd )->name, false );
@@ -829,9 +844,10 @@ void Cmd_AddCommand( const char *cmd_name, xcommand_t function ) {
 	}
 
 	// fail if the command already exists
-	assert( cmd_function_trie );
+	assert( cmd_function_index );
 	assert( cmd_name );
-	if( Trie_Find( cmd_function_trie, cmd_name, TRIE_EXACT_MATCH, (void **)&cmd ) == TRIE_OK ) {
+	cmd = ( cmd_function_t * )NameIndex_Find( cmd_function_index, cmd_name );
+	if( cmd ) {
 		cmd->function = function;
 		cmd->completion_func = NULL;
 		Com_DPrintf( "Cmd_AddCommand: %s already defined\n", cmd_name );
@@ -844,6 +860,7 @@ void Cmd_AddCommand( const char *cmd_name, xcommand_t function ) {
 	cmd->function = function;
 	cmd->completion_func = NULL;
 	Trie_Insert( cmd_function_trie, cmd_name, cmd );
+	NameIndex_Insert( cmd_function_index, cmd );
 }
 
 /*
@@ -859,6 +876,7 @@ void Cmd_RemoveCommand( const char *cmd_name ) {
 	assert( cmd_function_trie );
 	assert( cmd_name );
 	if( Trie_Remove( cmd_function_trie, cmd_name, (void **)&cmd ) == TRIE_OK ) {
+		NameIndex_Remove( cmd_function_index, cmd_name );
 		Mem_ZoneFree( cmd );
 	} else {
 		Com_Printf( "Cmd_RemoveCommand: %s not added\n", cmd_name );
@@ -870,11 +888,9 @@ void Cmd_RemoveCommand( const char *cmd_name ) {
 * // used by the cvar code to check for cvar / command name overlap
 */
 bool Cmd_Exists( const char *cmd_name ) {
-	cmd_function_t *cmd;
-
-	assert( cmd_function_trie );
+	assert( cmd_function_index );
 	assert( cmd_name );
-	return Trie_Find( cmd_function_trie, cmd_name, TRIE_EXACT_MATCH, (void **)&cmd ) == TRIE_OK;
+	return NameIndex_Find( cmd_function_index, cmd_name ) != NULL;
 }
 
 /*
@@ -888,7 +904,8 @@ void Cmd_SetCompletionFunc( const char *cmd_name, xcompletionf_t completion_func
 		return;
 	}
 
-	if( Trie_Find( cmd_function_trie, cmd_name, TRIE_EXACT_MATCH, (void **)&cmd ) == TRIE_OK ) {
+	cmd = ( cmd_function_t * )NameIndex_Find( cmd_function_index, cmd_name );
+	if( cmd ) {
 		cmd->completion_func = completion_func;
 		return;
 	}
@@ -949,9 +966,10 @@ char **Cmd_CompleteBuildList( const char *partial ) {
 * Find a possible single matching command
 */
 char **Cmd_CompleteBuildArgListExt( const char *command, const char *arguments ) {
-	cmd_function_t *cmd = NULL;
+	cmd_function_t *cmd;
 
-	if( Trie_Find( cmd_function_trie, command, TRIE_EXACT_MATCH, (void **)&cmd ) != TRIE_OK ) {
+	cmd = ( cmd_function_t * )NameIndex_Find( cmd_function_index, command );
+	if( !cmd ) {
 		return NULL;
 	}
 	if( cmd->completion_func ) {
@@ -1183,7 +1201,6 @@ char **Cmd_CompleteAliasBuildList( const char *partial ) {
 */
 bool Cmd_CheckForCommand( char *text ) {
 	char cmd[MAX_STRING_CHARS];
-	cmd_alias_t *a;
 	int i;
 
 	// this is not exactly what cbuf does when extracting lines
@@ -1203,7 +1220,7 @@ bool Cmd_CheckForCommand( char *text ) {
 	if( Cvar_Find( cmd ) ) {
 		return true;
 	}
-	if( Trie_Find( cmd_alias_trie, cmd, TRIE_EXACT_MATCH, (void **)&a ) == TRIE_OK ) {
+	if( NameIndex_Find( cmd_alias_index, cmd ) ) {
 		return true;
 	}
 
@@ -1237,9 +1254,9 @@ void Cmd_ExecuteString( const char *text ) {
 	// that does not break seperation of concerns.
 	// Aiwa, 07-14-2006
 
-	assert( cmd_function_trie );
-	assert( cmd_alias_trie );
-	if( Trie_Find( cmd_function_trie, str, TRIE_EXACT_MATCH, (void **)&cmd ) == TRIE_OK ) {
+	assert( cmd_function_index );
+	assert( cmd_alias_index );
+	if( ( cmd = ( cmd_function_t * )NameIndex_Find( cmd_function_index, str ) ) != NULL ) {
 		// check functions
 		if( !cmd->function ) {
 			// forward to server command
@@ -1247,7 +1264,7 @@ void Cmd_ExecuteString( const char *text ) {
 		} else {
 			cmd->function();
 		}
-	} else if( Trie_Find( cmd_alias_trie, str, TRIE_EXACT_MATCH, (void **)&a ) == TRIE_OK ) {
+	} else if( ( a = ( cmd_alias_t * )NameIndex_Find( cmd_alias_index, str ) ) != NULL ) {
 		// check alias
 		if( ++alias_count == ALIAS_LOOP_COUNT ) {
 			Com_Printf( "ALIAS_LOOP_COUNT\n" );
@@ -1301,6 +1318,8 @@ void Cmd_PreInit( void ) {
 
 	Trie_Create( CMD_ALIAS_TRIE_CASING, &cmd_alias_trie );
 	Trie_Create( CMD_FUNCTION_TRIE_CASING, &cmd_function_trie );
+	cmd_alias_index = NameIndex_Create( CMD_ALIAS_TRIE_CASING == TRIE_CASE_SENSITIVE, Cmd_AliasIndexKey );
+	cmd_function_index = NameIndex_Create( CMD_FUNCTION_TRIE_CASING == TRIE_CASE_SENSITIVE, Cmd_FunctionIndexKey );
 
 	cmd_preinitialized = true;
 }
@@ -1337,6 +1356,18 @@ void Cmd_Init( void ) {
 	cmd_initialized = true;
 }
 
+/*
+* Cmd_Frame
+*
+* Frees lookup tables which lock-free readers may no longer be using
+*/
+void Cmd_Frame( void ) {
+	if( cmd_initialized ) {
+		NameIndex_Reclaim( cmd_alias_index );
+		NameIndex_Reclaim( cmd_function_index );
+	}
+}
+
 void Cmd_Shutdown( void ) {
 	if( cmd_initialized ) {
 		unsigned int i;
@@ -1383,6 +1414,8 @@ void Cmd_Shutdown( void ) {
 		cmd_alias_trie = NULL;
 		Trie_Destroy( cmd_function_trie );
 		cmd_function_trie = NULL;
+		NameIndex_Destroy( &cmd_alias_index );
+		NameIndex_Destroy( &cmd_function_index );
 
 		cmd_preinitialized = false;
 	}
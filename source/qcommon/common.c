@@ -683,6 +683,8 @@ void Qcommon_Init( int argc, char **argv ) {
 
 	QThreads_Init();
 
+	Prof_ThreadName( "main" );
+
 	com_print_mutex = QMutex_Create();
 
 	// initialize memory manager
@@ -721,6 +723,8 @@ void Qcommon_Init( int argc, char **argv ) {
 #endif
 	developer =     Cvar_Get( "developer", "0", 0 );
 
+	QJobs_Init();
+
 	FS_Init();
 
 	Cbuf_AddText( "exec default.cfg\n" );
@@ -738,6 +742,9 @@ void Qcommon_Init( int argc, char **argv ) {
 	// init commands and vars
 	//
 	Memory_InitCommands();
+	QThreads_InitCommands();
+	QJobs_InitCommands();
+	Prof_Init();
 
 	Qcommon_InitCommands();
 
@@ -828,6 +835,16 @@ void Qcommon_Frame( unsigned int realMsec ) {
 
 	}
 
+	// also drops scratch allocations abandoned by an ERR_DROP
+	Mem_ScratchReset();
+
+	// likewise closes zones left open by an ERR_DROP
+	Prof_Frame();
+
+	// tables outgrown during the last frame are freed a frame later
+	Cvar_Frame();
+	Cmd_Frame();
+
 	if( logconsole && logconsole->modified ) {
 		logconsole->modified = false;
 		Com_ReopenConsoleLog();
@@ -875,13 +892,17 @@ void Qcommon_Frame( unsigned int realMsec ) {
 		time_before = Sys_Milliseconds();
 	}
 
+	Prof_Enter( "SV_Frame" );
 	SV_Frame( realMsec, gameMsec );
+	Prof_Leave();
 
 	if( host_speeds->integer ) {
 		time_between = Sys_Milliseconds();
 	}
 
+	Prof_Enter( "CL_Frame" );
 	CL_Frame( realMsec, gameMsec );
+	Prof_Leave();
 
 	if( host_speeds->integer ) {
 		time_after = Sys_Milliseconds();
@@ -927,12 +948,17 @@ void Qcommon_Shutdown( void ) {
 	Com_Autoupdate_Shutdown();
 
 	Qcommon_ShutdownCommands();
+	QThreads_ShutdownCommands();
 	Memory_ShutdownCommands();
 
 	Com_CloseConsoleLog( true, true );
 
 	FS_Shutdown();
 
+	QJobs_Shutdown();
+
+	Prof_Shutdown();
+
 	wswcurl_cleanup();
 
 	Cvar_Shutdown();
@@ -21,11 +21,15 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "qcommon.h"
 #include "../qalgo/q_trie.h"
 #include "../client/console.h"
+#include "nameindex.h"
 
 static bool cvar_initialized = false;
 static bool cvar_preinitialized = false;
 
+// the trie is kept sorted for listing and completion, exact lookups go
+// through the hash index which readers can use without taking the mutex
 static trie_t *cvar_trie = NULL;
+static nameindex_t *cvar_index = NULL;
 static qmutex_t *cvar_mutex = NULL;
 static const trie_casing_t CVAR_TRIE_CASING = CON_CASE_SENSITIVE ? TRIE_CASE_SENSITIVE : TRIE_CASE_INSENSITIVE;
 
@@ -46,6 +50,10 @@ static bool Cvar_CheatsAllowed() {
 		   ( Com_ServerState() && Cvar_Value( "sv_cheats" ) ); // local server, sv_cheats
 }
 
+static const char *Cvar_IndexKey( const void *cvar ) {
+	return ( (const cvar_t *) cvar )->name;
+}
+
 static int Cvar_PatternMatches( void *cvar, void *pattern ) {
 	return !pattern || Com_GlobMatch( (const char *) pattern, ( (cvar_t *) cvar )->name, false );
 }
@@ -72,12 +80,8 @@ bool Cvar_Initialized( void ) {
 * Cvar_Find
 */
 cvar_t *Cvar_Find( const char *var_name ) {
-	cvar_t *cvar;
-	assert( cvar_trie );
-	QMutex_Lock( cvar_mutex );
-	Trie_Find( cvar_trie, var_name, TRIE_EXACT_MATCH, (void **)&cvar );
-	QMutex_Unlock( cvar_mutex );
-	return cvar;
+	assert( cvar_index );
+	return ( cvar_t * )NameIndex_Find( cvar_index, var_name );
 }
 
 /*
@@ -134,10 +138,7 @@ cvar_t *Cvar_Get( const char *var_name, const char *var_value, cvar_flag_t flags
 		}
 	}
 
-	assert( cvar_trie );
-	QMutex_Lock( cvar_mutex );
-	Trie_Find( cvar_trie, var_name, TRIE_EXACT_MATCH, (void **)&var );
-	QMutex_Unlock( cvar_mutex );
+	var = Cvar_Find( var_name );
 
 	if( !var_value ) {
 		return NULL;
@@ -203,6 +204,7 @@ cvar_t *Cvar_Get( const char *var_name, const char *var_value, cvar_flag_t flags
 
 	QMutex_Lock( cvar_mutex );
 	Trie_Insert( cvar_trie, var_name, var );
+	NameIndex_Insert( cvar_index, var );
 	QMutex_Unlock( cvar_mutex );
 
 	return var;
@@ -826,6 +828,7 @@ void Cvar_PreInit( void ) {
 	cvar_mutex = QMutex_Create();
 
 	Trie_Create( CVAR_TRIE_CASING, &cvar_trie );
+	cvar_index = NameIndex_Create( CVAR_TRIE_CASING == TRIE_CASE_SENSITIVE, Cvar_IndexKey );
 
 	cvar_preinitialized = true;
 }
@@ -867,6 +870,17 @@ void Cvar_Init( void ) {
 	cvar_initialized = true;
 }
 
+/*
+* Cvar_Frame
+*
+* Frees lookup tables which lock-free readers may no longer be using
+*/
+void Cvar_Frame( void ) {
+	if( cvar_initialized ) {
+		NameIndex_Reclaim( cvar_index );
+	}
+}
+
 /*
 * Cvar_Shutdown
 *
@@ -930,6 +944,7 @@ void Cvar_Shutdown( void ) {
 
 		QMutex_Lock( cvar_mutex );
 		Trie_Destroy( cvar_trie );
+		NameIndex_Destroy( &cvar_index );
 		QMutex_Unlock( cvar_mutex );
 		cvar_trie = NULL;
 
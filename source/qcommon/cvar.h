@@ -77,6 +77,7 @@ void        Cvar_WriteVariables( int file );
 void        Cvar_PreInit( void );
 void        Cvar_Init( void );
 void        Cvar_Shutdown( void );
+void        Cvar_Frame( void );
 char *Cvar_Userinfo( void );
 char *Cvar_Serverinfo( void );
 
@@ -109,6 +110,7 @@ static inline bool Cvar_IsModified( const cvar_t *var ) {
 }
 static inline void Cvar_SetModified( cvar_t *var ) {
 	var->modified = ( bool )1;
+	var->modificationCount++;
 }
 static inline void Cvar_UnsetModified( cvar_t *var ) {
 	var->modified = ( bool )0;
@@ -84,8 +84,6 @@ typedef struct {
 #define FS_PACKFILE_COHERENT        2
 #define FS_PACKFILE_DIRECTORY       4
 
-#define FS_PACKFILE_NUM_THREADS     4     // including the main thread
-
 typedef struct packfile_s {
 	char *name;
 	char *pakname;
@@ -135,6 +133,8 @@ typedef struct filehandle_s {
 	size_t mapping_size;
 	size_t mapping_offset;
 
+	uint8_t *prefetchData;          // inflated contents of a prefetched pak file
+
 	struct filehandle_s *prev, *next;
 } filehandle_t;
 
@@ -160,6 +160,7 @@ static cvar_t *fs_usehomedir;
 static cvar_t *fs_usedownloadsdir;
 static cvar_t *fs_basegame;
 static cvar_t *fs_game;
+static cvar_t *fs_prefetch;
 
 static searchpath_t *fs_basepaths = NULL;       // directories without gamedirs
 static searchpath_t *fs_searchpaths = NULL;     // game search directories, plus paks
@@ -187,6 +188,15 @@ static int fs_notifications = 0;
 
 static int FS_AddNotifications( int bitmask );
 
+static int FS_OpenPrefetchedFile( const char *filename, packfile_t *pakFile, int *filenum );
+static void FS_FlushPrefetchedFiles( void );
+static void FS_DropPrefetchedPak( const pack_t *pack );
+static void FS_ExpirePrefetchedFiles( void );
+static void FS_ShutdownPrefetch( void );
+
+static bool FS_CachedPakFileChecksum( const char *filename, unsigned *checksum );
+static void FS_SetCachedPakFileChecksum( const char *filename, unsigned checksum );
+
 static bool fs_initialized = false;
 
 /*
@@ -204,6 +214,24 @@ static inline unsigned short LittleShortRaw( const uint8_t *raw ) {
 	return ( raw[1] << 8 ) | raw[0];
 }
 
+/*
+* FS_HashFileName
+*
+* Case-insensitive, so that it matches the pak tries.
+*/
+static unsigned FS_HashFileName( const char *name ) {
+	unsigned hash = 5381;
+
+	while( *name ) {
+		int c = tolower( *( const unsigned char * )name++ );
+		if( c == '\\' ) {
+			c = '/';
+		}
+		hash = ( hash << 5 ) + hash + c;
+	}
+	return hash;
+}
+
 /*
 * FS_PK3CheckFileCoherency
 *
@@ -412,18 +440,382 @@ static int FS_FileLength( FILE *f, bool close ) {
 	return end;
 }
 
+/*
+=============================================================================
+
+FILE INDEX
+
+Maps every pak entry name to the paks that win the pure and the regular passes
+of FS_SearchPathForFile, so a lookup is a single hash probe instead of a trie
+search per pak. Directories are not indexed and are always probed directly, so
+loose files show up as soon as they're written. The index is rebuilt lazily
+whenever the set of paks or their pure state changes.
+
+=============================================================================
+*/
+
+typedef struct {
+	searchpath_t *search;
+	packfile_t *file;
+	int order;                          // position of the search path in fs_searchpaths
+} fs_indexslot_t;
+
+typedef struct {
+	const char *name;
+	unsigned hashKey;
+	int hashNext;
+	fs_indexslot_t explicitPure;        // first explicitly pure pak
+	fs_indexslot_t implicitPure;        // first implicitly pure pak
+	fs_indexslot_t regular;             // first non-pure pak
+} fs_indexentry_t;
+
+static fs_indexentry_t *fs_index_entries;
+static int *fs_index_buckets;
+static int fs_index_numentries, fs_index_maxentries;
+static int fs_index_numbuckets;
+static bool fs_index_dirty = true;
+
+static struct {
+	unsigned lookups;
+	unsigned misses;
+	unsigned dirProbes;
+	uint64_t lookupTime;
+	unsigned rebuilds;
+	uint64_t rebuildTime;
+} fs_index_stats;
+
+/*
+* FS_InvalidateFileIndex
+*
+* Must be called with fs_searchpaths_mutex held whenever paks are added,
+* removed or change their pure state.
+*/
+static void FS_InvalidateFileIndex( void ) {
+	fs_index_dirty = true;
+}
+
+/*
+* FS_IndexEntryForName
+*/
+static fs_indexentry_t *FS_IndexEntryForName( const char *name, unsigned hashKey ) {
+	int i;
+	fs_indexentry_t *entry;
+
+	if( !fs_index_numbuckets ) {
+		return NULL;
+	}
+
+	for( i = fs_index_buckets[hashKey & ( fs_index_numbuckets - 1 )]; i >= 0; i = entry->hashNext ) {
+		entry = &fs_index_entries[i];
+		if( entry->hashKey == hashKey && !Q_stricmp( entry->name, name ) ) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/*
+* FS_BuildFileIndex
+*/
+static void FS_BuildFileIndex( void ) {
+	int i, order, numFiles;
+	uint64_t startTime;
+	searchpath_t *search;
+
+	startTime = Sys_Microseconds();
+
+	numFiles = 0;
+	for( search = fs_searchpaths; search; search = search->next ) {
+		if( search->pack && !search->pack->deferred_load ) {
+			numFiles += search->pack->numFiles;
+		}
+	}
+
+	if( numFiles > fs_index_maxentries ) {
+		if( fs_index_entries ) {
+			FS_Free( fs_index_entries );
+		}
+		fs_index_maxentries = numFiles;
+		fs_index_entries = ( fs_indexentry_t * )FS_Malloc( sizeof( *fs_index_entries ) * fs_index_maxentries );
+	}
+
+	// keep the load factor under 0.5
+	for( i = 64; i < numFiles * 2; i <<= 1 ) ;
+	if( i != fs_index_numbuckets ) {
+		if( fs_index_buckets ) {
+			FS_Free( fs_index_buckets );
+		}
+		fs_index_numbuckets = i;
+		fs_index_buckets = ( int * )FS_Malloc( sizeof( *fs_index_buckets ) * fs_index_numbuckets );
+	}
+	memset( fs_index_buckets, -1, sizeof( *fs_index_buckets ) * fs_index_numbuckets );
+
+	fs_index_numentries = 0;
+
+	for( search = fs_searchpaths, order = 0; search; search = search->next, order++ ) {
+		pack_t *pack = search->pack;
+		packfile_t *file;
+
+		if( !pack || pack->deferred_load ) {
+			continue;
+		}
+
+		for( i = 0, file = pack->files; i < pack->numFiles; i++, file++ ) {
+			unsigned hashKey = FS_HashFileName( file->name );
+			fs_indexentry_t *entry = FS_IndexEntryForName( file->name, hashKey );
+			fs_indexslot_t *slot;
+
+			if( !entry ) {
+				int bucket = hashKey & ( fs_index_numbuckets - 1 );
+
+				entry = &fs_index_entries[fs_index_numentries];
+				memset( entry, 0, sizeof( *entry ) );
+				entry->name = file->name;
+				entry->hashKey = hashKey;
+				entry->hashNext = fs_index_buckets[bucket];
+				fs_index_buckets[bucket] = fs_index_numentries++;
+			}
+
+			if( pack->pure == FS_PURE_EXPLICIT ) {
+				slot = &entry->explicitPure;
+			} else if( pack->pure == FS_PURE_IMPLICIT ) {
+				slot = &entry->implicitPure;
+			} else {
+				slot = &entry->regular;
+			}
+
+			// duplicate names within the same pak: the last one wins, just like in the trie
+			if( !slot->search || slot->search == search ) {
+				slot->search = search;
+				slot->file = file;
+				slot->order = order;
+			}
+		}
+	}
+
+	fs_index_dirty = false;
+	fs_index_stats.rebuilds++;
+	fs_index_stats.rebuildTime += Sys_Microseconds() - startTime;
+}
+
+/*
+* FS_FindIndexEntry
+*
+* Must be called with fs_searchpaths_mutex held.
+*/
+static fs_indexentry_t *FS_FindIndexEntry( const char *filename ) {
+	fs_indexentry_t *entry;
+
+	if( fs_index_dirty ) {
+		FS_BuildFileIndex();
+	}
+
+	entry = FS_IndexEntryForName( filename, FS_HashFileName( filename ) );
+	if( !entry ) {
+		fs_index_stats.misses++;
+	}
+	return entry;
+}
+
+/*
+* FS_IndexEntryPureSlot
+*
+* Returns the winner of the pure pass: explicitly pure paks take precedence.
+*/
+static fs_indexslot_t *FS_IndexEntryPureSlot( fs_indexentry_t *entry ) {
+	if( entry->explicitPure.search ) {
+		return &entry->explicitPure;
+	}
+	if( entry->implicitPure.search ) {
+		return &entry->implicitPure;
+	}
+	return NULL;
+}
+
+/*
+* FS_FreeFileIndex
+*/
+static void FS_FreeFileIndex( void ) {
+	if( fs_index_entries ) {
+		FS_Free( fs_index_entries );
+		fs_index_entries = NULL;
+	}
+	if( fs_index_buckets ) {
+		FS_Free( fs_index_buckets );
+		fs_index_buckets = NULL;
+	}
+	fs_index_numentries = fs_index_maxentries = 0;
+	fs_index_numbuckets = 0;
+	fs_index_dirty = true;
+}
+
+/*
+* Cmd_FS_IndexStats_f
+*/
+static void Cmd_FS_IndexStats_f( void ) {
+	QMutex_Lock( fs_searchpaths_mutex );
+
+	if( fs_index_dirty ) {
+		FS_BuildFileIndex();
+	}
+
+	Com_Printf( "File index: %i names, %i buckets\n", fs_index_numentries, fs_index_numbuckets );
+	Com_Printf( "Lookups: %u (%u not in paks), %u directory probes\n", fs_index_stats.lookups,
+				fs_index_stats.misses, fs_index_stats.dirProbes );
+	Com_Printf( "Lookup time: %.3f ms total, %.3f usec average\n", fs_index_stats.lookupTime / 1000.0,
+				fs_index_stats.lookups ? (double)fs_index_stats.lookupTime / fs_index_stats.lookups : 0.0 );
+	Com_Printf( "Rebuilds: %u, %.3f ms total\n", fs_index_stats.rebuilds, fs_index_stats.rebuildTime / 1000.0 );
+
+	if( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		memset( &fs_index_stats, 0, sizeof( fs_index_stats ) );
+	}
+
+	QMutex_Unlock( fs_searchpaths_mutex );
+}
+
+/*
+* FS_TrieBenchDirectory
+*
+* Returns the directory part of the name, including the trailing slash
+*/
+static const char *FS_TrieBenchDirectory( const char *name, char *dir, size_t size ) {
+	char *slash;
+
+	Q_strncpyz( dir, name, size );
+	slash = strrchr( dir, '/' );
+	if( slash ) {
+		slash[1] = '\0';
+	} else {
+		dir[0] = '\0';
+	}
+	return dir;
+}
+
+/*
+* Cmd_FS_TrieBench_f
+*
+* Times the pack file tries on the names of all loaded packs. The comparison
+* with the character-per-node trie they replaced lives in tools/triebench.
+*/
+static void Cmd_FS_TrieBench_f( void ) {
+	int i, j, numNames, iterations;
+	size_t mark, memInsert, memBulk;
+	uint64_t startTime, insertTime, bulkTime, findTime, dumpTime;
+	unsigned int numFound, numDumps, numDumped;
+	searchpath_t *search;
+	trie_key_value_t *names;
+	trie_t *trie = NULL, *bulk = NULL;
+	trie_dump_t *dump;
+	char dir[FS_MAX_PATH];
+	void *data;
+
+	iterations = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 10;
+	iterations = Q_bound( 1, iterations, 1000 );
+
+	QMutex_Lock( fs_searchpaths_mutex );
+
+	numNames = 0;
+	for( search = fs_searchpaths; search; search = search->next ) {
+		if( search->pack ) {
+			numNames += search->pack->numFiles;
+		}
+	}
+	if( !numNames ) {
+		QMutex_Unlock( fs_searchpaths_mutex );
+		Com_Printf( "No packs loaded\n" );
+		return;
+	}
+
+	mark = Mem_ScratchMark();
+	names = ( trie_key_value_t * )Mem_ScratchAlloc( numNames * sizeof( *names ) );
+	for( search = fs_searchpaths, j = 0; search; search = search->next ) {
+		if( search->pack ) {
+			for( i = 0; i < search->pack->numFiles; i++, j++ ) {
+				names[j].key = search->pack->files[i].name;
+				names[j].value = &search->pack->files[i];
+			}
+		}
+	}
+
+	// one name at a time, the way paks used to be indexed
+	startTime = Sys_Microseconds();
+	for( i = 0; i < iterations; i++ ) {
+		if( trie ) {
+			Trie_Destroy( trie );
+		}
+		Trie_Create( TRIE_CASE_INSENSITIVE, &trie );
+		for( j = 0; j < numNames; j++ ) {
+			if( Trie_Replace( trie, names[j].key, names[j].value, &data ) == TRIE_KEY_NOT_FOUND ) {
+				Trie_Insert( trie, names[j].key, names[j].value );
+			}
+		}
+	}
+	insertTime = Sys_Microseconds() - startTime;
+
+	startTime = Sys_Microseconds();
+	for( i = 0; i < iterations; i++ ) {
+		if( bulk ) {
+			Trie_Destroy( bulk );
+		}
+		Trie_Create( TRIE_CASE_INSENSITIVE, &bulk );
+		Trie_InsertBulk( bulk, names, numNames );
+	}
+	bulkTime = Sys_Microseconds() - startTime;
+
+	numFound = 0;
+	startTime = Sys_Microseconds();
+	for( i = 0; i < iterations; i++ ) {
+		for( j = 0; j < numNames; j++ ) {
+			if( Trie_Find( bulk, names[j].key, TRIE_EXACT_MATCH, &data ) == TRIE_OK ) {
+				numFound++;
+			}
+		}
+	}
+	findTime = Sys_Microseconds() - startTime;
+
+	// list the directory of every 16th name, like FS_GetFileList does
+	numDumps = numDumped = 0;
+	startTime = Sys_Microseconds();
+	for( i = 0; i < iterations; i++ ) {
+		for( j = 0; j < numNames; j += 16 ) {
+			FS_TrieBenchDirectory( names[j].key, dir, sizeof( dir ) );
+			if( Trie_Dump( bulk, dir, TRIE_DUMP_VALUES, &dump ) == TRIE_OK ) {
+				numDumped += dump->size;
+				Trie_FreeDump( dump );
+			}
+			numDumps++;
+		}
+	}
+	dumpTime = Sys_Microseconds() - startTime;
+
+	Trie_GetMemoryUsage( trie, &memInsert );
+	Trie_GetMemoryUsage( bulk, &memBulk );
+	Trie_Destroy( trie );
+	Trie_Destroy( bulk );
+
+	Mem_ScratchFreeToMark( mark );
+
+	QMutex_Unlock( fs_searchpaths_mutex );
+
+	Com_Printf( "%i names, %i iterations\n", numNames, iterations );
+	Com_Printf( "insert: %.3f ms per pass, %" PRIuPTR " KiB\n", insertTime / 1000.0 / iterations, (uintptr_t)( memInsert >> 10 ) );
+	Com_Printf( "bulk:   %.3f ms per pass, %" PRIuPTR " KiB\n", bulkTime / 1000.0 / iterations, (uintptr_t)( memBulk >> 10 ) );
+	Com_Printf( "find:   %.3f usec per name, %u found\n", (double)findTime / iterations / numNames, numFound / iterations );
+	Com_Printf( "dump:   %.3f usec per directory, %u names\n", (double)dumpTime / numDumps, numDumped / iterations );
+}
+
 /*
 * FS_SearchPathForFile
 *
 * Gives the searchpath element where this file exists, or NULL if it doesn't
 */
 static searchpath_t *FS_SearchPathForFile( const char *filename, packfile_t **pout, char *path, size_t path_size, void **vfsHandle, int mode ) {
+	int order, maxOrder;
+	uint64_t startTime;
 	searchpath_t *search;
-	packfile_t *search_pak;
-	searchpath_t *implicitpure;
-	packfile_t *implicitpure_pak;
-	bool purepass;
 	searchpath_t *result;
+	fs_indexentry_t *entry;
+	fs_indexslot_t *slot;
 
 	if( !COM_ValidateRelativeFilename( filename ) ) {
 		return NULL;
@@ -437,63 +829,51 @@ static searchpath_t *FS_SearchPathForFile( const char *filename, packfile_t **po
 	}
 
 	result = NULL;
-	purepass = true;
-	implicitpure = NULL;
-	implicitpure_pak = NULL;
 
-	// search through the path, one element at a time
 	QMutex_Lock( fs_searchpaths_mutex );
-	search = fs_searchpaths;
-	while( search ) {
-		// is the element a pak file?
-		if( search->pack ) {
-			if( mode & FS_SEARCH_PAKS ) {
-				if( ( search->pack->pure > FS_PURE_NONE ) == purepass ) {
-					if( FS_SearchPakForFile( search->pack, filename, &search_pak ) ) {
-						// if we find an explicitly pure pak, return immediately
-						if( !purepass || search->pack->pure == FS_PURE_EXPLICIT ) {
-							if( pout ) {
-								*pout = search_pak;
-							}
-							result = search;
-							goto return_result;
-						}
-						// otherwise store the pointer but keep searching for an explicit pak
-						else if( implicitpure == NULL ) {
-							implicitpure = search;
-							implicitpure_pak = search_pak;
-						}
-					}
-				}
-			}
-		} else {
-			if( mode & FS_SEARCH_DIRS ) {
-				if( !purepass ) {
-					if( FS_SearchDirectoryForFile( search, filename, path, path_size, vfsHandle ) ) {
-						result = search;
-						goto return_result;
-					}
-				}
+
+	startTime = Sys_Microseconds();
+	fs_index_stats.lookups++;
+
+	entry = NULL;
+	if( mode & FS_SEARCH_PAKS ) {
+		entry = FS_FindIndexEntry( filename );
+
+		// pure paks take precedence over everything else
+		if( entry && ( slot = FS_IndexEntryPureSlot( entry ) ) != NULL ) {
+			if( pout ) {
+				*pout = slot->file;
 			}
+			result = slot->search;
+			goto return_result;
 		}
+	}
 
-		if( !search->next && purepass ) {
-			if( implicitpure ) {
-				// return file from an implicitly pure pak
-				if( pout ) {
-					*pout = implicitpure_pak;
-				}
-				result = implicitpure;
+	// otherwise the first directory or non-pure pak in search order wins
+	maxOrder = entry && entry->regular.search ? entry->regular.order : INT_MAX;
+
+	if( mode & FS_SEARCH_DIRS ) {
+		for( search = fs_searchpaths, order = 0; search && order < maxOrder; search = search->next, order++ ) {
+			if( search->pack ) {
+				continue;
+			}
+			fs_index_stats.dirProbes++;
+			if( FS_SearchDirectoryForFile( search, filename, path, path_size, vfsHandle ) ) {
+				result = search;
 				goto return_result;
 			}
-			search = fs_searchpaths;
-			purepass = false;
-		} else {
-			search = search->next;
 		}
 	}
 
+	if( entry && entry->regular.search ) {
+		if( pout ) {
+			*pout = entry->regular.file;
+		}
+		result = entry->regular.search;
+	}
+
 return_result:
+	fs_index_stats.lookupTime += Sys_Microseconds() - startTime;
 	QMutex_Unlock( fs_searchpaths_mutex );
 	return result;
 }
@@ -747,8 +1127,10 @@ const char *FS_FirstExtension( const char *filename, const char *extensions[], i
 	int i;
 	size_t max_extension_length;
 	searchpath_t *search;
-	bool purepass;
-	const char *implicitpure;
+	int order, maxOrder;
+	int explicitExt, implicitExt, regularExt;
+	fs_indexslot_t *explicitPure, *implicitPure, *regular;
+	uint64_t startTime;
 	const char *result;
 
 	assert( filename && extensions );
@@ -788,52 +1170,68 @@ const char *FS_FirstExtension( const char *filename, const char *extensions[], i
 	}
 
 	result = NULL;
-	purepass = true;
-	implicitpure = NULL;
 
-	// search through the path, one element at a time
 	QMutex_Lock( fs_searchpaths_mutex );
-	search = fs_searchpaths;
-	while( search ) {
-		if( search->pack ) { // is the element a pak file?
-			if( ( search->pack->pure > FS_PURE_NONE ) == purepass ) {
-				for( i = 0; i < num_extensions; i++ ) {
-					if( FS_SearchPakForFile( search->pack, filenames[i], NULL ) ) {
-						if( !purepass || search->pack->pure == FS_PURE_EXPLICIT ) {
-							result = extensions[i];
-							goto return_result;
-						} else if( implicitpure == NULL ) {
-							implicitpure = extensions[i];
-							break;
-						}
-					}
-				}
-			}
-		} else {
-			if( !purepass ) {
-				for( i = 0; i < num_extensions; i++ ) {
-					void *vfsHandle = NULL; // search in VFS as well
-					if( FS_SearchDirectoryForFile( search, filenames[i], NULL, 0, &vfsHandle ) ) {
-						result = extensions[i];
-						goto return_result;
-					}
-				}
-			}
+
+	startTime = Sys_Microseconds();
+	fs_index_stats.lookups++;
+
+	// pure pass: the first explicitly pure pak wins, then the first implicitly pure one,
+	// within the same pak extensions are tried in the given order
+	explicitPure = implicitPure = regular = NULL;
+	explicitExt = implicitExt = regularExt = -1;
+	for( i = 0; i < num_extensions; i++ ) {
+		fs_indexentry_t *entry = FS_FindIndexEntry( filenames[i] );
+		if( !entry ) {
+			continue;
+		}
+
+		if( entry->explicitPure.search && ( !explicitPure || entry->explicitPure.order < explicitPure->order ) ) {
+			explicitPure = &entry->explicitPure;
+			explicitExt = i;
+		}
+		if( entry->implicitPure.search && ( !implicitPure || entry->implicitPure.order < implicitPure->order ) ) {
+			implicitPure = &entry->implicitPure;
+			implicitExt = i;
+		}
+		if( entry->regular.search && ( !regular || entry->regular.order < regular->order ) ) {
+			regular = &entry->regular;
+			regularExt = i;
+		}
+	}
+
+	if( explicitPure ) {
+		result = extensions[explicitExt];
+		goto return_result;
+	}
+	if( implicitPure ) {
+		result = extensions[implicitExt];
+		goto return_result;
+	}
+
+	// directories that precede the first non-pure pak with a match
+	maxOrder = regular ? regular->order : INT_MAX;
+	for( search = fs_searchpaths, order = 0; search && order < maxOrder; search = search->next, order++ ) {
+		if( search->pack ) {
+			continue;
 		}
 
-		if( !search->next && purepass ) {
-			if( implicitpure ) {
-				result = implicitpure;
+		for( i = 0; i < num_extensions; i++ ) {
+			void *vfsHandle = NULL; // search in VFS as well
+			fs_index_stats.dirProbes++;
+			if( FS_SearchDirectoryForFile( search, filenames[i], NULL, 0, &vfsHandle ) ) {
+				result = extensions[i];
 				goto return_result;
 			}
-			search = fs_searchpaths;
-			purepass = false;
-		} else {
-			search = search->next;
 		}
 	}
 
+	if( regular ) {
+		result = extensions[regularExt];
+	}
+
 return_result:
+	fs_index_stats.lookupTime += Sys_Microseconds() - startTime;
 	QMutex_Unlock( fs_searchpaths_mutex );
 
 	return result;
@@ -1028,13 +1426,19 @@ static int _FS_FOpenPakFile( packfile_t *pakFile, int *filenum ) {
 	file->pakFile = pakFile;
 
 	if( !( pakFile->flags & FS_PACKFILE_COHERENT ) ) {
-		unsigned offset = FS_PK3CheckFileCoherency( file->fstream, pakFile );
-		if( !offset ) {
-			Com_DPrintf( "_FS_FOpenPakFile: can't get proper offset for %s\n", pakFile->name );
-			return -1;
+		// the same entry may be opened by prefetch threads at the same time
+		QMutex_Lock( fs_fh_mutex );
+		if( !( pakFile->flags & FS_PACKFILE_COHERENT ) ) {
+			unsigned offset = FS_PK3CheckFileCoherency( file->fstream, pakFile );
+			if( !offset ) {
+				QMutex_Unlock( fs_fh_mutex );
+				Com_DPrintf( "_FS_FOpenPakFile: can't get proper offset for %s\n", pakFile->name );
+				return -1;
+			}
+			pakFile->offset += offset;
+			pakFile->flags |= FS_PACKFILE_COHERENT;
 		}
-		pakFile->offset += offset;
-		pakFile->flags |= FS_PACKFILE_COHERENT;
+		QMutex_Unlock( fs_fh_mutex );
 	}
 	file->pakOffset = Sys_VFS_FileOffset( pakFile->vfsHandle ) + pakFile->offset;
 
@@ -1202,6 +1606,12 @@ static int _FS_FOpenFile( const char *filename, int *filenum, int mode, bool bas
 
 		assert( !base );
 
+		uncompressedSize = FS_OpenPrefetchedFile( filename, pakFile, filenum );
+		if( uncompressedSize >= 0 ) {
+			Com_DPrintf( "PackFile: %s : %s (prefetched)\n", search->pack->filename, filename );
+			return uncompressedSize;
+		}
+
 		uncompressedSize = _FS_FOpenPakFile( pakFile, filenum );
 		if( uncompressedSize < 0 ) {
 			if( *filenum > 0 ) {
@@ -1299,6 +1709,10 @@ void FS_FCloseFile( int file ) {
 	}
 	fh = FS_FileHandleForNum( file );
 
+	if( fh->prefetchData ) {
+		FS_Free( fh->prefetchData );
+		fh->prefetchData = NULL;
+	}
 	if( fh->zipEntry ) {
 		mz_inflateEnd( &fh->zipEntry->zstream );
 		Mem_Free( fh->zipEntry );
@@ -1413,14 +1827,17 @@ int FS_Read( void *buffer, size_t len, int file ) {
 
 	fh = FS_FileHandleForNum( file );
 
-	if( fh->fstream && ( fh->pakFile || fh->vfsHandle ) && len + fh->offset > fh->uncompressedSize ) {
+	if( ( fh->fstream || fh->prefetchData ) && ( fh->pakFile || fh->vfsHandle ) && len + fh->offset > fh->uncompressedSize ) {
 		len = fh->uncompressedSize - fh->offset;
 		if( !len ) {
 			return 0;
 		}
 	}
 
-	if( fh->zipEntry ) {
+	if( fh->prefetchData ) {
+		memcpy( buffer, fh->prefetchData + fh->offset, len );
+		total = (int)len;
+	} else if( fh->zipEntry ) {
 		total = FS_ReadPK3File( ( uint8_t * )buffer, len, fh );
 	} else if( fh->streamHandle ) {
 		total = FS_ReadStream( (uint8_t *)buffer, len, fh );
@@ -1586,6 +2003,14 @@ int FS_Seek( int file, int offset, int whence ) {
 		return 0;
 	}
 
+	if( fh->prefetchData ) {
+		if( offset > (int)fh->uncompressedSize ) {
+			return -1;
+		}
+		fh->offset = offset;
+		return 0;
+	}
+
 	if( !fh->fstream ) {
 		return -1;
 	}
@@ -1645,6 +2070,9 @@ int FS_Eof( int file ) {
 	if( fh->zipEntry ) {
 		return fh->zipEntry->restReadCompressed == 0;
 	}
+	if( fh->prefetchData ) {
+		return fh->offset >= fh->uncompressedSize;
+	}
 
 	if( fh->fstream ) {
 		return ( fh->pakFile || fh->vfsHandle ) ? fh->offset >= fh->uncompressedSize : feof( fh->fstream );
@@ -1802,34 +2230,524 @@ void FS_FreeBaseFile( void *buffer ) {
 }
 
 /*
-* FS_ChecksumAbsoluteFile
-*/
-unsigned FS_ChecksumAbsoluteFile( const char *filename ) {
-	uint8_t buffer[FS_MAX_BLOCK_SIZE];
-	int left, length, filenum;
-	md5_byte_t digest[16];
-	md5_state_t state;
+=============================================================================
 
-	Com_DPrintf( "Calculating checksum for file: %s\n", filename );
+PREFETCHING
 
-	md5_init( &state );
+Pak entries are opened and inflated on a small pool of worker threads. Prefetched
+entries are kept in memory until they're opened with FS_FOpenFile, which then
+serves reads straight from the inflated buffer instead of touching the pak.
 
-	left = FS_FOpenAbsoluteFile( filename, &filenum, FS_READ );
-	if( left == -1 ) {
-		return 0;
-	}
+=============================================================================
+*/
 
-	while( ( length = FS_Read( buffer, sizeof( buffer ), filenum ) ) ) {
-		left -= length;
-		md5_append( &state, (md5_byte_t *)buffer, length );
-	}
+#define FS_PREFETCH_NUM_THREADS     4
+#define FS_PREFETCH_HASH_SIZE       256
+#define FS_PREFETCH_MAX_BYTES       0x8000000   // 128MB of inflated data in flight
+#define FS_PREFETCH_TIMEOUT         30000       // drop unclaimed entries after this many msec
 
-	FS_FCloseFile( filenum );
-	md5_finish( &state, digest );
+typedef enum {
+	FS_PREFETCH_QUEUED,
+	FS_PREFETCH_LOADING,
+	FS_PREFETCH_READY,
+	FS_PREFETCH_FAILED
+} fs_prefetch_state_t;
 
-	if( left != 0 ) {
-		return 0;
-	}
+typedef struct fs_prefetch_s {
+	char *name;
+	packfile_t *pakFile;
+	volatile int state;
+	bool cancelled;                 // removed from the hash table while owned by a worker, freed by it
+	uint8_t *data;
+	unsigned size;
+	int64_t readyTime;
+	unsigned hashKey;
+	struct fs_prefetch_s *hashNext;
+	struct fs_prefetch_s *queueNext;
+} fs_prefetch_t;
+
+static qmutex_t *fs_prefetch_mutex;
+static qcondvar_t *fs_prefetch_queue_cond;
+static qcondvar_t *fs_prefetch_done_cond;
+static qthread_t *fs_prefetch_threads[FS_PREFETCH_NUM_THREADS];
+static volatile int fs_prefetch_shutdown;
+static fs_prefetch_t *fs_prefetch_hash[FS_PREFETCH_HASH_SIZE];
+static fs_prefetch_t *fs_prefetch_head, *fs_prefetch_tail;
+static size_t fs_prefetch_bytes;
+static int fs_prefetch_loading;     // number of entries being inflated by the workers
+
+/*
+* FS_FreePrefetch
+*/
+static void FS_FreePrefetch( fs_prefetch_t *pf ) {
+	fs_prefetch_bytes -= pf->size;
+	if( pf->data ) {
+		FS_Free( pf->data );
+	}
+	FS_Free( pf );
+}
+
+/*
+* FS_FindPrefetch
+*
+* Must be called with fs_prefetch_mutex held.
+*/
+static fs_prefetch_t *FS_FindPrefetch( const char *filename, unsigned hashKey, fs_prefetch_t ***pprev ) {
+	fs_prefetch_t *pf, **prev;
+
+	prev = &fs_prefetch_hash[hashKey % FS_PREFETCH_HASH_SIZE];
+	for( pf = *prev; pf; prev = &pf->hashNext, pf = pf->hashNext ) {
+		if( pf->hashKey == hashKey && !Q_stricmp( pf->name, filename ) ) {
+			if( pprev ) {
+				*pprev = prev;
+			}
+			return pf;
+		}
+	}
+	return NULL;
+}
+
+/*
+* FS_UnlinkPrefetch
+*
+* Removes the entry from the hash table. Entries which are queued or being
+* inflated are only flagged and later freed by the worker thread that owns them.
+*/
+static void FS_UnlinkPrefetch( fs_prefetch_t *pf, fs_prefetch_t **prev ) {
+	*prev = pf->hashNext;
+	pf->hashNext = NULL;
+
+	if( pf->state == FS_PREFETCH_QUEUED || pf->state == FS_PREFETCH_LOADING ) {
+		pf->cancelled = true;
+	} else {
+		FS_FreePrefetch( pf );
+	}
+}
+
+/*
+* FS_WaitPrefetch
+*
+* Waits until the entry is no longer being inflated. The mutex is released
+* while waiting and the entry may be unlinked and freed by another thread
+* meanwhile, so it is looked up again after every wait.
+* Must be called with fs_prefetch_mutex held.
+*/
+static fs_prefetch_t *FS_WaitPrefetch( const char *filename, unsigned hashKey, fs_prefetch_t ***pprev ) {
+	fs_prefetch_t *pf;
+
+	while( ( pf = FS_FindPrefetch( filename, hashKey, pprev ) ) != NULL && pf->state == FS_PREFETCH_LOADING ) {
+		QCondVar_Wait( fs_prefetch_done_cond, fs_prefetch_mutex, 10 );
+	}
+	return pf;
+}
+
+/*
+* FS_WaitPrefetchWorkers
+*
+* Waits until no entry is being inflated, so that none of them touches
+* a pak file anymore. Must be called with fs_prefetch_mutex held.
+*/
+static void FS_WaitPrefetchWorkers( void ) {
+	while( fs_prefetch_loading > 0 ) {
+		QCondVar_Wait( fs_prefetch_done_cond, fs_prefetch_mutex, 10 );
+	}
+}
+
+/*
+* FS_RunPrefetch
+*/
+static void FS_RunPrefetch( fs_prefetch_t *pf ) {
+	int filenum, size;
+
+	size = _FS_FOpenPakFile( pf->pakFile, &filenum );
+	if( size < 0 ) {
+		if( filenum ) {
+			FS_FCloseFile( filenum );
+		}
+		return;
+	}
+
+	pf->data = ( uint8_t * )FS_Malloc( size + 1 );
+	pf->data[size] = 0;
+	if( FS_Read( pf->data, size, filenum ) != size || (unsigned)size != pf->size ) {
+		FS_Free( pf->data );
+		pf->data = NULL;
+	}
+
+	FS_FCloseFile( filenum );
+}
+
+/*
+* FS_PrefetchThread
+*/
+static void *FS_PrefetchThread( void *param ) {
+	fs_prefetch_t *pf;
+
+	QMutex_Lock( fs_prefetch_mutex );
+
+	while( !fs_prefetch_shutdown ) {
+		pf = fs_prefetch_head;
+		if( !pf ) {
+			QCondVar_Wait( fs_prefetch_queue_cond, fs_prefetch_mutex, 100 );
+			continue;
+		}
+
+		fs_prefetch_head = pf->queueNext;
+		if( !fs_prefetch_head ) {
+			fs_prefetch_tail = NULL;
+		}
+		pf->queueNext = NULL;
+
+		if( pf->cancelled ) {
+			FS_FreePrefetch( pf );
+			continue;
+		}
+
+		pf->state = FS_PREFETCH_LOADING;
+		fs_prefetch_loading++;
+		QMutex_Unlock( fs_prefetch_mutex );
+
+		FS_RunPrefetch( pf );
+
+		QMutex_Lock( fs_prefetch_mutex );
+
+		fs_prefetch_loading--;
+		if( pf->cancelled ) {
+			FS_FreePrefetch( pf );
+		} else {
+			pf->state = pf->data ? FS_PREFETCH_READY : FS_PREFETCH_FAILED;
+			pf->readyTime = Sys_Milliseconds();
+		}
+		QCondVar_WakeAll( fs_prefetch_done_cond );
+	}
+
+	QMutex_Unlock( fs_prefetch_mutex );
+
+	return NULL;
+}
+
+/*
+* FS_InitPrefetch
+*/
+static void FS_InitPrefetch( void ) {
+	fs_prefetch_mutex = QMutex_Create();
+	fs_prefetch_queue_cond = QCondVar_Create();
+	fs_prefetch_done_cond = QCondVar_Create();
+	fs_prefetch_shutdown = 0;
+	fs_prefetch_head = fs_prefetch_tail = NULL;
+	fs_prefetch_bytes = 0;
+	fs_prefetch_loading = 0;
+	memset( fs_prefetch_hash, 0, sizeof( fs_prefetch_hash ) );
+	memset( fs_prefetch_threads, 0, sizeof( fs_prefetch_threads ) );
+}
+
+/*
+* FS_QueuePrefetch
+*
+* Must be called with fs_prefetch_mutex held. Worker threads are spawned on demand.
+*/
+static void FS_QueuePrefetch( fs_prefetch_t *pf ) {
+	int i;
+
+	pf->state = FS_PREFETCH_QUEUED;
+	pf->queueNext = NULL;
+	if( fs_prefetch_tail ) {
+		fs_prefetch_tail->queueNext = pf;
+	} else {
+		fs_prefetch_head = pf;
+	}
+	fs_prefetch_tail = pf;
+
+	if( !fs_prefetch_threads[0] ) {
+		for( i = 0; i < FS_PREFETCH_NUM_THREADS; i++ )
+			fs_prefetch_threads[i] = QThread_Create( FS_PrefetchThread, NULL );
+	}
+
+	QCondVar_Wake( fs_prefetch_queue_cond );
+}
+
+/*
+* FS_PrefetchFiles
+*
+* Starts inflating the given pak entries in background threads so that subsequent
+* FS_FOpenFile/FS_LoadFile calls for them don't block on decompression. Loose files
+* and files that can't be found are silently ignored.
+*/
+void FS_PrefetchFiles( const char **filenames, int numFiles ) {
+	int i;
+	unsigned hashKey;
+	packfile_t *pakFile;
+	fs_prefetch_t *pf, **prev;
+
+	if( !fs_prefetch || !fs_prefetch->integer ) {
+		return;
+	}
+
+	for( i = 0; i < numFiles; i++ ) {
+		if( !filenames[i] || !filenames[i][0] ) {
+			continue;
+		}
+		if( !FS_SearchPathForFile( filenames[i], &pakFile, NULL, 0, NULL, FS_SEARCH_ALL ) || !pakFile ) {
+			continue;
+		}
+		if( pakFile->flags & FS_PACKFILE_DIRECTORY ) {
+			continue;
+		}
+
+		hashKey = FS_HashFileName( filenames[i] );
+
+		QMutex_Lock( fs_prefetch_mutex );
+
+		pf = FS_FindPrefetch( filenames[i], hashKey, &prev );
+		if( pf ) {
+			if( pf->pakFile == pakFile ) {
+				QMutex_Unlock( fs_prefetch_mutex );
+				continue;
+			}
+
+			// the pure state must have changed, drop the stale entry
+			FS_UnlinkPrefetch( pf, prev );
+		}
+
+		if( fs_prefetch_bytes + pakFile->uncompressedSize > FS_PREFETCH_MAX_BYTES ) {
+			QMutex_Unlock( fs_prefetch_mutex );
+			continue;
+		}
+
+		pf = ( fs_prefetch_t * )FS_Malloc( sizeof( *pf ) + strlen( filenames[i] ) + 1 );
+		pf->name = ( char * )( pf + 1 );
+		strcpy( pf->name, filenames[i] );
+		pf->pakFile = pakFile;
+		pf->size = pakFile->uncompressedSize;
+		pf->hashKey = hashKey;
+		pf->hashNext = fs_prefetch_hash[hashKey % FS_PREFETCH_HASH_SIZE];
+		fs_prefetch_hash[hashKey % FS_PREFETCH_HASH_SIZE] = pf;
+		fs_prefetch_bytes += pakFile->uncompressedSize;
+
+		FS_QueuePrefetch( pf );
+
+		QMutex_Unlock( fs_prefetch_mutex );
+	}
+}
+
+/*
+* FS_OpenPrefetchedFile
+*
+* Hands the prefetched contents of the pak entry over to a new file handle.
+* Returns -1 if the file hasn't been prefetched.
+*/
+static int FS_OpenPrefetchedFile( const char *filename, packfile_t *pakFile, int *filenum ) {
+	int size;
+	unsigned hashKey;
+	filehandle_t *file;
+	fs_prefetch_t *pf, **prev;
+
+	*filenum = 0;
+
+	hashKey = FS_HashFileName( filename );
+
+	QMutex_Lock( fs_prefetch_mutex );
+
+	pf = FS_FindPrefetch( filename, hashKey, &prev );
+	if( !pf || pf->pakFile != pakFile ) {
+		QMutex_Unlock( fs_prefetch_mutex );
+		return -1;
+	}
+
+	if( pf->state == FS_PREFETCH_QUEUED ) {
+		// not started yet, it's faster to load it on the calling thread
+		FS_UnlinkPrefetch( pf, prev );
+		QMutex_Unlock( fs_prefetch_mutex );
+		return -1;
+	}
+
+	pf = FS_WaitPrefetch( filename, hashKey, &prev );
+	if( !pf || pf->pakFile != pakFile ) {
+		QMutex_Unlock( fs_prefetch_mutex );
+		return -1;
+	}
+
+	if( pf->state != FS_PREFETCH_READY ) {
+		FS_UnlinkPrefetch( pf, prev );
+		QMutex_Unlock( fs_prefetch_mutex );
+		return -1;
+	}
+
+	*filenum = FS_OpenFileHandle();
+	file = &fs_filehandles[*filenum - 1];
+	file->pakFile = pakFile;
+	file->prefetchData = pf->data;
+	file->uncompressedSize = pf->size;
+	size = (int)pf->size;
+
+	pf->data = NULL;
+	FS_UnlinkPrefetch( pf, prev );
+
+	QMutex_Unlock( fs_prefetch_mutex );
+
+	return size;
+}
+
+/*
+* FS_ExpirePrefetchedFiles
+*
+* Frees entries that have been sitting unclaimed for too long.
+*/
+static void FS_ExpirePrefetchedFiles( void ) {
+	int i;
+	int64_t now;
+	fs_prefetch_t *pf, **prev;
+
+	if( !fs_prefetch_bytes ) {
+		return;
+	}
+
+	now = Sys_Milliseconds();
+
+	QMutex_Lock( fs_prefetch_mutex );
+
+	for( i = 0; i < FS_PREFETCH_HASH_SIZE; i++ ) {
+		prev = &fs_prefetch_hash[i];
+		while( ( pf = *prev ) != NULL ) {
+			if( ( pf->state == FS_PREFETCH_READY || pf->state == FS_PREFETCH_FAILED )
+				&& pf->readyTime + FS_PREFETCH_TIMEOUT < now ) {
+				FS_UnlinkPrefetch( pf, prev );
+				continue;
+			}
+			prev = &pf->hashNext;
+		}
+	}
+
+	QMutex_Unlock( fs_prefetch_mutex );
+}
+
+/*
+* FS_FlushPrefetchedFiles
+*
+* Drops all prefetched data, must be called before pak files are freed.
+*/
+static void FS_FlushPrefetchedFiles( void ) {
+	int i;
+	fs_prefetch_t *pf, **prev;
+
+	if( !fs_prefetch_mutex ) {
+		return;
+	}
+
+	QMutex_Lock( fs_prefetch_mutex );
+
+	for( i = 0; i < FS_PREFETCH_HASH_SIZE; i++ ) {
+		prev = &fs_prefetch_hash[i];
+		while( ( pf = *prev ) != NULL ) {
+			FS_UnlinkPrefetch( pf, prev );
+		}
+	}
+
+	FS_WaitPrefetchWorkers();
+
+	QMutex_Unlock( fs_prefetch_mutex );
+}
+
+/*
+* FS_DropPrefetchedPak
+*
+* Drops the prefetched entries of a single pak, must be called before it is freed.
+*/
+static void FS_DropPrefetchedPak( const pack_t *pack ) {
+	int i;
+	fs_prefetch_t *pf, **prev;
+
+	if( !fs_prefetch_mutex || !pack->files ) {
+		return;
+	}
+
+	QMutex_Lock( fs_prefetch_mutex );
+
+	if( !fs_prefetch_bytes ) {
+		QMutex_Unlock( fs_prefetch_mutex );
+		return;
+	}
+
+	for( i = 0; i < FS_PREFETCH_HASH_SIZE; i++ ) {
+		prev = &fs_prefetch_hash[i];
+		while( ( pf = *prev ) != NULL ) {
+			if( pf->pakFile >= pack->files && pf->pakFile < pack->files + pack->numFiles ) {
+				FS_UnlinkPrefetch( pf, prev );
+				continue;
+			}
+			prev = &pf->hashNext;
+		}
+	}
+
+	FS_WaitPrefetchWorkers();
+
+	QMutex_Unlock( fs_prefetch_mutex );
+}
+
+/*
+* FS_ShutdownPrefetch
+*/
+static void FS_ShutdownPrefetch( void ) {
+	int i;
+	fs_prefetch_t *pf;
+
+	FS_FlushPrefetchedFiles();
+
+	QMutex_Lock( fs_prefetch_mutex );
+
+	fs_prefetch_shutdown = 1;
+	for( i = 0; i < FS_PREFETCH_NUM_THREADS; i++ )
+		QCondVar_Wake( fs_prefetch_queue_cond );
+
+	QMutex_Unlock( fs_prefetch_mutex );
+
+	for( i = 0; i < FS_PREFETCH_NUM_THREADS; i++ ) {
+		if( fs_prefetch_threads[i] ) {
+			QThread_Join( fs_prefetch_threads[i] );
+			fs_prefetch_threads[i] = NULL;
+		}
+	}
+
+	while( ( pf = fs_prefetch_head ) != NULL ) {
+		fs_prefetch_head = pf->queueNext;
+		FS_FreePrefetch( pf );
+	}
+	fs_prefetch_tail = NULL;
+
+	QCondVar_Destroy( &fs_prefetch_done_cond );
+	QCondVar_Destroy( &fs_prefetch_queue_cond );
+	QMutex_Destroy( &fs_prefetch_mutex );
+}
+
+/*
+* FS_ChecksumAbsoluteFile
+*/
+unsigned FS_ChecksumAbsoluteFile( const char *filename ) {
+	uint8_t buffer[FS_MAX_BLOCK_SIZE];
+	int left, length, filenum;
+	md5_byte_t digest[16];
+	md5_state_t state;
+
+	Com_DPrintf( "Calculating checksum for file: %s\n", filename );
+
+	md5_init( &state );
+
+	left = FS_FOpenAbsoluteFile( filename, &filenum, FS_READ );
+	if( left == -1 ) {
+		return 0;
+	}
+
+	while( ( length = FS_Read( buffer, sizeof( buffer ), filenum ) ) ) {
+		left -= length;
+		md5_append( &state, (md5_byte_t *)buffer, length );
+	}
+
+	FS_FCloseFile( filenum );
+	md5_finish( &state, digest );
+
+	if( left != 0 ) {
+		return 0;
+	}
 
 	return md5_reduce( digest );
 }
@@ -1893,6 +2811,7 @@ static unsigned FS_PakChecksum( const char *filename ) {
 */
 unsigned FS_ChecksumBaseFile( const char *filename, bool ignorePakChecksum ) {
 	const char *fullname;
+	unsigned checksum;
 
 	if( !ignorePakChecksum && FS_CheckPakExtension( filename ) ) {
 		return FS_PakChecksum( filename );
@@ -1903,7 +2822,17 @@ unsigned FS_ChecksumBaseFile( const char *filename, bool ignorePakChecksum ) {
 		return false;
 	}
 
-	return FS_ChecksumAbsoluteFile( fullname );
+	if( !FS_CheckPakExtension( fullname ) ) {
+		return FS_ChecksumAbsoluteFile( fullname );
+	}
+
+	if( FS_CachedPakFileChecksum( fullname, &checksum ) ) {
+		return checksum;
+	}
+
+	checksum = FS_ChecksumAbsoluteFile( fullname );
+	FS_SetCachedPakFileChecksum( fullname, checksum );
+	return checksum;
 }
 
 /*
@@ -1919,6 +2848,7 @@ bool FS_AddPurePak( unsigned checksum ) {
 		if( search->pack && search->pack->checksum == checksum ) {
 			if( search->pack->pure < FS_PURE_IMPLICIT ) {
 				search->pack->pure = FS_PURE_IMPLICIT;
+				FS_InvalidateFileIndex();
 			}
 			result = true;
 			break;
@@ -1941,6 +2871,7 @@ void FS_RemovePurePaks( void ) {
 	for( search = fs_searchpaths; search; search = search->next ) {
 		if( search->pack && search->pack->pure == FS_PURE_IMPLICIT ) {
 			search->pack->pure = FS_PURE_NONE;
+			FS_InvalidateFileIndex();
 		}
 	}
 
@@ -2236,166 +3167,738 @@ static void FS_ReadPackManifest( pack_t *pack ) {
 	if( ( size > -1 ) && file ) {
 		pack->manifest = ( char* )FS_Malloc( size + 1 );
 
-		// read the file into memory
-		FS_Read( ( uint8_t * )pack->manifest, size, file );
-		FS_FCloseFile( file );
+		// read the file into memory
+		FS_Read( ( uint8_t * )pack->manifest, size, file );
+		FS_FCloseFile( file );
+
+		// compress (get rid of comments, etc)
+		COM_Compress( pack->manifest );
+	}
+}
+
+/*
+* FS_PK3SearchCentralDir
+*
+* Locate the central directory of a zipfile (at the end, just before the global comment)
+*/
+static unsigned FS_PK3SearchCentralDir( FILE *fin, void *vfsHandle ) {
+	unsigned fileSize, backRead;
+	unsigned maxBack = 0xffff; // maximum size of global comment
+	unsigned char buf[FS_ZIP_BUFREADCOMMENT + 4];
+	unsigned vfsOffset = 0;
+
+	if( vfsHandle ) {
+		vfsOffset = Sys_VFS_FileOffset( vfsHandle );
+		if( fseek( fin, vfsOffset + Sys_VFS_FileSize( vfsHandle ), SEEK_SET ) != 0 ) {
+			return 0;
+		}
+	} else {
+		if( fseek( fin, 0, SEEK_END ) != 0 ) {
+			return 0;
+		}
+	}
+
+	fileSize = ftell( fin ) - vfsOffset;
+	if( maxBack > fileSize ) {
+		maxBack = fileSize;
+	}
+
+	backRead = 4;
+	while( backRead < maxBack ) {
+		unsigned i, readSize, readPos;
+
+		if( backRead + FS_ZIP_BUFREADCOMMENT > maxBack ) {
+			backRead = maxBack;
+		} else {
+			backRead += FS_ZIP_BUFREADCOMMENT;
+		}
+
+		readPos = fileSize - backRead;
+		readSize = min( FS_ZIP_BUFREADCOMMENT + 4, backRead );
+		if( readSize < 4 ) {
+			continue;
+		}
+
+		if( fseek( fin, vfsOffset + readPos, SEEK_SET ) != 0 ) {
+			break;
+		}
+		if( fread( buf, 1, readSize, fin ) != readSize ) {
+			break;
+		}
+
+		for( i = readSize - 3; i--; ) {
+			// check the magic
+			if( LittleLongRaw( buf + i ) == FS_ZIP_ENDHEADERMAGIC ) {
+				return readPos + i;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+* FS_DosTimeToUnixtime
+*
+* Converts DOS time to tm struct
+*/
+static time_t FS_DosTimeToUnixtime( unsigned dosDateTime ) {
+	unsigned dosDate;
+	struct tm ttm = { 0 };
+	time_t time;
+
+	dosDate = (unsigned)( dosDateTime >> 16 );
+
+	ttm.tm_hour = ( dosDateTime & 0xF800 ) / 0x800;
+	ttm.tm_min  = ( dosDateTime & 0x7E0 ) / 0x20;
+	ttm.tm_sec  =  2 * ( dosDateTime & 0x1f );
+
+	ttm.tm_mday = dosDate & 0x1f;
+	ttm.tm_mon  = ( ( ( dosDate ) & 0x1E0 ) / 0x20 ) - 1;
+	ttm.tm_year = ( ( dosDate & 0x0FE00 ) / 0x0200 ) + 1980 - 1900;
+
+	time = mktime( &ttm );
+	return time;
+}
+
+/*
+* FS_PK3GetFileInfo
+*
+* Get Info about the current file in the zipfile, with internal only info
+*/
+static unsigned FS_PK3GetFileInfo( FILE *f, void *vfsHandle, unsigned pos, unsigned byteBeforeTheZipFile,
+								   packfile_t *file, size_t *fileNameLen, int *crc ) {
+	size_t sizeRead;
+	unsigned dosDateTime;
+	unsigned compressed;
+	unsigned char infoHeader[46]; // we can't use a struct here because of packing
+
+	if( fseek( f, Sys_VFS_FileOffset( vfsHandle ) + pos, SEEK_SET ) != 0 ) {
+		return 0;
+	}
+	if( fread( infoHeader, 1, sizeof( infoHeader ), f ) != sizeof( infoHeader ) ) {
+		return 0;
+	}
+
+	// check the magic
+	if( LittleLongRaw( &infoHeader[0] ) != FS_ZIP_CENTRALHEADERMAGIC ) {
+		return 0;
+	}
+
+	compressed = LittleShortRaw( &infoHeader[10] );
+	if( compressed && ( compressed != Z_DEFLATED ) ) {
+		return 0;
+	}
+
+	dosDateTime = LittleLongRaw( &infoHeader[12] );
+
+	if( crc ) {
+		*crc = LittleLongRaw( &infoHeader[16] );
+	}
+	if( file ) {
+		if( compressed == Z_DEFLATED ) {
+			file->flags |= FS_PACKFILE_DEFLATED;
+		}
+		file->compressedSize = LittleLongRaw( &infoHeader[20] );
+		file->uncompressedSize = LittleLongRaw( &infoHeader[24] );
+		file->offset = LittleLongRaw( &infoHeader[42] ) + byteBeforeTheZipFile;
+		file->mtime = FS_DosTimeToUnixtime( dosDateTime );
+	}
+
+	sizeRead = ( size_t )LittleShortRaw( &infoHeader[28] );
+	if( !sizeRead ) {
+		return 0;
+	}
+
+	if( fileNameLen ) {
+		*fileNameLen = sizeRead;
+	}
+
+	if( file ) {
+		if( fread( file->name, 1, sizeRead, f ) != sizeRead ) {
+			return 0;
+		}
+
+		*( file->name + sizeRead ) = 0;
+		if( *( file->name + sizeRead - 1 ) == '/' ) {
+			file->flags |= FS_PACKFILE_DIRECTORY;
+		}
+	}
+
+	return FS_ZIP_SIZECENTRALDIRITEM + ( unsigned )LittleShortRaw( &infoHeader[28] ) +
+		   ( unsigned )LittleShortRaw( &infoHeader[30] ) + ( unsigned )LittleShortRaw( &infoHeader[32] );
+}
+
+/*
+=============================================================================
+
+PAK MOUNT CACHE
+
+Parsed central directories of pk3 files are stored in a binary file in the cache
+directory, keyed by the pak path, size and modification time. On a hit, mounting
+a pak doesn't have to read its central directory at all.
+
+File layout: header, then one record per pak:
+	int pathLen, char path[pathLen]
+	fs_pakcache_disk_t
+	fs_pakcache_file_t files[numFiles]
+	char names[namesLen]
+followed by the trailing magic number.
+
+=============================================================================
+*/
+
+#define FS_PAKCACHE_FILE            "paks.cache"
+#define FS_PAKCACHE_MAGIC           ( ( 'C' << 24 ) + ( 'K' << 16 ) + ( 'P' << 8 ) + 'Q' )
+#define FS_PAKCACHE_VERSION         2
+#define FS_PAKCACHE_HASH_SIZE       256
+
+typedef struct {
+	int magic;
+	int version;
+	int numRecords;
+} fs_pakcache_header_t;
+
+typedef struct {
+	int64_t size;
+	int64_t mtime;
+	unsigned checksum;
+	unsigned fileChecksum;          // md5 of the whole file, 0 if not computed yet
+	int numFiles;
+	unsigned namesLen;
+} fs_pakcache_disk_t;
+
+typedef struct {
+	unsigned flags;
+	unsigned compressedSize;
+	unsigned uncompressedSize;
+	unsigned offset;
+	int64_t mtime;
+} fs_pakcache_file_t;
+
+typedef struct fs_pakcache_s {
+	char *path;
+	unsigned hashKey;
+	fs_pakcache_disk_t disk;
+	fs_pakcache_file_t *files;
+	char *names;
+	bool used;                      // mounted or verified during this session
+	struct fs_pakcache_s *hashNext;
+	struct fs_pakcache_s *prev, *next;
+} fs_pakcache_t;
+
+static cvar_t *fs_pakcache;
+static qmutex_t *fs_pakcache_mutex;
+static fs_pakcache_t *fs_pakcache_hash[FS_PAKCACHE_HASH_SIZE];
+static fs_pakcache_t fs_pakcache_headnode;
+static bool fs_pakcache_dirty;
+static unsigned fs_pakcache_hits, fs_pakcache_misses;
+
+/*
+* FS_PakCacheFileName
+*/
+static const char *FS_PakCacheFileName( char *buf, size_t size ) {
+	Q_snprintfz( buf, size, "%s/%s", FS_CacheDirectory(), FS_PAKCACHE_FILE );
+	return buf;
+}
+
+/*
+* FS_AllocPakCacheRecord
+*/
+static fs_pakcache_t *FS_AllocPakCacheRecord( const char *path, const fs_pakcache_disk_t *disk ) {
+	size_t pathLen = strlen( path ) + 1;
+	fs_pakcache_t *rec;
+
+	rec = ( fs_pakcache_t * )FS_Malloc( sizeof( *rec ) + disk->numFiles * sizeof( fs_pakcache_file_t ) + disk->namesLen + pathLen );
+	rec->disk = *disk;
+	rec->files = ( fs_pakcache_file_t * )( rec + 1 );
+	rec->names = ( char * )( rec->files + disk->numFiles );
+	rec->path = rec->names + disk->namesLen;
+	memcpy( rec->path, path, pathLen );
+	rec->hashKey = FS_HashFileName( path );
+	return rec;
+}
+
+/*
+* FS_UnlinkPakCacheRecord
+*/
+static void FS_UnlinkPakCacheRecord( fs_pakcache_t *rec ) {
+	fs_pakcache_t **prev;
+
+	for( prev = &fs_pakcache_hash[rec->hashKey % FS_PAKCACHE_HASH_SIZE]; *prev; prev = &( *prev )->hashNext ) {
+		if( *prev == rec ) {
+			*prev = rec->hashNext;
+			break;
+		}
+	}
+
+	rec->prev->next = rec->next;
+	rec->next->prev = rec->prev;
+}
+
+/*
+* FS_LinkPakCacheRecord
+*
+* Replaces the older record for the same path, if any.
+*/
+static void FS_LinkPakCacheRecord( fs_pakcache_t *rec ) {
+	fs_pakcache_t *old;
+
+	for( old = fs_pakcache_hash[rec->hashKey % FS_PAKCACHE_HASH_SIZE]; old; old = old->hashNext ) {
+		if( old->hashKey == rec->hashKey && !strcmp( old->path, rec->path ) ) {
+			FS_UnlinkPakCacheRecord( old );
+			FS_Free( old );
+			break;
+		}
+	}
+
+	rec->hashNext = fs_pakcache_hash[rec->hashKey % FS_PAKCACHE_HASH_SIZE];
+	fs_pakcache_hash[rec->hashKey % FS_PAKCACHE_HASH_SIZE] = rec;
+
+	rec->prev = &fs_pakcache_headnode;
+	rec->next = fs_pakcache_headnode.next;
+	rec->next->prev = rec;
+	rec->prev->next = rec;
+}
+
+/*
+* FS_FindPakCacheRecord
+*
+* Must be called with fs_pakcache_mutex held.
+*/
+static fs_pakcache_t *FS_FindPakCacheRecord( const char *path ) {
+	unsigned hashKey = FS_HashFileName( path );
+	fs_pakcache_t *rec;
+
+	for( rec = fs_pakcache_hash[hashKey % FS_PAKCACHE_HASH_SIZE]; rec; rec = rec->hashNext ) {
+		if( rec->hashKey == hashKey && !strcmp( rec->path, path ) ) {
+			return rec;
+		}
+	}
+	return NULL;
+}
+
+/*
+* FS_ClearPakCache
+*/
+static void FS_ClearPakCache( void ) {
+	fs_pakcache_t *rec, *next;
+
+	for( rec = fs_pakcache_headnode.next; rec != &fs_pakcache_headnode; rec = next ) {
+		next = rec->next;
+		FS_Free( rec );
+	}
+
+	memset( fs_pakcache_hash, 0, sizeof( fs_pakcache_hash ) );
+	fs_pakcache_headnode.prev = fs_pakcache_headnode.next = &fs_pakcache_headnode;
+}
+
+/*
+* FS_ValidPakCacheNames
+*
+* The names block must hold exactly numFiles NUL-terminated strings.
+*/
+static bool FS_ValidPakCacheNames( const char *names, size_t namesLen, int numFiles ) {
+	int i;
+	const char *p, *end, *nul;
+
+	p = names;
+	end = names + namesLen;
+	for( i = 0; i < numFiles; i++ ) {
+		nul = p < end ? ( const char * )memchr( p, '\0', end - p ) : NULL;
+		if( !nul ) {
+			return false;
+		}
+		p = nul + 1;
+	}
+
+	return p == end;
+}
+
+/*
+* FS_ReadPakCache
+*/
+static void FS_ReadPakCache( void ) {
+	int i, numRecords;
+	int length, filenum;
+	uint8_t *buf, *p, *end;
+	fs_pakcache_header_t header;
+	char filename[FS_MAX_PATH];
+
+	length = FS_FOpenAbsoluteFile( FS_PakCacheFileName( filename, sizeof( filename ) ), &filenum, FS_READ );
+	if( !filenum ) {
+		return;
+	}
+
+	if( length < (int)( sizeof( header ) + sizeof( int ) ) ) {
+		FS_FCloseFile( filenum );
+		return;
+	}
+
+	buf = ( uint8_t * )Mem_TempMalloc( length );
+	if( FS_Read( buf, length, filenum ) != length ) {
+		FS_FCloseFile( filenum );
+		Mem_TempFree( buf );
+		return;
+	}
+	FS_FCloseFile( filenum );
+
+	memcpy( &header, buf, sizeof( header ) );
+	memcpy( &i, buf + length - sizeof( int ), sizeof( int ) );
+	if( header.magic != FS_PAKCACHE_MAGIC || header.version != FS_PAKCACHE_VERSION || i != FS_PAKCACHE_MAGIC ) {
+		Com_DPrintf( "Ignoring pak cache %s: bad header\n", filename );
+		Mem_TempFree( buf );
+		return;
+	}
+
+	p = buf + sizeof( header );
+	end = buf + length - sizeof( int );
+	numRecords = header.numRecords;
+
+	for( i = 0; i < numRecords; i++ ) {
+		int pathLen;
+		size_t filesSize;
+		fs_pakcache_disk_t disk;
+		fs_pakcache_t *rec;
+		char path[FS_MAX_PATH];
+
+		if( p + sizeof( pathLen ) > end ) {
+			break;
+		}
+		memcpy( &pathLen, p, sizeof( pathLen ) );
+		p += sizeof( pathLen );
+		if( pathLen <= 0 || pathLen >= FS_MAX_PATH || p + pathLen + sizeof( disk ) > end ) {
+			break;
+		}
+		memcpy( path, p, pathLen );
+		path[pathLen] = '\0';
+		p += pathLen;
+
+		memcpy( &disk, p, sizeof( disk ) );
+		p += sizeof( disk );
+
+		if( disk.numFiles <= 0 || disk.numFiles > 0xffff ) {
+			break;
+		}
+		filesSize = disk.numFiles * sizeof( fs_pakcache_file_t );
+		if( (size_t)( end - p ) < filesSize + disk.namesLen
+			|| !FS_ValidPakCacheNames( ( const char * )p + filesSize, disk.namesLen, disk.numFiles ) ) {
+			break;
+		}
+
+		rec = FS_AllocPakCacheRecord( path, &disk );
+		memcpy( rec->files, p, filesSize );
+		memcpy( rec->names, p + filesSize, disk.namesLen );
+		p += filesSize + disk.namesLen;
+
+		FS_LinkPakCacheRecord( rec );
+	}
+
+	if( i != numRecords ) {
+		Com_Printf( S_COLOR_YELLOW "Pak cache %s is corrupt, discarding\n", filename );
+		FS_ClearPakCache();
+		fs_pakcache_dirty = true;
+	}
+
+	Mem_TempFree( buf );
+}
+
+/*
+* FS_WritePakCache
+*
+* Records that haven't been used during this session are only kept
+* if the pak they describe is still there and unmodified.
+*/
+static void FS_WritePakCache( void ) {
+	int filenum, numRecords, pathLen, magic;
+	fs_pakcache_t *rec, *next;
+	fs_pakcache_header_t header;
+	char filename[FS_MAX_PATH];
+
+	if( !fs_pakcache->integer || !fs_pakcache_dirty ) {
+		return;
+	}
+
+	QMutex_Lock( fs_pakcache_mutex );
+
+	numRecords = 0;
+	for( rec = fs_pakcache_headnode.next; rec != &fs_pakcache_headnode; rec = next ) {
+		next = rec->next;
+		if( !rec->used && ( FS_AbsoluteFileExists( rec->path ) != rec->disk.size
+							|| (int64_t)Sys_FS_FileMTime( rec->path ) != rec->disk.mtime ) ) {
+			FS_UnlinkPakCacheRecord( rec );
+			FS_Free( rec );
+			continue;
+		}
+		numRecords++;
+	}
+
+	if( FS_FOpenAbsoluteFile( FS_PakCacheFileName( filename, sizeof( filename ) ), &filenum, FS_WRITE ) == -1 ) {
+		QMutex_Unlock( fs_pakcache_mutex );
+		Com_DPrintf( "Could not open %s for writing\n", filename );
+		return;
+	}
+
+	header.magic = FS_PAKCACHE_MAGIC;
+	header.version = FS_PAKCACHE_VERSION;
+	header.numRecords = numRecords;
+	FS_Write( &header, sizeof( header ), filenum );
+
+	for( rec = fs_pakcache_headnode.prev; rec != &fs_pakcache_headnode; rec = rec->prev ) {
+		pathLen = strlen( rec->path );
+		FS_Write( &pathLen, sizeof( pathLen ), filenum );
+		FS_Write( rec->path, pathLen, filenum );
+		FS_Write( &rec->disk, sizeof( rec->disk ), filenum );
+		FS_Write( rec->files, rec->disk.numFiles * sizeof( *rec->files ), filenum );
+		FS_Write( rec->names, rec->disk.namesLen, filenum );
+	}
+
+	magic = FS_PAKCACHE_MAGIC;
+	FS_Write( &magic, sizeof( magic ), filenum );
+	FS_FCloseFile( filenum );
+
+	fs_pakcache_dirty = false;
+
+	QMutex_Unlock( fs_pakcache_mutex );
+}
+
+/*
+* FS_StorePakInCache
+*/
+static void FS_StorePakInCache( const pack_t *pack, int64_t size, int64_t mtime ) {
+	int i;
+	char *names;
+	fs_pakcache_disk_t disk;
+	fs_pakcache_t *rec;
+	fs_pakcache_file_t *out;
+	const packfile_t *in;
+
+	disk.size = size;
+	disk.mtime = mtime;
+	disk.checksum = pack->checksum;
+	disk.fileChecksum = 0;
+	disk.numFiles = pack->numFiles;
+	disk.namesLen = 0;
+	for( i = 0; i < pack->numFiles; i++ ) {
+		disk.namesLen += strlen( pack->files[i].name ) + 1;
+	}
+
+	rec = FS_AllocPakCacheRecord( pack->filename, &disk );
+	rec->used = true;
+
+	names = rec->names;
+	for( i = 0, in = pack->files, out = rec->files; i < pack->numFiles; i++, in++, out++ ) {
+		size_t len = strlen( in->name ) + 1;
+
+		out->flags = in->flags;
+		out->compressedSize = in->compressedSize;
+		out->uncompressedSize = in->uncompressedSize;
+		out->offset = in->offset;
+		out->mtime = in->mtime;
+
+		memcpy( names, in->name, len );
+		names += len;
+	}
+
+	QMutex_Lock( fs_pakcache_mutex );
+	FS_LinkPakCacheRecord( rec );
+	fs_pakcache_dirty = true;
+	QMutex_Unlock( fs_pakcache_mutex );
+}
+
+/*
+* FS_BuildPackTrie
+*
+* Indexes all files of the pack at once, a name repeated in the pack resolves to the last entry.
+*/
+static void FS_BuildPackTrie( pack_t *pack ) {
+	int i;
+	size_t mark;
+	trie_key_value_t *files;
+
+	mark = Mem_ScratchMark();
+	files = ( trie_key_value_t * )Mem_ScratchAlloc( pack->numFiles * sizeof( *files ) );
+	for( i = 0; i < pack->numFiles; i++ ) {
+		files[i].key = pack->files[i].name;
+		files[i].value = &pack->files[i];
+	}
+	Trie_InsertBulk( pack->trie, files, pack->numFiles );
+	Mem_ScratchFreeToMark( mark );
+}
+
+/*
+* FS_LoadCachedPK3File
+*
+* Mounts the pak from its cached central directory, returns NULL on a cache miss.
+*/
+static pack_t *FS_LoadCachedPK3File( const char *packfilename, int64_t size, int64_t mtime, void *handle, bool silent ) {
+	int i;
+	char *names;
+	pack_t *pack;
+	packfile_t *file;
+	fs_pakcache_t *rec;
+	const fs_pakcache_file_t *in;
+	bool modulepack, hasManifest;
+
+	QMutex_Lock( fs_pakcache_mutex );
+
+	rec = FS_FindPakCacheRecord( packfilename );
+	if( !rec || rec->disk.size != size || rec->disk.mtime != mtime ) {
+		fs_pakcache_misses++;
+		QMutex_Unlock( fs_pakcache_mutex );
+		return NULL;
+	}
+
+	rec->used = true;
+	fs_pakcache_hits++;
+
+	pack = ( pack_t* )FS_Malloc( (int)( sizeof( pack_t ) + rec->disk.numFiles * sizeof( packfile_t ) + rec->disk.namesLen + 1 ) );
+	pack->filename = FS_CopyString( packfilename );
+	pack->files = ( packfile_t * )( ( uint8_t * )pack + sizeof( pack_t ) );
+	pack->fileNames = names = ( char * )( ( uint8_t * )pack->files + rec->disk.numFiles * sizeof( packfile_t ) );
+	pack->numFiles = rec->disk.numFiles;
+	pack->checksum = rec->disk.checksum;
+	pack->sysHandle = handle;
+	pack->vfsHandle = NULL;
+	pack->pure = FS_IsExplicitPurePak( packfilename, NULL ) ? FS_PURE_EXPLICIT : FS_PURE_NONE;
+
+	memcpy( names, rec->names, rec->disk.namesLen );
 
-		// compress (get rid of comments, etc)
-		COM_Compress( pack->manifest );
-	}
-}
+	Trie_Create( TRIE_CASE_INSENSITIVE, &pack->trie );
 
-/*
-* FS_PK3SearchCentralDir
-*
-* Locate the central directory of a zipfile (at the end, just before the global comment)
-*/
-static unsigned FS_PK3SearchCentralDir( FILE *fin, void *vfsHandle ) {
-	unsigned fileSize, backRead;
-	unsigned maxBack = 0xffff; // maximum size of global comment
-	unsigned char buf[FS_ZIP_BUFREADCOMMENT + 4];
-	unsigned vfsOffset = 0;
+	modulepack = !Q_strnicmp( COM_FileBase( packfilename ), "modules", strlen( "modules" ) );
+	hasManifest = false;
 
-	if( vfsHandle ) {
-		vfsOffset = Sys_VFS_FileOffset( vfsHandle );
-		if( fseek( fin, vfsOffset + Sys_VFS_FileSize( vfsHandle ), SEEK_SET ) != 0 ) {
-			return 0;
-		}
-	} else {
-		if( fseek( fin, 0, SEEK_END ) != 0 ) {
-			return 0;
+	for( i = 0, file = pack->files, in = rec->files; i < pack->numFiles; i++, file++, in++ ) {
+		file->name = names;
+		file->pakname = pack->filename;
+		file->vfsHandle = NULL;
+		file->flags = in->flags;
+		file->compressedSize = in->compressedSize;
+		file->uncompressedSize = in->uncompressedSize;
+		file->offset = in->offset;
+		file->mtime = in->mtime;
+		names += strlen( names ) + 1;
+
+		if( modulepack && file->uncompressedSize > 0 && !( file->flags & FS_PACKFILE_DIRECTORY )
+			&& !Q_stricmp( file->name, FS_PAK_MANIFEST_FILE ) ) {
+			hasManifest = true;
 		}
 	}
 
-	fileSize = ftell( fin ) - vfsOffset;
-	if( maxBack > fileSize ) {
-		maxBack = fileSize;
+	FS_BuildPackTrie( pack );
+
+	QMutex_Unlock( fs_pakcache_mutex );
+
+	if( hasManifest ) {
+		FS_ReadPackManifest( pack );
 	}
 
-	backRead = 4;
-	while( backRead < maxBack ) {
-		unsigned i, readSize, readPos;
+	if( !silent ) {
+		Com_Printf( "Added pk3 file %s (%i files, cached)\n", pack->filename, pack->numFiles );
+	}
 
-		if( backRead + FS_ZIP_BUFREADCOMMENT > maxBack ) {
-			backRead = maxBack;
-		} else {
-			backRead += FS_ZIP_BUFREADCOMMENT;
-		}
+	return pack;
+}
 
-		readPos = fileSize - backRead;
-		readSize = min( FS_ZIP_BUFREADCOMMENT + 4, backRead );
-		if( readSize < 4 ) {
-			continue;
-		}
+/*
+* FS_InitPakCache
+*/
+static void FS_InitPakCache( void ) {
+	fs_pakcache = Cvar_Get( "fs_pakcache", "1", CVAR_ARCHIVE );
 
-		if( fseek( fin, vfsOffset + readPos, SEEK_SET ) != 0 ) {
-			break;
-		}
-		if( fread( buf, 1, readSize, fin ) != readSize ) {
-			break;
-		}
+	fs_pakcache_mutex = QMutex_Create();
+	memset( fs_pakcache_hash, 0, sizeof( fs_pakcache_hash ) );
+	fs_pakcache_headnode.prev = fs_pakcache_headnode.next = &fs_pakcache_headnode;
+	fs_pakcache_dirty = false;
+	fs_pakcache_hits = fs_pakcache_misses = 0;
 
-		for( i = readSize - 3; i--; ) {
-			// check the magic
-			if( LittleLongRaw( buf + i ) == FS_ZIP_ENDHEADERMAGIC ) {
-				return readPos + i;
-			}
-		}
+	if( fs_pakcache->integer ) {
+		FS_ReadPakCache();
 	}
-
-	return 0;
 }
 
 /*
-* FS_DosTimeToUnixtime
-*
-* Converts DOS time to tm struct
+* FS_ShutdownPakCache
 */
-static time_t FS_DosTimeToUnixtime( unsigned dosDateTime ) {
-	unsigned dosDate;
-	struct tm ttm = { 0 };
-	time_t time;
+static void FS_ShutdownPakCache( void ) {
+	FS_WritePakCache();
 
-	dosDate = (unsigned)( dosDateTime >> 16 );
+	FS_ClearPakCache();
+	QMutex_Destroy( &fs_pakcache_mutex );
+}
 
-	ttm.tm_hour = ( dosDateTime & 0xF800 ) / 0x800;
-	ttm.tm_min  = ( dosDateTime & 0x7E0 ) / 0x20;
-	ttm.tm_sec  =  2 * ( dosDateTime & 0x1f );
+/*
+=============================================================================
 
-	ttm.tm_mday = dosDate & 0x1f;
-	ttm.tm_mon  = ( ( ( dosDate ) & 0x1E0 ) / 0x20 ) - 1;
-	ttm.tm_year = ( ( dosDate & 0x0FE00 ) / 0x0200 ) + 1980 - 1900;
+PAK FILE CHECKSUMS
 
-	time = mktime( &ttm );
-	return time;
+Full-content checksums of pk3 files are computed the first time they are
+asked for and stored in the pak mount cache, so they are only recomputed
+after the pak has been modified.
+
+=============================================================================
+*/
+
+/*
+* FS_PakFileStat
+*/
+static bool FS_PakFileStat( const char *filename, int64_t *size, int64_t *mtime ) {
+	*size = FS_AbsoluteFileExists( filename );
+	if( *size == -1 ) {
+		return false;
+	}
+	*mtime = (int64_t)Sys_FS_FileMTime( filename );
+	return true;
 }
 
 /*
-* FS_PK3GetFileInfo
+* FS_CachedPakFileChecksum
 *
-* Get Info about the current file in the zipfile, with internal only info
+* Returns the full-content checksum of the pak if it's known and the file hasn't been modified since.
 */
-static unsigned FS_PK3GetFileInfo( FILE *f, void *vfsHandle, unsigned pos, unsigned byteBeforeTheZipFile,
-								   packfile_t *file, size_t *fileNameLen, int *crc ) {
-	size_t sizeRead;
-	unsigned dosDateTime;
-	unsigned compressed;
-	unsigned char infoHeader[46]; // we can't use a struct here because of packing
+static bool FS_CachedPakFileChecksum( const char *filename, unsigned *checksum ) {
+	int64_t size, mtime;
+	fs_pakcache_t *rec;
+	bool found = false;
 
-	if( fseek( f, Sys_VFS_FileOffset( vfsHandle ) + pos, SEEK_SET ) != 0 ) {
-		return 0;
-	}
-	if( fread( infoHeader, 1, sizeof( infoHeader ), f ) != sizeof( infoHeader ) ) {
-		return 0;
+	if( !FS_PakFileStat( filename, &size, &mtime ) ) {
+		return false;
 	}
 
-	// check the magic
-	if( LittleLongRaw( &infoHeader[0] ) != FS_ZIP_CENTRALHEADERMAGIC ) {
-		return 0;
-	}
+	QMutex_Lock( fs_pakcache_mutex );
 
-	compressed = LittleShortRaw( &infoHeader[10] );
-	if( compressed && ( compressed != Z_DEFLATED ) ) {
-		return 0;
+	rec = FS_FindPakCacheRecord( filename );
+	if( rec && rec->disk.fileChecksum && rec->disk.size == size && rec->disk.mtime == mtime ) {
+		*checksum = rec->disk.fileChecksum;
+		found = true;
 	}
 
-	dosDateTime = LittleLongRaw( &infoHeader[12] );
+	QMutex_Unlock( fs_pakcache_mutex );
 
-	if( crc ) {
-		*crc = LittleLongRaw( &infoHeader[16] );
-	}
-	if( file ) {
-		if( compressed == Z_DEFLATED ) {
-			file->flags |= FS_PACKFILE_DEFLATED;
-		}
-		file->compressedSize = LittleLongRaw( &infoHeader[20] );
-		file->uncompressedSize = LittleLongRaw( &infoHeader[24] );
-		file->offset = LittleLongRaw( &infoHeader[42] ) + byteBeforeTheZipFile;
-		file->mtime = FS_DosTimeToUnixtime( dosDateTime );
-	}
+	return found;
+}
 
-	sizeRead = ( size_t )LittleShortRaw( &infoHeader[28] );
-	if( !sizeRead ) {
-		return 0;
-	}
+/*
+* FS_SetCachedPakFileChecksum
+*/
+static void FS_SetCachedPakFileChecksum( const char *filename, unsigned checksum ) {
+	int64_t size, mtime;
+	fs_pakcache_t *rec;
 
-	if( fileNameLen ) {
-		*fileNameLen = sizeRead;
+	if( !checksum || !FS_PakFileStat( filename, &size, &mtime ) ) {
+		return;
 	}
 
-	if( file ) {
-		if( fread( file->name, 1, sizeRead, f ) != sizeRead ) {
-			return 0;
-		}
+	QMutex_Lock( fs_pakcache_mutex );
 
-		*( file->name + sizeRead ) = 0;
-		if( *( file->name + sizeRead - 1 ) == '/' ) {
-			file->flags |= FS_PACKFILE_DIRECTORY;
-		}
+	rec = FS_FindPakCacheRecord( filename );
+	if( rec && rec->disk.size == size && rec->disk.mtime == mtime && rec->disk.fileChecksum != checksum ) {
+		rec->disk.fileChecksum = checksum;
+		fs_pakcache_dirty = true;
 	}
 
-	return FS_ZIP_SIZECENTRALDIRITEM + ( unsigned )LittleShortRaw( &infoHeader[28] ) +
-		   ( unsigned )LittleShortRaw( &infoHeader[30] ) + ( unsigned )LittleShortRaw( &infoHeader[32] );
+	QMutex_Unlock( fs_pakcache_mutex );
 }
 
 /*
@@ -2405,8 +3908,11 @@ static unsigned FS_PK3GetFileInfo( FILE *f, void *vfsHandle, unsigned pos, unsig
 *
 * Loads the header and directory, adding the files at the beginning
 * of the list so they override previous pack files.
+*
+* If useCache is true, the directory is taken from the pak mount cache
+* when the file hasn't changed since it was last parsed.
 */
-static pack_t *FS_LoadPK3File( const char *packfilename, bool silent ) {
+static pack_t *FS_LoadPK3File( const char *packfilename, bool silent, bool useCache ) {
 	int i;
 	int *checksums = NULL;
 	int numFiles;
@@ -2421,8 +3927,10 @@ static pack_t *FS_LoadPK3File( const char *packfilename, bool silent ) {
 	int manifestFilesize;
 	void *handle = NULL;
 	void *vfsHandle = NULL;
+	int64_t pakSize, pakMTime = 0;
 
-	if( FS_AbsoluteFileExists( packfilename ) == -1 ) {
+	pakSize = FS_AbsoluteFileExists( packfilename );
+	if( pakSize == -1 ) {
 		vfsHandle = FS_VFSHandleForPakName( packfilename );
 	}
 
@@ -2437,6 +3945,16 @@ static pack_t *FS_LoadPK3File( const char *packfilename, bool silent ) {
 		}
 	}
 
+	// paks inside VFS containers are never cached
+	useCache = useCache && !vfsHandle && fs_pakcache->integer;
+	if( useCache ) {
+		pakMTime = (int64_t)Sys_FS_FileMTime( packfilename );
+		pack = FS_LoadCachedPK3File( packfilename, pakSize, pakMTime, handle, silent );
+		if( pack ) {
+			return pack;
+		}
+	}
+
 	fin = fopen( vfsHandle ? Sys_VFS_VFSName( vfsHandle ) : packfilename, "rb" );
 	if( fin == NULL ) {
 		if( !silent ) {
@@ -2532,8 +4050,6 @@ static pack_t *FS_LoadPK3File( const char *packfilename, bool silent ) {
 	// add all files to the trie
 	for( i = 0, file = pack->files, centralPos = offsetCentralDir + byteBeforeTheZipFile; i < numFiles; i++, file++, centralPos += offset, names += len + 1 ) {
 		const char *ext;
-		trie_error_t trie_err;
-		packfile_t *trie_file;
 
 		file->name = names;
 		file->pakname = pack->filename;
@@ -2562,13 +4078,10 @@ static pack_t *FS_LoadPK3File( const char *packfilename, bool silent ) {
 				manifestFilesize = file->uncompressedSize;
 			}
 		}
-
-		trie_err = Trie_Replace( pack->trie, file->name, file, (void **)&trie_file );
-		if( trie_err == TRIE_KEY_NOT_FOUND ) {
-			Trie_Insert( pack->trie, file->name, file );
-		}
 	}
 
+	FS_BuildPackTrie( pack );
+
 	fclose( fin );
 	fin = NULL;
 
@@ -2584,6 +4097,10 @@ static pack_t *FS_LoadPK3File( const char *packfilename, bool silent ) {
 
 	Mem_TempFree( checksums );
 
+	if( useCache ) {
+		FS_StorePakInCache( pack, pakSize, pakMTime );
+	}
+
 	// read manifest file if it's a module pk3
 	if( modulepack && manifestFilesize > 0 ) {
 		FS_ReadPackManifest( pack );
@@ -2772,9 +4289,6 @@ static pack_t *FS_LoadPakFile( const char *packfilename, bool silent ) {
 
 	// add all files and dirs
 	for( i = 0, file = pack->files; i < numFiles + numDirs; i++, file++ ) {
-		trie_error_t trie_err;
-		packfile_t *trie_file;
-
 		file->name = names;
 		file->pakname = pack->filename;
 		file->vfsHandle = vfsHandle;
@@ -2816,13 +4330,10 @@ static pack_t *FS_LoadPakFile( const char *packfilename, bool silent ) {
 			strcpy( file->name, dirs[i - numFiles].name );
 			ext = NULL;
 		}
-
-		trie_err = Trie_Replace( pack->trie, file->name, file, (void **)&trie_file );
-		if( trie_err == TRIE_KEY_NOT_FOUND ) {
-			Trie_Insert( pack->trie, file->name, file );
-		}
 	}
 
+	FS_BuildPackTrie( pack );
+
 	fclose( fin );
 	fin = NULL;
 
@@ -2902,7 +4413,7 @@ static pack_t *FS_LoadPackFile( const char *packfilename, bool silent ) {
 	}
 
 	if( !Q_stricmp( ext, ".pk3" ) || !Q_stricmp( ext, ".pk2" ) ) {
-		return FS_LoadPK3File( packfilename, silent );
+		return FS_LoadPK3File( packfilename, silent, true );
 	}
 	if( !Q_stricmp( ext, ".pak" ) ) {
 		return FS_LoadPakFile( packfilename, silent );
@@ -2996,6 +4507,8 @@ return_result:
 * FS_FreePakFile
 */
 static void FS_FreePakFile( pack_t *pack ) {
+	FS_DropPrefetchedPak( pack );
+
 	if( pack->sysHandle ) {
 		Sys_FS_UnlockFile( pack->sysHandle );
 	}
@@ -3027,6 +4540,130 @@ bool FS_IsPakValid( const char *filename, unsigned *checksum ) {
 	return false;
 }
 
+/*
+* FS_VerifyCachedPak
+*
+* Compares the cached directory of a mounted pak with freshly parsed one.
+*/
+static bool FS_VerifyCachedPak( const pack_t *pack ) {
+	int i;
+	bool ok;
+	pack_t *fresh;
+	const char *name;
+	const fs_pakcache_t *rec;
+	const packfile_t *file;
+
+	fresh = FS_LoadPK3File( pack->filename, true, false );
+	if( !fresh ) {
+		Com_Printf( "%s: failed to parse\n", pack->filename );
+		return false;
+	}
+
+	QMutex_Lock( fs_pakcache_mutex );
+
+	rec = FS_FindPakCacheRecord( pack->filename );
+	if( !rec ) {
+		ok = true;
+	} else if( rec->disk.checksum != fresh->checksum || rec->disk.numFiles != fresh->numFiles ) {
+		ok = false;
+	} else {
+		name = rec->names;
+		for( i = 0, file = fresh->files; i < fresh->numFiles; i++, file++ ) {
+			if( strcmp( name, file->name ) || rec->files[i].flags != ( file->flags & ~FS_PACKFILE_COHERENT )
+				|| rec->files[i].compressedSize != file->compressedSize
+				|| rec->files[i].uncompressedSize != file->uncompressedSize
+				|| rec->files[i].offset != file->offset || rec->files[i].mtime != file->mtime ) {
+				break;
+			}
+			name += strlen( name ) + 1;
+		}
+		ok = ( i == fresh->numFiles );
+	}
+
+	QMutex_Unlock( fs_pakcache_mutex );
+
+	if( !ok ) {
+		Com_Printf( "%s: cached directory is out of date\n", pack->filename );
+	}
+
+	FS_FreePakFile( fresh );
+	return ok;
+}
+
+/*
+* Cmd_FS_PakCache_f
+*/
+static void Cmd_FS_PakCache_f( void ) {
+	int numRecords, numPaks, numBad;
+	const char *ext;
+	const char *cmd = Cmd_Argv( 1 );
+	fs_pakcache_t *rec;
+	searchpath_t *search;
+	pack_t *pack;
+
+	if( !Q_stricmp( cmd, "verify" ) || !Q_stricmp( cmd, "rebuild" ) ) {
+		bool rebuild = !Q_stricmp( cmd, "rebuild" );
+
+		if( !fs_pakcache->integer ) {
+			Com_Printf( "Pak cache is disabled\n" );
+			return;
+		}
+
+		QMutex_Lock( fs_searchpaths_mutex );
+
+		if( rebuild ) {
+			QMutex_Lock( fs_pakcache_mutex );
+			FS_ClearPakCache();
+			QMutex_Unlock( fs_pakcache_mutex );
+		}
+
+		numPaks = numBad = 0;
+		for( search = fs_searchpaths; search; search = search->next ) {
+			if( !search->pack || search->pack->deferred_load || search->pack->vfsHandle ) {
+				continue;
+			}
+			ext = COM_FileExtension( search->pack->filename );
+			if( !ext || !( !Q_stricmp( ext, ".pk3" ) || !Q_stricmp( ext, ".pk2" ) ) ) {
+				continue;
+			}
+
+			numPaks++;
+			if( rebuild ) {
+				pack = FS_LoadPK3File( search->pack->filename, true, true );
+				if( pack ) {
+					FS_FreePakFile( pack );
+				} else {
+					numBad++;
+				}
+			} else if( !FS_VerifyCachedPak( search->pack ) ) {
+				numBad++;
+			}
+		}
+
+		QMutex_Unlock( fs_searchpaths_mutex );
+
+		if( rebuild ) {
+			fs_pakcache_dirty = true;
+			FS_WritePakCache();
+			Com_Printf( "Rebuilt pak cache for %i paks (%i failed)\n", numPaks, numBad );
+		} else {
+			Com_Printf( "Verified %i paks, %i mismatches\n", numPaks, numBad );
+		}
+		return;
+	}
+
+	QMutex_Lock( fs_pakcache_mutex );
+	numRecords = 0;
+	for( rec = fs_pakcache_headnode.next; rec != &fs_pakcache_headnode; rec = rec->next ) {
+		numRecords++;
+	}
+	QMutex_Unlock( fs_pakcache_mutex );
+
+	Com_Printf( "Pak cache: %s, %i records, %u hits, %u misses\n", fs_pakcache->integer ? "enabled" : "disabled",
+				numRecords, fs_pakcache_hits, fs_pakcache_misses );
+	Com_Printf( "Usage: %s [verify|rebuild]\n", Cmd_Argv( 0 ) );
+}
+
 /*
 * FS_CheckPakExtension
 */
@@ -3817,6 +5454,10 @@ freename:
 		Mem_ZoneFree( paknames );
 	}
 
+	if( newpaks ) {
+		FS_InvalidateFileIndex();
+	}
+
 	QMutex_Unlock( fs_searchpaths_mutex );
 
 	return newpaks;
@@ -3869,60 +5510,45 @@ static void FS_ReplaceDeferredPaks( void ) {
 		search = search->next;
 	}
 
+	FS_InvalidateFileIndex();
+
 	QMutex_Unlock( fs_searchpaths_mutex );
 }
 
 /*
 * FS_LoadDeferredPaks_Job
 */
-typedef struct {
-	volatile int *cnt;
-	int maxcnt;
-	pack_t **packs;
-} deferred_pack_arg_t;
-
-static void *FS_LoadDeferredPaks_Job( void *parg ) {
-	int i;
+static void FS_LoadDeferredPaks_Job( unsigned first, unsigned items, void *parg ) {
+	unsigned i;
 	pack_t *pack;
-	deferred_pack_arg_t *arg = parg;
-
-	while( true ) {
-		i = QAtomic_Add( arg->cnt, 1 );
-		if( i >= arg->maxcnt ) {
-			break;
-		}
+	pack_t **packs = parg;
 
-		pack = arg->packs[i];
+	for( i = first; i < first + items; i++ ) {
+		pack = packs[i];
 
 		assert( pack != NULL );
 		assert( pack->deferred_load );
 
 		pack->deferred_pack = FS_LoadPackFile( pack->filename, false );
 	}
-
-	return NULL;
 }
 
 /*
 * FS_LoadDeferredPaks
 */
 static void FS_LoadDeferredPaks( int newpaks ) {
-	int i;
-	volatile int cnt;
-	qthread_t *threads[FS_PACKFILE_NUM_THREADS - 1] = { NULL };
-	const int num_threads = min( newpaks, FS_PACKFILE_NUM_THREADS ) - 1;
+	int cnt;
+	volatile int counter = 0;
+	size_t mark;
 	pack_t **packs;
 	searchpath_t *search;
-	deferred_pack_arg_t *arg;
 
 	if( !newpaks ) {
 		return;
 	}
 
-	packs = Mem_TempMalloc( sizeof( *packs ) * ( newpaks + 1 ) );
-	if( !packs ) {
-		return;
-	}
+	mark = Mem_ScratchMark();
+	packs = ( pack_t ** )Mem_ScratchAlloc( sizeof( *packs ) * ( newpaks + 1 ) );
 
 	cnt = 0;
 	for( search = fs_searchpaths; search != NULL; search = search->next ) {
@@ -3934,28 +5560,14 @@ static void FS_LoadDeferredPaks( int newpaks ) {
 		}
 	}
 
-	arg = Mem_TempMalloc( sizeof( *arg ) );
-	arg->cnt = Mem_TempMalloc( sizeof( int ) );
-	arg->maxcnt = newpaks;
-	arg->packs = packs;
-
-	if( num_threads > 0 ) {
-		for( i = 0; i < num_threads; i++ )
-			threads[i] = QThread_Create( FS_LoadDeferredPaks_Job, arg );
-	}
-
-	FS_LoadDeferredPaks_Job( arg );
-
-	if( num_threads > 0 ) {
-		for( i = 0; i < num_threads; i++ )
-			QThread_Join( threads[i] );
-	}
+	// the pak loaders must never take fs_searchpaths_mutex, it's held
+	// by the caller for the whole duration of the wait
+	QJobs_Schedule( FS_LoadDeferredPaks_Job, packs, cnt, 1, &counter );
+	QJobs_Wait( &counter );
 
 	FS_ReplaceDeferredPaks();
 
-	Mem_TempFree( (void *)arg->cnt );
-	Mem_TempFree( arg->packs );
-	Mem_TempFree( arg );
+	Mem_ScratchFreeToMark( mark );
 }
 
 /*
@@ -3977,6 +5589,7 @@ static void FS_RemoveExtraPaks( searchpath_t *old ) {
 					!strcmp( COM_FileBase( search->pack->filename ), COM_FileBase( compare->pack->filename ) ) ) {
 					Com_Printf( "Removed duplicate pk3 file %s\n", search->pack->filename );
 					prev->next = search->next;
+					FS_InvalidateFileIndex();
 					FS_FreePakFile( search->pack );
 					FS_Free( search );
 					search = prev;
@@ -4020,6 +5633,7 @@ static int FS_TouchGameDirectory( const char *gamedir, bool initial ) {
 	// possibly spawn a few threads to load deferred packs in parallel
 	if( newpaks ) {
 		FS_LoadDeferredPaks( newpaks );
+		FS_WritePakCache();
 	}
 
 	// FIXME: remove the initial check?
@@ -4084,6 +5698,9 @@ bool FS_SetGameDirectory( const char *dir, bool force ) {
 		Cmd_ExecuteString( "writeconfig config.cfg" );
 	}
 
+	// prefetched data references pak files that are about to be freed
+	FS_FlushPrefetchedFiles();
+
 	// free up any current game dir info
 	QMutex_Lock( fs_searchpaths_mutex );
 	while( fs_searchpaths != fs_base_searchpaths ) {
@@ -4095,6 +5712,7 @@ bool FS_SetGameDirectory( const char *dir, bool force ) {
 		FS_Free( fs_searchpaths );
 		fs_searchpaths = next;
 	}
+	FS_InvalidateFileIndex();
 	QMutex_Unlock( fs_searchpaths_mutex );
 
 	if( !strcmp( dir, fs_basegame->string ) || ( *dir == 0 ) ) {
@@ -4348,12 +5966,17 @@ void FS_Init( void ) {
 
 	fs_mempool = Mem_AllocPool( NULL, "Filesystem" );
 
+	FS_InitPrefetch();
+
 	Cmd_AddCommand( "fs_path", FS_Path_f );
 	Cmd_AddCommand( "fs_pakfile", Cmd_PakFile_f );
 	Cmd_AddCommand( "fs_search", Cmd_FS_Search_f );
 	Cmd_AddCommand( "fs_checksum", Cmd_FileChecksum_f );
 	Cmd_AddCommand( "fs_mtime", Cmd_FileMTime_f );
 	Cmd_AddCommand( "fs_untoched", Cmd_FS_Untouched_f );
+	Cmd_AddCommand( "fs_indexstats", Cmd_FS_IndexStats_f );
+	Cmd_AddCommand( "fs_pakcache", Cmd_FS_PakCache_f );
+	Cmd_AddCommand( "fs_triebench", Cmd_FS_TrieBench_f );
 
 	fs_numsearchfiles = FS_MIN_SEARCHFILES;
 	fs_searchfiles = ( searchfile_t* )FS_Malloc( sizeof( searchfile_t ) * fs_numsearchfiles );
@@ -4382,6 +6005,7 @@ void FS_Init( void ) {
 	{ fs_usehomedir = Cvar_Get( "fs_usehomedir", "0", CVAR_NOSET );}
 #endif
 	fs_usedownloadsdir = Cvar_Get( "fs_usedownloadsdir", "1", CVAR_NOSET );
+	fs_prefetch = Cvar_Get( "fs_prefetch", "1", CVAR_ARCHIVE );
 
 	fs_downloads_searchpath = NULL;
 	if( fs_usedownloadsdir->integer ) {
@@ -4415,6 +6039,8 @@ void FS_Init( void ) {
 
 	Sys_VFS_Init();
 
+	FS_InitPakCache();
+
 	//
 	// set game directories
 	//
@@ -4469,6 +6095,8 @@ int FS_Rescan( void ) {
 */
 void FS_Frame( void ) {
 	FS_FreeSearchFiles();
+
+	FS_ExpirePrefetchedFiles();
 }
 
 /*
@@ -4487,6 +6115,11 @@ void FS_Shutdown( void ) {
 	Cmd_RemoveCommand( "fs_checksum" );
 	Cmd_RemoveCommand( "fs_mtime" );
 	Cmd_RemoveCommand( "fs_untoched" );
+	Cmd_RemoveCommand( "fs_indexstats" );
+	Cmd_RemoveCommand( "fs_pakcache" );
+	Cmd_RemoveCommand( "fs_triebench" );
+
+	FS_ShutdownPrefetch();
 
 	FS_FreeSearchFiles();
 	FS_Free( fs_searchfiles );
@@ -4505,8 +6138,12 @@ void FS_Shutdown( void ) {
 		FS_Free( search );
 	}
 
+	FS_FreeFileIndex();
+
 	QMutex_Unlock( fs_searchpaths_mutex );
 
+	FS_ShutdownPakCache();
+
 	while( fs_basepaths ) {
 		search = fs_basepaths;
 		fs_basepaths = search->next;
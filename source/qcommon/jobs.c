@@ -0,0 +1,589 @@
+/*
+Copyright (C) 2017 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "qcommon.h"
+
+/*
+=============================================================================
+
+JOB SYSTEM
+
+A pool of worker threads, sized to the number of cores, each owning a bounded
+deque of job ranges. A worker pops jobs from the tail of its own deque and
+steals from the head of the other deques once it runs dry. Scheduled work is
+split into small ranges which are spread over all deques. Threads waiting on
+a job counter help by running queued jobs instead of just sleeping.
+
+=============================================================================
+*/
+
+#define QJOBS_MAX_WORKERS       32
+#define QJOBS_QUEUE_SIZE        1024        // must be a power of two
+#define QJOBS_QUEUE_MASK        ( QJOBS_QUEUE_SIZE - 1 )
+#define QJOBS_SPLIT_FACTOR      4           // ranges per thread if no granularity is given
+#define QJOBS_IDLE_WAIT_MSEC    100
+#define QJOBS_DONE_WAIT_MSEC    1
+
+typedef struct {
+	qjobfunc_t func;
+	void *arg;
+	unsigned first;
+	unsigned items;
+	volatile int *counter;
+} qjob_t;
+
+typedef struct {
+	qmutex_t *mutex;
+	volatile unsigned head;                 // stealing end
+	volatile unsigned tail;                 // owner end
+	qjob_t jobs[QJOBS_QUEUE_SIZE];
+} qjobqueue_t;
+
+typedef struct {
+	int index;
+	qthread_t *thread;
+	qjobqueue_t queue;
+} qjobworker_t;
+
+static cvar_t *com_jobthreads;
+
+static int qjobs_numWorkers;
+static qjobworker_t *qjobs_workers;
+
+static volatile int qjobs_quit;
+static volatile int qjobs_pending;
+static volatile int qjobs_sleeping;
+static volatile int qjobs_nextQueue;
+
+static qmutex_t *qjobs_sleepMutex;
+static qcondvar_t *qjobs_sleepCondVar;
+static qmutex_t *qjobs_doneMutex;
+static qcondvar_t *qjobs_doneCondVar;
+
+static void QJobs_Bench_f( void );
+
+/*
+* QJobs_PushJob
+*/
+static bool QJobs_PushJob( qjobqueue_t *queue, const qjob_t *job ) {
+	QMutex_Lock( queue->mutex );
+	if( queue->tail - queue->head >= QJOBS_QUEUE_SIZE ) {
+		QMutex_Unlock( queue->mutex );
+		return false;
+	}
+	queue->jobs[queue->tail & QJOBS_QUEUE_MASK] = *job;
+	queue->tail++;
+	QMutex_Unlock( queue->mutex );
+	return true;
+}
+
+/*
+* QJobs_PopJob
+*
+* Takes the most recently pushed job, the one most likely to still be in cache.
+*/
+static bool QJobs_PopJob( qjobqueue_t *queue, qjob_t *job ) {
+	if( queue->head == queue->tail ) {
+		return false;
+	}
+
+	QMutex_Lock( queue->mutex );
+	if( queue->head == queue->tail ) {
+		QMutex_Unlock( queue->mutex );
+		return false;
+	}
+	queue->tail--;
+	*job = queue->jobs[queue->tail & QJOBS_QUEUE_MASK];
+	QMutex_Unlock( queue->mutex );
+	return true;
+}
+
+/*
+* QJobs_StealJob
+*
+* If the counter is not NULL, only a job of that batch is taken, and only
+* from either end of the queue, so that the caller never gets stuck running
+* work it isn't waiting for.
+*/
+static bool QJobs_StealJob( qjobqueue_t *queue, volatile int *counter, qjob_t *job ) {
+	if( queue->head == queue->tail ) {
+		return false;
+	}
+
+	QMutex_Lock( queue->mutex );
+	if( queue->head == queue->tail ) {
+		QMutex_Unlock( queue->mutex );
+		return false;
+	}
+	if( !counter || queue->jobs[queue->head & QJOBS_QUEUE_MASK].counter == counter ) {
+		*job = queue->jobs[queue->head & QJOBS_QUEUE_MASK];
+		queue->head++;
+	} else if( queue->jobs[( queue->tail - 1 ) & QJOBS_QUEUE_MASK].counter == counter ) {
+		queue->tail--;
+		*job = queue->jobs[queue->tail & QJOBS_QUEUE_MASK];
+	} else {
+		QMutex_Unlock( queue->mutex );
+		return false;
+	}
+	QMutex_Unlock( queue->mutex );
+	return true;
+}
+
+/*
+* QJobs_FindJob
+*
+* Pops a job off the worker's own queue or steals one from a random victim.
+* Threads which aren't workers pass a negative index and only steal,
+* optionally restricted to the jobs of a single batch.
+*/
+static bool QJobs_FindJob( int self, volatile int *counter, qjob_t *job ) {
+	int i, victim;
+
+	if( !qjobs_pending ) {
+		return false;
+	}
+
+	if( self >= 0 && QJobs_PopJob( &qjobs_workers[self].queue, job ) ) {
+		QAtomic_Add( &qjobs_pending, -1 );
+		return true;
+	}
+
+	victim = self >= 0 ? self + 1 : rand();
+	for( i = 0; i < qjobs_numWorkers; i++, victim++ ) {
+		victim %= qjobs_numWorkers;
+		if( victim == self ) {
+			continue;
+		}
+		if( QJobs_StealJob( &qjobs_workers[victim].queue, counter, job ) ) {
+			QAtomic_Add( &qjobs_pending, -1 );
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+* QJobs_RunJob
+*/
+static void QJobs_RunJob( const qjob_t *job ) {
+	Prof_Enter( "QJobs_RunJob" );
+	job->func( job->first, job->items, job->arg );
+	Prof_Leave();
+
+	if( !job->counter ) {
+		return;
+	}
+
+	// don't touch the counter after the decrement, the waiting
+	// thread is free to release it as soon as it reaches zero.
+	// several threads may be waiting on different batches, so wake them all
+	if( QAtomic_Add( job->counter, -1 ) == 1 ) {
+		QMutex_Lock( qjobs_doneMutex );
+		QCondVar_WakeAll( qjobs_doneCondVar );
+		QMutex_Unlock( qjobs_doneMutex );
+	}
+}
+
+/*
+* QJobs_WakeWorkers
+*/
+static void QJobs_WakeWorkers( int count ) {
+	int i;
+
+	if( !qjobs_sleeping ) {
+		return;
+	}
+
+	QMutex_Lock( qjobs_sleepMutex );
+	for( i = 0; i < count && i < qjobs_sleeping; i++ ) {
+		QCondVar_Wake( qjobs_sleepCondVar );
+	}
+	QMutex_Unlock( qjobs_sleepMutex );
+}
+
+/*
+* QJobs_WorkerThread
+*/
+static void *QJobs_WorkerThread( void *param ) {
+	qjob_t job;
+	qjobworker_t *worker = param;
+	char name[32];
+
+	Q_snprintfz( name, sizeof( name ), "job worker %i", worker->index );
+	Prof_ThreadName( name );
+
+	while( !qjobs_quit ) {
+		if( QJobs_FindJob( worker->index, NULL, &job ) ) {
+			QJobs_RunJob( &job );
+			continue;
+		}
+
+		QMutex_Lock( qjobs_sleepMutex );
+		// announce ourselves before checking for work, so that either we see
+		// the newly scheduled jobs or the scheduler sees us and wakes us up
+		QAtomic_Add( &qjobs_sleeping, 1 );
+		if( !qjobs_pending && !qjobs_quit ) {
+			QCondVar_Wait( qjobs_sleepCondVar, qjobs_sleepMutex, QJOBS_IDLE_WAIT_MSEC );
+		}
+		QAtomic_Add( &qjobs_sleeping, -1 );
+		QMutex_Unlock( qjobs_sleepMutex );
+	}
+
+	return NULL;
+}
+
+/*
+* QJobs_NumWorkers
+*/
+int QJobs_NumWorkers( void ) {
+	return qjobs_numWorkers;
+}
+
+/*
+* QJobs_Schedule
+*
+* Splits the [0, items) range into chunks of at most granularity items and
+* queues them. If the counter is not NULL, it is incremented by the number
+* of queued chunks and decremented as each of them completes. Passing zero
+* granularity lets the job system pick the chunk size.
+*/
+void QJobs_Schedule( qjobfunc_t func, void *arg, unsigned items, unsigned granularity, volatile int *counter ) {
+	int queue, numChunks;
+	unsigned first;
+	qjob_t job;
+
+	if( !items ) {
+		return;
+	}
+
+	if( !qjobs_numWorkers ) {
+		func( 0, items, arg );
+		return;
+	}
+
+	if( !granularity ) {
+		granularity = items / ( ( qjobs_numWorkers + 1 ) * QJOBS_SPLIT_FACTOR );
+		if( !granularity ) {
+			granularity = 1;
+		}
+	}
+
+	numChunks = ( items + granularity - 1 ) / granularity;
+	if( counter ) {
+		QAtomic_Add( counter, numChunks );
+	}
+
+	job.func = func;
+	job.arg = arg;
+	job.counter = counter;
+
+	queue = QAtomic_Add( &qjobs_nextQueue, 1 );
+	for( first = 0; first < items; first += job.items ) {
+		int i;
+
+		job.first = first;
+		job.items = min( granularity, items - first );
+
+		for( i = 0; i < qjobs_numWorkers; i++ ) {
+			queue = ( queue & INT_MAX ) % qjobs_numWorkers;
+			if( QJobs_PushJob( &qjobs_workers[queue++].queue, &job ) ) {
+				break;
+			}
+		}
+
+		if( i == qjobs_numWorkers ) {
+			// all queues are full, so do the work ourselves
+			QJobs_RunJob( &job );
+			numChunks--;
+		}
+	}
+
+	if( numChunks > 0 ) {
+		QAtomic_Add( &qjobs_pending, numChunks );
+		QJobs_WakeWorkers( numChunks );
+	}
+}
+
+/*
+* QJobs_Done
+*/
+bool QJobs_Done( volatile int *counter ) {
+	return !counter || *counter <= 0;
+}
+
+/*
+* QJobs_Wait
+*
+* Blocks until the counter drops to zero, helping with the queued jobs
+* of the same batch meanwhile.
+*/
+void QJobs_Wait( volatile int *counter ) {
+	qjob_t job;
+
+	if( !counter ) {
+		return;
+	}
+
+	while( *counter > 0 ) {
+		if( QJobs_FindJob( -1, counter, &job ) ) {
+			QJobs_RunJob( &job );
+			continue;
+		}
+
+		QMutex_Lock( qjobs_doneMutex );
+		if( *counter > 0 ) {
+			QCondVar_Wait( qjobs_doneCondVar, qjobs_doneMutex, QJOBS_DONE_WAIT_MSEC );
+		}
+		QMutex_Unlock( qjobs_doneMutex );
+	}
+}
+
+/*
+* QJobs_StartWorkers
+*/
+static void QJobs_StartWorkers( int numWorkers ) {
+	int i;
+
+	qjobs_quit = 0;
+	qjobs_pending = 0;
+	qjobs_sleeping = 0;
+	qjobs_nextQueue = 0;
+
+	qjobs_workers = Q_malloc( sizeof( *qjobs_workers ) * numWorkers );
+	memset( qjobs_workers, 0, sizeof( *qjobs_workers ) * numWorkers );
+	for( i = 0; i < numWorkers; i++ ) {
+		qjobs_workers[i].index = i;
+		qjobs_workers[i].queue.mutex = QMutex_Create();
+	}
+
+	// the workers look at the queues of each other, so
+	// only start them once everything is in place
+	qjobs_numWorkers = numWorkers;
+	for( i = 0; i < numWorkers; i++ ) {
+		qjobs_workers[i].thread = QThread_Create( QJobs_WorkerThread, &qjobs_workers[i] );
+	}
+
+	Com_DPrintf( "Job system started with %i worker threads\n", numWorkers );
+}
+
+/*
+* QJobs_StopWorkers
+*/
+static void QJobs_StopWorkers( void ) {
+	int i, numWorkers;
+	qjob_t job;
+
+	if( !qjobs_numWorkers ) {
+		return;
+	}
+
+	// finish whatever is left in the queues
+	while( QJobs_FindJob( -1, NULL, &job ) )
+		QJobs_RunJob( &job );
+
+	qjobs_quit = 1;
+	QJobs_WakeWorkers( qjobs_numWorkers );
+
+	numWorkers = qjobs_numWorkers;
+	for( i = 0; i < numWorkers; i++ ) {
+		QThread_Join( qjobs_workers[i].thread );
+	}
+
+	qjobs_numWorkers = 0;
+
+	for( i = 0; i < numWorkers; i++ ) {
+		QMutex_Destroy( &qjobs_workers[i].queue.mutex );
+	}
+	Q_free( qjobs_workers );
+	qjobs_workers = NULL;
+}
+
+/*
+* QJobs_DefaultNumWorkers
+*/
+static int QJobs_DefaultNumWorkers( void ) {
+	int numWorkers = com_jobthreads ? com_jobthreads->integer : 0;
+
+	if( numWorkers <= 0 ) {
+		// leave a core for the main thread
+		numWorkers = QThread_NumCores() - 1;
+	}
+	return Q_bound( 1, numWorkers, QJOBS_MAX_WORKERS );
+}
+
+/*
+* QJobs_Init
+*
+* Called before the filesystem is up, so the config hasn't been executed
+* yet and the workers are started with the default count. QJobs_InitCommands
+* applies the user's setting later.
+*/
+void QJobs_Init( void ) {
+	qjobs_sleepMutex = QMutex_Create();
+	qjobs_sleepCondVar = QCondVar_Create();
+	qjobs_doneMutex = QMutex_Create();
+	qjobs_doneCondVar = QCondVar_Create();
+
+	QJobs_StartWorkers( QJobs_DefaultNumWorkers() );
+}
+
+/*
+* QJobs_InitCommands
+*/
+void QJobs_InitCommands( void ) {
+	int numWorkers;
+
+	com_jobthreads = Cvar_Get( "com_jobthreads", "0", CVAR_ARCHIVE | CVAR_LATCH );
+
+	numWorkers = QJobs_DefaultNumWorkers();
+	if( numWorkers != qjobs_numWorkers ) {
+		QJobs_StopWorkers();
+		QJobs_StartWorkers( numWorkers );
+	}
+
+	Cmd_AddCommand( "jobs_bench", QJobs_Bench_f );
+}
+
+/*
+* QJobs_Shutdown
+*/
+void QJobs_Shutdown( void ) {
+	if( !qjobs_doneMutex ) {
+		return;
+	}
+
+	if( com_jobthreads ) {
+		Cmd_RemoveCommand( "jobs_bench" );
+		com_jobthreads = NULL;
+	}
+
+	QJobs_StopWorkers();
+
+	QCondVar_Destroy( &qjobs_doneCondVar );
+	QMutex_Destroy( &qjobs_doneMutex );
+	QCondVar_Destroy( &qjobs_sleepCondVar );
+	QMutex_Destroy( &qjobs_sleepMutex );
+}
+
+/*
+=============================================================================
+
+BENCHMARK
+
+=============================================================================
+*/
+
+typedef struct {
+	const float *in;
+	float *out;
+} qjobs_bench_arg_t;
+
+/*
+* QJobs_BenchEmptyJob
+*/
+static void QJobs_BenchEmptyJob( unsigned first, unsigned items, void *arg ) {
+}
+
+/*
+* QJobs_BenchSqrtJob
+*/
+static void QJobs_BenchSqrtJob( unsigned first, unsigned items, void *parg ) {
+	unsigned i;
+	qjobs_bench_arg_t *arg = parg;
+
+	for( i = first; i < first + items; i++ ) {
+		arg->out[i] = sqrt( arg->in[i] ) * 0.5f + 1.0f / ( arg->in[i] + 1.0f );
+	}
+}
+
+/*
+* QJobs_BenchNestedJob
+*/
+static void QJobs_BenchNestedJob( unsigned first, unsigned items, void *parg ) {
+	volatile int counter = 0;
+
+	QJobs_Schedule( QJobs_BenchEmptyJob, NULL, items * 16, 1, &counter );
+	QJobs_Wait( &counter );
+}
+
+/*
+* QJobs_Bench_f
+*/
+static void QJobs_Bench_f( void ) {
+	int i;
+	unsigned numJobs, numItems;
+	uint64_t t, best[4];
+	volatile int counter;
+	qjobs_bench_arg_t arg;
+	const int numRuns = 5;
+
+	numJobs = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 10000;
+	numItems = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : ( 1 << 22 );
+	if( !numJobs || !numItems ) {
+		Com_Printf( "Usage: %s [jobs] [items]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	arg.in = Q_malloc( sizeof( float ) * numItems );
+	arg.out = Q_malloc( sizeof( float ) * numItems );
+	for( i = 0; i < (int)numItems; i++ ) {
+		( (float *)arg.in )[i] = (float)i;
+	}
+
+	best[0] = best[1] = best[2] = best[3] = UINT64_MAX;
+	for( i = 0; i < numRuns; i++ ) {
+		// scheduling overhead: one empty job per range
+		counter = 0;
+		t = Sys_Microseconds();
+		QJobs_Schedule( QJobs_BenchEmptyJob, NULL, numJobs, 1, &counter );
+		QJobs_Wait( &counter );
+		best[0] = min( best[0], Sys_Microseconds() - t );
+
+		// nested scheduling from inside of the workers
+		counter = 0;
+		t = Sys_Microseconds();
+		QJobs_Schedule( QJobs_BenchNestedJob, NULL, numJobs / 16 + 1, 1, &counter );
+		QJobs_Wait( &counter );
+		best[1] = min( best[1], Sys_Microseconds() - t );
+
+		// data parallel throughput vs the calling thread alone
+		t = Sys_Microseconds();
+		QJobs_BenchSqrtJob( 0, numItems, &arg );
+		best[2] = min( best[2], Sys_Microseconds() - t );
+
+		counter = 0;
+		t = Sys_Microseconds();
+		QJobs_Schedule( QJobs_BenchSqrtJob, &arg, numItems, 0, &counter );
+		QJobs_Wait( &counter );
+		best[3] = min( best[3], Sys_Microseconds() - t );
+	}
+
+	Com_Printf( "Job system: %i workers, best of %i runs\n", qjobs_numWorkers, numRuns );
+	Com_Printf( "  schedule+wait: %u jobs in %u usec, %.3f usec/job\n",
+				numJobs, (unsigned)best[0], (double)best[0] / numJobs );
+	Com_Printf( "  nested:        %u jobs in %u usec, %.3f usec/job\n",
+				( numJobs / 16 + 1 ) * 17, (unsigned)best[1], (double)best[1] / ( ( numJobs / 16 + 1 ) * 17 ) );
+	Com_Printf( "  parallel for:  %u items in %u usec, serial %u usec, %.2fx\n",
+				numItems, (unsigned)best[3], (unsigned)best[2], best[3] ? (double)best[2] / best[3] : 0.0 );
+
+	Q_free( (void *)arg.in );
+	Q_free( arg.out );
+}
@@ -30,6 +30,24 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define MEMALIGNMENT_DEFAULT        16
 
+// blocks up to MEMCLASS_MAXSIZE bytes are carved out of slabs of the same
+// size class, larger ones go straight to malloc
+#define MEMCLASS_MAXSIZE            16384
+#define MEMCLASS_LOOKUP_SHIFT       4
+#define MEMCLASS_LOOKUP_SIZE        ( ( MEMCLASS_MAXSIZE >> MEMCLASS_LOOKUP_SHIFT ) + 1 )
+#define MEM_NUM_CLASSES             36
+#define MEMSLAB_SIZE                0x10000
+#define MEMSLAB_MINBLOCKS           8
+#define MEMCACHE_BATCH_BYTES        0x4000  // amount of memory moved between a thread cache and the depot at once
+
+// allocations made by different threads from the same pool
+// are linked into different chains to reduce contention
+#define MEMPOOL_NUM_CHAINS          8
+
+#if defined( ATTRIBUTE_TLS )
+#define MEM_THREAD_CACHE
+#endif
+
 typedef struct memheader_s {
 	// address returned by malloc (may be significantly before this header to satisify alignment)
 	void *baseaddress;
@@ -47,6 +65,12 @@ typedef struct memheader_s {
 	// size of the memory including the header, alignment and sentinel2
 	size_t realsize;
 
+	// size class of the block or -1 if allocated with malloc
+	short sizeclass;
+
+	// pool chain the memheader is linked into
+	short chainnum;
+
 	// file name and line where Mem_Alloc was called
 	const char *filename;
 	int fileline;
@@ -60,8 +84,9 @@ struct mempool_s {
 	// should always be MEMHEADER_SENTINEL1
 	unsigned int sentinel1;
 
-	// chain of individual memory allocations
-	struct memheader_s *chain;
+	// chains of individual memory allocations
+	struct memheader_s *chain[MEMPOOL_NUM_CHAINS];
+	volatile int chainlock[MEMPOOL_NUM_CHAINS];
 
 	// temporary, etc
 	int flags;
@@ -109,7 +134,41 @@ mempool_t *tempMemPool;
 // only for zone
 mempool_t *zoneMemPool;
 
-static qmutex_t *memMutex;
+typedef struct memslab_s {
+	struct memslab_s *next;
+	size_t size;
+} memslab_t;
+
+typedef struct {
+	size_t size;
+	unsigned batch;
+
+	// free blocks shared by all threads
+	volatile int lock;
+	void *freelist;
+	unsigned numfree;
+
+	memslab_t *slabs;
+	size_t slabsize;
+} memclass_t;
+
+#ifdef MEM_THREAD_CACHE
+typedef struct {
+	void *freelist[MEM_NUM_CLASSES];
+	unsigned numfree[MEM_NUM_CLASSES];
+	int chainnum;
+} memcache_t;
+
+static ATTRIBUTE_TLS memcache_t mem_threadcache;
+static volatile int mem_numthreads;
+#endif
+
+static volatile int mem_numallocs;
+static volatile int mem_countallocs;    // allocations are only counted while this is non-zero
+
+static memclass_t mem_classes[MEM_NUM_CLASSES];
+static uint8_t mem_classlookup[MEMCLASS_LOOKUP_SIZE];
+static int mem_numclasses;
 
 static bool memory_initialized = false;
 static bool commands_initialized = false;
@@ -125,9 +184,287 @@ static void _Mem_Error( const char *format, ... ) {
 	Sys_Error( "%s", msg );
 }
 
+/*
+* Mem_SpinLock
+*
+* The locked sections are a few pointer updates long, so spinning
+* is cheaper than going to sleep on a mutex.
+*/
+static void Mem_SpinLock( volatile int *lock ) {
+	int spins = 0;
+
+	while( *lock || !QAtomic_CAS( lock, 0, 1 ) ) {
+		if( ++spins > 64 ) {
+			QThread_Yield();
+			spins = 0;
+		}
+	}
+}
+
+/*
+* Mem_SpinUnlock
+*/
+static void Mem_SpinUnlock( volatile int *lock ) {
+	QAtomic_CAS( lock, 1, 0 );
+}
+
+/*
+* Mem_InitClasses
+*
+* 16 byte steps up to 128 bytes, then four classes per power of two.
+*/
+static void Mem_InitClasses( void ) {
+	int i;
+	size_t size, step;
+	memclass_t *cls;
+
+	memset( mem_classes, 0, sizeof( mem_classes ) );
+
+	mem_numclasses = 0;
+	for( size = 16, step = 16; size <= MEMCLASS_MAXSIZE; size += step ) {
+		if( size >= 128 && !( size & ( size - 1 ) ) ) {
+			step = size / 4;
+		}
+
+		assert( mem_numclasses < MEM_NUM_CLASSES );
+		cls = &mem_classes[mem_numclasses++];
+		cls->size = size;
+		cls->batch = Q_bound( 2, MEMCACHE_BATCH_BYTES / size, 64 );
+		cls->slabsize = max( MEMSLAB_SIZE, sizeof( memslab_t ) + size * MEMSLAB_MINBLOCKS );
+	}
+
+	for( i = 0, cls = mem_classes; i < MEMCLASS_LOOKUP_SIZE; i++ ) {
+		while( cls->size < ( (size_t)i << MEMCLASS_LOOKUP_SHIFT ) ) {
+			cls++;
+		}
+		mem_classlookup[i] = cls - mem_classes;
+	}
+}
+
+/*
+* Mem_ClassForSize
+*/
+static int Mem_ClassForSize( size_t size ) {
+	if( size > MEMCLASS_MAXSIZE ) {
+		return -1;
+	}
+	return mem_classlookup[( size + ( 1 << MEMCLASS_LOOKUP_SHIFT ) - 1 ) >> MEMCLASS_LOOKUP_SHIFT];
+}
+
+/*
+* Mem_AllocSlab
+*
+* Carves a new slab into free blocks. Must be called with the class locked.
+*/
+static void Mem_AllocSlab( memclass_t *cls ) {
+	uint8_t *block, *end;
+	memslab_t *slab;
+
+	slab = ( memslab_t * )malloc( cls->slabsize );
+	if( slab == NULL ) {
+		_Mem_Error( "Mem_Alloc: out of memory (%" PRIuPTR " bytes slab)", (uintptr_t)cls->slabsize );
+	}
+
+	slab->size = cls->slabsize;
+	slab->next = cls->slabs;
+	cls->slabs = slab;
+
+	block = (uint8_t *)slab + Q_ALIGN( sizeof( memslab_t ), MEMALIGNMENT_DEFAULT );
+	end = (uint8_t *)slab + cls->slabsize;
+	for( ; block + cls->size <= end; block += cls->size ) {
+		*( void ** )block = cls->freelist;
+		cls->freelist = block;
+		cls->numfree++;
+	}
+}
+
+/*
+* Mem_FreeSlabs
+*/
+static void Mem_FreeSlabs( void ) {
+	int i;
+	memslab_t *slab, *next;
+
+	for( i = 0; i < mem_numclasses; i++ ) {
+		for( slab = mem_classes[i].slabs; slab; slab = next ) {
+			next = slab->next;
+			free( slab );
+		}
+		mem_classes[i].slabs = NULL;
+		mem_classes[i].freelist = NULL;
+		mem_classes[i].numfree = 0;
+	}
+}
+
+#ifdef MEM_THREAD_CACHE
+
+/*
+* Mem_RefillCache
+*/
+static void Mem_RefillCache( memcache_t *cache, int c ) {
+	unsigned i;
+	void *block;
+	memclass_t *cls = &mem_classes[c];
+
+	Mem_SpinLock( &cls->lock );
+	for( i = 0; i < cls->batch; i++ ) {
+		if( !cls->freelist ) {
+			Mem_AllocSlab( cls );
+		}
+
+		block = cls->freelist;
+		cls->freelist = *( void ** )block;
+		cls->numfree--;
+
+		*( void ** )block = cache->freelist[c];
+		cache->freelist[c] = block;
+	}
+	Mem_SpinUnlock( &cls->lock );
+
+	cache->numfree[c] += cls->batch;
+}
+
+/*
+* Mem_FlushCache
+*
+* Hands count blocks of the given class back to the depot.
+*/
+static void Mem_FlushCache( memcache_t *cache, int c, unsigned count ) {
+	unsigned i;
+	void *block;
+	memclass_t *cls = &mem_classes[c];
+
+	Mem_SpinLock( &cls->lock );
+	for( i = 0; i < count && cache->freelist[c]; i++ ) {
+		block = cache->freelist[c];
+		cache->freelist[c] = *( void ** )block;
+		cache->numfree[c]--;
+
+		*( void ** )block = cls->freelist;
+		cls->freelist = block;
+		cls->numfree++;
+	}
+	Mem_SpinUnlock( &cls->lock );
+}
+
+#endif
+
+/*
+* Mem_FlushThreadCache
+*
+* Returns the free blocks cached by the calling thread, must be
+* called by threads that allocate memory before they exit.
+*/
+void Mem_FlushThreadCache( void ) {
+#ifdef MEM_THREAD_CACHE
+	int c;
+	memcache_t *cache = &mem_threadcache;
+
+	for( c = 0; c < mem_numclasses; c++ ) {
+		if( cache->numfree[c] ) {
+			Mem_FlushCache( cache, c, cache->numfree[c] );
+		}
+	}
+#endif
+}
+
+/*
+* Mem_ChainNum
+*/
+static int Mem_ChainNum( void ) {
+#ifdef MEM_THREAD_CACHE
+	memcache_t *cache = &mem_threadcache;
+
+	if( !cache->chainnum ) {
+		cache->chainnum = QAtomic_Add( &mem_numthreads, 1 ) % MEMPOOL_NUM_CHAINS + 1;
+	}
+	return cache->chainnum - 1;
+#else
+	return 0;
+#endif
+}
+
+/*
+* Mem_AllocBlock
+*/
+static void *Mem_AllocBlock( size_t size, short *sizeclass ) {
+	void *block;
+	int c = Mem_ClassForSize( size );
+
+	*sizeclass = c;
+	if( c < 0 ) {
+		return malloc( size );
+	}
+
+#ifdef MEM_THREAD_CACHE
+	{
+		memcache_t *cache = &mem_threadcache;
+
+		if( !cache->freelist[c] ) {
+			Mem_RefillCache( cache, c );
+		}
+
+		block = cache->freelist[c];
+		cache->freelist[c] = *( void ** )block;
+		cache->numfree[c]--;
+	}
+#else
+	{
+		memclass_t *cls = &mem_classes[c];
+
+		Mem_SpinLock( &cls->lock );
+		if( !cls->freelist ) {
+			Mem_AllocSlab( cls );
+		}
+		block = cls->freelist;
+		cls->freelist = *( void ** )block;
+		cls->numfree--;
+		Mem_SpinUnlock( &cls->lock );
+	}
+#endif
+
+	return block;
+}
+
+/*
+* Mem_FreeBlock
+*/
+static void Mem_FreeBlock( void *block, int c ) {
+	if( c < 0 ) {
+		free( block );
+		return;
+	}
+
+#ifdef MEM_THREAD_CACHE
+	{
+		memcache_t *cache = &mem_threadcache;
+
+		*( void ** )block = cache->freelist[c];
+		cache->freelist[c] = block;
+		cache->numfree[c]++;
+
+		if( cache->numfree[c] >= mem_classes[c].batch * 2 ) {
+			Mem_FlushCache( cache, c, mem_classes[c].batch );
+		}
+	}
+#else
+	{
+		memclass_t *cls = &mem_classes[c];
+
+		Mem_SpinLock( &cls->lock );
+		*( void ** )block = cls->freelist;
+		cls->freelist = block;
+		cls->numfree++;
+		Mem_SpinUnlock( &cls->lock );
+	}
+#endif
+}
+
 ATTRIBUTE_MALLOC void *_Mem_AllocExt( mempool_t *pool, size_t size, size_t alignment, int z, int musthave, int canthave, const char *filename, int fileline ) {
 	void *base;
 	size_t realsize;
+	short sizeclass;
+	int chainnum;
 	memheader_t *mem;
 
 	if( size <= 0 ) {
@@ -155,14 +492,9 @@ ATTRIBUTE_MALLOC void *_Mem_AllocExt( mempool_t *pool, size_t size, size_t align
 		Com_DPrintf( "Mem_Alloc: pool %s, file %s:%i, size %" PRIuPTR " bytes\n", pool->name, filename, fileline, (uintptr_t)size );
 	}
 
-	QMutex_Lock( memMutex );
-
-	pool->totalsize += size;
 	realsize = sizeof( memheader_t ) + size + alignment + sizeof( int );
 
-	pool->realsize += realsize;
-
-	base = malloc( realsize );
+	base = Mem_AllocBlock( realsize, &sizeclass );
 	if( base == NULL ) {
 		_Mem_Error( "Mem_Alloc: out of memory (alloc at %s:%i)", filename, fileline );
 	}
@@ -174,21 +506,31 @@ ATTRIBUTE_MALLOC void *_Mem_AllocExt( mempool_t *pool, size_t size, size_t align
 	mem->fileline = fileline;
 	mem->size = size;
 	mem->realsize = realsize;
+	mem->sizeclass = sizeclass;
+	mem->chainnum = chainnum = Mem_ChainNum();
 	mem->pool = pool;
 	mem->sentinel1 = MEMHEADER_SENTINEL1;
 
 	// we have to use only a single byte for this sentinel, because it may not be aligned, and some platforms can't use unaligned accesses
 	*( (uint8_t *) mem + sizeof( memheader_t ) + mem->size ) = MEMHEADER_SENTINEL2;
 
+	QAtomic_Add( &pool->totalsize, size );
+	QAtomic_Add( &pool->realsize, realsize );
+	if( mem_countallocs ) {
+		QAtomic_Add( &mem_numallocs, 1 );
+	}
+
+	Mem_SpinLock( &pool->chainlock[chainnum] );
+
 	// append to head of list
-	mem->next = pool->chain;
+	mem->next = pool->chain[chainnum];
 	mem->prev = NULL;
-	pool->chain = mem;
+	pool->chain[chainnum] = mem;
 	if( mem->next ) {
 		mem->next->prev = mem;
 	}
 
-	QMutex_Unlock( memMutex );
+	Mem_SpinUnlock( &pool->chainlock[chainnum] );
 
 	if( z ) {
 		memset( (void *)( (uint8_t *) mem + sizeof( memheader_t ) ), 0, mem->size );
@@ -253,6 +595,7 @@ char *_Mem_CopyString( mempool_t *pool, const char *in, const char *filename, in
 
 void _Mem_Free( void *data, int musthave, int canthave, const char *filename, int fileline ) {
 	void *base;
+	int chainnum, sizeclass;
 	memheader_t *mem;
 	mempool_t *pool;
 
@@ -288,35 +631,81 @@ void _Mem_Free( void *data, int musthave, int canthave, const char *filename, in
 			pool->name, mem->filename, mem->fileline, filename, fileline, (uintptr_t)mem->size );
 	}
 
-	QMutex_Lock( memMutex );
+	chainnum = mem->chainnum;
+	if( chainnum < 0 || chainnum >= MEMPOOL_NUM_CHAINS ) {
+		_Mem_Error( "Mem_Free: not allocated or double freed (free at %s:%i)", filename, fileline );
+	}
+
+	Mem_SpinLock( &pool->chainlock[chainnum] );
 
 	// unlink memheader from doubly linked list
-	if( ( mem->prev ? mem->prev->next != mem : pool->chain != mem ) || ( mem->next && mem->next->prev != mem ) ) {
+	if( ( mem->prev ? mem->prev->next != mem : pool->chain[chainnum] != mem ) || ( mem->next && mem->next->prev != mem ) ) {
+		Mem_SpinUnlock( &pool->chainlock[chainnum] );
 		_Mem_Error( "Mem_Free: not allocated or double freed (free at %s:%i)", filename, fileline );
 	}
 
 	if( mem->prev ) {
 		mem->prev->next = mem->next;
 	} else {
-		pool->chain = mem->next;
+		pool->chain[chainnum] = mem->next;
 	}
 	if( mem->next ) {
 		mem->next->prev = mem->prev;
 	}
 
+	Mem_SpinUnlock( &pool->chainlock[chainnum] );
+
 	// memheader has been unlinked, do the actual free now
-	pool->totalsize -= mem->size;
+	QAtomic_Add( &pool->totalsize, -(int)mem->size );
+	QAtomic_Add( &pool->realsize, -(int)mem->realsize );
 
 	base = mem->baseaddress;
-	pool->realsize -= mem->realsize;
-
-	QMutex_Unlock( memMutex );
+	sizeclass = mem->sizeclass;
 
 #ifdef MEMTRASH
 	memset( mem, 0xBF, sizeof( memheader_t ) + mem->size + sizeof( int ) );
 #endif
 
-	free( base );
+	Mem_FreeBlock( base, sizeclass );
+}
+
+static bool Mem_PoolHasAllocations( mempool_t *pool ) {
+	int i;
+
+	for( i = 0; i < MEMPOOL_NUM_CHAINS; i++ ) {
+		if( pool->chain[i] ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void Mem_PrintAllocations( mempool_t *pool ) {
+	int i;
+	memheader_t *mem;
+
+	for( i = 0; i < MEMPOOL_NUM_CHAINS; i++ ) {
+		for( mem = pool->chain[i]; mem; mem = mem->next )
+			Com_Printf( "%10" PRIuPTR " bytes allocated at %s:%i\n", (uintptr_t)mem->size, mem->filename, mem->fileline );
+	}
+}
+
+#ifdef SHOW_NONFREED
+static void Mem_PrintNonFreed( mempool_t *pool ) {
+	if( Mem_PoolHasAllocations( pool ) ) {
+		Com_Printf( "Warning: Memory pool %s has resources that weren't freed:\n", pool->name );
+		Mem_PrintAllocations( pool );
+	}
+}
+#endif
+
+static void Mem_FreeChains( mempool_t *pool ) {
+	int i;
+
+	for( i = 0; i < MEMPOOL_NUM_CHAINS; i++ ) {
+		while( pool->chain[i] )     // free memory owned by the pool
+			Mem_Free( (void *)( (uint8_t *)pool->chain[i] + sizeof( memheader_t ) ) );
+	}
 }
 
 mempool_t *_Mem_AllocPool( mempool_t *parent, const char *name, int flags, const char *filename, int fileline ) {
@@ -340,7 +729,6 @@ mempool_t *_Mem_AllocPool( mempool_t *parent, const char *name, int flags, const
 	pool->filename = filename;
 	pool->fileline = fileline;
 	pool->flags = flags;
-	pool->chain = NULL;
 	pool->parent = parent;
 	pool->child = NULL;
 	pool->totalsize = 0;
@@ -369,9 +757,6 @@ mempool_t *_Mem_AllocTempPool( const char *name, const char *filename, int filel
 
 void _Mem_FreePool( mempool_t **pool, int musthave, int canthave, const char *filename, int fileline ) {
 	mempool_t **chainAddress;
-#ifdef SHOW_NONFREED
-	memheader_t *mem;
-#endif
 
 	if( !( *pool ) ) {
 		return;
@@ -402,12 +787,7 @@ void _Mem_FreePool( mempool_t **pool, int musthave, int canthave, const char *fi
 	}
 
 #ifdef SHOW_NONFREED
-	if( ( *pool )->chain ) {
-		Com_Printf( "Warning: Memory pool %s has resources that weren't freed:\n", ( *pool )->name );
-	}
-	for( mem = ( *pool )->chain; mem; mem = mem->next ) {
-		Com_Printf( "%10i bytes allocated at %s:%i\n", mem->size, mem->filename, mem->fileline );
-	}
+	Mem_PrintNonFreed( *pool );
 #endif
 
 	// unlink pool from chain
@@ -421,8 +801,7 @@ void _Mem_FreePool( mempool_t **pool, int musthave, int canthave, const char *fi
 		_Mem_Error( "Mem_FreePool: pool already free (freepool at %s:%i)", filename, fileline );
 	}
 
-	while( ( *pool )->chain )  // free memory owned by the pool
-		Mem_Free( (void *)( (uint8_t *)( *pool )->chain + sizeof( memheader_t ) ) );
+	Mem_FreeChains( *pool );
 
 	*chainAddress = ( *pool )->next;
 
@@ -436,9 +815,6 @@ void _Mem_FreePool( mempool_t **pool, int musthave, int canthave, const char *fi
 
 void _Mem_EmptyPool( mempool_t *pool, int musthave, int canthave, const char *filename, int fileline ) {
 	mempool_t *child, *next;
-#ifdef SHOW_NONFREED
-	memheader_t *mem;
-#endif
 
 	if( pool == NULL ) {
 		_Mem_Error( "Mem_EmptyPool: pool == NULL (emptypool at %s:%i)", filename, fileline );
@@ -469,15 +845,9 @@ void _Mem_EmptyPool( mempool_t *pool, int musthave, int canthave, const char *fi
 	}
 
 #ifdef SHOW_NONFREED
-	if( pool->chain ) {
-		Com_Printf( "Warning: Memory pool %s has resources that weren't freed:\n", pool->name );
-	}
-	for( mem = pool->chain; mem; mem = mem->next ) {
-		Com_Printf( "%10i bytes allocated at %s:%i\n", mem->size, mem->filename, mem->fileline );
-	}
+	Mem_PrintNonFreed( pool );
 #endif
-	while( pool->chain )        // free memory owned by the pool
-		Mem_Free( (void *)( (uint8_t *) pool->chain + sizeof( memheader_t ) ) );
+	Mem_FreeChains( pool );
 }
 
 size_t Mem_PoolTotalSize( mempool_t *pool ) {
@@ -486,6 +856,26 @@ size_t Mem_PoolTotalSize( mempool_t *pool ) {
 	return pool->totalsize;
 }
 
+/*
+* Mem_CountAllocs
+*
+* Counting every allocation would make all threads contend for the same
+* cache line, so it is only done between matching enable and disable calls.
+*/
+void Mem_CountAllocs( bool enable ) {
+	QAtomic_Add( &mem_countallocs, enable ? 1 : -1 );
+}
+
+/*
+* Mem_NumAllocs
+*
+* Returns the number of allocations counted so far, wrapping around.
+* Only meaningful as a difference between two calls.
+*/
+unsigned Mem_NumAllocs( void ) {
+	return (unsigned)mem_numallocs;
+}
+
 void _Mem_CheckSentinels( void *data, const char *filename, int fileline ) {
 	memheader_t *mem;
 
@@ -507,6 +897,7 @@ void _Mem_CheckSentinels( void *data, const char *filename, int fileline ) {
 }
 
 static void _Mem_CheckSentinelsPool( mempool_t *pool, const char *filename, int fileline ) {
+	int i;
 	memheader_t *mem;
 	mempool_t *child;
 
@@ -526,8 +917,10 @@ static void _Mem_CheckSentinelsPool( mempool_t *pool, const char *filename, int
 		_Mem_Error( "_Mem_CheckSentinelsPool: trashed pool sentinel 2 (allocpool at %s:%i, sentinel check at %s:%i)", pool->filename, pool->fileline, filename, fileline );
 	}
 
-	for( mem = pool->chain; mem; mem = mem->next )
-		_Mem_CheckSentinels( (void *)( (uint8_t *) mem + sizeof( memheader_t ) ), filename, fileline );
+	for( i = 0; i < MEMPOOL_NUM_CHAINS; i++ ) {
+		for( mem = pool->chain[i]; mem; mem = mem->next )
+			_Mem_CheckSentinels( (void *)( (uint8_t *) mem + sizeof( memheader_t ) ), filename, fileline );
+	}
 }
 
 void _Mem_CheckSentinelsGlobal( const char *filename, int fileline ) {
@@ -537,6 +930,312 @@ void _Mem_CheckSentinelsGlobal( const char *filename, int fileline ) {
 		_Mem_CheckSentinelsPool( pool, filename, fileline );
 }
 
+// ============================================================================
+
+#define MEMARENA_DEFAULT_BLOCKSIZE  0x10000
+
+typedef struct memarenablock_s {
+	struct memarenablock_s *next;   // older block
+	size_t start;                   // arena offset of the first byte of the block
+	size_t size;
+	size_t used;
+} memarenablock_t;
+
+struct memarena_s {
+	char name[POOLNAMESIZE];
+	size_t blocksize;
+
+	// current block, older blocks are linked through next
+	memarenablock_t *block;
+
+	// blocks released by Mem_ArenaFreeToMark, reused when the arena grows again
+	memarenablock_t *spare;
+
+	size_t used;
+	size_t reserved;
+
+	// high-water marks since the last reset, of the previous frame and overall
+	size_t framepeak;
+	size_t lastframepeak;
+	size_t peak;
+
+	struct memarena_s *prev, *next;
+
+	const char *filename;
+	int fileline;
+};
+
+static mempool_t *arenaMemPool;
+static memarena_t arenaChain;   // sentinel of the list of all arenas
+static volatile int arenaChainLock;
+static volatile int numScratchArenas;
+
+#ifdef MEM_THREAD_CACHE
+static ATTRIBUTE_TLS memarena_t *mem_scratcharena;
+#else
+static memarena_t *mem_scratcharena;
+#endif
+
+/*
+* Mem_ArenaBlockData
+*/
+static uint8_t *Mem_ArenaBlockData( memarenablock_t *block ) {
+	return (uint8_t *)block + Q_ALIGN( sizeof( memarenablock_t ), MEMALIGNMENT_DEFAULT );
+}
+
+/*
+* Mem_FreeArenaBlocks
+*/
+static void Mem_FreeArenaBlocks( memarenablock_t *block ) {
+	memarenablock_t *next;
+
+	for( ; block; block = next ) {
+		next = block->next;
+		Mem_Free( block );
+	}
+}
+
+/*
+* Mem_NewArenaBlock
+*
+* Starts a new block at the current offset of the arena, reusing a spare one if it is large enough.
+*/
+static memarenablock_t *Mem_NewArenaBlock( memarena_t *arena, size_t size, const char *filename, int fileline ) {
+	memarenablock_t *block;
+
+	block = arena->spare;
+	if( block && block->size >= size ) {
+		arena->spare = block->next;
+	} else {
+		size = max( size, arena->blocksize );
+
+		block = ( memarenablock_t * )_Mem_AllocExt( arenaMemPool, Q_ALIGN( sizeof( memarenablock_t ), MEMALIGNMENT_DEFAULT ) + size,
+			MEMALIGNMENT_DEFAULT, 0, 0, 0, filename, fileline );
+		block->size = size;
+		arena->reserved += size;
+	}
+
+	block->start = arena->used;
+	block->used = 0;
+	block->next = arena->block;
+	arena->block = block;
+	return block;
+}
+
+/*
+* _Mem_AllocArena
+*/
+memarena_t *_Mem_AllocArena( const char *name, size_t blocksize, const char *filename, int fileline ) {
+	memarena_t *arena;
+
+	arena = ( memarena_t * )_Mem_AllocExt( arenaMemPool, sizeof( *arena ), 0, 1, 0, 0, filename, fileline );
+	Q_strncpyz( arena->name, name, sizeof( arena->name ) );
+	arena->blocksize = blocksize ? blocksize : MEMARENA_DEFAULT_BLOCKSIZE;
+	arena->filename = filename;
+	arena->fileline = fileline;
+
+	Mem_SpinLock( &arenaChainLock );
+	arena->prev = &arenaChain;
+	arena->next = arenaChain.next;
+	arena->next->prev = arena;
+	arenaChain.next = arena;
+	Mem_SpinUnlock( &arenaChainLock );
+
+	return arena;
+}
+
+/*
+* _Mem_FreeArena
+*/
+void _Mem_FreeArena( memarena_t **parena, const char *filename, int fileline ) {
+	memarena_t *arena = *parena;
+
+	if( !arena ) {
+		return;
+	}
+
+	Mem_SpinLock( &arenaChainLock );
+	arena->prev->next = arena->next;
+	arena->next->prev = arena->prev;
+	Mem_SpinUnlock( &arenaChainLock );
+
+	Mem_FreeArenaBlocks( arena->block );
+	Mem_FreeArenaBlocks( arena->spare );
+	_Mem_Free( arena, 0, 0, filename, fileline );
+
+	*parena = NULL;
+}
+
+/*
+* _Mem_ArenaAlloc
+*
+* The memory is not cleared and stays valid until the arena is reset or freed to an earlier mark.
+*/
+ATTRIBUTE_MALLOC void *_Mem_ArenaAlloc( memarena_t *arena, size_t size, size_t alignment, const char *filename, int fileline ) {
+	uintptr_t base = 0;
+	size_t offset = 0;
+	memarenablock_t *block = arena->block;
+
+	if( !size ) {
+		return NULL;
+	}
+	if( !alignment ) {
+		alignment = MEMALIGNMENT_DEFAULT;
+	}
+
+	if( block ) {
+		base = (uintptr_t)Mem_ArenaBlockData( block );
+		offset = Q_ALIGN( base + block->used, alignment ) - base;
+	}
+	if( !block || offset + size > block->size ) {
+		block = Mem_NewArenaBlock( arena, size + alignment, filename, fileline );
+		base = (uintptr_t)Mem_ArenaBlockData( block );
+		offset = Q_ALIGN( base, alignment ) - base;
+	}
+
+	block->used = offset + size;
+	arena->used = block->start + block->used;
+	if( arena->used > arena->framepeak ) {
+		arena->framepeak = arena->used;
+		if( arena->used > arena->peak ) {
+			arena->peak = arena->used;
+		}
+	}
+
+	return (void *)( base + offset );
+}
+
+/*
+* Mem_ArenaMark
+*/
+size_t Mem_ArenaMark( memarena_t *arena ) {
+	return arena->used;
+}
+
+/*
+* Mem_ArenaFreeToMark
+*
+* Releases everything allocated after the mark was taken.
+*/
+void Mem_ArenaFreeToMark( memarena_t *arena, size_t mark ) {
+	memarenablock_t *block;
+
+	// marks taken before a reset are silently ignored
+	if( mark >= arena->used ) {
+		return;
+	}
+
+	while( ( block = arena->block ) != NULL && block->start > mark ) {
+		arena->block = block->next;
+		block->next = arena->spare;
+		arena->spare = block;
+	}
+
+	if( block ) {
+		block->used = mark - block->start;
+	}
+	arena->used = mark;
+}
+
+/*
+* Mem_ArenaReset
+*
+* Frees everything in the arena. Memory that had to be spread over several blocks
+* is merged into a single block large enough for the peak usage since the last reset.
+*/
+void Mem_ArenaReset( memarena_t *arena ) {
+	size_t size;
+
+	Mem_ArenaFreeToMark( arena, 0 );
+
+	if( arena->spare ) {
+		size = Q_ALIGN( max( arena->framepeak, arena->blocksize ), MEMALIGNMENT_DEFAULT );
+
+		Mem_FreeArenaBlocks( arena->block );
+		Mem_FreeArenaBlocks( arena->spare );
+		arena->block = arena->spare = NULL;
+		arena->reserved = 0;
+
+		Mem_NewArenaBlock( arena, size, __FILE__, __LINE__ );
+	}
+
+	arena->lastframepeak = arena->framepeak;
+	arena->framepeak = 0;
+}
+
+/*
+* Mem_ScratchArena
+*
+* Returns the scratch arena of the calling thread. Without compiler support for thread-local
+* storage there is a single scratch arena, which may only be used by the main thread.
+*/
+memarena_t *Mem_ScratchArena( void ) {
+	char name[POOLNAMESIZE];
+
+	if( !mem_scratcharena ) {
+		Q_snprintfz( name, sizeof( name ), "Scratch %i", QAtomic_Add( &numScratchArenas, 1 ) );
+		mem_scratcharena = Mem_AllocArena( name, 0 );
+	}
+	return mem_scratcharena;
+}
+
+/*
+* _Mem_ScratchAlloc
+*/
+ATTRIBUTE_MALLOC void *_Mem_ScratchAlloc( size_t size, const char *filename, int fileline ) {
+	return _Mem_ArenaAlloc( Mem_ScratchArena(), size, 0, filename, fileline );
+}
+
+/*
+* Mem_ScratchMark
+*/
+size_t Mem_ScratchMark( void ) {
+	return Mem_ArenaMark( Mem_ScratchArena() );
+}
+
+/*
+* Mem_ScratchFreeToMark
+*/
+void Mem_ScratchFreeToMark( size_t mark ) {
+	Mem_ArenaFreeToMark( Mem_ScratchArena(), mark );
+}
+
+/*
+* Mem_ScratchReset
+*
+* Called once per frame by threads that run frames, to release scratch memory nobody freed.
+*/
+void Mem_ScratchReset( void ) {
+	Mem_ArenaReset( Mem_ScratchArena() );
+}
+
+/*
+* Mem_FreeThreadArena
+*
+* Frees the scratch arena of the calling thread, must be called before it exits.
+*/
+void Mem_FreeThreadArena( void ) {
+	Mem_FreeArena( &mem_scratcharena );
+}
+
+/*
+* Mem_PrintArenaStats
+*/
+static void Mem_PrintArenaStats( void ) {
+	memarena_t *arena;
+
+	Com_Printf( "arenas:\n" "    used  frame peak   last frame     peak   reserved  name\n" );
+
+	Mem_SpinLock( &arenaChainLock );
+	for( arena = arenaChain.next; arena != &arenaChain; arena = arena->next ) {
+		Com_Printf( "%7uk %10uk %11uk %7uk %9uk  %s\n",
+			(unsigned)( ( arena->used + 1023 ) / 1024 ), (unsigned)( ( arena->framepeak + 1023 ) / 1024 ),
+			(unsigned)( ( arena->lastframepeak + 1023 ) / 1024 ), (unsigned)( ( arena->peak + 1023 ) / 1024 ),
+			(unsigned)( ( arena->reserved + 1023 ) / 1024 ), arena->name );
+	}
+	Mem_SpinUnlock( &arenaChainLock );
+}
+
 static void Mem_CountPoolStats( mempool_t *pool, int *count, int *size, int *realsize ) {
 	mempool_t *child;
 
@@ -561,7 +1260,6 @@ static void Mem_PrintStats( void ) {
 	int count, size, real;
 	int total, totalsize, realsize;
 	mempool_t *pool;
-	memheader_t *mem;
 
 	Mem_CheckSentinelsGlobal();
 
@@ -576,20 +1274,20 @@ static void Mem_PrintStats( void ) {
 
 	// temporary pools are not nested
 	for( pool = poolChain; pool; pool = pool->next ) {
-		if( ( pool->flags & MEMPOOL_TEMPORARY ) && pool->chain ) {
+		if( ( pool->flags & MEMPOOL_TEMPORARY ) && Mem_PoolHasAllocations( pool ) ) {
 			Com_Printf( "%i bytes (%.3fMB) (%i bytes (%.3fMB actual)) of temporary memory still allocated (Leak!)\n", pool->totalsize, pool->totalsize / 1048576.0,
 						pool->realsize, pool->realsize / 1048576.0 );
 			Com_Printf( "listing temporary memory allocations for %s:\n", pool->name );
 
-			for( mem = tempMemPool->chain; mem; mem = mem->next )
-				Com_Printf( "%10" PRIuPTR " bytes allocated at %s:%i\n", (uintptr_t)mem->size, mem->filename, mem->fileline );
+			Mem_PrintAllocations( pool );
 		}
 	}
+
+	Mem_PrintArenaStats();
 }
 
 static void Mem_PrintPoolStats( mempool_t *pool, int listchildren, int listallocations ) {
 	mempool_t *child;
-	memheader_t *mem;
 	int totalsize = 0, realsize = 0;
 
 	Mem_CountPoolStats( pool, NULL, &totalsize, &realsize );
@@ -611,8 +1309,7 @@ static void Mem_PrintPoolStats( mempool_t *pool, int listchildren, int listalloc
 	pool->lastchecksize = totalsize;
 
 	if( listallocations ) {
-		for( mem = pool->chain; mem; mem = mem->next )
-			Com_Printf( "%10" PRIuPTR " bytes allocated at %s:%i\n", (uintptr_t)mem->size, mem->filename, mem->fileline );
+		Mem_PrintAllocations( pool );
 	}
 
 	if( listchildren ) {
@@ -672,6 +1369,108 @@ static void MemStats_f( void ) {
 	Mem_PrintStats();
 }
 
+#define MEMSTRESS_SLOTS     256
+#define MEMSTRESS_MINSIZE   16
+#define MEMSTRESS_MAXSIZE   2048
+
+typedef struct {
+	mempool_t *pool;        // NULL for the system allocator
+	unsigned ops;
+	unsigned seed;
+	qthread_t *thread;
+} memstress_t;
+
+/*
+* Mem_StressThread
+*
+* Frees and reallocates random slots in a ring of live blocks, so
+* blocks of various sizes stay allocated while others churn.
+*/
+static void *Mem_StressThread( void *param ) {
+	unsigned i, slot, size;
+	memstress_t *ms = ( memstress_t * )param;
+	void *slots[MEMSTRESS_SLOTS];
+
+	memset( slots, 0, sizeof( slots ) );
+
+	for( i = 0; i < ms->ops; i++ ) {
+		ms->seed = ms->seed * 1103515245 + 12345;
+		slot = ( ms->seed >> 8 ) % MEMSTRESS_SLOTS;
+		size = MEMSTRESS_MINSIZE + ( ms->seed >> 16 ) % ( MEMSTRESS_MAXSIZE - MEMSTRESS_MINSIZE + 1 );
+
+		if( ms->pool ) {
+			Mem_Free( slots[slot] );
+			slots[slot] = Mem_AllocExt( ms->pool, size, 0 );
+		} else {
+			free( slots[slot] );
+			slots[slot] = malloc( size );
+		}
+		*( uint8_t * )slots[slot] = i;
+	}
+
+	for( i = 0; i < MEMSTRESS_SLOTS; i++ ) {
+		if( ms->pool ) {
+			Mem_Free( slots[i] );
+		} else {
+			free( slots[i] );
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* Mem_StressRun
+*/
+static double Mem_StressRun( mempool_t *pool, int numThreads, unsigned ops ) {
+	int i;
+	uint64_t t;
+	memstress_t ms[16];
+
+	for( i = 0; i < numThreads; i++ ) {
+		ms[i].pool = pool;
+		ms[i].ops = ops;
+		ms[i].seed = i * 7919 + 1;
+	}
+
+	t = Sys_Microseconds();
+	for( i = 0; i < numThreads; i++ )
+		ms[i].thread = QThread_Create( Mem_StressThread, &ms[i] );
+	for( i = 0; i < numThreads; i++ )
+		QThread_Join( ms[i].thread );
+	t = Sys_Microseconds() - t;
+
+	return (double)numThreads * ops / (double)max( t, 1 );
+}
+
+/*
+* MemStress_f
+*
+* memstress [maxthreads] [ops]
+* Measures allocation throughput of a shared pool for 1 to maxthreads threads.
+*/
+static void MemStress_f( void ) {
+	int numThreads, maxThreads;
+	unsigned ops;
+	double pool, sys;
+	mempool_t *stressPool;
+
+	maxThreads = Cmd_Argc() > 1 ? Q_bound( 1, atoi( Cmd_Argv( 1 ) ), 16 ) : 16;
+	ops = Cmd_Argc() > 2 ? max( atoi( Cmd_Argv( 2 ) ), 1 ) : 1000000;
+
+	stressPool = Mem_AllocPool( NULL, "Memory Stress" );
+
+	Com_Printf( "%u alloc/free pairs per thread, %i..%i bytes\n", ops, MEMSTRESS_MINSIZE, MEMSTRESS_MAXSIZE );
+	Com_Printf( "threads   pool Mops/s  malloc Mops/s\n" );
+
+	for( numThreads = 1; numThreads <= maxThreads; numThreads *= 2 ) {
+		pool = Mem_StressRun( stressPool, numThreads, ops );
+		sys = Mem_StressRun( NULL, numThreads, ops );
+		Com_Printf( "%7i %12.2f %14.2f\n", numThreads, pool, sys );
+	}
+
+	Mem_FreePool( &stressPool );
+}
 
 /*
 * Memory_Init
@@ -679,10 +1478,13 @@ static void MemStats_f( void ) {
 void Memory_Init( void ) {
 	assert( !memory_initialized );
 
-	memMutex = QMutex_Create();
+	Mem_InitClasses();
 
 	zoneMemPool = Mem_AllocPool( NULL, "Zone" );
 	tempMemPool = Mem_AllocTempPool( "Temporary Memory" );
+	arenaMemPool = Mem_AllocPool( NULL, "Arenas" );
+
+	arenaChain.prev = arenaChain.next = &arenaChain;
 
 	memory_initialized = true;
 }
@@ -697,6 +1499,7 @@ void Memory_InitCommands( void ) {
 
 	Cmd_AddCommand( "memlist", MemList_f );
 	Cmd_AddCommand( "memstats", MemStats_f );
+	Cmd_AddCommand( "memstress", MemStress_f );
 
 	commands_initialized = true;
 }
@@ -721,6 +1524,11 @@ void Memory_Shutdown( void ) {
 	Mem_FreePool( &zoneMemPool );
 	Mem_FreePool( &tempMemPool );
 
+	// the memory of all arenas is gone with the pool
+	mem_scratcharena = NULL;
+	arenaChain.prev = arenaChain.next = &arenaChain;
+	Mem_FreePool( &arenaMemPool );
+
 	for( pool = poolChain; pool; pool = next ) {
 		// do it here, because pool is to be freed
 		// and the chain will be broken
@@ -731,7 +1539,8 @@ void Memory_Shutdown( void ) {
 		Mem_FreePool( &pool );
 	}
 
-	QMutex_Destroy( &memMutex );
+	Mem_FlushThreadCache();
+	Mem_FreeSlabs();
 
 	memory_initialized = false;
 }
@@ -746,4 +1555,5 @@ void Memory_ShutdownCommands( void ) {
 
 	Cmd_RemoveCommand( "memlist" );
 	Cmd_RemoveCommand( "memstats" );
+	Cmd_RemoveCommand( "memstress" );
 }
@@ -0,0 +1,298 @@
+/*
+Copyright (C) 2017 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "qcommon.h"
+#include "nameindex.h"
+
+#define NAMEINDEX_MIN_SIZE      64
+
+typedef struct {
+	unsigned hash;
+	void *volatile value;
+} nameindexslot_t;
+
+typedef struct nameindextable_s {
+	unsigned size;                  // power of two
+	unsigned used;                  // slots ever filled, including removed ones
+	struct nameindextable_s *next;  // next on the retired list
+	nameindexslot_t slots[1];
+} nameindextable_t;
+
+struct nameindex_s {
+	nameindextable_t *volatile table;
+	nameindextable_t *retired;      // replaced since the last reclaim, readers may still probe them
+	nameindextable_t *retiring;     // replaced before the last reclaim, freed by the next one
+	unsigned count;
+	bool casesensitive;
+	nameindex_keyfunc_t keyfunc;
+};
+
+// marks removed slots, so probing continues past them
+static char nameindex_removed;
+#define NAMEINDEX_REMOVED   ( (void *)&nameindex_removed )
+
+/*
+* NameIndex_Hash
+*
+* FNV-1a, folding the case if the index is case insensitive.
+*/
+static unsigned NameIndex_Hash( const nameindex_t *index, const char *name ) {
+	unsigned hash = 2166136261u;
+	const uint8_t *s = ( const uint8_t * )name;
+
+	if( index->casesensitive ) {
+		for( ; *s; s++ ) {
+			hash = ( hash ^ *s ) * 16777619u;
+		}
+	} else {
+		for( ; *s; s++ ) {
+			hash = ( hash ^ tolower( *s ) ) * 16777619u;
+		}
+	}
+
+	return hash ? hash : 1;
+}
+
+/*
+* NameIndex_Compare
+*/
+static int NameIndex_Compare( const nameindex_t *index, const char *a, const char *b ) {
+	return index->casesensitive ? strcmp( a, b ) : Q_stricmp( a, b );
+}
+
+/*
+* NameIndex_AllocTable
+*/
+static nameindextable_t *NameIndex_AllocTable( unsigned size ) {
+	nameindextable_t *table;
+
+	table = ( nameindextable_t * )Q_malloc( sizeof( *table ) + sizeof( nameindexslot_t ) * ( size - 1 ) );
+	memset( table, 0, sizeof( *table ) + sizeof( nameindexslot_t ) * ( size - 1 ) );
+	table->size = size;
+	return table;
+}
+
+/*
+* NameIndex_FreeTables
+*/
+static void NameIndex_FreeTables( nameindextable_t *table ) {
+	nameindextable_t *next;
+
+	for( ; table; table = next ) {
+		next = table->next;
+		Q_free( table );
+	}
+}
+
+/*
+* NameIndex_Load
+*
+* Pairs with NameIndex_Store, so readers see the hash and the object
+* as they were when the value was published.
+*/
+static void *NameIndex_Load( const nameindexslot_t *slot ) {
+	return QAtomic_LoadPtr( ( void *volatile * )&slot->value );
+}
+
+/*
+* NameIndex_Store
+*
+* Publishes the value after its hash, so concurrent readers never see it with a stale hash.
+*/
+static void NameIndex_Store( nameindexslot_t *slot, unsigned hash, void *value ) {
+	slot->hash = hash;
+	QAtomic_StorePtr( &slot->value, value );
+}
+
+/*
+* NameIndex_Grow
+*
+* Rehashes into a table large enough for twice the live entries, dropping removed slots.
+* The old table stays valid for concurrent readers until NameIndex_Reclaim frees it.
+*/
+static void NameIndex_Grow( nameindex_t *index ) {
+	unsigned i, j, size, mask;
+	nameindextable_t *table, *old = index->table;
+
+	for( size = NAMEINDEX_MIN_SIZE; size < ( index->count + 1 ) * 4; size <<= 1 ) ;
+
+	table = NameIndex_AllocTable( size );
+	mask = size - 1;
+
+	for( i = 0; i < old->size; i++ ) {
+		nameindexslot_t *slot = &old->slots[i];
+		if( !slot->value || slot->value == NAMEINDEX_REMOVED ) {
+			continue;
+		}
+
+		for( j = slot->hash & mask; table->slots[j].value; j = ( j + 1 ) & mask ) ;
+		table->slots[j] = *slot;
+		table->used++;
+	}
+
+	QAtomic_StorePtr( ( void *volatile * )&index->table, table );
+	old->next = index->retired;
+	index->retired = old;
+}
+
+/*
+* NameIndex_Create
+*/
+nameindex_t *NameIndex_Create( bool casesensitive, nameindex_keyfunc_t keyfunc ) {
+	nameindex_t *index;
+
+	index = ( nameindex_t * )Q_malloc( sizeof( *index ) );
+	memset( index, 0, sizeof( *index ) );
+	index->casesensitive = casesensitive;
+	index->keyfunc = keyfunc;
+	index->table = NameIndex_AllocTable( NAMEINDEX_MIN_SIZE );
+	return index;
+}
+
+/*
+* NameIndex_Destroy
+*/
+void NameIndex_Destroy( nameindex_t **pindex ) {
+	nameindex_t *index = *pindex;
+
+	if( !index ) {
+		return;
+	}
+
+	NameIndex_FreeTables( index->table );
+	NameIndex_FreeTables( index->retired );
+	NameIndex_FreeTables( index->retiring );
+	Q_free( index );
+
+	*pindex = NULL;
+}
+
+/*
+* NameIndex_Reclaim
+*
+* Frees the tables replaced before the previous call. Call it from the writer once per frame,
+* a reader still probing a table retired a whole frame ago is not a concern.
+*/
+void NameIndex_Reclaim( nameindex_t *index ) {
+	NameIndex_FreeTables( index->retiring );
+	index->retiring = index->retired;
+	index->retired = NULL;
+}
+
+/*
+* NameIndex_Find
+*/
+void *NameIndex_Find( const nameindex_t *index, const char *name ) {
+	unsigned i, hash, mask;
+	void *value;
+	const nameindextable_t *table;
+
+	table = ( const nameindextable_t * )QAtomic_LoadPtr( ( void *volatile * )&index->table );
+	hash = NameIndex_Hash( index, name );
+	mask = table->size - 1;
+
+	for( i = hash & mask; ( value = NameIndex_Load( &table->slots[i] ) ) != NULL; i = ( i + 1 ) & mask ) {
+		if( value != NAMEINDEX_REMOVED && table->slots[i].hash == hash
+			&& !NameIndex_Compare( index, index->keyfunc( value ), name ) ) {
+			return value;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* NameIndex_Insert
+*
+* The name must not be in the index yet.
+*/
+void NameIndex_Insert( nameindex_t *index, void *value ) {
+	unsigned i, hash, mask;
+	nameindextable_t *table;
+	nameindexslot_t *slot;
+
+	// keep at least half of the slots empty so probe sequences stay short
+	if( ( index->table->used + 1 ) * 2 > index->table->size ) {
+		NameIndex_Grow( index );
+	}
+
+	table = index->table;
+	hash = NameIndex_Hash( index, index->keyfunc( value ) );
+	mask = table->size - 1;
+
+	for( i = hash & mask; ; i = ( i + 1 ) & mask ) {
+		slot = &table->slots[i];
+		if( !slot->value ) {
+			table->used++;
+			break;
+		}
+		if( slot->value == NAMEINDEX_REMOVED ) {
+			break;
+		}
+	}
+
+	NameIndex_Store( slot, hash, value );
+	index->count++;
+}
+
+/*
+* NameIndex_Remove
+*/
+void *NameIndex_Remove( nameindex_t *index, const char *name ) {
+	unsigned i, hash, mask;
+	void *value;
+	nameindextable_t *table = index->table;
+
+	hash = NameIndex_Hash( index, name );
+	mask = table->size - 1;
+
+	for( i = hash & mask; ( value = table->slots[i].value ) != NULL; i = ( i + 1 ) & mask ) {
+		if( value != NAMEINDEX_REMOVED && table->slots[i].hash == hash
+			&& !NameIndex_Compare( index, index->keyfunc( value ), name ) ) {
+			QAtomic_StorePtr( &table->slots[i].value, NAMEINDEX_REMOVED );
+			index->count--;
+			return value;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* NameIndex_Clear
+*/
+void NameIndex_Clear( nameindex_t *index ) {
+	unsigned i;
+	nameindextable_t *table = index->table;
+
+	for( i = 0; i < table->size; i++ ) {
+		if( table->slots[i].value ) {
+			QAtomic_StorePtr( &table->slots[i].value, NAMEINDEX_REMOVED );
+		}
+	}
+	index->count = 0;
+}
+
+/*
+* NameIndex_Count
+*/
+unsigned NameIndex_Count( const nameindex_t *index ) {
+	return index->count;
+}
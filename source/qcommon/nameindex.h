@@ -0,0 +1,47 @@
+/*
+Copyright (C) 2017 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifndef Q_NAMEINDEX_H
+#define Q_NAMEINDEX_H
+
+// open-addressing hash index of named objects, the name is read
+// from the object itself through the key function
+//
+// lookups take no locks and may run concurrently with a single writer,
+// inserts and removals must be serialized by the caller. an object must
+// not be freed after removal while other threads may still be looking it up.
+// tables outgrown by inserts are freed by NameIndex_Reclaim, which the writer
+// calls at the frame boundary.
+
+struct nameindex_s;
+typedef struct nameindex_s nameindex_t;
+
+typedef const char *( *nameindex_keyfunc_t )( const void *value );
+
+nameindex_t *NameIndex_Create( bool casesensitive, nameindex_keyfunc_t keyfunc );
+void NameIndex_Destroy( nameindex_t **pindex );
+void NameIndex_Reclaim( nameindex_t *index );
+void *NameIndex_Find( const nameindex_t *index, const char *name );
+void NameIndex_Insert( nameindex_t *index, void *value );
+void *NameIndex_Remove( nameindex_t *index, const char *name );
+void NameIndex_Clear( nameindex_t *index );
+unsigned NameIndex_Count( const nameindex_t *index );
+
+#endif // Q_NAMEINDEX_H
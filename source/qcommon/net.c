@@ -33,6 +33,11 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#ifdef __linux__
+#include <errno.h>
+#include <sys/epoll.h>
+#define NET_USE_EPOLL
+#endif
 #endif
 
 #define MAX_LOOPBACK    4
@@ -618,7 +623,7 @@ static int NET_TCP_Send( const socket_t *socket, const void *data, size_t length
 static bool NET_TCP_Listen( const socket_t *socket ) {
 	assert( socket && socket->open && socket->type == SOCKET_TCP && socket->handle );
 
-	if( listen( socket->handle, 8 ) == -1 ) {
+	if( listen( socket->handle, SOMAXCONN ) == -1 ) {
 		NET_SetErrorStringFromLastError( "listen" );
 		return false;
 	}
@@ -1825,6 +1830,278 @@ int NET_Monitor( int msec, socket_t *sockets[], void ( *read_cb )( socket_t *, v
 	return ret;
 }
 
+/*
+=============================================================================
+SOCKET POLLING
+
+Unlike NET_Monitor, a poll set is persistent and only reports the events
+each socket is interested in. Uses epoll where available.
+=============================================================================
+*/
+
+#define NET_POLL_MAX_EVENTS 64
+
+typedef struct {
+	const socket_t *socket;         // NULL if removed
+	int events;
+	void *privatep;
+} net_pollentry_t;
+
+struct net_poll_s {
+#ifdef NET_USE_EPOLL
+	int epfd;
+#else
+	int numentries, maxentries;
+	net_pollentry_t *entries;
+#endif
+};
+
+#ifdef NET_USE_EPOLL
+/*
+* NET_EpollEvents
+*/
+static uint32_t NET_EpollEvents( int events ) {
+	return ( events & NET_POLL_READ ? EPOLLIN : 0 ) | ( events & NET_POLL_WRITE ? EPOLLOUT : 0 );
+}
+#else
+/*
+* NET_FindPollEntry
+*/
+static net_pollentry_t *NET_FindPollEntry( net_poll_t *poll, const socket_t *socket ) {
+	int i;
+
+	for( i = 0; i < poll->numentries; i++ ) {
+		if( poll->entries[i].socket == socket ) {
+			return &poll->entries[i];
+		}
+	}
+	return NULL;
+}
+#endif
+
+/*
+* NET_CreatePoll
+*/
+net_poll_t *NET_CreatePoll( void ) {
+	net_poll_t *poll;
+
+	poll = ( net_poll_t * )Mem_ZoneMalloc( sizeof( *poll ) );
+#ifdef NET_USE_EPOLL
+	poll->epfd = epoll_create( NET_POLL_MAX_EVENTS );
+	if( poll->epfd < 0 ) {
+		NET_SetErrorStringFromLastError( "epoll_create" );
+		Mem_ZoneFree( poll );
+		return NULL;
+	}
+#endif
+	return poll;
+}
+
+/*
+* NET_DestroyPoll
+*/
+void NET_DestroyPoll( net_poll_t **ppoll ) {
+	net_poll_t *poll = *ppoll;
+
+	if( !poll ) {
+		return;
+	}
+
+#ifdef NET_USE_EPOLL
+	close( poll->epfd );
+#else
+	if( poll->entries ) {
+		Mem_ZoneFree( poll->entries );
+	}
+#endif
+	Mem_ZoneFree( poll );
+	*ppoll = NULL;
+}
+
+/*
+* NET_PollAdd
+*
+* The privatep pointer is passed to the callback of NET_Poll and must stay valid until
+* the socket is removed from the set.
+*/
+bool NET_PollAdd( net_poll_t *poll, const socket_t *socket, int events, void *privatep ) {
+#ifdef NET_USE_EPOLL
+	struct epoll_event ev;
+
+	ev.events = NET_EpollEvents( events );
+	ev.data.ptr = privatep;
+	if( epoll_ctl( poll->epfd, EPOLL_CTL_ADD, socket->handle, &ev ) < 0 ) {
+		NET_SetErrorStringFromLastError( "epoll_ctl" );
+		return false;
+	}
+#else
+	net_pollentry_t *entry;
+
+	entry = NET_FindPollEntry( poll, NULL );
+	if( !entry ) {
+		if( poll->numentries == poll->maxentries ) {
+			net_pollentry_t *entries;
+
+			entries = ( net_pollentry_t * )Mem_ZoneMalloc( ( poll->maxentries + NET_POLL_MAX_EVENTS ) * sizeof( *entries ) );
+			if( poll->entries ) {
+				memcpy( entries, poll->entries, poll->numentries * sizeof( *entries ) );
+				Mem_ZoneFree( poll->entries );
+			}
+			poll->entries = entries;
+			poll->maxentries += NET_POLL_MAX_EVENTS;
+		}
+		entry = &poll->entries[poll->numentries++];
+	}
+
+	entry->socket = socket;
+	entry->events = events;
+	entry->privatep = privatep;
+#endif
+	return true;
+}
+
+/*
+* NET_PollModify
+*/
+bool NET_PollModify( net_poll_t *poll, const socket_t *socket, int events, void *privatep ) {
+#ifdef NET_USE_EPOLL
+	struct epoll_event ev;
+
+	ev.events = NET_EpollEvents( events );
+	ev.data.ptr = privatep;
+	if( epoll_ctl( poll->epfd, EPOLL_CTL_MOD, socket->handle, &ev ) < 0 ) {
+		NET_SetErrorStringFromLastError( "epoll_ctl" );
+		return false;
+	}
+#else
+	net_pollentry_t *entry;
+
+	entry = NET_FindPollEntry( poll, socket );
+	if( !entry ) {
+		NET_SetErrorString( "Socket is not in the poll set" );
+		return false;
+	}
+
+	entry->events = events;
+	entry->privatep = privatep;
+#endif
+	return true;
+}
+
+/*
+* NET_PollRemove
+*
+* Must be called before the socket is closed.
+*/
+void NET_PollRemove( net_poll_t *poll, const socket_t *socket ) {
+#ifdef NET_USE_EPOLL
+	struct epoll_event ev = { 0 };
+
+	epoll_ctl( poll->epfd, EPOLL_CTL_DEL, socket->handle, &ev );
+#else
+	net_pollentry_t *entry;
+
+	// the slot is reused by NET_PollAdd, so NET_Poll can safely walk the array
+	// while callbacks remove sockets
+	entry = NET_FindPollEntry( poll, socket );
+	if( entry ) {
+		entry->socket = NULL;
+		entry->events = 0;
+	}
+#endif
+}
+
+/*
+* NET_Poll
+*
+* Waits up to msec milliseconds for any of the sockets in the set to become ready and calls
+* cb( events, privatep ) for each of them. Errors and hangups are reported as NET_POLL_ERROR
+* along with both NET_POLL_READ and NET_POLL_WRITE, even for sockets which aren't waiting for
+* any event. Returns the number of ready sockets or -1 on error.
+*/
+int NET_Poll( net_poll_t *poll, int msec, void ( *cb )( int events, void *privatep ) ) {
+#ifdef NET_USE_EPOLL
+	int i, ret, events;
+	struct epoll_event ev[NET_POLL_MAX_EVENTS];
+
+	ret = epoll_wait( poll->epfd, ev, NET_POLL_MAX_EVENTS, msec );
+	if( ret < 0 ) {
+		if( errno == EINTR ) {
+			return 0;
+		}
+		NET_SetErrorStringFromLastError( "epoll_wait" );
+		return -1;
+	}
+
+	for( i = 0; i < ret; i++ ) {
+		events = 0;
+		if( ev[i].events & ( EPOLLIN | EPOLLERR | EPOLLHUP ) ) {
+			events |= NET_POLL_READ;
+		}
+		if( ev[i].events & ( EPOLLOUT | EPOLLERR | EPOLLHUP ) ) {
+			events |= NET_POLL_WRITE;
+		}
+		if( ev[i].events & ( EPOLLERR | EPOLLHUP ) ) {
+			events |= NET_POLL_ERROR;
+		}
+		cb( events, ev[i].data.ptr );
+	}
+
+	return ret;
+#else
+	struct timeval timeout;
+	fd_set fdsetr, fdsetw;
+	int i, ret, events, numentries;
+	int fdmax = 0;
+	net_pollentry_t *entry;
+
+	FD_ZERO( &fdsetr );
+	FD_ZERO( &fdsetw );
+
+	numentries = poll->numentries;
+	for( i = 0, entry = poll->entries; i < numentries; i++, entry++ ) {
+		if( !entry->socket || !entry->events ) {
+			continue;
+		}
+		fdmax = max( (int)entry->socket->handle, fdmax );
+		if( entry->events & NET_POLL_READ ) {
+			FD_SET( entry->socket->handle, &fdsetr );
+		}
+		if( entry->events & NET_POLL_WRITE ) {
+			FD_SET( entry->socket->handle, &fdsetw );
+		}
+	}
+
+	timeout.tv_sec = msec / 1000;
+	timeout.tv_usec = ( msec % 1000 ) * 1000;
+	ret = select( fdmax + 1, &fdsetr, &fdsetw, NULL, &timeout );
+	if( ret == SOCKET_ERROR ) {
+		NET_SetErrorStringFromLastError( "select" );
+		return -1;
+	}
+
+	for( i = 0; i < numentries && ret > 0; i++ ) {
+		entry = &poll->entries[i];
+		if( !entry->socket ) {
+			continue;
+		}
+
+		events = 0;
+		if( FD_ISSET( entry->socket->handle, &fdsetr ) ) {
+			events |= NET_POLL_READ;
+		}
+		if( FD_ISSET( entry->socket->handle, &fdsetw ) ) {
+			events |= NET_POLL_WRITE;
+		}
+		if( events ) {
+			cb( events, entry->privatep );
+		}
+	}
+
+	return ret;
+#endif
+}
+
 /*
 * NET_SendFile
 */
@@ -0,0 +1,537 @@
+/*
+Copyright (C) 2017 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "qcommon.h"
+#include "../qalgo/hash.h"
+
+/*
+=============================================================================
+
+PROFILER
+
+Code marks zones with Prof_Enter and Prof_Leave. While a capture is running,
+each thread appends timestamped enter and leave events to a ring buffer of its
+own, so recording takes no locks. When the capture ends the rings are paired
+up into complete events and written out in the Chrome trace event format,
+which chrome://tracing and Perfetto can open.
+
+Zone names usually are string literals of modules that may be unloaded before
+the capture is written, so each distinct name is copied into a table owned by
+the profiler. Threads keep a small cache of the copies, so the table is only
+locked the first time a thread sees a name.
+
+=============================================================================
+*/
+
+#define PROF_MAX_THREADS        64
+#define PROF_EVENTS             ( 1 << 17 )     // per thread, must be a power of two
+#define PROF_MAX_DEPTH          64
+#define PROF_MAX_SECONDS        60
+#define PROF_NAME_CACHE         256             // per thread, must be a power of two
+#define PROF_NAME_HASH          1024
+
+#define PROF_FRAME_MARKER       ( (const char *)1 )
+
+typedef struct {
+	uint64_t time;
+	const char *name;           // NULL when leaving a zone
+} prof_event_t;
+
+typedef struct prof_name_s {
+	struct prof_name_s *next;
+	char name[1];
+} prof_name_t;
+
+typedef struct {
+	const char *key;            // the pointer passed by the caller, only compared
+	const char *name;           // the copy in the profiler table
+} prof_namecache_t;
+
+typedef struct {
+	int id;
+	char name[32];
+	prof_namecache_t names[PROF_NAME_CACHE];
+	volatile int owned;         // cleared once the thread exits, the buffer may then be reused
+	unsigned head;              // events recorded during the capture, only written by the owner
+	prof_event_t *events;
+} prof_thread_t;
+
+typedef struct {
+	int file;
+	size_t len;
+	size_t numEvents;
+	char buf[0x10000];
+} prof_writer_t;
+
+static volatile int prof_capturing;
+static bool prof_flushPending;
+static uint64_t prof_captureStart, prof_captureEnd;
+static char prof_captureName[MAX_QPATH];
+
+static qmutex_t *prof_mutex;
+static prof_thread_t *prof_threads[PROF_MAX_THREADS];
+static volatile int prof_numThreads;
+static prof_name_t *prof_names[PROF_NAME_HASH];
+
+static ATTRIBUTE_TLS prof_thread_t *prof_thread;
+static ATTRIBUTE_TLS bool prof_threadNoSlot;
+static ATTRIBUTE_TLS char prof_threadName[32];
+
+/*
+* Prof_AcquireThread
+*/
+static prof_thread_t *Prof_AcquireThread( void ) {
+	int i;
+	prof_thread_t *thread = NULL;
+
+	if( prof_threadNoSlot ) {
+		return NULL;
+	}
+
+	QMutex_Lock( prof_mutex );
+
+	// reuse a buffer left behind by an exited thread, unless it holds events of this capture
+	for( i = 0; i < prof_numThreads; i++ ) {
+		if( !prof_threads[i]->owned && !prof_threads[i]->head ) {
+			thread = prof_threads[i];
+			break;
+		}
+	}
+
+	if( !thread && prof_numThreads < PROF_MAX_THREADS ) {
+		thread = ( prof_thread_t * )Q_malloc( sizeof( *thread ) );
+		memset( thread, 0, sizeof( *thread ) );
+		thread->id = prof_numThreads + 1;
+		thread->events = ( prof_event_t * )Q_malloc( PROF_EVENTS * sizeof( prof_event_t ) );
+		prof_threads[prof_numThreads] = thread;
+		QAtomic_Add( &prof_numThreads, 1 );
+	}
+
+	if( thread ) {
+		thread->owned = 1;
+		if( prof_threadName[0] ) {
+			Q_strncpyz( thread->name, prof_threadName, sizeof( thread->name ) );
+		} else {
+			Q_snprintfz( thread->name, sizeof( thread->name ), "thread %i", thread->id );
+		}
+	} else {
+		prof_threadNoSlot = true;
+	}
+
+	QMutex_Unlock( prof_mutex );
+
+	prof_thread = thread;
+	return thread;
+}
+
+/*
+* Prof_InternName
+*
+* Returns the profiler-owned copy of the zone name, adding it to the table if needed.
+*/
+static const char *Prof_InternName( prof_thread_t *thread, const char *name ) {
+	unsigned hash;
+	prof_name_t *n;
+	prof_namecache_t *cache;
+
+	// a module reloaded at the same address may put a different string there, hence the compare
+	cache = &thread->names[( (uintptr_t)name >> 3 ) & ( PROF_NAME_CACHE - 1 )];
+	if( cache->key == name && !strcmp( cache->name, name ) ) {
+		return cache->name;
+	}
+
+	hash = COM_SuperFastHash( ( const uint8_t * )name, strlen( name ) ) & ( PROF_NAME_HASH - 1 );
+
+	QMutex_Lock( prof_mutex );
+
+	for( n = prof_names[hash]; n; n = n->next ) {
+		if( !strcmp( n->name, name ) ) {
+			break;
+		}
+	}
+	if( !n ) {
+		size_t len = strlen( name );
+
+		n = ( prof_name_t * )Q_malloc( sizeof( *n ) + len );
+		memcpy( n->name, name, len + 1 );
+		n->next = prof_names[hash];
+		prof_names[hash] = n;
+	}
+
+	QMutex_Unlock( prof_mutex );
+
+	cache->key = name;
+	cache->name = n->name;
+	return n->name;
+}
+
+/*
+* Prof_Record
+*/
+static inline void Prof_Record( const char *name ) {
+	prof_event_t *event;
+	prof_thread_t *thread = prof_thread;
+
+	if( !thread ) {
+		thread = Prof_AcquireThread();
+		if( !thread ) {
+			return;
+		}
+	}
+
+	if( name && name != PROF_FRAME_MARKER ) {
+		name = Prof_InternName( thread, name );
+	}
+
+	event = &thread->events[thread->head & ( PROF_EVENTS - 1 )];
+	event->time = Sys_Nanoseconds();
+	event->name = name;
+	thread->head++;
+}
+
+/*
+* Prof_Enter
+*/
+void Prof_Enter( const char *name ) {
+	if( !prof_capturing ) {
+		return;
+	}
+	Prof_Record( name );
+}
+
+/*
+* Prof_Leave
+*/
+void Prof_Leave( void ) {
+	if( !prof_capturing ) {
+		return;
+	}
+	Prof_Record( NULL );
+}
+
+/*
+* Prof_ThreadName
+*
+* Names the calling thread in captures.
+*/
+void Prof_ThreadName( const char *name ) {
+	Q_strncpyz( prof_threadName, name, sizeof( prof_threadName ) );
+	if( prof_thread ) {
+		Q_strncpyz( prof_thread->name, name, sizeof( prof_thread->name ) );
+	}
+}
+
+/*
+* Prof_ThreadExit
+*
+* Hands the buffer of the exiting thread over to threads created later.
+*/
+void Prof_ThreadExit( void ) {
+	if( prof_thread ) {
+		prof_thread->owned = 0;
+		prof_thread = NULL;
+	}
+	prof_threadName[0] = '\0';
+}
+
+/*
+* Prof_Write
+*/
+static void Prof_Write( prof_writer_t *writer, const char *format, ... ) {
+	int len;
+	va_list argptr;
+	char msg[1024];
+
+	va_start( argptr, format );
+	len = Q_vsnprintfz( msg, sizeof( msg ), format, argptr );
+	va_end( argptr );
+
+	if( len < 0 ) {
+		return;
+	}
+	len = min( len, (int)sizeof( msg ) - 1 );
+
+	if( writer->len + len > sizeof( writer->buf ) ) {
+		FS_Write( writer->buf, writer->len, writer->file );
+		writer->len = 0;
+	}
+	memcpy( writer->buf + writer->len, msg, len );
+	writer->len += len;
+}
+
+/*
+* Prof_WriteEvent
+*/
+static void Prof_WriteEvent( prof_writer_t *writer, int tid, const char *name, uint64_t start, uint64_t end ) {
+	Prof_Write( writer, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+				writer->numEvents ? "," : "", name, tid,
+				( start - prof_captureStart ) / 1000.0, ( end - start ) / 1000.0 );
+	writer->numEvents++;
+}
+
+/*
+* Prof_WriteThread
+*
+* Pairs up the enter and leave events of a thread. Zones entered before the ring
+* wrapped around are dropped and zones still open at the end are cut off.
+*/
+static unsigned Prof_WriteThread( prof_writer_t *writer, const prof_thread_t *thread ) {
+	unsigned i, first, depth;
+	const char *names[PROF_MAX_DEPTH];
+	uint64_t times[PROF_MAX_DEPTH];
+	uint64_t time;
+
+	if( !thread->head ) {
+		return 0;
+	}
+
+	Prof_Write( writer, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+				writer->numEvents ? "," : "", thread->id, thread->name );
+	writer->numEvents++;
+
+	first = thread->head > PROF_EVENTS ? thread->head - PROF_EVENTS : 0;
+
+	depth = 0;
+	time = prof_captureEnd;
+	for( i = first; i != thread->head; i++ ) {
+		const prof_event_t *event = &thread->events[i & ( PROF_EVENTS - 1 )];
+
+		time = event->time;
+		if( event->name == PROF_FRAME_MARKER ) {
+			// a new frame, close whatever an ERR_DROP left open
+			for( ; depth > 0; depth-- ) {
+				if( depth <= PROF_MAX_DEPTH ) {
+					Prof_WriteEvent( writer, thread->id, names[depth - 1], times[depth - 1], time );
+				}
+			}
+		} else if( event->name ) {
+			if( depth < PROF_MAX_DEPTH ) {
+				names[depth] = event->name;
+				times[depth] = event->time;
+			}
+			depth++;
+		} else if( depth ) {
+			depth--;
+			if( depth < PROF_MAX_DEPTH ) {
+				Prof_WriteEvent( writer, thread->id, names[depth], times[depth], time );
+			}
+		}
+	}
+
+	for( ; depth > 0; depth-- ) {
+		if( depth <= PROF_MAX_DEPTH ) {
+			Prof_WriteEvent( writer, thread->id, names[depth - 1], times[depth - 1], max( time, prof_captureEnd ) );
+		}
+	}
+
+	return first;
+}
+
+/*
+* Prof_WriteCapture
+*/
+static void Prof_WriteCapture( void ) {
+	int i;
+	unsigned dropped;
+	prof_writer_t *writer;
+
+	writer = ( prof_writer_t * )Q_malloc( sizeof( *writer ) );
+	writer->len = 0;
+	writer->numEvents = 0;
+
+	if( FS_FOpenFile( prof_captureName, &writer->file, FS_WRITE ) == -1 ) {
+		Com_Printf( "Prof_WriteCapture: couldn't open %s for writing\n", prof_captureName );
+		Q_free( writer );
+		return;
+	}
+
+	Prof_Write( writer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+
+	dropped = 0;
+	for( i = 0; i < prof_numThreads; i++ ) {
+		dropped += Prof_WriteThread( writer, prof_threads[i] );
+	}
+
+	Prof_Write( writer, "\n]}\n" );
+	FS_Write( writer->buf, writer->len, writer->file );
+	FS_FCloseFile( writer->file );
+
+	Com_Printf( "Wrote %" PRIuPTR " zones to %s\n", (uintptr_t)writer->numEvents, prof_captureName );
+	if( dropped ) {
+		Com_Printf( "%u events were dropped, the capture is too long for the buffers\n", dropped );
+	}
+
+	Q_free( writer );
+}
+
+/*
+* Prof_StopCapture
+*/
+static void Prof_StopCapture( void ) {
+	if( !prof_capturing ) {
+		return;
+	}
+
+	prof_captureEnd = Sys_Nanoseconds();
+	prof_capturing = 0;
+
+	// give threads in the middle of recording an event a frame to finish
+	prof_flushPending = true;
+}
+
+/*
+* Prof_Frame
+*
+* Called at the start of each frame on the main thread.
+*/
+void Prof_Frame( void ) {
+	int i;
+
+	if( prof_flushPending ) {
+		prof_flushPending = false;
+		Prof_WriteCapture();
+
+		for( i = 0; i < prof_numThreads; i++ ) {
+			prof_threads[i]->head = 0;
+		}
+		return;
+	}
+
+	if( !prof_capturing ) {
+		return;
+	}
+
+	if( Sys_Nanoseconds() >= prof_captureEnd ) {
+		Prof_StopCapture();
+		return;
+	}
+
+	Prof_Record( PROF_FRAME_MARKER );
+}
+
+/*
+* Prof_Capture_f
+*/
+static void Prof_Capture_f( void ) {
+	float seconds;
+
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <seconds> [filename]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	if( prof_capturing || prof_flushPending ) {
+		Com_Printf( "A capture is already in progress\n" );
+		return;
+	}
+
+	seconds = atof( Cmd_Argv( 1 ) );
+	if( seconds <= 0 ) {
+		Com_Printf( "Invalid capture length\n" );
+		return;
+	}
+	seconds = min( seconds, PROF_MAX_SECONDS );
+
+	if( Cmd_Argc() > 2 ) {
+		Q_snprintfz( prof_captureName, sizeof( prof_captureName ), "profiles/%s", Cmd_Argv( 2 ) );
+	} else {
+		time_t long_time;
+		struct tm *newtime;
+
+		time( &long_time );
+		newtime = localtime( &long_time );
+		Q_snprintfz( prof_captureName, sizeof( prof_captureName ), "profiles/%04d%02d%02d-%02d%02d%02d",
+					 newtime->tm_year + 1900, newtime->tm_mon + 1, newtime->tm_mday,
+					 newtime->tm_hour, newtime->tm_min, newtime->tm_sec );
+	}
+	COM_SanitizeFilePath( prof_captureName );
+	COM_DefaultExtension( prof_captureName, ".json", sizeof( prof_captureName ) );
+
+	if( !COM_ValidateRelativeFilename( prof_captureName ) ) {
+		Com_Printf( "Invalid filename\n" );
+		return;
+	}
+
+	Com_Printf( "Capturing %.1f seconds to %s\n", seconds, prof_captureName );
+
+	prof_captureStart = Sys_Nanoseconds();
+	prof_captureEnd = prof_captureStart + (uint64_t)( seconds * 1000000000.0 );
+
+	// the buffers were reset after the last capture was written, so just let the threads in
+	QAtomic_CAS( &prof_capturing, 0, 1 );
+}
+
+/*
+* Prof_Stop_f
+*/
+static void Prof_Stop_f( void ) {
+	if( !prof_capturing ) {
+		Com_Printf( "No capture in progress\n" );
+		return;
+	}
+	Prof_StopCapture();
+}
+
+/*
+* Prof_Init
+*/
+void Prof_Init( void ) {
+	prof_mutex = QMutex_Create();
+
+	Cmd_AddCommand( "prof_capture", Prof_Capture_f );
+	Cmd_AddCommand( "prof_stop", Prof_Stop_f );
+}
+
+/*
+* Prof_Shutdown
+*/
+void Prof_Shutdown( void ) {
+	int i;
+
+	if( !prof_mutex ) {
+		return;
+	}
+
+	Cmd_RemoveCommand( "prof_capture" );
+	Cmd_RemoveCommand( "prof_stop" );
+
+	prof_capturing = 0;
+	prof_flushPending = false;
+	prof_thread = NULL;
+
+	for( i = 0; i < prof_numThreads; i++ ) {
+		Q_free( prof_threads[i]->events );
+		Q_free( prof_threads[i] );
+		prof_threads[i] = NULL;
+	}
+	prof_numThreads = 0;
+
+	for( i = 0; i < PROF_NAME_HASH; i++ ) {
+		prof_name_t *n, *next;
+
+		for( n = prof_names[i]; n; n = next ) {
+			next = n->next;
+			Q_free( n );
+		}
+		prof_names[i] = NULL;
+	}
+
+	QMutex_Destroy( &prof_mutex );
+}
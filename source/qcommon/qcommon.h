@@ -349,6 +349,7 @@ typedef char ** ( *xcompletionf_t )( const char *partial );
 void        Cmd_PreInit( void );
 void        Cmd_Init( void );
 void        Cmd_Shutdown( void );
+void        Cmd_Frame( void );
 void        Cmd_AddCommand( const char *cmd_name, xcommand_t function );
 void        Cmd_RemoveCommand( const char *cmd_name );
 bool    Cmd_Exists( const char *cmd_name );
@@ -486,6 +487,20 @@ int         NET_Monitor( int msec, socket_t *sockets[],
 						 void ( *read_cb )( socket_t *socket, void* ),
 						 void ( *write_cb )( socket_t *socket, void* ),
 						 void ( *exception_cb )( socket_t *socket, void* ), void *privatep[] );
+
+#define NET_POLL_READ   1
+#define NET_POLL_WRITE  2
+#define NET_POLL_ERROR  4
+
+typedef struct net_poll_s net_poll_t;
+
+net_poll_t *NET_CreatePoll( void );
+void        NET_DestroyPoll( net_poll_t **ppoll );
+bool        NET_PollAdd( net_poll_t *poll, const socket_t *socket, int events, void *privatep );
+bool        NET_PollModify( net_poll_t *poll, const socket_t *socket, int events, void *privatep );
+void        NET_PollRemove( net_poll_t *poll, const socket_t *socket );
+int         NET_Poll( net_poll_t *poll, int msec, void ( *cb )( int events, void *privatep ) );
+
 const char *NET_ErrorString( void );
 
 #ifndef _MSC_VER
@@ -633,6 +648,7 @@ int     FS_LoadFileExt( const char *path, int flags, void **buffer, void *stack,
 int     FS_LoadBaseFileExt( const char *path, int flags, void **buffer, void *stack, size_t stackSize, const char *filename, int fileline );
 void    FS_FreeFile( void *buffer );
 void    FS_FreeBaseFile( void *buffer );
+void    FS_PrefetchFiles( const char **filenames, int numFiles );
 #define FS_LoadFile( path,buffer,stack,stacksize ) FS_LoadFileExt( path,0,buffer,stack,stacksize,__FILE__,__LINE__ )
 #define FS_LoadBaseFile( path,buffer,stack,stacksize ) FS_LoadBaseFileExt( path,0,buffer,stack,stacksize,__FILE__,__LINE__ )
 #define FS_LoadCacheFile( path,buffer,stack,stacksize ) FS_LoadFileExt( path,FS_CACHE,buffer,stack,stacksize,__FILE__,__LINE__ )
@@ -780,6 +796,28 @@ void _Mem_CheckSentinels( void *data, const char *filename, int fileline );
 void _Mem_CheckSentinelsGlobal( const char *filename, int fileline );
 
 size_t Mem_PoolTotalSize( mempool_t *pool );
+void Mem_CountAllocs( bool enable );
+unsigned Mem_NumAllocs( void );
+
+void Mem_FlushThreadCache( void );
+
+// linear allocators, memory is released all at once by resetting the arena or freeing to a mark
+typedef struct memarena_s memarena_t;
+
+memarena_t *_Mem_AllocArena( const char *name, size_t blocksize, const char *filename, int fileline );
+void _Mem_FreeArena( memarena_t **arena, const char *filename, int fileline );
+ATTRIBUTE_MALLOC void *_Mem_ArenaAlloc( memarena_t *arena, size_t size, size_t alignment, const char *filename, int fileline );
+size_t Mem_ArenaMark( memarena_t *arena );
+void Mem_ArenaFreeToMark( memarena_t *arena, size_t mark );
+void Mem_ArenaReset( memarena_t *arena );
+
+// per-thread scratch arenas, reset every frame on the main thread
+memarena_t *Mem_ScratchArena( void );
+ATTRIBUTE_MALLOC void *_Mem_ScratchAlloc( size_t size, const char *filename, int fileline );
+size_t Mem_ScratchMark( void );
+void Mem_ScratchFreeToMark( size_t mark );
+void Mem_ScratchReset( void );
+void Mem_FreeThreadArena( void );
 
 #define Mem_AllocExt( pool, size, z ) _Mem_AllocExt( pool, size, 0, z, 0, 0, __FILE__, __LINE__ )
 #define Mem_Alloc( pool, size ) _Mem_Alloc( pool, size, 0, 0, __FILE__, __LINE__ )
@@ -791,6 +829,11 @@ size_t Mem_PoolTotalSize( mempool_t *pool );
 #define Mem_EmptyPool( pool ) _Mem_EmptyPool( pool, 0, 0, __FILE__, __LINE__ )
 #define Mem_CopyString( pool, str ) _Mem_CopyString( pool, str, __FILE__, __LINE__ )
 
+#define Mem_AllocArena( name, blocksize ) _Mem_AllocArena( name, blocksize, __FILE__, __LINE__ )
+#define Mem_FreeArena( arena ) _Mem_FreeArena( arena, __FILE__, __LINE__ )
+#define Mem_ArenaAlloc( arena, size ) _Mem_ArenaAlloc( arena, size, 0, __FILE__, __LINE__ )
+#define Mem_ScratchAlloc( size ) _Mem_ScratchAlloc( size, __FILE__, __LINE__ )
+
 #define Mem_CheckSentinels( data ) _Mem_CheckSentinels( data, __FILE__, __LINE__ )
 #define Mem_CheckSentinelsGlobal() _Mem_CheckSentinelsGlobal( __FILE__, __LINE__ )
 #ifdef NDEBUG
@@ -815,6 +858,24 @@ void *Q_malloc( size_t size );
 void *Q_realloc( void *buf, size_t newsize );
 void Q_free( void *buf );
 
+/*
+==============================================================
+
+PROFILER
+
+==============================================================
+*/
+
+// zone names are copied the first time they are seen, keep the set of names small
+void Prof_Enter( const char *name );
+void Prof_Leave( void );
+void Prof_ThreadName( const char *name );
+void Prof_ThreadExit( void );
+
+void Prof_Init( void );
+void Prof_Shutdown( void );
+void Prof_Frame( void );
+
 void Qcommon_Init( int argc, char **argv );
 void Qcommon_Frame( unsigned int realMsec );
 void Qcommon_Shutdown( void );
@@ -840,6 +901,7 @@ void    Sys_AppActivate( void );
 
 int64_t    Sys_Milliseconds( void );
 uint64_t        Sys_Microseconds( void );
+uint64_t        Sys_Nanoseconds( void );
 void        Sys_Sleep( unsigned int millis );
 
 char    *Sys_ConsoleInput( void );
@@ -44,23 +44,41 @@ qcondvar_t *QCondVar_Create( void );
 void QCondVar_Destroy( qcondvar_t **pcond );
 bool QCondVar_Wait( qcondvar_t *cond, qmutex_t *mutex, unsigned int timeout_msec );
 void QCondVar_Wake( qcondvar_t *cond );
+void QCondVar_WakeAll( qcondvar_t *cond );
 
 qthread_t *QThread_Create( void *( *routine )( void* ), void *param );
 void QThread_Join( qthread_t *thread );
 void QThread_Yield( void );
+int QThread_NumCores( void );
 
 void QThreads_Init( void );
 void QThreads_Shutdown( void );
+void QThreads_InitCommands( void );
+void QThreads_ShutdownCommands( void );
 
 qbufPipe_t *QBufPipe_Create( size_t bufSize, int flags );
 void QBufPipe_Destroy( qbufPipe_t **pqueue );
 void QBufPipe_Finish( qbufPipe_t *queue );
 void QBufPipe_WriteCmd( qbufPipe_t *queue, const void *cmd, unsigned cmd_size );
+void *QBufPipe_AllocCmd( qbufPipe_t *queue, unsigned cmd_size );
+void QBufPipe_CommitCmd( qbufPipe_t *queue, unsigned cmd_size );
 int QBufPipe_ReadCmds( qbufPipe_t *queue, unsigned( **cmdHandlers )( const void * ) );
 void QBufPipe_Wait( qbufPipe_t *queue, int ( *read )( qbufPipe_t *, unsigned( ** )( const void * ), bool ),
 					unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec );
 
 int QAtomic_Add( volatile int *value, int add );
 bool QAtomic_CAS( volatile int *value, int oldval, int newval );
+void *QAtomic_LoadPtr( void *volatile *ptr );
+void QAtomic_StorePtr( void *volatile *ptr, void *value );
+
+typedef void ( *qjobfunc_t )( unsigned first, unsigned items, void *arg );
+
+void QJobs_Init( void );
+void QJobs_InitCommands( void );
+void QJobs_Shutdown( void );
+int QJobs_NumWorkers( void );
+void QJobs_Schedule( qjobfunc_t func, void *arg, unsigned items, unsigned granularity, volatile int *counter );
+bool QJobs_Done( volatile int *counter );
+void QJobs_Wait( volatile int *counter );
 
 #endif // Q_THREADS_H
@@ -496,31 +496,21 @@ static float SNAP_GainForAttenuation( float dist, float attenuation ) {
 	float refdistance = S_DEFAULT_ATTENUATION_REFDISTANCE;
 
 #if !defined( PUBLIC_BUILD ) && !defined( DEDICATED_ONLY )
-#define DUMMY_CVAR ( cvar_t * )( (void *)1 )
-	static cvar_t *s_attenuation_model = DUMMY_CVAR;
-	static cvar_t *s_attenuation_maxdistance = DUMMY_CVAR;
-	static cvar_t *s_attenuation_refdistance = DUMMY_CVAR;
+	static cvar_t *s_attenuation_model;
+	static cvar_t *s_attenuation_maxdistance;
+	static cvar_t *s_attenuation_refdistance;
 
-	if( s_attenuation_model == DUMMY_CVAR ) {
-		s_attenuation_model = Cvar_Find( "s_attenuation_model" );
-	}
-	if( s_attenuation_maxdistance == DUMMY_CVAR ) {
-		s_attenuation_maxdistance = Cvar_Find( "s_attenuation_maxdistance" );
-	}
-	if( s_attenuation_refdistance == DUMMY_CVAR ) {
-		s_attenuation_refdistance = Cvar_Find( "s_attenuation_refdistance" );
+	// the sound system is started after the server and may not be started at all,
+	// so register the cvars the same way it does instead of searching for them every call
+	if( !s_attenuation_model ) {
+		s_attenuation_model = Cvar_Get( "s_attenuation_model", va( "%i", S_DEFAULT_ATTENUATION_MODEL ), CVAR_DEVELOPER | CVAR_LATCH_SOUND );
+		s_attenuation_maxdistance = Cvar_Get( "s_attenuation_maxdistance", va( "%i", S_DEFAULT_ATTENUATION_MAXDISTANCE ), CVAR_DEVELOPER | CVAR_LATCH_SOUND );
+		s_attenuation_refdistance = Cvar_Get( "s_attenuation_refdistance", va( "%i", S_DEFAULT_ATTENUATION_REFDISTANCE ), CVAR_DEVELOPER | CVAR_LATCH_SOUND );
 	}
 
-	if( s_attenuation_model && s_attenuation_model != DUMMY_CVAR ) {
-		model = s_attenuation_model->integer;
-	}
-	if( s_attenuation_maxdistance && s_attenuation_maxdistance != DUMMY_CVAR ) {
-		maxdistance = s_attenuation_maxdistance->value;
-	}
-	if( s_attenuation_refdistance && s_attenuation_refdistance != DUMMY_CVAR ) {
-		refdistance = s_attenuation_refdistance->value;
-	}
-#undef DUMMY_CVAR
+	model = s_attenuation_model->integer;
+	maxdistance = s_attenuation_maxdistance->value;
+	refdistance = s_attenuation_refdistance->value;
 #endif
 
 	return Q_GainForAttenuation( model, maxdistance, refdistance, dist, attenuation );
@@ -629,7 +619,7 @@ static void SNAP_AddEntitiesVisibleAtOrigin( cmodel_state_t *cms, ginfo_t *gi, e
 	edict_t *ent;
 	uint8_t *pvs;
 
-	pvs = alloca( CM_ClusterRowSize( cms ) );
+	pvs = ( uint8_t * )Mem_ScratchAlloc( CM_ClusterRowSize( cms ) );
 	SNAP_FatPVS( cms, vieworg, pvs );
 
 	// add the entities to the list
@@ -726,7 +716,8 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameN
 	client_snapshot_t *frame;
 	entity_state_t *state;
 	int numplayers, numareas;
-	snapshotEntityNumbers_t entsList;
+	size_t mark;
+	snapshotEntityNumbers_t *entsList;
 
 	assert( gameState );
 
@@ -810,7 +801,9 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameN
 
 	// build up the list of visible entities
 	//=============================
-	SNAP_BuildSnapEntitiesList( cms, gi, clent, org, frame, &entsList );
+	mark = Mem_ScratchMark();
+	entsList = ( snapshotEntityNumbers_t * )Mem_ScratchAlloc( sizeof( *entsList ) );
+	SNAP_BuildSnapEntitiesList( cms, gi, clent, org, frame, entsList );
 
 	// store current match state information
 	frame->gameState = *gameState;
@@ -822,9 +815,9 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameN
 	frame->num_entities = 0;
 	frame->first_entity = ne;
 
-	for( e = 0; e < entsList.numSnapshotEntities; e++ ) {
+	for( e = 0; e < entsList->numSnapshotEntities; e++ ) {
 		// add it to the circular client_entities array
-		ent = EDICT_NUM( entsList.snapshotEntities[e] );
+		ent = EDICT_NUM( entsList->snapshotEntities[e] );
 		state = &client_entities->entities[ne % client_entities->num_entities];
 
 		*state = ent->s;
@@ -840,6 +833,8 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, int64_t frameN
 	}
 
 	client_entities->next_entities = ne;
+
+	Mem_ScratchFreeToMark( mark );
 }
 
 /*
@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 int Sys_Thread_Create( qthread_t **pthread, void *( *routine )( void* ), void *param );
 void Sys_Thread_Join( qthread_t *thread );
 void Sys_Thread_Yield( void );
+int Sys_Thread_NumCores( void );
 
 int Sys_Mutex_Create( qmutex_t **pmutex );
 void Sys_Mutex_Destroy( qmutex_t *mutex );
@@ -31,10 +32,13 @@ void Sys_Mutex_Lock( qmutex_t *mutex );
 void Sys_Mutex_Unlock( qmutex_t *mutex );
 int Sys_Atomic_Add( volatile int *value, int add );
 bool Sys_Atomic_CAS( volatile int *value, int oldval, int newval );
+void *Sys_Atomic_LoadPtr( void *volatile *ptr );
+void Sys_Atomic_StorePtr( void *volatile *ptr, void *value );
 
 int Sys_CondVar_Create( qcondvar_t **pcond );
 void Sys_CondVar_Destroy( qcondvar_t *cond );
 bool Sys_CondVar_Wait( qcondvar_t *cond, qmutex_t *mutex, unsigned int timeout_msec );
 void Sys_CondVar_Wake( qcondvar_t *cond );
+void Sys_CondVar_WakeAll( qcondvar_t *cond );
 
 #endif // SYS_THREADS_H
@@ -101,15 +101,57 @@ void QCondVar_Wake( qcondvar_t *cond ) {
 	Sys_CondVar_Wake( cond );
 }
 
+/*
+* QCondVar_WakeAll
+*/
+void QCondVar_WakeAll( qcondvar_t *cond ) {
+	Sys_CondVar_WakeAll( cond );
+}
+
+typedef struct {
+	void *( *routine )( void * );
+	void *param;
+} qthreadstart_t;
+
+/*
+* QThread_Start
+*
+* Releases the scratch arena, the blocks cached by the thread in the allocator
+* and its profiler buffer before it exits.
+*/
+static void *QThread_Start( void *param ) {
+	void *ret;
+	qthreadstart_t start = *( qthreadstart_t * )param;
+
+	free( param );
+
+	ret = start.routine( start.param );
+
+	Mem_FreeThreadArena();
+	Mem_FlushThreadCache();
+	Prof_ThreadExit();
+
+	return ret;
+}
+
 /*
 * QThread_Create
 */
 qthread_t *QThread_Create( void *( *routine )( void* ), void *param ) {
 	int ret;
 	qthread_t *thread;
+	qthreadstart_t *start;
 
-	ret = Sys_Thread_Create( &thread, routine, param );
+	start = ( qthreadstart_t * )malloc( sizeof( *start ) );
+	if( !start ) {
+		Sys_Error( "QThread_Create: out of memory" );
+	}
+	start->routine = routine;
+	start->param = param;
+
+	ret = Sys_Thread_Create( &thread, QThread_Start, start );
 	if( ret != 0 ) {
+		free( start );
 		Sys_Error( "QThread_Create: failed with code %i", ret );
 	}
 	return thread;
@@ -129,6 +171,14 @@ void QThread_Yield( void ) {
 	Sys_Thread_Yield();
 }
 
+/*
+* QThread_NumCores
+*/
+int QThread_NumCores( void ) {
+	int cores = Sys_Thread_NumCores();
+	return max( cores, 1 );
+}
+
 /*
 * QThreads_Init
 */
@@ -157,17 +207,48 @@ bool QAtomic_CAS( volatile int *value, int oldval, int newval ) {
 	return Sys_Atomic_CAS( value, oldval, newval );
 }
 
+/*
+* QAtomic_LoadPtr
+*
+* Acquire load, nothing written before the matching QAtomic_StorePtr can be seen as stale.
+*/
+void *QAtomic_LoadPtr( void *volatile *ptr ) {
+	return Sys_Atomic_LoadPtr( ptr );
+}
+
+/*
+* QAtomic_StorePtr
+*
+* Release store, everything written before it is visible to whoever loads the pointer.
+*/
+void QAtomic_StorePtr( void *volatile *ptr, void *value ) {
+	Sys_Atomic_StorePtr( ptr, value );
+}
+
 // ============================================================================
 
+#define QBUFPIPE_WAIT_MSEC  100
+
+/*
+* The pipe is a single producer, single consumer ring buffer. The writer owns
+* write_pos, the reader owns read_pos and the only shared state is the atomic
+* amount of bytes in flight, so neither side ever takes a lock on the fast path.
+* The mutex and condition variables are only touched when the other side has
+* announced that it's about to go to sleep.
+*/
 struct qbufPipe_s {
 	int blockWrite;
 	volatile int terminated;
 	unsigned write_pos;
 	unsigned read_pos;
 	volatile int cmdbuf_len;
+	volatile int reader_waiting;
+	volatile int writer_waiting;
+	volatile int num_wakeups;
 	size_t bufSize;
 	qcondvar_t *nonempty_condvar;
-	qmutex_t *nonempty_mutex;
+	qcondvar_t *nonfull_condvar;
+	qmutex_t *mutex;
 	char *buf;
 };
 
@@ -184,7 +265,8 @@ qbufPipe_t *QBufPipe_Create( size_t bufSize, int flags ) {
 	pipe->buf = (char *)( pipe + 1 );
 	pipe->bufSize = bufSize;
 	pipe->nonempty_condvar = QCondVar_Create();
-	pipe->nonempty_mutex = QMutex_Create();
+	pipe->nonfull_condvar = QCondVar_Create();
+	pipe->mutex = QMutex_Create();
 	return pipe;
 }
 
@@ -206,69 +288,132 @@ void QBufPipe_Destroy( qbufPipe_t **ppipe ) {
 		return;
 	}
 
-	QMutex_Destroy( &pipe->nonempty_mutex );
+	QMutex_Destroy( &pipe->mutex );
 	QCondVar_Destroy( &pipe->nonempty_condvar );
+	QCondVar_Destroy( &pipe->nonfull_condvar );
 	free( pipe );
 }
 
 /*
-* QBufPipe_Wake
+* QBufPipe_BufLen
 *
-* Signals the waiting thread to wake up.
+* The full barrier guarantees that the command data written before
+* the length was increased is visible to the reader.
+*/
+static int QBufPipe_BufLen( qbufPipe_t *pipe ) {
+	return Sys_Atomic_Add( &pipe->cmdbuf_len, 0 );
+}
+
+/*
+* QBufPipe_BufLenAdd
 */
-static void QBufPipe_Wake( qbufPipe_t *pipe ) {
+static void QBufPipe_BufLenAdd( qbufPipe_t *pipe, int val ) {
+	Sys_Atomic_Add( &pipe->cmdbuf_len, val );
+}
+
+/*
+* QBufPipe_WakeReader
+*
+* Signals the reader, but only if it has announced that it's going to sleep.
+* The waiting flag is raised before the reader rechecks the buffer length,
+* and we read it after updating the length, so the wake up can't get lost.
+* Clearing the flag makes sure it's signalled once per sleep and not
+* once per command until it gets scheduled.
+*/
+static void QBufPipe_WakeReader( qbufPipe_t *pipe ) {
+	if( !pipe->reader_waiting || !Sys_Atomic_CAS( &pipe->reader_waiting, 1, 0 ) ) {
+		return;
+	}
+
+	QMutex_Lock( pipe->mutex );
+	pipe->num_wakeups++;
 	QCondVar_Wake( pipe->nonempty_condvar );
+	QMutex_Unlock( pipe->mutex );
 }
 
 /*
-* QBufPipe_Finish
+* QBufPipe_WakeWriter
+*/
+static void QBufPipe_WakeWriter( qbufPipe_t *pipe ) {
+	if( !pipe->writer_waiting || !Sys_Atomic_CAS( &pipe->writer_waiting, 1, 0 ) ) {
+		return;
+	}
+
+	QMutex_Lock( pipe->mutex );
+	pipe->num_wakeups++;
+	QCondVar_Wake( pipe->nonfull_condvar );
+	QMutex_Unlock( pipe->mutex );
+}
+
+/*
+* QBufPipe_WaitWriter
 *
-* Blocks until the reader thread handles all commands
-* or terminates with an error.
+* Puts the writer to sleep until the amount of bytes in
+* the pipe drops to the limit or the reader terminates.
 */
-void QBufPipe_Finish( qbufPipe_t *pipe ) {
-	while( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0 ) == false && !pipe->terminated ) {
-		QMutex_Lock( pipe->nonempty_mutex );
-		QBufPipe_Wake( pipe );
-		QMutex_Unlock( pipe->nonempty_mutex );
-		QThread_Yield();
+static bool QBufPipe_WaitWriter( qbufPipe_t *pipe, int limit ) {
+	while( QBufPipe_BufLen( pipe ) > limit ) {
+		if( pipe->terminated ) {
+			return false;
+		}
+
+		QMutex_Lock( pipe->mutex );
+		Sys_Atomic_CAS( &pipe->writer_waiting, 0, 1 );
+		if( QBufPipe_BufLen( pipe ) > limit && !pipe->terminated ) {
+			QCondVar_Wait( pipe->nonfull_condvar, pipe->mutex, QBUFPIPE_WAIT_MSEC );
+		}
+		pipe->writer_waiting = 0;
+		QMutex_Unlock( pipe->mutex );
 	}
+	return true;
 }
 
 /*
-* QBufPipe_AllocCmd
+* QBufPipe_Finish
+*
+* Blocks until the reader thread handles all commands
+* or terminates with an error.
 */
-static void *QBufPipe_AllocCmd( qbufPipe_t *pipe, unsigned cmd_size ) {
-	void *buf = &pipe->buf[pipe->write_pos];
-	pipe->write_pos += cmd_size;
-	return buf;
+void QBufPipe_Finish( qbufPipe_t *pipe ) {
+	QBufPipe_WaitWriter( pipe, 0 );
 }
 
 /*
-* QBufPipe_BufLenAdd
+* QBufPipe_ReserveSpace
 */
-static void QBufPipe_BufLenAdd( qbufPipe_t *pipe, int val ) {
-	Sys_Atomic_Add( &pipe->cmdbuf_len, val );
+static bool QBufPipe_ReserveSpace( qbufPipe_t *pipe, unsigned size ) {
+	if( size > pipe->bufSize ) {
+		return false;
+	}
+	// only the reader can shrink cmdbuf_len, so a stale value
+	// just sends us down the slow path below
+	if( pipe->cmdbuf_len + size <= pipe->bufSize ) {
+		return true;
+	}
+	if( !pipe->blockWrite ) {
+		return false;
+	}
+	return QBufPipe_WaitWriter( pipe, pipe->bufSize - size );
 }
 
 /*
-* QBufPipe_WriteCmd
+* QBufPipe_AllocCmd
 *
-* Add new command to buffer. Never allow the distance between the reader
-* and the writer to grow beyond the size of the buffer.
+* Returns a pointer to cmd_size contiguous bytes in the buffer for the
+* caller to construct the command in place. Must be followed by a call
+* to QBufPipe_CommitCmd. Returns NULL if the command must be dropped.
 *
-* Note that there are race conditions here but in the worst case we're going
-* to erroneously drop cmd's instead of stepping on the reader's toes.
+* Never allow the distance between the reader and the writer to grow
+* beyond the size of the buffer.
 */
-void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *pcmd, unsigned cmd_size ) {
-	void *buf;
+void *QBufPipe_AllocCmd( qbufPipe_t *pipe, unsigned cmd_size ) {
 	unsigned write_remains;
 
 	if( !pipe ) {
-		return;
+		return NULL;
 	}
 	if( pipe->terminated ) {
-		return;
+		return NULL;
 	}
 
 	assert( pipe->bufSize >= pipe->write_pos );
@@ -279,87 +424,318 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *pcmd, unsigned cmd_size )
 	write_remains = pipe->bufSize - pipe->write_pos;
 
 	if( sizeof( int ) > write_remains ) {
-		while( pipe->cmdbuf_len + cmd_size + write_remains > pipe->bufSize ) {
-			if( pipe->blockWrite ) {
-				QThread_Yield();
-				continue;
-			}
-			return;
+		if( !QBufPipe_ReserveSpace( pipe, cmd_size + write_remains ) ) {
+			return NULL;
 		}
 
 		// not enough space to enpipe even the reset cmd, rewind
 		QBufPipe_BufLenAdd( pipe, write_remains ); // atomic
 		pipe->write_pos = 0;
 	} else if( cmd_size > write_remains ) {
-		int *cmd;
-
-		while( pipe->cmdbuf_len + sizeof( int ) + cmd_size + write_remains > pipe->bufSize ) {
-			if( pipe->blockWrite ) {
-				QThread_Yield();
-				continue;
-			}
-			return;
+		if( !QBufPipe_ReserveSpace( pipe, sizeof( int ) + cmd_size + write_remains ) ) {
+			return NULL;
 		}
 
 		// explicit pointer reset cmd
-		cmd = QBufPipe_AllocCmd( pipe, sizeof( int ) );
-		*cmd = -1;
+		*( (int *)&pipe->buf[pipe->write_pos] ) = -1;
 
-		QBufPipe_BufLenAdd( pipe, sizeof( *cmd ) + write_remains ); // atomic
+		QBufPipe_BufLenAdd( pipe, sizeof( int ) + write_remains ); // atomic
 		pipe->write_pos = 0;
 	} else {
-		while( pipe->cmdbuf_len + cmd_size > pipe->bufSize ) {
-			if( pipe->blockWrite ) {
-				QThread_Yield();
-				continue;
-			}
-			return;
+		if( !QBufPipe_ReserveSpace( pipe, cmd_size ) ) {
+			return NULL;
 		}
 	}
 
-	buf = QBufPipe_AllocCmd( pipe, cmd_size );
-	memcpy( buf, pcmd, cmd_size );
+	return &pipe->buf[pipe->write_pos];
+}
+
+/*
+* QBufPipe_CommitCmd
+*
+* Makes the command constructed with QBufPipe_AllocCmd visible to the reader.
+*/
+void QBufPipe_CommitCmd( qbufPipe_t *pipe, unsigned cmd_size ) {
+	pipe->write_pos += cmd_size;
 	QBufPipe_BufLenAdd( pipe, cmd_size ); // atomic
 
-	// wake the other thread waiting for signal
-	QMutex_Lock( pipe->nonempty_mutex );
-	QBufPipe_Wake( pipe );
-	QMutex_Unlock( pipe->nonempty_mutex );
+	QBufPipe_WakeReader( pipe );
+}
+
+/*
+* QBufPipe_WriteCmd
+*
+* Add new command to buffer.
+*/
+void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *pcmd, unsigned cmd_size ) {
+	void *buf;
+
+	buf = QBufPipe_AllocCmd( pipe, cmd_size );
+	if( !buf ) {
+		return;
+	}
+
+	memcpy( buf, pcmd, cmd_size );
+	QBufPipe_CommitCmd( pipe, cmd_size );
 }
 
 /*
 * QBufPipe_ReadCmds
+*
+* Handles everything that's in the pipe at the moment of the call. The space
+* is handed back to the writer once per batch instead of once per command.
 */
 int QBufPipe_ReadCmds( qbufPipe_t *pipe, unsigned( **cmdHandlers )( const void * ) ) {
 	int read = 0;
+	int avail;
 
 	if( !pipe ) {
 		return -1;
 	}
 
+	while( !pipe->terminated && ( avail = QBufPipe_BufLen( pipe ) ) > 0 ) {
+		int consumed = 0;
+
+		while( consumed < avail ) {
+			int cmd;
+			int cmd_size;
+			int read_remains;
+
+			assert( pipe->bufSize >= pipe->read_pos );
+			if( pipe->bufSize < pipe->read_pos ) {
+				pipe->read_pos = 0;
+			}
+
+			read_remains = pipe->bufSize - pipe->read_pos;
+
+			if( sizeof( int ) > read_remains ) {
+				// implicit reset
+				pipe->read_pos = 0;
+				consumed += read_remains;
+				continue;
+			}
+
+			cmd = *( (int *)( pipe->buf + pipe->read_pos ) );
+			if( cmd == -1 ) {
+				// this cmd is special
+				pipe->read_pos = 0;
+				consumed += sizeof( int ) + read_remains;
+				continue;
+			}
+
+			cmd_size = cmdHandlers[cmd]( pipe->buf + pipe->read_pos );
+			read++;
+
+			if( !cmd_size || cmd_size > avail - consumed ) {
+				assert( !cmd_size );
+				pipe->terminated = 1;
+				break;
+			}
+
+			pipe->read_pos += cmd_size;
+			consumed += cmd_size;
+		}
+
+		QBufPipe_BufLenAdd( pipe, -consumed ); // atomic
+
+		if( pipe->terminated ) {
+			// release a writer blocked on a full pipe or in QBufPipe_Finish
+			QMutex_Lock( pipe->mutex );
+			QCondVar_Wake( pipe->nonfull_condvar );
+			QMutex_Unlock( pipe->mutex );
+			return -1;
+		}
+
+		QBufPipe_WakeWriter( pipe );
+	}
+
+	return read;
+}
+
+/*
+* QBufPipe_Wait
+*/
+void QBufPipe_Wait( qbufPipe_t *pipe, int ( *read )( qbufPipe_t *, unsigned( ** )( const void * ), bool ),
+					unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec ) {
+	while( !pipe->terminated ) {
+		int res;
+		bool timeout = false;
+
+		if( QBufPipe_BufLen( pipe ) == 0 ) {
+			QMutex_Lock( pipe->mutex );
+			Sys_Atomic_CAS( &pipe->reader_waiting, 0, 1 );
+			if( QBufPipe_BufLen( pipe ) == 0 ) {
+				timeout = QCondVar_Wait( pipe->nonempty_condvar, pipe->mutex, timeout_msec ) == false;
+			}
+			pipe->reader_waiting = 0;
+			QMutex_Unlock( pipe->mutex );
+		}
+
+		// we're guaranteed at this point that either cmdbuf_len is > 0
+		// or that waiting on the condition variable has timed out
+		res = read( pipe, cmdHandlers, timeout );
+		if( res < 0 ) {
+			// done
+			return;
+		}
+	}
+}
+
+/*
+=============================================================================
+
+BENCHMARK
+
+=============================================================================
+*/
+
+enum {
+	BUFPIPE_BENCH_CMD_DATA,
+	BUFPIPE_BENCH_CMD_QUIT,
+
+	NUM_BUFPIPE_BENCH_CMDS
+};
+
+typedef struct {
+	int id;
+	unsigned size;
+	unsigned seq;
+} bufPipeBenchCmd_t;
+
+enum {
+	BUFPIPE_BENCH_COPY,
+	BUFPIPE_BENCH_INPLACE,
+	BUFPIPE_BENCH_REFERENCE
+};
+
+static unsigned bufpipe_bench_seq;
+static unsigned bufpipe_bench_errors;
+
+// the mutex and condition variable pipe QBufPipe used to be, kept only
+// so that bufpipe_bench can compare the current one against it
+typedef struct {
+	int blockWrite;
+	volatile int terminated;
+	unsigned write_pos;
+	unsigned read_pos;
+	volatile int cmdbuf_len;
+	qmutex_t *nonempty_mutex;
+	qcondvar_t *nonempty_condvar;
+	size_t bufSize;
+	char *buf;
+	unsigned num_wakeups;
+} bufPipeRef_t;
+
+/*
+* QBufPipeRef_Create
+*/
+static bufPipeRef_t *QBufPipeRef_Create( size_t bufSize ) {
+	bufPipeRef_t *pipe = malloc( sizeof( *pipe ) + bufSize );
+
+	memset( pipe, 0, sizeof( *pipe ) );
+	pipe->blockWrite = 1;
+	pipe->buf = (char *)( pipe + 1 );
+	pipe->bufSize = bufSize;
+	pipe->nonempty_condvar = QCondVar_Create();
+	pipe->nonempty_mutex = QMutex_Create();
+	return pipe;
+}
+
+/*
+* QBufPipeRef_Destroy
+*/
+static void QBufPipeRef_Destroy( bufPipeRef_t *pipe ) {
+	QMutex_Destroy( &pipe->nonempty_mutex );
+	QCondVar_Destroy( &pipe->nonempty_condvar );
+	free( pipe );
+}
+
+/*
+* QBufPipeRef_Wake
+*/
+static void QBufPipeRef_Wake( bufPipeRef_t *pipe ) {
+	QMutex_Lock( pipe->nonempty_mutex );
+	QCondVar_Wake( pipe->nonempty_condvar );
+	QMutex_Unlock( pipe->nonempty_mutex );
+	pipe->num_wakeups++;
+}
+
+/*
+* QBufPipeRef_Finish
+*/
+static void QBufPipeRef_Finish( bufPipeRef_t *pipe ) {
+	while( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0 ) == false && !pipe->terminated ) {
+		QBufPipeRef_Wake( pipe );
+		QThread_Yield();
+	}
+}
+
+/*
+* QBufPipeRef_WriteCmd
+*/
+static void QBufPipeRef_WriteCmd( bufPipeRef_t *pipe, const void *pcmd, unsigned cmd_size ) {
+	unsigned write_remains;
+
+	if( pipe->terminated ) {
+		return;
+	}
+
+	write_remains = pipe->bufSize - pipe->write_pos;
+
+	if( sizeof( int ) > write_remains ) {
+		while( pipe->cmdbuf_len + cmd_size + write_remains > pipe->bufSize ) {
+			QThread_Yield();
+		}
+
+		// not enough space to enpipe even the reset cmd, rewind
+		Sys_Atomic_Add( &pipe->cmdbuf_len, write_remains );
+		pipe->write_pos = 0;
+	} else if( cmd_size > write_remains ) {
+		while( pipe->cmdbuf_len + sizeof( int ) + cmd_size + write_remains > pipe->bufSize ) {
+			QThread_Yield();
+		}
+
+		// explicit pointer reset cmd
+		*(int *)( pipe->buf + pipe->write_pos ) = -1;
+		Sys_Atomic_Add( &pipe->cmdbuf_len, sizeof( int ) + write_remains );
+		pipe->write_pos = 0;
+	} else {
+		while( pipe->cmdbuf_len + cmd_size > pipe->bufSize ) {
+			QThread_Yield();
+		}
+	}
+
+	memcpy( pipe->buf + pipe->write_pos, pcmd, cmd_size );
+	pipe->write_pos += cmd_size;
+	Sys_Atomic_Add( &pipe->cmdbuf_len, cmd_size );
+
+	QBufPipeRef_Wake( pipe );
+}
+
+/*
+* QBufPipeRef_ReadCmds
+*/
+static int QBufPipeRef_ReadCmds( bufPipeRef_t *pipe, unsigned( **cmdHandlers )( const void * ) ) {
+	int read = 0;
+
 	while( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0 ) == false && !pipe->terminated ) {
 		int cmd;
 		int cmd_size;
 		int read_remains;
 
-		assert( pipe->bufSize >= pipe->read_pos );
-		if( pipe->bufSize < pipe->read_pos ) {
-			pipe->read_pos = 0;
-		}
-
 		read_remains = pipe->bufSize - pipe->read_pos;
 
 		if( sizeof( int ) > read_remains ) {
 			// implicit reset
 			pipe->read_pos = 0;
-			QBufPipe_BufLenAdd( pipe, -read_remains );
+			Sys_Atomic_Add( &pipe->cmdbuf_len, -read_remains );
 		}
 
 		cmd = *( (int *)( pipe->buf + pipe->read_pos ) );
 		if( cmd == -1 ) {
 			// this cmd is special
 			pipe->read_pos = 0;
-			QBufPipe_BufLenAdd( pipe, -( (int)( sizeof( int ) + read_remains ) ) ); // atomic
+			Sys_Atomic_Add( &pipe->cmdbuf_len, -( (int)( sizeof( int ) + read_remains ) ) );
 			continue;
 		}
 
@@ -371,44 +747,183 @@ int QBufPipe_ReadCmds( qbufPipe_t *pipe, unsigned( **cmdHandlers )( const void *
 			return -1;
 		}
 
-		if( cmd_size > pipe->cmdbuf_len ) {
-			assert( 0 );
-			pipe->terminated = 1;
-			return -1;
-		}
-
 		pipe->read_pos += cmd_size;
-		QBufPipe_BufLenAdd( pipe, -cmd_size ); // atomic
+		Sys_Atomic_Add( &pipe->cmdbuf_len, -cmd_size );
 	}
 
 	return read;
 }
 
 /*
-* QBufPipe_Wait
+* QBufPipe_BenchDataCmd
 */
-void QBufPipe_Wait( qbufPipe_t *pipe, int ( *read )( qbufPipe_t *, unsigned( ** )( const void * ), bool ),
-					unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec ) {
-	while( !pipe->terminated ) {
-		int res;
-		bool timeout = false;
+static unsigned QBufPipe_BenchDataCmd( const void *pcmd ) {
+	const bufPipeBenchCmd_t *cmd = pcmd;
 
-		while( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0 ) == true ) {
-			QMutex_Lock( pipe->nonempty_mutex );
+	if( cmd->seq != bufpipe_bench_seq ) {
+		bufpipe_bench_errors++;
+	}
+	bufpipe_bench_seq = cmd->seq + 1;
+	return cmd->size;
+}
 
-			timeout = QCondVar_Wait( pipe->nonempty_condvar, pipe->nonempty_mutex, timeout_msec ) == false;
+/*
+* QBufPipe_BenchQuitCmd
+*/
+static unsigned QBufPipe_BenchQuitCmd( const void *pcmd ) {
+	return 0;
+}
 
-			// don't hold the mutex, changes to cmdbuf_len are atomic anyway
+/*
+* QBufPipe_BenchReadCmds
+*/
+static int QBufPipe_BenchReadCmds( qbufPipe_t *pipe, unsigned( **cmdHandlers )( const void * ), bool timeout ) {
+	return QBufPipe_ReadCmds( pipe, cmdHandlers );
+}
+
+/*
+* QBufPipe_BenchThread
+*/
+static void *QBufPipe_BenchThread( void *param ) {
+	unsigned( *cmdHandlers[NUM_BUFPIPE_BENCH_CMDS] )( const void * ) = {
+		QBufPipe_BenchDataCmd,
+		QBufPipe_BenchQuitCmd,
+	};
+
+	QBufPipe_Wait( param, QBufPipe_BenchReadCmds, cmdHandlers, Q_THREADS_WAIT_INFINITE );
+	return NULL;
+}
+
+/*
+* QBufPipeRef_BenchThread
+*
+* Same as QBufPipe_Wait used to be.
+*/
+static void *QBufPipeRef_BenchThread( void *param ) {
+	bufPipeRef_t *pipe = param;
+	unsigned( *cmdHandlers[NUM_BUFPIPE_BENCH_CMDS] )( const void * ) = {
+		QBufPipe_BenchDataCmd,
+		QBufPipe_BenchQuitCmd,
+	};
+
+	while( !pipe->terminated ) {
+		if( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0 ) == true ) {
+			QMutex_Lock( pipe->nonempty_mutex );
+			QCondVar_Wait( pipe->nonempty_condvar, pipe->nonempty_mutex, Q_THREADS_WAIT_INFINITE );
 			QMutex_Unlock( pipe->nonempty_mutex );
+		}
+
+		if( QBufPipeRef_ReadCmds( pipe, cmdHandlers ) < 0 ) {
 			break;
 		}
+	}
+	return NULL;
+}
 
-		// we're guaranteed at this point that either cmdbuf_len is > 0
-		// or that waiting on the condition variable has timed out
-		res = read( pipe, cmdHandlers, timeout );
-		if( res < 0 ) {
-			// done
-			return;
+/*
+* QBufPipe_BenchRun
+*/
+static void QBufPipe_BenchRun( const char *name, unsigned numCmds, unsigned cmdSize, size_t bufSize, int mode ) {
+	unsigned i;
+	uint64_t t;
+	unsigned wakeups;
+	qthread_t *thread;
+	qbufPipe_t *pipe = NULL;
+	bufPipeRef_t *refPipe = NULL;
+	bufPipeBenchCmd_t *cmd;
+	int quit = BUFPIPE_BENCH_CMD_QUIT;
+	uint8_t *tmp = malloc( cmdSize );
+
+	memset( tmp, 0, cmdSize );
+	bufpipe_bench_seq = 0;
+	bufpipe_bench_errors = 0;
+
+	if( mode == BUFPIPE_BENCH_REFERENCE ) {
+		refPipe = QBufPipeRef_Create( bufSize );
+		thread = QThread_Create( QBufPipeRef_BenchThread, refPipe );
+	} else {
+		pipe = QBufPipe_Create( bufSize, 1 );
+		thread = QThread_Create( QBufPipe_BenchThread, pipe );
+	}
+
+	t = Sys_Microseconds();
+	for( i = 0; i < numCmds; i++ ) {
+		if( mode == BUFPIPE_BENCH_INPLACE ) {
+			cmd = QBufPipe_AllocCmd( pipe, cmdSize );
+		} else {
+			cmd = (bufPipeBenchCmd_t *)tmp;
+		}
+		cmd->id = BUFPIPE_BENCH_CMD_DATA;
+		cmd->size = cmdSize;
+		cmd->seq = i;
+		memset( cmd + 1, i, cmdSize - sizeof( *cmd ) );
+
+		if( mode == BUFPIPE_BENCH_INPLACE ) {
+			QBufPipe_CommitCmd( pipe, cmdSize );
+		} else if( mode == BUFPIPE_BENCH_COPY ) {
+			QBufPipe_WriteCmd( pipe, cmd, cmdSize );
+		} else {
+			QBufPipeRef_WriteCmd( refPipe, cmd, cmdSize );
 		}
 	}
+
+	if( refPipe ) {
+		QBufPipeRef_Finish( refPipe );
+		t = Sys_Microseconds() - t;
+		wakeups = refPipe->num_wakeups;
+
+		QBufPipeRef_WriteCmd( refPipe, &quit, sizeof( quit ) );
+		QThread_Join( thread );
+		QBufPipeRef_Destroy( refPipe );
+	} else {
+		QBufPipe_Finish( pipe );
+		t = Sys_Microseconds() - t;
+		wakeups = pipe->num_wakeups;
+
+		QBufPipe_WriteCmd( pipe, &quit, sizeof( quit ) );
+		QThread_Join( thread );
+		QBufPipe_Destroy( &pipe );
+	}
+
+	Com_Printf( "%-9s %8u cmds in %6u usec, %7.1f ns/cmd, %7.1f MB/s, %u wakeups%s\n", name,
+				numCmds, (unsigned)t, t * 1000.0 / numCmds, t ? (double)numCmds * cmdSize / t : 0.0,
+				wakeups, bufpipe_bench_errors ? ", OUT OF ORDER" : "" );
+
+	free( tmp );
+}
+
+/*
+* QBufPipe_Bench_f
+*/
+static void QBufPipe_Bench_f( void ) {
+	unsigned numCmds, cmdSize, bufSize;
+
+	numCmds = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 1000000;
+	cmdSize = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 64;
+	bufSize = Cmd_Argc() > 3 ? atoi( Cmd_Argv( 3 ) ) : 0x10000;
+
+	cmdSize = ( max( cmdSize, sizeof( bufPipeBenchCmd_t ) ) + 3 ) & ~3;
+	if( !numCmds || cmdSize + sizeof( int ) > bufSize ) {
+		Com_Printf( "Usage: %s [commands] [cmdsize] [bufsize]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	Com_Printf( "QBufPipe: %u byte commands, %u byte buffer\n", cmdSize, bufSize );
+	QBufPipe_BenchRun( "reference", numCmds, cmdSize, bufSize, BUFPIPE_BENCH_REFERENCE );
+	QBufPipe_BenchRun( "copy", numCmds, cmdSize, bufSize, BUFPIPE_BENCH_COPY );
+	QBufPipe_BenchRun( "in-place", numCmds, cmdSize, bufSize, BUFPIPE_BENCH_INPLACE );
+}
+
+/*
+* QThreads_InitCommands
+*/
+void QThreads_InitCommands( void ) {
+	Cmd_AddCommand( "bufpipe_bench", QBufPipe_Bench_f );
+}
+
+/*
+* QThreads_ShutdownCommands
+*/
+void QThreads_ShutdownCommands( void ) {
+	Cmd_RemoveCommand( "bufpipe_bench" );
 }
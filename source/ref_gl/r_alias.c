@@ -636,6 +636,42 @@ void R_DrawAliasSurf( const entity_t *e, const shader_t *shader, const mfog_t *f
 	}
 }
 
+/*
+* R_AliasSurfInstanceable
+*
+* Returns true if the surface is drawn straight from the static VBO for this entity,
+* so that several entities can share a single instanced draw call
+*/
+bool R_AliasSurfInstanceable( const entity_t *e, const drawSurfaceAlias_t *drawSurf ) {
+	int framenum = e->frame, oldframenum = e->oldframe;
+	const maliasmodel_t *model = ( const maliasmodel_t * )drawSurf->model->extradata;
+
+	if( !drawSurf->mesh->vbo ) {
+		return false;
+	}
+	if( ( framenum >= model->numframes ) || ( framenum < 0 ) ) {
+		framenum = 0;
+	}
+	if( ( oldframenum >= model->numframes ) || ( oldframenum < 0 ) ) {
+		oldframenum = 0;
+	}
+	return !framenum && !oldframenum;
+}
+
+/*
+* R_DrawAliasSurfInstances
+*
+* Draws the static VBO of the mesh once per instance point. The shader must be
+* bound to an entity with identity transform, the instances are in world space.
+*/
+void R_DrawAliasSurfInstances( const drawSurfaceAlias_t *drawSurf, int numInstances, instancePoint_t *instances ) {
+	const maliasmesh_t *aliasmesh = drawSurf->mesh;
+
+	RB_BindVBO( aliasmesh->vbo->index, GL_TRIANGLES );
+
+	RB_DrawElementsInstanced( 0, aliasmesh->numverts, 0, aliasmesh->numtris * 3, numInstances, instances );
+}
+
 /*
 * R_AliasModelFrameBounds
 */
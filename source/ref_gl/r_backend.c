@@ -1112,7 +1112,7 @@ void RB_DrawElementsReal( rbDrawElements_t *de ) {
 	numInstances = de->numInstances;
 
 	if( numInstances ) {
-		if( glConfig.ext.instanced_arrays ) {
+		if( ( rb.currentVAttribs & VATTRIB_INSTANCES_BITS ) == VATTRIB_INSTANCES_BITS ) {
 			// the instance data is contained in vertex attributes
 			qglDrawElementsInstancedARB( rb.primitive, numElems, GL_UNSIGNED_SHORT,
 										 (GLvoid *)( firstElem * sizeof( elem_t ) ), numInstances );
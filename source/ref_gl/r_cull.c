@@ -20,6 +20,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "r_local.h"
 
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define R_CULL_SSE
+#include <xmmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#define R_CULL_NEON
+#include <arm_neon.h>
+#endif
+
 
 /*
 =============================================================
@@ -526,6 +534,232 @@ bool R_CullSphere( const vec3_t centre, const float radius, const unsigned int c
 	return R_CullSphereCustomPlanes( rn.frustum, sizeof( rn.frustum ) / sizeof( rn.frustum[0] ), centre, radius, clipFlags );
 }
 
+/*
+* R_CullBoxBatch
+*
+* Classifies R_CULL_BATCH boxes starting at the given index against the
+* clip planes at once. Returns the mask of boxes that are completely outside
+* the frustum, partial is set to the mask of boxes that cross at least one
+* of the planes. The remaining boxes are entirely inside.
+*/
+unsigned R_CullBoxBatch( const cplane_t *p, unsigned nump, const mbounds_t *bounds, unsigned first, unsigned int clipflags, unsigned *partial ) {
+	unsigned i, bit;
+	unsigned culled, crossing;
+	const float *mins[3], *maxs[3];
+#if defined( R_CULL_SSE )
+	__m128 vculled = _mm_setzero_ps(), vcrossing = _mm_setzero_ps();
+#elif defined( R_CULL_NEON )
+	uint32x4_t vculled = vdupq_n_u32( 0 ), vcrossing = vdupq_n_u32( 0 );
+#else
+	unsigned k;
+	float dist1[R_CULL_BATCH], dist2[R_CULL_BATCH];
+#endif
+
+	assert( !( first % R_CULL_BATCH ) && first < bounds->numBounds );
+
+	for( i = 0; i < 3; i++ ) {
+		mins[i] = bounds->mins[i] + first;
+		maxs[i] = bounds->maxs[i] + first;
+	}
+
+	clipflags &= 63;
+
+	culled = crossing = 0;
+	for( i = 0, bit = 1; i < nump && clipflags; i++, bit <<= 1, p++ ) {
+		const float *n1[3], *n2[3];
+
+		if( !( clipflags & bit ) ) {
+			continue;
+		}
+		clipflags &= ~bit;
+
+		// dist1 is the distance of the corner furthest along the plane normal, dist2 of the nearest
+		n1[0] = p->signbits & 1 ? mins[0] : maxs[0];
+		n1[1] = p->signbits & 2 ? mins[1] : maxs[1];
+		n1[2] = p->signbits & 4 ? mins[2] : maxs[2];
+		n2[0] = p->signbits & 1 ? maxs[0] : mins[0];
+		n2[1] = p->signbits & 2 ? maxs[1] : mins[1];
+		n2[2] = p->signbits & 4 ? maxs[2] : mins[2];
+
+#if defined( R_CULL_SSE )
+		{
+			__m128 nx = _mm_set1_ps( p->normal[0] ), ny = _mm_set1_ps( p->normal[1] ), nz = _mm_set1_ps( p->normal[2] );
+			__m128 dist = _mm_set1_ps( p->dist );
+			__m128 dist1, dist2;
+
+			dist1 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, _mm_load_ps( n1[0] ) ), _mm_mul_ps( ny, _mm_load_ps( n1[1] ) ) ),
+								_mm_mul_ps( nz, _mm_load_ps( n1[2] ) ) );
+			dist2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, _mm_load_ps( n2[0] ) ), _mm_mul_ps( ny, _mm_load_ps( n2[1] ) ) ),
+								_mm_mul_ps( nz, _mm_load_ps( n2[2] ) ) );
+
+			vculled = _mm_or_ps( vculled, _mm_cmplt_ps( dist1, dist ) );
+			vcrossing = _mm_or_ps( vcrossing, _mm_cmplt_ps( dist2, dist ) );
+
+			if( _mm_movemask_ps( vculled ) == ( 1 << R_CULL_BATCH ) - 1 ) {
+				break;
+			}
+		}
+#elif defined( R_CULL_NEON )
+		{
+			float32x4_t dist = vdupq_n_f32( p->dist );
+			float32x4_t dist1, dist2;
+			uint32x2_t all;
+
+			dist1 = vmulq_n_f32( vld1q_f32( n1[0] ), p->normal[0] );
+			dist1 = vaddq_f32( dist1, vmulq_n_f32( vld1q_f32( n1[1] ), p->normal[1] ) );
+			dist1 = vaddq_f32( dist1, vmulq_n_f32( vld1q_f32( n1[2] ), p->normal[2] ) );
+			dist2 = vmulq_n_f32( vld1q_f32( n2[0] ), p->normal[0] );
+			dist2 = vaddq_f32( dist2, vmulq_n_f32( vld1q_f32( n2[1] ), p->normal[1] ) );
+			dist2 = vaddq_f32( dist2, vmulq_n_f32( vld1q_f32( n2[2] ), p->normal[2] ) );
+
+			vculled = vorrq_u32( vculled, vcltq_f32( dist1, dist ) );
+			vcrossing = vorrq_u32( vcrossing, vcltq_f32( dist2, dist ) );
+
+			all = vand_u32( vget_low_u32( vculled ), vget_high_u32( vculled ) );
+			if( vget_lane_u32( all, 0 ) & vget_lane_u32( all, 1 ) ) {
+				break;
+			}
+		}
+#else
+		for( k = 0; k < R_CULL_BATCH; k++ ) {
+			dist1[k] = p->normal[0] * n1[0][k] + p->normal[1] * n1[1][k] + p->normal[2] * n1[2][k];
+			dist2[k] = p->normal[0] * n2[0][k] + p->normal[1] * n2[1][k] + p->normal[2] * n2[2][k];
+			if( dist1[k] < p->dist ) {
+				culled |= 1 << k;
+			}
+			if( dist2[k] < p->dist ) {
+				crossing |= 1 << k;
+			}
+		}
+		if( culled == ( 1 << R_CULL_BATCH ) - 1 ) {
+			break;
+		}
+#endif
+	}
+
+#if defined( R_CULL_SSE )
+	culled = _mm_movemask_ps( vculled );
+	crossing = _mm_movemask_ps( vcrossing );
+#elif defined( R_CULL_NEON )
+	{
+		uint32_t c1[R_CULL_BATCH], c2[R_CULL_BATCH];
+
+		vst1q_u32( c1, vculled );
+		vst1q_u32( c2, vcrossing );
+		for( i = 0; i < R_CULL_BATCH; i++ ) {
+			culled |= ( c1[i] & 1 ) << i;
+			crossing |= ( c2[i] & 1 ) << i;
+		}
+	}
+#endif
+
+	*partial = crossing & ~culled;
+	return culled;
+}
+
+/*
+* R_CullBench_f
+*
+* r_cullbench [iterations]
+*
+* Times per-box frustum culling of all world leaves and surfaces against the
+* batched version, using the frustum of the last rendered view.
+*/
+void R_CullBench_f( void ) {
+	int it, iterations;
+	unsigned i, j, bit;
+	unsigned numLeafs, numSurfaces, mismatches;
+	unsigned culled, partial;
+	unsigned scalarCulled, scalarPartial;
+	int64_t start, scalarTime, batchTime;
+	const mbrushmodel_t *bm = rsh.worldBrushModel;
+	uint8_t *scalarSides, *batchSides;
+	const unsigned clipFlags = 63;
+
+	if( !bm ) {
+		Com_Printf( "No map loaded\n" );
+		return;
+	}
+
+	iterations = ri.Cmd_Argc() > 1 ? atoi( ri.Cmd_Argv( 1 ) ) : 100;
+	iterations = max( iterations, 1 );
+
+	numLeafs = bm->leafBounds.numBounds;
+	numSurfaces = bm->surfBounds.numBounds;
+
+	// 0 - inside, 1 - partial, 2 - culled
+	scalarSides = R_Malloc( numLeafs + numSurfaces );
+	batchSides = R_Malloc( numLeafs + numSurfaces );
+
+	scalarTime = 0;
+	for( it = 0; it < iterations; it++ ) {
+		start = ri.Sys_Microseconds();
+		for( i = 0; i < numLeafs + numSurfaces; i++ ) {
+			const mbounds_t *bounds = i < numLeafs ? &bm->leafBounds : &bm->surfBounds;
+			unsigned b = i < numLeafs ? i : i - numLeafs;
+			const cplane_t *p;
+			vec3_t mins, maxs;
+			int side = 0;
+
+			for( j = 0; j < 3; j++ ) {
+				mins[j] = bounds->mins[j][b];
+				maxs[j] = bounds->maxs[j][b];
+			}
+
+			scalarSides[i] = 0;
+			for( j = 0, bit = 1, p = rn.frustum; j < 6; j++, bit <<= 1, p++ ) {
+				if( !( clipFlags & bit ) ) {
+					continue;
+				}
+				side = BoxOnPlaneSide( mins, maxs, p );
+				if( side == 2 ) {
+					scalarSides[i] = 2;
+					break;
+				}
+				if( side != 1 ) {
+					scalarSides[i] = 1;
+				}
+			}
+		}
+		scalarTime += ri.Sys_Microseconds() - start;
+	}
+
+	batchTime = 0;
+	for( it = 0; it < iterations; it++ ) {
+		start = ri.Sys_Microseconds();
+		for( i = 0; i < numLeafs + numSurfaces; i += R_CULL_BATCH ) {
+			const mbounds_t *bounds = i < numLeafs ? &bm->leafBounds : &bm->surfBounds;
+			unsigned b = i < numLeafs ? i : i - numLeafs;
+
+			culled = R_CullBoxBatch( rn.frustum, 6, bounds, b, clipFlags, &partial );
+			for( j = 0; j < R_CULL_BATCH; j++ ) {
+				batchSides[i + j] = ( culled & ( 1 << j ) ) ? 2 : ( ( partial & ( 1 << j ) ) ? 1 : 0 );
+			}
+		}
+		batchTime += ri.Sys_Microseconds() - start;
+	}
+
+	mismatches = 0;
+	scalarCulled = scalarPartial = 0;
+	for( i = 0; i < numLeafs + numSurfaces; i++ ) {
+		if( scalarSides[i] != batchSides[i] ) {
+			mismatches++;
+		}
+		scalarCulled += scalarSides[i] == 2;
+		scalarPartial += scalarSides[i] == 1;
+	}
+
+	Com_Printf( "%u leaf and %u surface boxes, %u culled, %u partial, %i iterations\n",
+				numLeafs, numSurfaces, scalarCulled, scalarPartial, iterations );
+	Com_Printf( "per box: %.1f usec, batched: %.1f usec\n", (double)scalarTime / iterations, (double)batchTime / iterations );
+	if( mismatches ) {
+		Com_Printf( S_COLOR_RED "%u boxes classified differently\n", mismatches );
+	}
+
+	R_Free( scalarSides );
+	R_Free( batchSides );
+}
+
 /*
 * R_VisCullBox
 */
@@ -56,7 +56,9 @@ static void *RF_AdapterThreadProc( void *param )
 	GLimp_MakeCurrent( adapter->GLcontext, GLimp_GetWindowSurface( NULL ) );
 
 	while( !adapter->shutdown ) {
+		ri.Prof_Enter( "RF_AdapterFrame" );
 		RF_AdapterFrame( adapter );
+		ri.Prof_Leave();
 	}
 
 	GLimp_MakeCurrent( NULL, NULL );
@@ -21,6 +21,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "r_imagelib.h"
 #include "../qalgo/hash.h"
 
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define R_IMAGE_SSE2
+#include <emmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#define R_IMAGE_NEON
+#include <arm_neon.h>
+#endif
+
 #define MAX_GLIMAGES 8192
 #define IMAGES_HASH_SIZE 64
 
@@ -621,10 +629,105 @@ static void R_CutImage(
 }
 
 /*
- * R_ResampleTexture
+ * R_ResampleRowSIMD
+ *
+ * Resamples the leading part of an 8-bit RGBA row, exactly like the scalar loop
+ * in R_ResampleTextureExt does. Returns the number of output pixels written.
  */
-static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, int outwidth,
-	int outheight, int samples, int alignment )
+static int R_ResampleRowSIMD( const uint8_t *inrow, const uint8_t *inrow2, const unsigned *p1, const unsigned *p2,
+	uint8_t *out, int outwidth, int samples )
+{
+	int j = 0;
+
+	if( samples != 4 ) {
+		return 0;
+	}
+
+#if defined( R_IMAGE_SSE2 )
+	{
+		int t[4][4];
+		__m128i a, b, c, d, lo, hi;
+		const __m128i zero = _mm_setzero_si128();
+
+		for( ; j + 4 <= outwidth; j += 4, out += 16 ) {
+			memcpy( &t[0][0], inrow + p1[j + 0], 4 );
+			memcpy( &t[0][1], inrow + p1[j + 1], 4 );
+			memcpy( &t[0][2], inrow + p1[j + 2], 4 );
+			memcpy( &t[0][3], inrow + p1[j + 3], 4 );
+			memcpy( &t[1][0], inrow + p2[j + 0], 4 );
+			memcpy( &t[1][1], inrow + p2[j + 1], 4 );
+			memcpy( &t[1][2], inrow + p2[j + 2], 4 );
+			memcpy( &t[1][3], inrow + p2[j + 3], 4 );
+			memcpy( &t[2][0], inrow2 + p1[j + 0], 4 );
+			memcpy( &t[2][1], inrow2 + p1[j + 1], 4 );
+			memcpy( &t[2][2], inrow2 + p1[j + 2], 4 );
+			memcpy( &t[2][3], inrow2 + p1[j + 3], 4 );
+			memcpy( &t[3][0], inrow2 + p2[j + 0], 4 );
+			memcpy( &t[3][1], inrow2 + p2[j + 1], 4 );
+			memcpy( &t[3][2], inrow2 + p2[j + 2], 4 );
+			memcpy( &t[3][3], inrow2 + p2[j + 3], 4 );
+
+			a = _mm_loadu_si128( (const __m128i *)t[0] );
+			b = _mm_loadu_si128( (const __m128i *)t[1] );
+			c = _mm_loadu_si128( (const __m128i *)t[2] );
+			d = _mm_loadu_si128( (const __m128i *)t[3] );
+
+			lo = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) ),
+				_mm_add_epi16( _mm_unpacklo_epi8( c, zero ), _mm_unpacklo_epi8( d, zero ) ) );
+			hi = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) ),
+				_mm_add_epi16( _mm_unpackhi_epi8( c, zero ), _mm_unpackhi_epi8( d, zero ) ) );
+
+			_mm_storeu_si128(
+				(__m128i *)out, _mm_packus_epi16( _mm_srli_epi16( lo, 2 ), _mm_srli_epi16( hi, 2 ) ) );
+		}
+	}
+#elif defined( R_IMAGE_NEON )
+	{
+		uint32_t t[4][4];
+		uint8x16_t a, b, c, d;
+		uint16x8_t lo, hi;
+
+		for( ; j + 4 <= outwidth; j += 4, out += 16 ) {
+			memcpy( &t[0][0], inrow + p1[j + 0], 4 );
+			memcpy( &t[0][1], inrow + p1[j + 1], 4 );
+			memcpy( &t[0][2], inrow + p1[j + 2], 4 );
+			memcpy( &t[0][3], inrow + p1[j + 3], 4 );
+			memcpy( &t[1][0], inrow + p2[j + 0], 4 );
+			memcpy( &t[1][1], inrow + p2[j + 1], 4 );
+			memcpy( &t[1][2], inrow + p2[j + 2], 4 );
+			memcpy( &t[1][3], inrow + p2[j + 3], 4 );
+			memcpy( &t[2][0], inrow2 + p1[j + 0], 4 );
+			memcpy( &t[2][1], inrow2 + p1[j + 1], 4 );
+			memcpy( &t[2][2], inrow2 + p1[j + 2], 4 );
+			memcpy( &t[2][3], inrow2 + p1[j + 3], 4 );
+			memcpy( &t[3][0], inrow2 + p2[j + 0], 4 );
+			memcpy( &t[3][1], inrow2 + p2[j + 1], 4 );
+			memcpy( &t[3][2], inrow2 + p2[j + 2], 4 );
+			memcpy( &t[3][3], inrow2 + p2[j + 3], 4 );
+
+			a = vreinterpretq_u8_u32( vld1q_u32( t[0] ) );
+			b = vreinterpretq_u8_u32( vld1q_u32( t[1] ) );
+			c = vreinterpretq_u8_u32( vld1q_u32( t[2] ) );
+			d = vreinterpretq_u8_u32( vld1q_u32( t[3] ) );
+
+			lo = vaddw_u8( vaddw_u8( vaddl_u8( vget_low_u8( a ), vget_low_u8( b ) ), vget_low_u8( c ) ),
+				vget_low_u8( d ) );
+			hi = vaddw_u8( vaddw_u8( vaddl_u8( vget_high_u8( a ), vget_high_u8( b ) ), vget_high_u8( c ) ),
+				vget_high_u8( d ) );
+
+			vst1q_u8( out, vcombine_u8( vshrn_n_u16( lo, 2 ), vshrn_n_u16( hi, 2 ) ) );
+		}
+	}
+#endif
+
+	return j;
+}
+
+/*
+ * R_ResampleTextureExt
+ */
+static void R_ResampleTextureExt( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, int outwidth,
+	int outheight, int samples, int alignment, bool simd )
 {
 	int i, j, k;
 	int inwidthS, outwidthS;
@@ -660,7 +763,8 @@ static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inhe
 	for( i = 0; i < outheight; i++, out += outwidthS ) {
 		inrow = in + inwidthS * (int)( ( i + 0.25 ) * inheight / outheight );
 		inrow2 = in + inwidthS * (int)( ( i + 0.75 ) * inheight / outheight );
-		for( j = 0; j < outwidth; j++ ) {
+		j = simd ? R_ResampleRowSIMD( inrow, inrow2, p1, p2, out, outwidth, samples ) : 0;
+		for( ; j < outwidth; j++ ) {
 			pix1 = inrow + p1[j];
 			pix2 = inrow + p2[j];
 			pix3 = inrow2 + p1[j];
@@ -673,6 +777,16 @@ static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inhe
 	}
 }
 
+/*
+ * R_ResampleTexture
+ */
+static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, int outwidth,
+	int outheight, int samples, int alignment )
+{
+	R_ResampleTextureExt(
+		ctx, in, inwidth, inheight, out, outwidth, outheight, samples, alignment, r_imagesimd->integer != 0 );
+}
+
 /*
  * R_ResampleTexture16
  *
@@ -732,11 +846,113 @@ static void R_ResampleTexture16( int ctx, const unsigned short *in, int inwidth,
 }
 
 /*
- * R_MipMap
+ * R_MipMapRowSIMD
+ *
+ * Averages the leading complete 2x2 blocks of a pair of source rows, exactly like
+ * the scalar loop in R_MipMapExt does. The output may overlap the first row as long
+ * as it does not start past it. Returns the number of output pixels written.
+ */
+static int R_MipMapRowSIMD( const uint8_t *in, const uint8_t *next, uint8_t *out, int count, int samples )
+{
+	int j = 0;
+
+#if defined( R_IMAGE_SSE2 )
+	__m128i a0, a1, b0, b1, s0, s1, s2, s3;
+	const __m128i zero = _mm_setzero_si128();
+
+	if( samples == 4 ) {
+		for( ; j + 4 <= count; j += 4, in += 32, next += 32, out += 16 ) {
+			a0 = _mm_loadu_si128( (const __m128i *)in );
+			a1 = _mm_loadu_si128( (const __m128i *)( in + 16 ) );
+			b0 = _mm_loadu_si128( (const __m128i *)next );
+			b1 = _mm_loadu_si128( (const __m128i *)( next + 16 ) );
+
+			// vertical sums of pixels 0-1, 2-3, 4-5 and 6-7
+			s0 = _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( b0, zero ) );
+			s1 = _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( b0, zero ) );
+			s2 = _mm_add_epi16( _mm_unpacklo_epi8( a1, zero ), _mm_unpacklo_epi8( b1, zero ) );
+			s3 = _mm_add_epi16( _mm_unpackhi_epi8( a1, zero ), _mm_unpackhi_epi8( b1, zero ) );
+
+			// horizontal sums of the even and the odd pixels
+			s0 = _mm_add_epi16( _mm_unpacklo_epi64( s0, s1 ), _mm_unpackhi_epi64( s0, s1 ) );
+			s2 = _mm_add_epi16( _mm_unpacklo_epi64( s2, s3 ), _mm_unpackhi_epi64( s2, s3 ) );
+
+			_mm_storeu_si128(
+				(__m128i *)out, _mm_packus_epi16( _mm_srli_epi16( s0, 2 ), _mm_srli_epi16( s2, 2 ) ) );
+		}
+	} else if( samples == 1 ) {
+		const __m128i one = _mm_set1_epi16( 1 );
+
+		for( ; j + 16 <= count; j += 16, in += 32, next += 32, out += 16 ) {
+			a0 = _mm_loadu_si128( (const __m128i *)in );
+			a1 = _mm_loadu_si128( (const __m128i *)( in + 16 ) );
+			b0 = _mm_loadu_si128( (const __m128i *)next );
+			b1 = _mm_loadu_si128( (const __m128i *)( next + 16 ) );
+
+			s0 = _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( b0, zero ) );
+			s1 = _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( b0, zero ) );
+			s2 = _mm_add_epi16( _mm_unpacklo_epi8( a1, zero ), _mm_unpacklo_epi8( b1, zero ) );
+			s3 = _mm_add_epi16( _mm_unpackhi_epi8( a1, zero ), _mm_unpackhi_epi8( b1, zero ) );
+
+			// adjacent pairs are summed to 32 bits, the sums never exceed 1020
+			s0 = _mm_packs_epi32( _mm_madd_epi16( s0, one ), _mm_madd_epi16( s1, one ) );
+			s2 = _mm_packs_epi32( _mm_madd_epi16( s2, one ), _mm_madd_epi16( s3, one ) );
+
+			_mm_storeu_si128(
+				(__m128i *)out, _mm_packus_epi16( _mm_srli_epi16( s0, 2 ), _mm_srli_epi16( s2, 2 ) ) );
+		}
+	}
+#elif defined( R_IMAGE_NEON )
+	int k;
+
+	// deinterleaving loads put every channel in its own register, so that pairwise
+	// additions sum horizontally adjacent pixels for any number of samples
+	switch( samples ) {
+		case 4:
+			for( ; j + 8 <= count; j += 8, in += 64, next += 64, out += 32 ) {
+				uint8x16x4_t a = vld4q_u8( in ), b = vld4q_u8( next );
+				uint8x8x4_t o;
+				for( k = 0; k < 4; k++ )
+					o.val[k] = vshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[k] ), vpaddlq_u8( b.val[k] ) ), 2 );
+				vst4_u8( out, o );
+			}
+			break;
+		case 3:
+			for( ; j + 8 <= count; j += 8, in += 48, next += 48, out += 24 ) {
+				uint8x16x3_t a = vld3q_u8( in ), b = vld3q_u8( next );
+				uint8x8x3_t o;
+				for( k = 0; k < 3; k++ )
+					o.val[k] = vshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[k] ), vpaddlq_u8( b.val[k] ) ), 2 );
+				vst3_u8( out, o );
+			}
+			break;
+		case 2:
+			for( ; j + 8 <= count; j += 8, in += 32, next += 32, out += 16 ) {
+				uint8x16x2_t a = vld2q_u8( in ), b = vld2q_u8( next );
+				uint8x8x2_t o;
+				for( k = 0; k < 2; k++ )
+					o.val[k] = vshrn_n_u16( vaddq_u16( vpaddlq_u8( a.val[k] ), vpaddlq_u8( b.val[k] ) ), 2 );
+				vst2_u8( out, o );
+			}
+			break;
+		case 1:
+			for( ; j + 8 <= count; j += 8, in += 16, next += 16, out += 8 ) {
+				uint8x16_t a = vld1q_u8( in ), b = vld1q_u8( next );
+				vst1_u8( out, vshrn_n_u16( vaddq_u16( vpaddlq_u8( a ), vpaddlq_u8( b ) ), 2 ) );
+			}
+			break;
+	}
+#endif
+
+	return j;
+}
+
+/*
+ * R_MipMapExt
  *
  * Operates in place, quartering the size of the texture
  */
-static void R_MipMap( uint8_t *in, int width, int height, int samples, int alignment )
+static void R_MipMapExt( uint8_t *in, int width, int height, int samples, int alignment, bool simd )
 {
 	int i, j, k;
 	int instride = Q_ALIGN( width * samples, alignment );
@@ -757,7 +973,9 @@ static void R_MipMap( uint8_t *in, int width, int height, int samples, int align
 
 	for( i = 0; i < outheight; i++, in += instride * 2, out += outpadding ) {
 		next = ( ( ( i << 1 ) + 1 ) < height ) ? ( in + instride ) : in;
-		for( j = 0, inofs = 0; j < outwidth; j++, inofs += samples ) {
+		j = simd ? R_MipMapRowSIMD( in, next, out, width >> 1, samples ) : 0;
+		out += j * samples;
+		for( inofs = j * samples * 2; j < outwidth; j++, inofs += samples ) {
 			if( ( ( j << 1 ) + 1 ) < width ) {
 				for( k = 0; k < samples; ++k, ++inofs )
 					*( out++ ) = ( in[inofs] + in[inofs + samples] + next[inofs] + next[inofs + samples] ) >> 2;
@@ -769,6 +987,14 @@ static void R_MipMap( uint8_t *in, int width, int height, int samples, int align
 	}
 }
 
+/*
+ * R_MipMap
+ */
+static void R_MipMap( uint8_t *in, int width, int height, int samples, int alignment )
+{
+	R_MipMapExt( in, width, height, samples, alignment, r_imagesimd->integer != 0 );
+}
+
 /*
  * R_MipMap16
  *
@@ -1508,26 +1734,18 @@ typedef struct ktx_header_s {
 } ktx_header_t;
 
 /*
- * R_LoadKTX
+ * R_UploadKTX
+ *
+ * Uploads the KTX image held in the buffer, may modify the buffer contents.
  */
-static bool R_LoadKTX( int ctx, image_t *image, const char *pathname )
+static bool R_UploadKTX( int ctx, image_t *image, const char *pathname, uint8_t *buffer )
 {
 	int i, j;
-	uint8_t *buffer;
 	ktx_header_t *header;
 	bool swapEndian;
 	uint8_t *data;
 	int numFaces = ( ( image->flags & IT_CUBEMAP ) ? 6 : 1 ), numMips;
 
-	if( image->flags & ( IT_FLIPX | IT_FLIPY | IT_FLIPDIAGONAL ) ) {
-		return false;
-	}
-
-	R_LoadFile( pathname, (void **)&buffer );
-	if( !buffer ) {
-		return false;
-	}
-
 	header = (ktx_header_t *)buffer;
 	if( memcmp( header->identifier, "\xABKTX 11\xBB\r\n\x1A\n", 12 ) ) {
 		ri.Com_DPrintf( S_COLOR_YELLOW "R_LoadKTX: Bad file identifier: %s\n", pathname );
@@ -1752,15 +1970,309 @@ static bool R_LoadKTX( int ctx, image_t *image, const char *pathname )
 	image->width = header->pixelWidth;
 	image->height = header->pixelHeight;
 
-	R_FreeFile( buffer );
 	R_DeferDataSync();
 	return true;
 
 error: // must not be reached after actually starting uploading the texture
-	R_FreeFile( buffer );
 	return false;
 }
 
+/*
+ * R_LoadKTX
+ */
+static bool R_LoadKTX( int ctx, image_t *image, const char *pathname )
+{
+	uint8_t *buffer;
+	bool loaded;
+
+	if( image->flags & ( IT_FLIPX | IT_FLIPY | IT_FLIPDIAGONAL ) ) {
+		return false;
+	}
+
+	R_LoadFile( pathname, (void **)&buffer );
+	if( !buffer ) {
+		return false;
+	}
+
+	loaded = R_UploadKTX( ctx, image, pathname, buffer );
+
+	R_FreeFile( buffer );
+	return loaded;
+}
+
+/*
+=========================================================
+
+IMAGE CACHE
+
+Decoded images are stored in the cache directory as uncompressed KTX files
+holding the full mip chain with 4-byte row alignment, so that they can be
+uploaded by R_UploadKTX without decoding or downsampling them again.
+
+=========================================================
+*/
+
+#define IMAGECACHE_VERSION      1
+#define IMAGECACHE_KEY          "wsw.imagecache"
+#define IMAGECACHE_ENDIANNESS   0x04030201
+
+/*
+ * R_ImageCacheable
+ *
+ * Only plain 2D images decoded from true color or PCX files are cached, flipped and
+ * cut images are left out as the KTX path does not handle them, WAL textures are
+ * cheap to expand from the palette.
+ */
+static bool R_ImageCacheable( int flags, const char *extension )
+{
+	if( !extension ) {
+		return false;
+	}
+	if( flags & ( IT_CUBEMAP | IT_FLIPX | IT_FLIPY | IT_FLIPDIAGONAL | IT_LEFTHALF | IT_RIGHTHALF | IT_WAL | IT_MIPTEX ) ) {
+		return false;
+	}
+	return !Q_stricmp( extension, ".tga" ) || !Q_stricmp( extension, ".jpg" ) || !Q_stricmp( extension, ".png" ) ||
+		   !Q_stricmp( extension, ".pcx" );
+}
+
+/*
+ * R_ImageCacheValue
+ *
+ * Identifies the source file by its name, size and modification time.
+ */
+static void R_ImageCacheValue( const char *pathname, char *value, size_t size )
+{
+	unsigned key = IMAGECACHE_VERSION;
+
+	key = key * 31 + COM_SuperFastHash( (const uint8_t *)pathname, strlen( pathname ) );
+	key = key * 31 + (unsigned)ri.FS_FileMTime( pathname );
+	key = key * 31 + (unsigned)ri.FS_FOpenFile( pathname, NULL, FS_READ );
+
+	Q_snprintfz( value, size, "%08x %s", key, COM_FileExtension( pathname ) );
+}
+
+/*
+ * R_ImageCachePath
+ */
+static void R_ImageCachePath( const image_t *image, char *path, size_t size )
+{
+	Q_snprintfz( path, size, "imagecache/%s.ktx", image->name );
+}
+
+/*
+ * R_ImageCacheSamples
+ */
+static int R_ImageCacheSamples( int format )
+{
+	switch( format ) {
+		case GL_RGBA:
+		case GL_BGRA_EXT:
+			return 4;
+		case GL_RGB:
+		case GL_BGR_EXT:
+			return 3;
+		case GL_LUMINANCE_ALPHA:
+			return 2;
+		case GL_LUMINANCE:
+		case GL_ALPHA:
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * R_ImageCacheSize
+ */
+static size_t R_ImageCacheSize( int width, int height, int samples, int numMips, size_t keyValueSize )
+{
+	int i;
+	size_t size = sizeof( ktx_header_t ) + keyValueSize;
+
+	for( i = 0; i < numMips; i++ ) {
+		size += sizeof( int ) + Q_ALIGN( width * samples, 4 ) * height;
+		width = max( width >> 1, 1 );
+		height = max( height >> 1, 1 );
+	}
+	return size;
+}
+
+/*
+ * R_ImageCacheValid
+ *
+ * Checks that the file was written by R_BuildImageCache for the given source file.
+ */
+static bool R_ImageCacheValid( const uint8_t *buffer, size_t len, const char *value )
+{
+	const ktx_header_t *header = (const ktx_header_t *)buffer;
+	const char *kv = (const char *)( buffer + sizeof( *header ) + sizeof( int ) );
+	int samples;
+
+	if( len < sizeof( *header ) + sizeof( int ) ) {
+		return false;
+	}
+	if( memcmp( header->identifier, "\xABKTX 11\xBB\r\n\x1A\n", 12 ) || header->endianness != IMAGECACHE_ENDIANNESS ) {
+		return false;
+	}
+	if( header->type != GL_UNSIGNED_BYTE || header->format != header->baseInternalFormat ||
+		header->numberOfFaces != 1 || header->numberOfMipmapLevels < 1 || header->numberOfMipmapLevels > 32 ) {
+		return false;
+	}
+	if( header->pixelWidth < 1 || header->pixelHeight < 1 || header->bytesOfKeyValueData < (int)sizeof( int ) ) {
+		return false;
+	}
+
+	samples = R_ImageCacheSamples( header->baseInternalFormat );
+	if( !samples || len != R_ImageCacheSize( header->pixelWidth, header->pixelHeight, samples,
+								header->numberOfMipmapLevels, header->bytesOfKeyValueData ) ) {
+		return false;
+	}
+
+	// the key and the value are both NUL-terminated, the buffer itself is NUL-terminated by R_LoadFile
+	if( strcmp( kv, IMAGECACHE_KEY ) ) {
+		return false;
+	}
+	return strcmp( kv + strlen( kv ) + 1, value ) == 0;
+}
+
+/*
+ * R_LoadImageCache
+ *
+ * Uploads the cached mip chain for the source file found for the image. Returns the
+ * size of the cache file, or 0 if the image is not cached or the cache is stale.
+ * The pathname is replaced with the name of the source file.
+ */
+static size_t R_LoadImageCache( int ctx, image_t *image, char *pathname, size_t pathsize )
+{
+	int len;
+	uint8_t *buffer;
+	const char *extension;
+	char path[1024], value[64];
+
+	if( image->width > 1 && image->height > 1 ) {
+		return 0; // SVG, rasterized to the requested size
+	}
+
+	extension = ri.FS_FirstExtension( pathname, IMAGE_EXTENSIONS, NUM_IMAGE_EXTENSIONS - 1 );
+	if( !R_ImageCacheable( image->flags, extension ) ) {
+		return 0;
+	}
+
+	COM_ReplaceExtension( pathname, extension, pathsize );
+	R_ImageCacheValue( pathname, value, sizeof( value ) );
+
+	R_ImageCachePath( image, path, sizeof( path ) );
+	len = R_LoadCacheFile( path, (void **)&buffer );
+	if( !buffer ) {
+		return 0;
+	}
+
+	if( !R_ImageCacheValid( buffer, len, value ) || !R_UploadKTX( ctx, image, path, buffer ) ) {
+		R_FreeFile( buffer );
+		return 0;
+	}
+
+	R_FreeFile( buffer );
+
+	Q_strncpyz( image->extension, extension, sizeof( image->extension ) );
+	return len;
+}
+
+/*
+ * R_BuildImageCache
+ *
+ * Lays out a freshly decoded image and its mipmaps the way they are stored in
+ * the cache file.
+ */
+static uint8_t *R_BuildImageCache(
+	int ctx, const uint8_t *pic, int width, int height, int samples, int flags, const char *value, size_t *size )
+{
+	int i, j, format;
+	int numMips;
+	int w = width, h = height;
+	size_t kvLength, kvSize, rowSize, faceSize;
+	uint8_t *buffer, *scratch, *data;
+	ktx_header_t *header;
+
+	if( samples == 4 ) {
+		format = ( flags & IT_BGRA ) ? GL_BGRA_EXT : GL_RGBA;
+	} else if( samples == 3 ) {
+		format = ( flags & IT_BGRA ) ? GL_BGR_EXT : GL_RGB;
+	} else if( samples == 2 ) {
+		format = GL_LUMINANCE_ALPHA;
+	} else {
+		format = ( flags & IT_ALPHAMASK ) ? GL_ALPHA : GL_LUMINANCE;
+	}
+
+	numMips = ( flags & IT_NOMIPMAP ) ? 1 : R_MipCount( width, height, 1 );
+
+	kvLength = sizeof( IMAGECACHE_KEY ) + strlen( value ) + 1;
+	kvSize = sizeof( int ) + Q_ALIGN( kvLength, 4 );
+
+	*size = R_ImageCacheSize( width, height, samples, numMips, kvSize );
+	buffer = R_PrepareImageBuffer( ctx, TEXTURE_LOADING_BUF1, *size );
+	memset( buffer, 0, sizeof( *header ) + kvSize );
+
+	header = (ktx_header_t *)buffer;
+	memcpy( header->identifier, "\xABKTX 11\xBB\r\n\x1A\n", 12 );
+	header->endianness = IMAGECACHE_ENDIANNESS;
+	header->type = GL_UNSIGNED_BYTE;
+	header->typeSize = 1;
+	header->format = header->internalFormat = header->baseInternalFormat = format;
+	header->pixelWidth = width;
+	header->pixelHeight = height;
+	header->numberOfFaces = 1;
+	header->numberOfMipmapLevels = numMips;
+	header->bytesOfKeyValueData = kvSize;
+
+	data = buffer + sizeof( *header );
+	*(int *)data = kvLength;
+	strcpy( (char *)data + sizeof( int ), IMAGECACHE_KEY );
+	strcpy( (char *)data + sizeof( int ) + sizeof( IMAGECACHE_KEY ), value );
+	data += kvSize;
+
+	// the mipmaps are generated in the resampling buffer, which is free at this point
+	rowSize = Q_ALIGN( width * samples, 4 );
+	scratch = R_PrepareImageBuffer( ctx, TEXTURE_RESAMPLING_BUF0, rowSize * height );
+	for( j = 0; j < height; j++ )
+		memcpy( scratch + j * rowSize, pic + j * width * samples, width * samples );
+
+	for( i = 0; i < numMips; i++ ) {
+		if( i ) {
+			R_MipMap( scratch, w, h, samples, 4 );
+			w = max( w >> 1, 1 );
+			h = max( h >> 1, 1 );
+		}
+
+		faceSize = Q_ALIGN( w * samples, 4 ) * h;
+		*(int *)data = faceSize;
+		data += sizeof( int );
+		memcpy( data, scratch, faceSize );
+		data += faceSize;
+	}
+
+	return buffer;
+}
+
+/*
+ * R_WriteImageCache
+ */
+static void R_WriteImageCache( const image_t *image, const uint8_t *buffer, size_t size )
+{
+	int file;
+	char path[1024];
+
+	R_ImageCachePath( image, path, sizeof( path ) );
+	if( ri.FS_FOpenFile( path, &file, FS_WRITE | FS_CACHE ) == -1 ) {
+		ri.Com_DPrintf( S_COLOR_YELLOW "Could not open %s for writing\n", path );
+		return;
+	}
+
+	if( (size_t)ri.FS_Write( buffer, size, file ) != size ) {
+		ri.Com_DPrintf( S_COLOR_YELLOW "Failed to write %s\n", path );
+	}
+	ri.FS_FCloseFile( file );
+}
+
 /*
 =========================================================
 
@@ -1842,8 +2354,11 @@ static int LoadMipTex( uint8_t **pic, int width, int height, int flags )
 
 /*
  * R_LoadImageFromDisk
+ *
+ * With useCache, plain 2D images are loaded from the image cache when possible,
+ * and the cache is refreshed when they are decoded from the source file.
  */
-static bool R_LoadImageFromDisk( int ctx, image_t *image )
+static bool R_LoadImageFromDisk( int ctx, image_t *image, bool useCache )
 {
 	int flags = image->flags;
 	size_t len = strlen( image->name );
@@ -1952,8 +2467,13 @@ static bool R_LoadImageFromDisk( int ctx, image_t *image )
 		}
 	} else {
 		uint8_t *pic = NULL;
+		bool uploaded = false;
 
 		Q_strncatz( pathname, ".tga", pathsize );
+		if( useCache && R_LoadImageCache( ctx, image, pathname, pathsize ) ) {
+			return true;
+		}
+
 		samples = R_ReadImageFromDisk( ctx, pathname, pathsize, &pic, &width, &height, &flags, 0 );
 
 		if( samples != 0 ) {
@@ -1963,8 +2483,23 @@ static bool R_LoadImageFromDisk( int ctx, image_t *image )
 
 			R_BindImage( image );
 
-			R_Upload32( ctx, &pic, 0, 0, 0, width, height, flags, image->minmipsize, &image->upload_width,
-				&image->upload_height, samples, false, false );
+			if( useCache && R_ImageCacheable( flags, &pathname[len] ) ) {
+				char value[64];
+				size_t size;
+				uint8_t *buffer;
+
+				R_ImageCacheValue( pathname, value, sizeof( value ) );
+				buffer = R_BuildImageCache( ctx, pic, width, height, samples, flags, value, &size );
+				R_WriteImageCache( image, buffer, size );
+
+				image->flags = flags;
+				uploaded = R_UploadKTX( ctx, image, pathname, buffer );
+			}
+
+			if( !uploaded ) {
+				R_Upload32( ctx, &pic, 0, 0, 0, width, height, flags, image->minmipsize, &image->upload_width,
+					&image->upload_height, samples, false, false );
+			}
 
 			image->error = qglGetError();
 			Q_strncpyz( image->extension, &pathname[len], sizeof( image->extension ) );
@@ -2350,7 +2885,7 @@ image_t *R_FindImage( const char *name, const char *suffix, int flags, int minmi
 		}
 	}
 
-	loaded = R_LoadImageFromDisk( QGL_CONTEXT_MAIN, image );
+	loaded = R_LoadImageFromDisk( QGL_CONTEXT_MAIN, image, r_imagecache->integer != 0 );
 	R_UnbindImage( image );
 
 	if( !loaded ) {
@@ -2367,6 +2902,159 @@ image_t *R_FindImage( const char *name, const char *suffix, int flags, int minmi
 	return image;
 }
 
+/*
+ * R_ImageCacheBench_f
+ *
+ * r_imagecachebench [all]
+ *
+ * Reloads the world textures, or all cacheable textures, first by decoding the
+ * source files and then through the image cache, and reports the time taken and
+ * the number of bytes read in both cases.
+ */
+void R_ImageCacheBench_f( void )
+{
+	int i, pass;
+	int tags = IMAGE_TAG_WORLD;
+	int numImages = 0, numMisses = 0;
+	size_t len, cacheSize;
+	int64_t start, time[2];
+	double bytes[2];
+	image_t *image;
+	char pathname[1024];
+
+	if( ri.Cmd_Argc() > 1 && !Q_stricmp( ri.Cmd_Argv( 1 ), "all" ) ) {
+		tags = ~0;
+	}
+
+	R_FinishLoadingImages();
+
+	for( pass = 0; pass < 2; pass++ ) {
+		bytes[pass] = 0;
+		start = ri.Sys_Microseconds();
+
+		for( i = 0, image = r_images; i < MAX_GLIMAGES; i++, image++ ) {
+			if( !image->texnum || !image->loaded || image->missing || !( image->tags & tags ) ) {
+				continue;
+			}
+			if( !R_ImageCacheable( image->flags, image->extension ) ) {
+				continue;
+			}
+
+			len = strlen( image->name );
+			if( len >= sizeof( pathname ) - sizeof( image->extension ) ) {
+				continue;
+			}
+			memcpy( pathname, image->name, len );
+			Q_strncpyz( pathname + len, image->extension, sizeof( pathname ) - len );
+
+			image->width = image->height = 1;
+
+			if( !pass ) {
+				bytes[pass] += ri.FS_FOpenFile( pathname, NULL, FS_READ );
+				R_LoadImageFromDisk( QGL_CONTEXT_MAIN, image, false );
+				numImages++;
+			} else {
+				cacheSize = R_LoadImageCache( QGL_CONTEXT_MAIN, image, pathname, sizeof( pathname ) );
+				if( !cacheSize ) {
+					bytes[pass] += ri.FS_FOpenFile( pathname, NULL, FS_READ );
+					R_LoadImageFromDisk( QGL_CONTEXT_MAIN, image, true );
+					numMisses++;
+				}
+				bytes[pass] += cacheSize;
+			}
+
+			R_UnbindImage( image );
+		}
+
+		qglFinish();
+		time[pass] = ri.Sys_Microseconds() - start;
+	}
+
+	Com_Printf( "%i images\n", numImages );
+	Com_Printf( "decoded: %.1f ms, %.2f MB read\n", time[0] / 1000.0, bytes[0] / 1048576.0 );
+	Com_Printf( "cached: %.1f ms, %.2f MB read, %i misses\n", time[1] / 1000.0, bytes[1] / 1048576.0, numMisses );
+}
+
+/*
+ * R_ImageSIMDBench_f
+ *
+ * r_imagesimdbench [iterations]
+ *
+ * Resamples random 1024x1024 and 2048x2048 images to half their size and builds
+ * their mipmap chains using both the scalar and the SIMD code, then reports the
+ * time taken and whether the outputs are identical.
+ */
+void R_ImageSIMDBench_f( void )
+{
+	int i, it, iterations, size, samples, pass;
+	int w, h;
+	size_t imageSize;
+	int64_t start, time[2][2];
+	uint8_t *src, *dest[2], *mip[2];
+	bool resampleExact, mipExact;
+	const int sizes[] = { 1024, 2048 };
+	const int numSamples[] = { 4, 3, 1 };
+
+	iterations = ri.Cmd_Argc() > 1 ? atoi( ri.Cmd_Argv( 1 ) ) : 10;
+	iterations = max( iterations, 1 );
+
+	R_FinishLoadingImages();
+
+	for( size = 0; size < (int)( sizeof( sizes ) / sizeof( sizes[0] ) ); size++ ) {
+		for( samples = 0; samples < (int)( sizeof( numSamples ) / sizeof( numSamples[0] ) ); samples++ ) {
+			const int dim = sizes[size], n = numSamples[samples];
+
+			imageSize = (size_t)dim * dim * n;
+			src = R_Malloc( imageSize );
+			dest[0] = R_Malloc( imageSize / 4 );
+			dest[1] = R_Malloc( imageSize / 4 );
+			mip[0] = R_Malloc( imageSize );
+			mip[1] = R_Malloc( imageSize );
+			for( i = 0; i < (int)imageSize; i++ )
+				src[i] = rand() & 255;
+
+			for( pass = 0; pass < 2; pass++ ) {
+				start = ri.Sys_Microseconds();
+				for( it = 0; it < iterations; it++ )
+					R_ResampleTextureExt(
+						QGL_CONTEXT_MAIN, src, dim, dim, dest[pass], dim / 2, dim / 2, n, 1, pass != 0 );
+				time[0][pass] = ri.Sys_Microseconds() - start;
+
+				time[1][pass] = 0;
+				for( it = 0; it < iterations; it++ ) {
+					memcpy( mip[pass], src, imageSize );
+
+					start = ri.Sys_Microseconds();
+					for( w = h = dim; w > 1 || h > 1; w = max( w >> 1, 1 ), h = max( h >> 1, 1 ) )
+						R_MipMapExt( mip[pass], w, h, n, 1, pass != 0 );
+					time[1][pass] += ri.Sys_Microseconds() - start;
+				}
+			}
+
+			resampleExact = !memcmp( dest[0], dest[1], imageSize / 4 );
+			mipExact = !memcmp( mip[0], mip[1], n ); // the 1x1 mip of the chains
+
+			// the first level of the chain, compared in full
+			for( pass = 0; pass < 2; pass++ ) {
+				memcpy( mip[pass], src, imageSize );
+				R_MipMapExt( mip[pass], dim, dim, n, 1, pass != 0 );
+			}
+			mipExact = mipExact && !memcmp( mip[0], mip[1], imageSize / 4 );
+
+			Com_Printf( "%ix%ix%i: resample %.2f ms, SIMD %.2f ms%s; mipmaps %.2f ms, SIMD %.2f ms%s\n", dim, dim, n,
+				time[0][0] / 1000.0 / iterations, time[0][1] / 1000.0 / iterations,
+				resampleExact ? "" : S_COLOR_RED " (MISMATCH)" S_COLOR_WHITE, time[1][0] / 1000.0 / iterations,
+				time[1][1] / 1000.0 / iterations, mipExact ? "" : S_COLOR_RED " (MISMATCH)" S_COLOR_WHITE );
+
+			R_Free( src );
+			R_Free( dest[0] );
+			R_Free( dest[1] );
+			R_Free( mip[0] );
+			R_Free( mip[1] );
+		}
+	}
+}
+
 /*
 ==============================================================================
 
@@ -3477,7 +4165,7 @@ static unsigned R_HandleLoadPicLoaderCmd( void *pcmd )
 	image_t *image = r_images + cmd->pic;
 	bool loaded;
 
-	loaded = R_LoadImageFromDisk( QGL_CONTEXT_LOADER + cmd->self, image );
+	loaded = R_LoadImageFromDisk( QGL_CONTEXT_LOADER + cmd->self, image, r_imagecache->integer != 0 );
 	R_UnbindImage( image );
 
 	if( !loaded ) {
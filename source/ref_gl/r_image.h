@@ -115,6 +115,8 @@ void R_InitDrawFlatTexture( void );
 void R_FreeImageBuffers( void );
 
 void R_PrintImageList( const char *pattern, bool ( *filter )( const char *filter, const char *value ) );
+void R_ImageCacheBench_f( void );
+void R_ImageSIMDBench_f( void );
 void R_ScreenShot( const char *filename, int x, int y, int width, int height, int quality,
 				   bool flipx, bool flipy, bool flipdiagonal, bool silent );
 
@@ -20,158 +20,64 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "r_local.h"
 
-typedef unsigned (*queueCmdHandler_t)( const void * );
-
-enum {
-	CMD_JOB_TAKE,
-	CMD_JOB_QUIT,
-
-	NUM_JOB_CMDS
-};
+// the job arguments are passed by pointer and may live on the
+// caller's stack, so keep copies of them until RJ_FinishJobs
+#define MAX_RJOBS   1024
 
 typedef struct {
-	int id;
-	unsigned first;
-	unsigned items;
 	jobfunc_t job;
 	jobarg_t job_arg;
-} jobTakeCmd_t;
-
-static qbufPipe_t *job_queue[NUM_JOB_THREADS] = { NULL };
-static qthread_t *job_thread[NUM_JOB_THREADS] = { NULL };
-static unsigned job_count;
+} rjob_t;
 
-static void RJ_IssueJobTakeCmd( unsigned thread, jobfunc_t job, jobarg_t *arg, unsigned first, unsigned stride );
-static void RJ_IssueJobQuitCmd( unsigned thread );
-static void *R_JobThreadProc( void *param );
+static rjob_t rj_jobs[MAX_RJOBS];
+static unsigned rj_numJobs;
+static volatile int rj_counter;
 
 /*
 * RJ_Init
 */
 void RJ_Init( void ) {
-	int i;
+	rj_numJobs = 0;
+	rj_counter = 0;
+}
 
-	job_count = 0;
+/*
+* R_RunJob
+*/
+static void R_RunJob( unsigned first, unsigned items, void *parg ) {
+	rjob_t *rjob = parg;
 
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		job_queue[i] = ri.BufPipe_Create( 0x4000, 1 );
-		job_thread[i] = ri.Thread_Create( R_JobThreadProc, job_queue[i] );
-	}
+	rjob->job( first, items, &rjob->job_arg );
 }
 
 /*
 * RJ_ScheduleJob
 */
 void RJ_ScheduleJob( jobfunc_t job, jobarg_t *arg, unsigned items ) {
-	unsigned first;
-	const unsigned block = ( items + NUM_JOB_THREADS - 1 ) / NUM_JOB_THREADS;
+	rjob_t *rjob;
 
-	for( first = 0; first < items; ) {
-		unsigned last = first + block;
-		if( last > items ) {
-			last = items;
-		}
+	if( rj_numJobs == MAX_RJOBS ) {
+		RJ_FinishJobs();
+	}
 
-		RJ_IssueJobTakeCmd( job_count % NUM_JOB_THREADS, job, arg, first, last - first );
-		job_count++;
+	rjob = &rj_jobs[rj_numJobs++];
+	rjob->job = job;
+	rjob->job_arg = *arg;
 
-		first += last - first;
-	}
+	ri.Jobs_Schedule( &R_RunJob, rjob, items, 0, &rj_counter );
 }
 
 /*
 * RJ_FinishJobs
 */
 void RJ_FinishJobs( void ) {
-	int i;
-
-	for( i = 0; i < NUM_JOB_THREADS; i++ )
-		ri.BufPipe_Finish( job_queue[i] );
+	ri.Jobs_Wait( &rj_counter );
+	rj_numJobs = 0;
 }
 
 /*
 * RJ_Shutdown
 */
 void RJ_Shutdown( void ) {
-	int i;
-
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		RJ_IssueJobQuitCmd( i );
-	}
-
 	RJ_FinishJobs();
-
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		ri.Thread_Join( job_thread[i] );
-		job_thread[i] = NULL;
-	}
-
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		ri.BufPipe_Destroy( &job_queue[i] );
-	}
-
-	job_count = 0;
-}
-
-/*
-* RJ_IssueJobTakeCmd
-*/
-static void RJ_IssueJobTakeCmd( unsigned thread, jobfunc_t job, jobarg_t *arg, unsigned first, unsigned items ) {
-	jobTakeCmd_t cmd;
-	cmd.id = CMD_JOB_TAKE;
-	cmd.job = job;
-	cmd.job_arg = *arg;
-	cmd.first = first;
-	cmd.items = items;
-	ri.BufPipe_WriteCmd( job_queue[thread], &cmd, sizeof( cmd ) );
-}
-
-/*
- * RJ_IssueJobQuitCmd
- */
-static void RJ_IssueJobQuitCmd( unsigned thread ) {
-	int cmd = CMD_JOB_QUIT;
-	ri.BufPipe_WriteCmd( job_queue[thread], &cmd, sizeof( cmd ) );
-}
-
-/*
-* R_HandleJobTakeCmd
-*/
-static unsigned R_HandleJobTakeCmd( void *pcmd ) {
-	jobTakeCmd_t *cmd = pcmd;
-
-	cmd->job( cmd->first, cmd->items, &cmd->job_arg );
-
-	return sizeof( *cmd );
-}
-
-/*
-* R_HandleJobQuitCmd
-*/
-static unsigned R_HandleJobQuitCmd( void *pcmd ) {
-	return 0;
-}
-
-/*
-* R_JobCmdsWaiter
-*/
-static int R_JobCmdsWaiter( qbufPipe_t *queue, queueCmdHandler_t *cmdHandlers, bool timeout ) {
-	return ri.BufPipe_ReadCmds( queue, (void *)cmdHandlers );
-}
-
-/*
-* R_JobThreadProc
-*/
-static void *R_JobThreadProc( void *param ) {
-	qbufPipe_t *cmdQueue = param;
-	queueCmdHandler_t cmdHandlers[NUM_JOB_CMDS] =
-	{
-		(queueCmdHandler_t)R_HandleJobTakeCmd,
-		(queueCmdHandler_t)R_HandleJobQuitCmd,
-
-	};
-
-	ri.BufPipe_Wait( cmdQueue, R_JobCmdsWaiter, (void*)cmdHandlers, Q_THREADS_WAIT_INFINITE );
-
-	return NULL;
 }
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // r_light.c
 
 #include "r_local.h"
+#include "../qalgo/hash.h"
 
 /*
 =============================================================================
@@ -1273,12 +1274,35 @@ static void R_CompileRtLightVisInfo( rtlight_t *l, mbrushmodel_t *bm, r_lightWor
 }
 
 /*
-* R_GetRtLightVisInfo
+* R_CropRtLightFrustum
+*
+* Updates the frustum of a directional light to only include the visible part of the world
 */
-void R_GetRtLightVisInfo( mbrushmodel_t *bm, rtlight_t *l ) {
+static void R_CropRtLightFrustum( rtlight_t *l ) {
+	vec_t *ob = l->ortho;
+
+	if( !l->directional ) {
+		return;
+	}
+
+	CopyBounds( l->worldmins, l->worldmaxs, l->lightmins, l->lightmaxs );
+
+	R_ProjectFarFrustumCornersOnBounds( l->frustumCorners, l->worldmins, l->worldmaxs );
+
+	R_OrthoFrustumPlanesFromCorners( l->frustumCorners, l->frustum );
+
+	Matrix4_CropMatrixParams( l->frustumCorners, l->worldToLightMatrix, ob );
+	Matrix4_OrthoProjection( ob[0], ob[1], ob[2], ob[3], -ob[5], -ob[4], l->projectionMatrix );
+
+	l->radius = LocalBounds( l->worldmins, l->worldmaxs, NULL, NULL, NULL ) * 2.0;
+}
+
+/*
+* R_ComputeRtLightVisInfo
+*/
+static void R_ComputeRtLightVisInfo( mbrushmodel_t *bm, rtlight_t *l, r_lightWorldVis_t *vis ) {
 	unsigned i;
 	mleaf_t *leaf;
-	r_lightWorldVis_t *vis = &r_lightWorldVis;
 
 	l->area = -1;
 	l->cluster = CLUSTER_INVALID;
@@ -1289,8 +1313,6 @@ void R_GetRtLightVisInfo( mbrushmodel_t *bm, rtlight_t *l ) {
 		l->area = leaf->area;
 	}
 
-	R_AllocLightWorldVis( &r_lightWorldVis, bm );
-
 	R_GetRtLightLeafVisInfo( l, bm->nodes, bm, vis );
 
 	for( i = 0; i < 3; i++ ) {
@@ -1313,20 +1335,371 @@ void R_GetRtLightVisInfo( mbrushmodel_t *bm, rtlight_t *l ) {
 	// limit combined surface box to light boundaries
 	ClipBounds( l->worldmins, l->worldmaxs, l->lightmins, l->lightmaxs );
 
-	// update the frustum to only include the visible part of the world 
-	if( l->directional ) {
-		vec_t *ob = l->ortho;
+	R_CropRtLightFrustum( l );
+}
+
+/*
+* R_GetRtLightVisInfo
+*/
+void R_GetRtLightVisInfo( mbrushmodel_t *bm, rtlight_t *l ) {
+	R_AllocLightWorldVis( &r_lightWorldVis, bm );
+
+	R_ComputeRtLightVisInfo( bm, l, &r_lightWorldVis );
+}
+
+/*
+=============================================================================
+
+WORLD LIGHTS VISIBILITY
+
+Visibility of all world lights is computed in parallel at map load and
+stored in the cache directory, keyed by the map checksum, the lights and
+the surface flags that decide which surfaces are lit and cast shadows.
+
+=============================================================================
+*/
+
+#define RTLIGHTVIS_ID           ( ( 'V' << 24 ) + ( 'L' << 16 ) + ( 'T' << 8 ) + 'R' )
+#define RTLIGHTVIS_VERSION      2
+
+typedef struct {
+	int ident;
+	int version;
+	unsigned key;
+	unsigned numLights;
+	unsigned dataSize;
+} rtLightVisCacheHeader_t;
+
+typedef struct {
+	int cluster;
+	int area;
+	vec3_t worldmins, worldmaxs;
+	unsigned numVisLeafs;
+	unsigned surfaceInfoSize;
+	unsigned numReceiveSurfaces;
+	unsigned numShadowSurfaces;
+} rtLightVisCacheLight_t;
+
+typedef struct {
+	mbrushmodel_t *bm;
+	rtlight_t *lights;
+} rtLightVisJob_t;
+
+/*
+* R_RtLightVisCacheKey
+*/
+static unsigned R_RtLightVisCacheKey( const mbrushmodel_t *bm, const rtlight_t *lights, unsigned numLights ) {
+	unsigned i;
+	unsigned key = RTLIGHTVIS_VERSION;
+
+	key = key * 31 + bm->checksum;
+	key = key * 31 + numLights;
+
+	for( i = 0; i < bm->numsurfaces; i++ ) {
+		const msurface_t *surf = bm->surfaces + i;
+		unsigned bits = ( R_SurfNoDlight( surf ) ? 1 : 0 ) | ( R_SurfNoShadow( surf ) ? 2 : 0 );
+
+		key = key * 31 + bits;
+		key = key * 31 + surf->drawSurf;
+	}
+
+	for( i = 0; i < numLights; i++ ) {
+		const rtlight_t *l = lights + i;
+
+		key = key * 31 + ( l->directional ? 1 : 0 ) + ( l->shadow ? 2 : 0 ) + ( l->sky ? 4 : 0 ) + ( l->rotated ? 8 : 0 );
+		key = key * 31 + COM_SuperFastHash( ( const uint8_t * )l->origin, sizeof( l->origin ) );
+		key = key * 31 + COM_SuperFastHash( ( const uint8_t * )l->axis, sizeof( l->axis ) );
+		key = key * 31 + COM_SuperFastHash( ( const uint8_t * )l->worldToLightMatrix, sizeof( l->worldToLightMatrix ) );
+		key = key * 31 + COM_SuperFastHash( ( const uint8_t * )&l->intensity, sizeof( l->intensity ) );
+		key = key * 31 + COM_SuperFastHash( ( const uint8_t * )l->lightmins, sizeof( l->lightmins ) );
+		key = key * 31 + COM_SuperFastHash( ( const uint8_t * )l->lightmaxs, sizeof( l->lightmaxs ) );
+		if( l->directional ) {
+			key = key * 31 + COM_SuperFastHash( ( const uint8_t * )l->frustumCorners, sizeof( l->frustumCorners ) );
+		}
+	}
+
+	return key;
+}
+
+/*
+* R_RtLightVisCachePath
+*/
+static void R_RtLightVisCachePath( const model_t *model, const char *extension, char *path, size_t size ) {
+	Q_strncpyz( path, model->name, size );
+	COM_ReplaceExtension( path, extension, size );
+}
+
+/*
+* R_RtLightSurfaceInfoSize
+*
+* Returns the number of elements in the compiled surface info of the light.
+*/
+static unsigned R_RtLightSurfaceInfoSize( const rtlight_t *l ) {
+	unsigned i, nds;
+	const unsigned *p = l->surfaceInfo;
+
+	if( !p ) {
+		return 0;
+	}
+
+	nds = *p++;
+	for( i = 0; i < nds; i++ ) {
+		p++;
+		p += 1 + *p * 3;
+	}
+
+	return p - l->surfaceInfo;
+}
+
+/*
+* R_ValidRtLightSurfaceInfo
+*/
+static bool R_ValidRtLightSurfaceInfo( const mbrushmodel_t *bm, const unsigned *info, unsigned size ) {
+	unsigned i, n, ds;
+	unsigned pos = 1;
+
+	if( !size ) {
+		return false;
+	}
+
+	for( i = 0; i < info[0]; i++ ) {
+		if( pos + 2 > size || info[pos] >= bm->numDrawSurfaces ) {
+			return false;
+		}
+
+		ds = info[pos];
+		n = info[pos + 1];
+		pos += 2;
+		if( n > ( size - pos ) / 3 ) {
+			return false;
+		}
+
+		// surfaces must still belong to the draw surface they were grouped under
+		for( ; n > 0; n--, pos += 3 ) {
+			if( info[pos] >= bm->numsurfaces || bm->surfaces[info[pos]].drawSurf != ds + 1 ) {
+				return false;
+			}
+		}
+	}
+
+	return pos == size;
+}
+
+/*
+* R_LoadRtLightVisCache
+*
+* Returns false if the cache is missing or stale, leaving the lights untouched.
+*/
+static bool R_LoadRtLightVisCache( const char *path, mbrushmodel_t *bm, rtlight_t *lights, unsigned numLights, unsigned key ) {
+	unsigned i, j;
+	int len;
+	size_t pos;
+	uint8_t *buffer;
+	const rtLightVisCacheHeader_t *header;
+	const rtLightVisCacheLight_t *in;
+	const unsigned *data;
+
+	len = R_LoadCacheFile( path, ( void ** )&buffer );
+	if( !buffer ) {
+		return false;
+	}
+
+	header = ( const rtLightVisCacheHeader_t * )buffer;
+	if( (size_t)len < sizeof( *header ) || header->ident != RTLIGHTVIS_ID || header->version != RTLIGHTVIS_VERSION
+		|| header->key != key || header->numLights != numLights || header->dataSize != len - sizeof( *header ) ) {
+		R_FreeFile( buffer );
+		ri.Com_DPrintf( "Ignoring stale light visibility cache %s\n", path );
+		return false;
+	}
+
+	// validate everything before touching the lights
+	pos = sizeof( *header );
+	for( i = 0; i < numLights; i++ ) {
+		in = ( const rtLightVisCacheLight_t * )( buffer + pos );
+		if( pos + sizeof( *in ) > (size_t)len ) {
+			break;
+		}
+		pos += sizeof( *in );
+
+		if( in->numVisLeafs > bm->numleafs || in->surfaceInfoSize > ( len - pos ) / sizeof( unsigned ) ) {
+			break;
+		}
+		if( in->numVisLeafs * sizeof( unsigned ) > len - pos - in->surfaceInfoSize * sizeof( unsigned ) ) {
+			break;
+		}
+
+		data = ( const unsigned * )( buffer + pos );
+		for( j = 0; j < in->numVisLeafs; j++ ) {
+			if( data[j] >= bm->numleafs ) {
+				break;
+			}
+		}
+		if( j < in->numVisLeafs ) {
+			break;
+		}
+		if( !R_ValidRtLightSurfaceInfo( bm, data + in->numVisLeafs, in->surfaceInfoSize ) ) {
+			break;
+		}
+
+		pos += ( in->numVisLeafs + in->surfaceInfoSize ) * sizeof( unsigned );
+	}
+
+	if( i < numLights || pos != (size_t)len ) {
+		R_FreeFile( buffer );
+		ri.Com_DPrintf( "Ignoring corrupt light visibility cache %s\n", path );
+		return false;
+	}
+
+	pos = sizeof( *header );
+	for( i = 0; i < numLights; i++ ) {
+		rtlight_t *l = lights + i;
+
+		in = ( const rtLightVisCacheLight_t * )( buffer + pos );
+		data = ( const unsigned * )( buffer + pos + sizeof( *in ) );
+		pos += sizeof( *in ) + ( in->numVisLeafs + in->surfaceInfoSize ) * sizeof( unsigned );
+
+		l->cluster = in->cluster;
+		l->area = in->area;
+		CopyBounds( in->worldmins, in->worldmaxs, l->worldmins, l->worldmaxs );
+
+		l->numVisLeafs = in->numVisLeafs;
+		l->visLeafs = R_RtLightMalloc( l, sizeof( unsigned ) * in->numVisLeafs );
+		memcpy( l->visLeafs, data, sizeof( unsigned ) * in->numVisLeafs );
+
+		l->surfaceInfo = R_RtLightMalloc( l, sizeof( unsigned ) * in->surfaceInfoSize );
+		memcpy( l->surfaceInfo, data + in->numVisLeafs, sizeof( unsigned ) * in->surfaceInfoSize );
+		l->numReceiveSurfaces = in->numReceiveSurfaces;
+		l->numShadowSurfaces = in->numShadowSurfaces;
+
+		R_CropRtLightFrustum( l );
+	}
 
-		CopyBounds( l->worldmins, l->worldmaxs, l->lightmins, l->lightmaxs );
+	R_FreeFile( buffer );
+	return true;
+}
+
+/*
+* R_WriteRtLightVisCache
+*/
+static void R_WriteRtLightVisCache( const char *path, const rtlight_t *lights, unsigned numLights, unsigned key ) {
+	unsigned i;
+	int file;
+	size_t size, pos;
+	uint8_t *buffer;
+	rtLightVisCacheHeader_t *header;
+	rtLightVisCacheLight_t *out;
+
+	size = sizeof( *header );
+	for( i = 0; i < numLights; i++ ) {
+		size += sizeof( *out ) + ( lights[i].numVisLeafs + R_RtLightSurfaceInfoSize( lights + i ) ) * sizeof( unsigned );
+	}
+
+	buffer = R_Malloc( size );
+
+	header = ( rtLightVisCacheHeader_t * )buffer;
+	header->ident = RTLIGHTVIS_ID;
+	header->version = RTLIGHTVIS_VERSION;
+	header->key = key;
+	header->numLights = numLights;
+	header->dataSize = size - sizeof( *header );
+
+	pos = sizeof( *header );
+	for( i = 0; i < numLights; i++ ) {
+		const rtlight_t *l = lights + i;
+
+		out = ( rtLightVisCacheLight_t * )( buffer + pos );
+		out->cluster = l->cluster;
+		out->area = l->area;
+		CopyBounds( l->worldmins, l->worldmaxs, out->worldmins, out->worldmaxs );
+		out->numVisLeafs = l->numVisLeafs;
+		out->surfaceInfoSize = R_RtLightSurfaceInfoSize( l );
+		out->numReceiveSurfaces = l->numReceiveSurfaces;
+		out->numShadowSurfaces = l->numShadowSurfaces;
+		pos += sizeof( *out );
+
+		memcpy( buffer + pos, l->visLeafs, out->numVisLeafs * sizeof( unsigned ) );
+		pos += out->numVisLeafs * sizeof( unsigned );
+
+		memcpy( buffer + pos, l->surfaceInfo, out->surfaceInfoSize * sizeof( unsigned ) );
+		pos += out->surfaceInfoSize * sizeof( unsigned );
+	}
+
+	if( ri.FS_FOpenFile( path, &file, FS_WRITE | FS_CACHE ) == -1 ) {
+		ri.Com_DPrintf( S_COLOR_YELLOW "Could not open %s for writing\n", path );
+	} else {
+		if( (size_t)ri.FS_Write( buffer, size, file ) != size ) {
+			ri.Com_DPrintf( S_COLOR_YELLOW "Failed to write %s\n", path );
+		}
+		ri.FS_FCloseFile( file );
+	}
+
+	R_Free( buffer );
+}
+
+/*
+* R_GetRtLightVisInfoJob
+*/
+static void R_GetRtLightVisInfoJob( unsigned first, unsigned items, jobarg_t *arg ) {
+	unsigned i;
+	r_lightWorldVis_t vis;
+	const rtLightVisJob_t *job = arg->parg;
+
+	// each job works on its own copy of the scratch buffers
+	memset( &vis, 0, sizeof( vis ) );
+	R_AllocLightWorldVis( &vis, job->bm );
+
+	for( i = first; i < first + items; i++ ) {
+		R_ComputeRtLightVisInfo( job->bm, job->lights + i, &vis );
+	}
+
+	R_Free( vis.visLeafs );
+	R_Free( vis.surfMasks );
+	R_Free( vis.drawSurfPvs );
+}
+
+/*
+* R_GetWorldRtLightsVisInfo
+*
+* Computes visibility of the given world lights across the job system, or loads it
+* from <map><extension> in the cache directory if neither the map nor the lights have
+* changed since the file was written.
+*/
+void R_GetWorldRtLightsVisInfo( model_t *model, rtlight_t *lights, unsigned numLights, const char *extension ) {
+	unsigned key = 0;
+	int64_t start;
+	char path[MAX_QPATH];
+	jobarg_t ja;
+	rtLightVisJob_t job;
+	mbrushmodel_t *bm = ( mbrushmodel_t * )model->extradata;
+
+	if( !numLights ) {
+		return;
+	}
+
+	start = ri.Sys_Microseconds();
+
+	R_RtLightVisCachePath( model, extension, path, sizeof( path ) );
+
+	if( r_lightviscache->integer ) {
+		key = R_RtLightVisCacheKey( bm, lights, numLights );
+		if( R_LoadRtLightVisCache( path, bm, lights, numLights, key ) ) {
+			ri.Com_DPrintf( "Loaded visibility of %u lights from %s in %.1f msec\n", numLights, path,
+				( ri.Sys_Microseconds() - start ) * 0.001 );
+			return;
+		}
+	}
 
-		R_ProjectFarFrustumCornersOnBounds( l->frustumCorners, l->worldmins, l->worldmaxs );
+	job.bm = bm;
+	job.lights = lights;
+	ja.parg = &job;
 
-		R_OrthoFrustumPlanesFromCorners( l->frustumCorners, l->frustum );
+	RJ_ScheduleJob( &R_GetRtLightVisInfoJob, &ja, numLights );
+	RJ_FinishJobs();
 
-		Matrix4_CropMatrixParams( l->frustumCorners, l->worldToLightMatrix, ob );
-		Matrix4_OrthoProjection( ob[0], ob[1], ob[2], ob[3], -ob[5], -ob[4], l->projectionMatrix );
+	ri.Com_DPrintf( "Computed visibility of %u lights in %.1f msec\n", numLights, ( ri.Sys_Microseconds() - start ) * 0.001 );
 
-		l->radius = LocalBounds( l->worldmins, l->worldmaxs, NULL, NULL, NULL ) * 2.0;
+	if( r_lightviscache->integer ) {
+		R_WriteRtLightVisCache( path, lights, numLights, key );
 	}
 }
 
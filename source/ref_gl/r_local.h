@@ -340,6 +340,7 @@ typedef struct {
 		unsigned int c_world_lights, c_dynamic_lights;
 		unsigned int c_world_light_shadows, c_dynamic_light_shadows;
 		unsigned int c_ents_total, c_ents_bmodels;
+		unsigned int c_ents_instanced, c_instanced_draws_saved;
 		unsigned int t_cull_world_nodes, t_cull_world_surfs;
 		unsigned int t_cull_rtlights;
 		unsigned int t_world_node, t_light_node;
@@ -397,6 +398,12 @@ extern cvar_t *r_dynamiclight;
 extern cvar_t *r_coronascale;
 extern cvar_t *r_detailtextures;
 extern cvar_t *r_subdivisions;
+extern cvar_t *r_meshcache;
+extern cvar_t *r_shaderindex;
+extern cvar_t *r_imagecache;
+extern cvar_t *r_imagesimd;
+extern cvar_t *r_autoinstancing;
+extern cvar_t *r_lightviscache;
 extern cvar_t *r_showtris;
 extern cvar_t *r_showtris2D;
 extern cvar_t *r_draworder;
@@ -525,6 +532,8 @@ void	R_CacheAliasModelEntity( const entity_t *e );
 bool    R_AddAliasModelToDrawList( const entity_t *e );
 void    R_DrawAliasSurf( const entity_t *e, const shader_t *shader, const mfog_t *fog, int lightStyleNum, 
 	const portalSurface_t *portalSurface, drawSurfaceAlias_t *drawSurf );
+bool    R_AliasSurfInstanceable( const entity_t *e, const drawSurfaceAlias_t *drawSurf );
+void    R_DrawAliasSurfInstances( const drawSurfaceAlias_t *drawSurf, int numInstances, instancePoint_t *instances );
 bool    R_AliasModelLerpTag( orientation_t *orient, const maliasmodel_t *aliasmodel, int framenum, int oldframenum,
 	float lerpfrac, const char *name );
 void        R_AliasModelFrameBounds( const model_t *mod, int frame, vec3_t mins, vec3_t maxs );
@@ -568,6 +577,8 @@ bool	R_CullBoxCustomPlanes( const cplane_t *p, unsigned nump, const vec3_t mins,
 bool	R_CullSphereCustomPlanes( const cplane_t *p, unsigned nump, const vec3_t centre, const float radius, unsigned int clipflags );
 bool    R_CullBox( const vec3_t mins, const vec3_t maxs, const unsigned int clipflags );
 bool    R_CullSphere( const vec3_t centre, const float radius, const unsigned int clipflags );
+unsigned R_CullBoxBatch( const cplane_t *p, unsigned nump, const mbounds_t *bounds, unsigned first, unsigned int clipflags, unsigned *partial );
+void	R_CullBench_f( void );
 bool    R_VisCullBox( const vec3_t mins, const vec3_t maxs );
 bool    R_VisCullSphere( const vec3_t origin, float radius );
 int     R_CullModelEntity( const entity_t *e, bool pvsCull );
@@ -752,6 +763,7 @@ void R_ReserveDrawListWorldSurfaces( drawList_t *list );
 void R_InitDrawLists( void );
 
 void R_SortDrawList( drawList_t *list );
+void R_SortBench_f( void );
 void R_DrawSurfaces( drawList_t *list );
 void R_DrawPortalSurfaces( drawList_t *list );
 void R_DrawSkySurfaces( drawList_t *list );
@@ -842,6 +854,7 @@ void        R_SkeletalGetBonePose( const model_t *mod, int bonenum, int frame, b
 int         R_SkeletalGetNumBones( const model_t *mod, int *numFrames );
 bool        R_SkeletalModelLerpTag( orientation_t *orient, const mskmodel_t *skmodel, int oldframenum, int framenum, float lerpfrac, const char *name );
 void		R_ClearSkeletalCache( void );
+void		R_SkinBench_f( void );
 
 //
 // r_vbo.c
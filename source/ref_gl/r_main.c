@@ -1352,9 +1352,10 @@ void R_RenderView( const refdef_t *fd ) {
 		msec = ri.Sys_Milliseconds();
 	}
 
+	ri.Prof_Enter( "R_DrawEntities" );
 	R_CullEntities();
-
 	R_DrawEntities();
+	ri.Prof_Leave();
 
 	if( r_speeds->integer ) {
 		rf.stats.t_add_entities += ( ri.Sys_Milliseconds() - msec );
@@ -1362,7 +1363,9 @@ void R_RenderView( const refdef_t *fd ) {
 
 	RJ_FinishJobs();
 
+	ri.Prof_Enter( "R_SortDrawList" );
 	R_SortDrawList( rn.meshlist );
+	ri.Prof_Leave();
 
 	R_BindRefInstFBO();
 
@@ -1382,7 +1385,9 @@ void R_RenderView( const refdef_t *fd ) {
 		msec = ri.Sys_Milliseconds();
 	}
 
+	ri.Prof_Enter( "R_DrawSurfaces" );
 	R_DrawSurfaces( rn.meshlist );
+	ri.Prof_Leave();
 
 	if( r_speeds->integer ) {
 		rf.stats.t_draw_meshes += ( ri.Sys_Milliseconds() - msec );
@@ -1699,6 +1704,7 @@ const char *R_WriteSpeedsMessage( char *out, size_t size ) {
 							 "polys\\ents: %5u\\%5u  draw: %5u\n"
 							 "world\\dynamic: lights %3u\\%3u  shadows %3u\\%3u\n"
 							 "ents total: %5u bmodels: %5u\n"
+							 "instanced ents\\saved draws: %5u\\%5u\n"
 							 "frame cache: %.3fMB\n"
 							 "%s",
 							 (int)(1000.0 / rf.frameTime.average),
@@ -1708,6 +1714,7 @@ const char *R_WriteSpeedsMessage( char *out, size_t size ) {
 							 rf.stats.t_add_polys, rf.stats.t_add_entities, rf.stats.t_draw_meshes,
 							 rf.stats.c_world_lights, rf.stats.c_dynamic_lights, rf.stats.c_world_light_shadows, rf.stats.c_dynamic_light_shadows,
 							 rf.stats.c_ents_total, rf.stats.c_ents_bmodels,
+							 rf.stats.c_ents_instanced, rf.stats.c_instanced_draws_saved,
 							 R_FrameCache_TotalSize() / 1048576.0,
 							 backend_msg
 							);
@@ -28,6 +28,12 @@ drawList_t r_shadowportallist;
 drawList_t r_portalmasklist;
 drawList_t r_portallist, r_skyportallist;
 
+static sortedDrawSurf_t *r_capturedDrawSurfs;
+static unsigned r_numCapturedDrawSurfs;
+static bool r_captureDrawList;
+
+static entity_t r_instanceEntity;
+
 /*
 * R_InitDrawList
 */
@@ -39,6 +45,11 @@ void R_InitDrawList( drawList_t *list ) {
 * R_InitDrawLists
 */
 void R_InitDrawLists( void ) {
+	// the capture buffer went away with the renderer mempool
+	r_capturedDrawSurfs = NULL;
+	r_numCapturedDrawSurfs = 0;
+	r_captureDrawList = false;
+
 	R_InitDrawList( &r_worldlist );
 	R_InitDrawList( &r_portalmasklist );
 	R_InitDrawList( &r_portallist );
@@ -287,7 +298,7 @@ portalSurface_t *R_GetDrawListSurfPortal( void *psds ) {
 /*
 * R_DrawSurfCompare
 *
-* Comparison callback function for R_SortDrawList
+* Comparison callback function for qsort, used as a reference by R_SortBench_f
 */
 static int R_DrawSurfCompare( const sortedDrawSurf_t *sbs1, const sortedDrawSurf_t *sbs2 ) {
 	if( sbs1->distKey > sbs2->distKey ) {
@@ -314,19 +325,208 @@ static int R_DrawSurfCompare( const sortedDrawSurf_t *sbs1, const sortedDrawSurf
 	return 0;
 }
 
+#define R_SORT_RADIX_BITS       8
+#define R_SORT_RADIX_SIZE       ( 1 << R_SORT_RADIX_BITS )
+#define R_SORT_KEY_DIGITS       6       // R_PackSortKey only uses the lower 48 bits
+#define R_SORT_DIST_DIGITS      4
+#define R_SORT_NUM_DIGITS       ( R_SORT_KEY_DIGITS + R_SORT_DIST_DIGITS )
+#define R_SORT_MIN_RADIX        64      // insertion sort for shorter lists
+
+/*
+* R_DrawSurfDigit
+*
+* Returns the given radix digit of the combined distKey:sortKey, least significant first.
+*/
+static inline unsigned R_DrawSurfDigit( const sortedDrawSurf_t *sds, int digit ) {
+	if( digit < R_SORT_KEY_DIGITS ) {
+		return ( sds->sortKey >> ( digit * R_SORT_RADIX_BITS ) ) & ( R_SORT_RADIX_SIZE - 1 );
+	}
+	return ( sds->distKey >> ( ( digit - R_SORT_KEY_DIGITS ) * R_SORT_RADIX_BITS ) ) & ( R_SORT_RADIX_SIZE - 1 );
+}
+
+/*
+* R_InsertionSortDrawSurfs
+*/
+static void R_InsertionSortDrawSurfs( sortedDrawSurf_t *drawSurfs, unsigned numDrawSurfs ) {
+	unsigned i, j;
+	sortedDrawSurf_t tmp;
+
+	for( i = 1; i < numDrawSurfs; i++ ) {
+		tmp = drawSurfs[i];
+		for( j = i; j > 0; j-- ) {
+			const sortedDrawSurf_t *prev = &drawSurfs[j - 1];
+			if( prev->distKey < tmp.distKey || ( prev->distKey == tmp.distKey && prev->sortKey <= tmp.sortKey ) ) {
+				break;
+			}
+			drawSurfs[j] = *prev;
+		}
+		drawSurfs[j] = tmp;
+	}
+}
+
+/*
+* R_RadixSortDrawSurfs
+*
+* Stable LSD radix sort on distKey, then sortKey. Digits that are the same
+* for every surface in the list (fogs, lightstyles and portals usually are)
+* are skipped. The scratch buffer must hold numDrawSurfs elements.
+*/
+static void R_RadixSortDrawSurfs( sortedDrawSurf_t *drawSurfs, unsigned numDrawSurfs, sortedDrawSurf_t *scratch ) {
+	int digit;
+	unsigned i, sum, count;
+	unsigned histogram[R_SORT_NUM_DIGITS][R_SORT_RADIX_SIZE];
+	sortedDrawSurf_t *src, *dst, *tmp;
+
+	if( numDrawSurfs < R_SORT_MIN_RADIX ) {
+		R_InsertionSortDrawSurfs( drawSurfs, numDrawSurfs );
+		return;
+	}
+
+	// count all digits in a single pass
+	memset( histogram, 0, sizeof( histogram ) );
+	for( i = 0; i < numDrawSurfs; i++ ) {
+		const sortedDrawSurf_t *sds = &drawSurfs[i];
+		uint64_t sortKey = sds->sortKey;
+		unsigned distKey = sds->distKey;
+
+		for( digit = 0; digit < R_SORT_KEY_DIGITS; digit++, sortKey >>= R_SORT_RADIX_BITS ) {
+			histogram[digit][sortKey & ( R_SORT_RADIX_SIZE - 1 )]++;
+		}
+		for( ; digit < R_SORT_NUM_DIGITS; digit++, distKey >>= R_SORT_RADIX_BITS ) {
+			histogram[digit][distKey & ( R_SORT_RADIX_SIZE - 1 )]++;
+		}
+	}
+
+	src = drawSurfs;
+	dst = scratch;
+	for( digit = 0; digit < R_SORT_NUM_DIGITS; digit++ ) {
+		unsigned *offsets = histogram[digit];
+
+		if( offsets[R_DrawSurfDigit( src, digit )] == numDrawSurfs ) {
+			continue;
+		}
+
+		// turn counts into offsets
+		for( i = 0, sum = 0; i < R_SORT_RADIX_SIZE; i++ ) {
+			count = offsets[i];
+			offsets[i] = sum;
+			sum += count;
+		}
+
+		for( i = 0; i < numDrawSurfs; i++ ) {
+			dst[offsets[R_DrawSurfDigit( &src[i], digit )]++] = src[i];
+		}
+
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	if( src != drawSurfs ) {
+		memcpy( drawSurfs, src, numDrawSurfs * sizeof( *drawSurfs ) );
+	}
+}
+
 /*
 * R_SortDrawList
 *
-* Regular quicksort. Note that for all kinds of transparent meshes
-* you probably want to set distance or draw order to prevent flickering
-* due to quicksort's unstable nature.
+* Stable radix sort on the packed keys, so surfaces with equal keys keep
+* the order they were added in and transparent meshes don't flicker.
 */
 void R_SortDrawList( drawList_t *list ) {
+	void *cacheMark;
+	sortedDrawSurf_t *scratch;
+
 	if( r_draworder->integer ) {
 		return;
 	}
-	qsort( list->drawSurfs, list->numDrawSurfs, sizeof( sortedDrawSurf_t ),
-		   ( int ( * )( const void *, const void * ) )R_DrawSurfCompare );
+
+	if( r_captureDrawList && list == &r_worldlist ) {
+		if( r_capturedDrawSurfs ) {
+			R_Free( r_capturedDrawSurfs );
+		}
+		r_numCapturedDrawSurfs = list->numDrawSurfs;
+		r_capturedDrawSurfs = R_Malloc( max( r_numCapturedDrawSurfs, 1 ) * sizeof( sortedDrawSurf_t ) );
+		memcpy( r_capturedDrawSurfs, list->drawSurfs, r_numCapturedDrawSurfs * sizeof( sortedDrawSurf_t ) );
+		r_captureDrawList = false;
+	}
+
+	if( list->numDrawSurfs < R_SORT_MIN_RADIX ) {
+		R_InsertionSortDrawSurfs( list->drawSurfs, list->numDrawSurfs );
+		return;
+	}
+
+	cacheMark = R_FrameCache_SetMark();
+	scratch = R_FrameCache_Alloc( list->numDrawSurfs * sizeof( sortedDrawSurf_t ) );
+	R_RadixSortDrawSurfs( list->drawSurfs, list->numDrawSurfs, scratch );
+	R_FrameCache_FreeToMark( cacheMark );
+}
+
+/*
+* R_SortBench_f
+*
+* r_sortbench [iterations]
+*
+* Times qsort against the radix sort on the world draw list captured from the
+* previous frame and checks that both produce the same key order. The first
+* invocation only arms the capture.
+*/
+void R_SortBench_f( void ) {
+	int i, iterations;
+	unsigned j, n;
+	size_t size;
+	sortedDrawSurf_t *work, *reference, *scratch;
+	int64_t start, qsortTime, radixTime;
+
+	if( !r_capturedDrawSurfs ) {
+		Com_Printf( "Capturing the world draw list on the next frame, run %s again to benchmark it\n", ri.Cmd_Argv( 0 ) );
+		r_captureDrawList = true;
+		return;
+	}
+
+	iterations = ri.Cmd_Argc() > 1 ? atoi( ri.Cmd_Argv( 1 ) ) : 100;
+	iterations = max( iterations, 1 );
+
+	n = r_numCapturedDrawSurfs;
+	size = max( n, 1 ) * sizeof( sortedDrawSurf_t );
+	work = R_Malloc( size );
+	reference = R_Malloc( size );
+	scratch = R_Malloc( size );
+
+	qsortTime = 0;
+	for( i = 0; i < iterations; i++ ) {
+		memcpy( work, r_capturedDrawSurfs, n * sizeof( sortedDrawSurf_t ) );
+		start = ri.Sys_Microseconds();
+		qsort( work, n, sizeof( sortedDrawSurf_t ), ( int ( * )( const void *, const void * ) )R_DrawSurfCompare );
+		qsortTime += ri.Sys_Microseconds() - start;
+	}
+	memcpy( reference, work, n * sizeof( sortedDrawSurf_t ) );
+
+	radixTime = 0;
+	for( i = 0; i < iterations; i++ ) {
+		memcpy( work, r_capturedDrawSurfs, n * sizeof( sortedDrawSurf_t ) );
+		start = ri.Sys_Microseconds();
+		R_RadixSortDrawSurfs( work, n, scratch );
+		radixTime += ri.Sys_Microseconds() - start;
+	}
+
+	for( j = 0; j < n; j++ ) {
+		if( work[j].distKey != reference[j].distKey || work[j].sortKey != reference[j].sortKey ) {
+			break;
+		}
+	}
+
+	Com_Printf( "%u draw surfaces, %i iterations\n", n, iterations );
+	Com_Printf( "qsort: %.1f usec, radix: %.1f usec\n", (double)qsortTime / iterations, (double)radixTime / iterations );
+	if( j < n ) {
+		Com_Printf( S_COLOR_RED "Key order mismatch at surface %u\n", j );
+	}
+
+	R_Free( work );
+	R_Free( reference );
+	R_Free( scratch );
+
+	r_captureDrawList = true;
 }
 
 static const drawSurf_cb r_drawSurfCb[ST_MAX_TYPES] =
@@ -425,6 +625,92 @@ static const flushBatchDrawSurf_cb r_flushBatchSurfCb[ST_MAX_TYPES] =
 	NULL,
 };
 
+/*
+* R_SurfEntitiesInstanceable
+*
+* Entities can share an instanced draw call if everything the shader reads
+* from them, apart from the transform, is the same.
+*/
+static bool R_SurfEntitiesInstanceable( const entity_t *e, const entity_t *first ) {
+	return e->renderfx == first->renderfx && e->shaderTime == first->shaderTime &&
+		!memcmp( e->shaderRGBA, first->shaderRGBA, sizeof( e->shaderRGBA ) ) &&
+		e->outlineHeight == first->outlineHeight &&
+		!memcmp( e->outlineRGBA, first->outlineRGBA, sizeof( e->outlineRGBA ) );
+}
+
+/*
+* R_GatherSurfInstances
+*
+* Collects the draw surfaces following the given one which only differ
+* in entity transform and stores world space instance points for all of them.
+* Returns the number of instances, less than 2 if the surface should be drawn normally.
+*/
+static int R_GatherSurfInstances( const drawList_t *list, unsigned first, int mode, instancePoint_t *instances ) {
+	unsigned i;
+	int numInstances;
+	const uint64_t entMask = (uint64_t)0xFFF << 8;
+	const sortedDrawSurf_t *sds = list->drawSurfs + first, *next;
+	const entity_t *e, *ne;
+	unsigned shaderNum;
+	int fogNum, lightStyle, portalNum;
+	unsigned entNum;
+	const shader_t *shader;
+
+	if( *(int *)sds->drawSurf != ST_ALIAS ) {
+		return 0;
+	}
+
+	R_UnpackSortKey( sds->sortKey, &shaderNum, &fogNum, &lightStyle, &portalNum, &entNum );
+	shader = R_ShaderById( shaderNum );
+	e = R_NUM2ENT( entNum );
+
+	// per-entity fog and portal state can't be expressed as instance data
+	if( fogNum >= 0 || portalNum >= 0 || ( shader->flags & SHADER_AUTOSPRITE ) ) {
+		return 0;
+	}
+	if( e->rtype != RT_MODEL || ( e->flags & ( RF_WEAPONMODEL|RF_CULLHACK ) ) ) {
+		return 0;
+	}
+
+	// lighting is only sampled at the first entity
+	if( r_autoinstancing->integer < 2 && !( e->renderfx & RF_FULLBRIGHT ) &&
+		mode != RB_MODE_DEPTH && !( rn.renderFlags & RF_SHADOWMAPVIEW ) ) {
+		return 0;
+	}
+
+	if( !R_AliasSurfInstanceable( e, ( const drawSurfaceAlias_t * )sds->drawSurf ) ) {
+		return 0;
+	}
+
+	numInstances = 0;
+	for( i = first; i < list->numDrawSurfs && numInstances < MAX_GLSL_UNIFORM_INSTANCES; i++ ) {
+		next = list->drawSurfs + i;
+		if( next->drawSurf != sds->drawSurf || next->distKey != sds->distKey ) {
+			break;
+		}
+		if( ( next->sortKey & ~entMask ) != ( sds->sortKey & ~entMask ) ) {
+			break;
+		}
+
+		ne = R_NUM2ENT( ( next->sortKey & entMask ) >> 8 );
+		if( ne != e ) {
+			if( ne->flags & RF_CULLHACK || !R_SurfEntitiesInstanceable( ne, e ) ) {
+				break;
+			}
+			if( !R_AliasSurfInstanceable( ne, ( const drawSurfaceAlias_t * )next->drawSurf ) ) {
+				break;
+			}
+		}
+
+		Quat_FromMatrix3( ne->axis, instances[numInstances] );
+		VectorCopy( ne->origin, &instances[numInstances][4] );
+		instances[numInstances][7] = ne->scale;
+		numInstances++;
+	}
+
+	return numInstances;
+}
+
 /*
 * R_DrawSurfaces
 */
@@ -454,6 +740,8 @@ static void _R_DrawSurfaces( drawList_t *list, bool *depthCopied, int mode, int
 	int entityFX = 0, prevEntityFX = -1;
 	mat4_t projectionMatrix;
 	int riFBO = 0;
+	int numInstances;
+	instancePoint_t instances[MAX_GLSL_UNIFORM_INSTANCES];
 
 	if( !list ) {
 		return;
@@ -602,15 +890,41 @@ static void _R_DrawSurfaces( drawList_t *list, bool *depthCopied, int mode, int
 				}
 			}
 
+			numInstances = 0;
 			if( !batchDrawSurf ) {
 				assert( r_drawSurfCb[drawSurfType] );
 
-				RB_BindShader( entity, shader, fog );
-
-				RB_SetPortalSurface( portalSurface );
+				if( r_autoinstancing->integer ) {
+					numInstances = R_GatherSurfInstances( list, i, mode, instances );
+				}
 
 				batchFlush = NULL;
-				r_drawSurfCb[drawSurfType]( entity, shader, fog, lightStyle, portalSurface, sds->drawSurf );
+
+				if( numInstances > 1 ) {
+					// instance points are in world space, so the shader is bound to
+					// a copy of the first entity with identity transform
+					r_instanceEntity = *entity;
+					VectorClear( r_instanceEntity.origin );
+					Matrix3_Identity( r_instanceEntity.axis );
+					r_instanceEntity.scale = 1;
+
+					R_TransformForWorld();
+
+					RB_BindShader( &r_instanceEntity, shader, fog );
+
+					RB_SetPortalSurface( portalSurface );
+
+					R_DrawAliasSurfInstances( ( const drawSurfaceAlias_t * )sds->drawSurf, numInstances, instances );
+
+					rf.stats.c_ents_instanced += numInstances;
+					rf.stats.c_instanced_draws_saved += numInstances - 1;
+				} else {
+					RB_BindShader( entity, shader, fog );
+
+					RB_SetPortalSurface( portalSurface );
+
+					r_drawSurfCb[drawSurfType]( entity, shader, fog, lightStyle, portalSurface, sds->drawSurf );
+				}
 			}
 
 			prevShaderNum = shaderNum;
@@ -621,6 +935,12 @@ static void _R_DrawSurfaces( drawList_t *list, bool *depthCopied, int mode, int
 			prevInfiniteProj = infiniteProj;
 			prevEntityFX = entityFX;
 			prevLightStyle = lightStyle;
+
+			if( numInstances > 1 ) {
+				// skip the merged surfaces and make sure the next one loads its own transform
+				i += numInstances - 1;
+				prevEntNum = MAX_REF_ENTITIES;
+			}
 		}
 
 		if( batchDrawSurf ) {
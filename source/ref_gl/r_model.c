@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // r_model.c -- model loading and caching
 
 #include "r_local.h"
+#include "../qalgo/hash.h"
 #include "iqm.h"
 
 typedef struct {
@@ -206,6 +207,53 @@ static void Mod_CreateVisLeafs( model_t *mod ) {
 	}
 }
 
+/*
+* Mod_AllocBounds
+*/
+static void Mod_AllocBounds( model_t *mod, mbounds_t *bounds, unsigned count ) {
+	unsigned j;
+	float *data;
+
+	bounds->numBounds = ( max( count, 1 ) + R_CULL_BATCH - 1 ) & ~( R_CULL_BATCH - 1 );
+
+	data = Mod_Malloc( mod, bounds->numBounds * 6 * sizeof( float ) );
+	for( j = 0; j < 3; j++ ) {
+		bounds->mins[j] = data + bounds->numBounds * j;
+		bounds->maxs[j] = data + bounds->numBounds * ( j + 3 );
+	}
+}
+
+/*
+* Mod_CreateCullBounds
+*
+* Copies leaf and surface bounds into structure-of-arrays form for R_CullBoxBatch.
+*/
+static void Mod_CreateCullBounds( model_t *mod ) {
+	unsigned i, j;
+	mbounds_t *bounds;
+	mbrushmodel_t *loadbmodel = ( ( mbrushmodel_t * )mod->extradata );
+
+	bounds = &loadbmodel->leafBounds;
+	Mod_AllocBounds( mod, bounds, loadbmodel->numleafs );
+	for( i = 0; i < loadbmodel->numleafs; i++ ) {
+		const mleaf_t *leaf = loadbmodel->leafs + i;
+		for( j = 0; j < 3; j++ ) {
+			bounds->mins[j][i] = leaf->mins[j];
+			bounds->maxs[j][i] = leaf->maxs[j];
+		}
+	}
+
+	bounds = &loadbmodel->surfBounds;
+	Mod_AllocBounds( mod, bounds, loadbmodel->numsurfaces );
+	for( i = 0; i < loadbmodel->numsurfaces; i++ ) {
+		const msurface_t *surf = loadbmodel->surfaces + i;
+		for( j = 0; j < 3; j++ ) {
+			bounds->mins[j][i] = surf->mins[j];
+			bounds->maxs[j][i] = surf->maxs[j];
+		}
+	}
+}
+
 /*
 * Mod_CalculateAutospriteBounds
 *
@@ -732,6 +780,8 @@ static void Mod_FinalizeBrushModel( model_t *model ) {
 
 	Mod_CreateVisLeafs( model );
 
+	Mod_CreateCullBounds( model );
+
 	Mod_CreateVertexBufferObjects( model );
 
 	Mod_SetupSubmodels( model );
@@ -1031,6 +1081,10 @@ model_t *Mod_ForName( const char *name, bool crash ) {
 	}
 
 	descr->loader( mod, NULL, buf, bspFormat );
+	if( mod_isworldmodel && mod->type == mod_brush ) {
+		// keys data cached for this map, such as realtime light visibility
+		( ( mbrushmodel_t * )mod->extradata )->checksum = COM_SuperFastHash( ( const uint8_t * )buf, modfilelen );
+	}
 	R_FreeFile( buf );
 
 	if( mod->type == mod_bad ) {
@@ -1314,11 +1368,11 @@ static void R_LoadWorldRtLightsFromMap( model_t *model ) {
 			if( cubemap[0] != '\0' ) {
 				l->cubemapFilter = R_FindImage( cubemap, NULL, IT_SRGB | IT_CLAMP | IT_CUBEMAP, 1, IMAGE_TAG_WORLD, NULL );
 			}
-
-			R_GetRtLightVisInfo( bmodel, l );
 		}
 	}
 
+	R_GetWorldRtLightsVisInfo( model, lights, numLights, ".rtlightvis" );
+
 	bmodel->numRtLights = numLights;
 	if( numLights ) {
 		bmodel->rtLights = Mod_Malloc( model, numLights * sizeof( rtlight_t ) );
@@ -1451,8 +1505,6 @@ static void R_LoadWorldRtLights( model_t *model ) {
 			l->cubemapFilter = R_FindImage( cubemap, NULL, IT_SRGB | IT_CLAMP | IT_CUBEMAP, 1, IMAGE_TAG_WORLD, NULL );
 		}
 
-		R_GetRtLightVisInfo( bmodel, l );
-
 		if( *s == '\r' )
 			s++;
 		if( *s == '\n' )
@@ -1460,6 +1512,8 @@ static void R_LoadWorldRtLights( model_t *model ) {
 		n++;
 	}
 
+	R_GetWorldRtLightsVisInfo( model, lights, numLights, ".rtlightvis" );
+
 	bmodel->numRtLights = numLights;
 	if( numLights ) {
 		bmodel->rtLights = Mod_Malloc( model, numLights * sizeof( rtlight_t ) );
@@ -1756,8 +1810,13 @@ static void R_LoadWorldRtSkyLights( model_t *model ) {
 		l->sky = true;
 		l->cascaded = true;
 		VectorCopy( shaderColor, l->skycolor );
+	}
 
-		R_GetRtLightVisInfo( bmodel, l );
+	R_GetWorldRtLightsVisInfo( model, bmodel->rtSkyLights, numskies, ".rtskylightvis" );
+
+	for( i = 0; i < numskies; i++ ) {
+		rtlight_t *l = &bmodel->rtSkyLights[i];
+		mbrushsky_t *sky = &skies[i];
 
 		CopyBounds( sky->skymins, sky->skymaxs, l->skymins, l->skymaxs );
 
@@ -133,8 +133,22 @@ typedef struct {
 	uint8_t direction[2];
 } mgridlight_t;
 
+#define R_CULL_BATCH    4
+
+/*
+* Bounding boxes in structure-of-arrays layout for batched frustum culling.
+* The arrays are padded to a multiple of R_CULL_BATCH elements with empty
+* boxes at the origin, numBounds includes the padding.
+*/
+typedef struct {
+	unsigned numBounds;
+	float *mins[3];
+	float *maxs[3];
+} mbounds_t;
+
 typedef struct mbrushmodel_s {
 	const bspFormatDesc_t *format;
+	unsigned checksum;                  // of the whole BSP file, only set for the world model
 
 	dvis_t          *pvs;
 
@@ -161,6 +175,9 @@ typedef struct mbrushmodel_s {
 
 	unsigned int numsurfaces;
 	msurface_t      *surfaces;
+
+	mbounds_t leafBounds;
+	mbounds_t surfBounds;
 	int				*surfTraceFrames;		// for multi-check avoidance
 	int				*surfFragmentFrames;	// for multi-check avoidance
 
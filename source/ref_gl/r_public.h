@@ -22,7 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "../cgame/ref.h"
 
-#define REF_API_VERSION 24
+#define REF_API_VERSION 27
 
 //
 // these are the functions exported by the refresh module
@@ -79,6 +79,7 @@ typedef struct {
 	int ( *FS_GetFileList )( const char *dir, const char *extension, char *buf, size_t bufsize, int start, int end );
 	int ( *FS_GetGameDirectoryList )( char *buf, size_t bufsize );
 	const char *( *FS_FirstExtension )( const char *filename, const char *extensions[], int num_extensions );
+	void ( *FS_PrefetchFiles )( const char **filenames, int numFiles );
 	bool ( *FS_MoveFile )( const char *src, const char *dst );
 	bool ( *FS_IsUrl )( const char *url );
 	time_t ( *FS_FileMTime )( const char *filename );
@@ -121,6 +122,16 @@ typedef struct {
 	int ( *BufPipe_ReadCmds )( struct qbufPipe_s *queue, unsigned( **cmdHandlers )( const void * ) );
 	void ( *BufPipe_Wait )( struct qbufPipe_s *queue, int ( *read )( struct qbufPipe_s *, unsigned( ** )( const void * ), bool ),
 							unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec );
+
+	// job system
+	int ( *Jobs_NumWorkers )( void );
+	void ( *Jobs_Schedule )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+							 unsigned items, unsigned granularity, volatile int *counter );
+	void ( *Jobs_Wait )( volatile int *counter );
+
+	// profiler
+	void ( *Prof_Enter )( const char *name );
+	void ( *Prof_Leave )( void );
 } ref_import_t;
 
 typedef struct {
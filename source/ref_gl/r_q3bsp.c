@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // r_q3bsp.c -- Q3 BSP model loading
 
 #include "r_local.h"
+#include "../qalgo/hash.h"
 
 typedef struct {
 	vec3_t mins, maxs;
@@ -535,6 +536,42 @@ static void Mod_LoadSubmodels( const lump_t *l ) {
 	}
 }
 
+/*
+* Mod_PrefetchShaderrefs
+*
+* Have the filesystem decompress implicit world textures in the background
+* while the rest of the BSP is being loaded.
+*/
+static void Mod_PrefetchShaderrefs( const mshaderref_t *shaderrefs, int count ) {
+	int i, numFiles;
+	const char *extension;
+	char *names;
+	const char **files;
+
+	names = R_Malloc( count * MAX_QPATH );
+	files = R_Malloc( count * sizeof( *files ) );
+
+	for( i = 0, numFiles = 0; i < count; i++ ) {
+		char *name = names + numFiles * MAX_QPATH;
+
+		Q_strncpyz( name, shaderrefs[i].name, MAX_QPATH );
+		extension = ri.FS_FirstExtension( name, IMAGE_EXTENSIONS, NUM_IMAGE_EXTENSIONS - 1 );
+		if( !extension ) {
+			continue;
+		}
+
+		COM_ReplaceExtension( name, extension, MAX_QPATH );
+		files[numFiles++] = name;
+	}
+
+	if( numFiles ) {
+		ri.FS_PrefetchFiles( files, numFiles );
+	}
+
+	R_Free( files );
+	R_Free( names );
+}
+
 /*
 * Mod_LoadShaderrefs
 */
@@ -566,6 +603,8 @@ static void Mod_LoadShaderrefs( const lump_t *l ) {
 		}
 	}
 
+	Mod_PrefetchShaderrefs( out, count );
+
 	// free world textures from the previous map that are not used on the new map
 	if( newMap ) {
 		const shaderType_e shaderTypes[] = { SHADER_TYPE_DELUXEMAP, SHADER_TYPE_VERTEX };
@@ -979,6 +1018,397 @@ void Mod_CreateMeshForSurface( const rdface_t *in, msurface_t *out, int patchGro
 	}
 }
 
+/*
+===============================================================================
+
+SURFACE MESH CACHE
+
+Tessellated patches and surface meshes with tangent vectors are stored in
+the cache directory after the first load of a map, keyed by a hash of the
+BSP geometry lumps and the settings that affect mesh creation.
+
+===============================================================================
+*/
+
+#define MESHCACHE_ID            ( ( 'C' << 24 ) + ( 'M' << 16 ) + ( 'S' << 8 ) + 'W' )
+#define MESHCACHE_VERSION       1
+#define MESHCACHE_ALIGN         16
+
+#define MESHCACHE_FLAG_FULLBRIGHT       1
+#define MESHCACHE_FLAG_GRAYSCALE        2
+#define MESHCACHE_FLAG_LIGHTMAPARRAYS   4
+#define MESHCACHE_FLAG_VERTEXLIGHT      8
+
+enum {
+	MESHCACHE_XYZ,
+	MESHCACHE_NORMALS,
+	MESHCACHE_SVECTORS,
+	MESHCACHE_ST,
+	MESHCACHE_LMST,
+	MESHCACHE_LMLAYERS = MESHCACHE_LMST + MAX_LIGHTMAPS,
+	MESHCACHE_COLORS = MESHCACHE_LMLAYERS + ( MAX_LIGHTMAPS + 3 ) / 4,
+	MESHCACHE_ELEMS = MESHCACHE_COLORS + MAX_LIGHTMAPS,
+	MESHCACHE_INSTANCES,
+
+	MESHCACHE_NUM_ARRAYS
+};
+
+typedef struct {
+	int ident;
+	int version;
+	unsigned key;
+	unsigned numSurfaces;
+	float subdivLevel;
+	int flags;
+	unsigned dataOffset;
+	unsigned dataSize;
+} meshCacheHeader_t;
+
+typedef struct {
+	int facetype;
+	unsigned numVerts;
+	unsigned numElems;
+	unsigned numInstances;
+	vec4_t plane;
+	int offsets[MESHCACHE_NUM_ARRAYS];      // relative to dataOffset, -1 if not present
+} meshCacheSurface_t;
+
+static unsigned loadmodel_meshcachekey;
+
+/*
+* Mod_MeshCacheKey
+*
+* Hashes the lumps Mod_CreateMeshForSurface depends on.
+*/
+static unsigned Mod_MeshCacheKey( const lump_t *lumps ) {
+	unsigned i;
+	unsigned key = MESHCACHE_VERSION;
+	const int lumpnums[] = { LUMP_FACES, LUMP_VERTEXES, LUMP_ELEMENTS, LUMP_SHADERREFS };
+
+	for( i = 0; i < sizeof( lumpnums ) / sizeof( lumpnums[0] ); i++ ) {
+		const lump_t *l = &lumps[lumpnums[i]];
+
+		key = key * 31 + l->filelen;
+		key = key * 31 + COM_SuperFastHash( mod_base + l->fileofs, l->filelen );
+	}
+
+	return key;
+}
+
+/*
+* Mod_MeshCachePath
+*/
+static void Mod_MeshCachePath( char *path, size_t size ) {
+	Q_strncpyz( path, loadmodel->name, size );
+	COM_ReplaceExtension( path, ".meshcache", size );
+}
+
+/*
+* Mod_InitMeshCacheHeader
+*/
+static void Mod_InitMeshCacheHeader( meshCacheHeader_t *header ) {
+	memset( header, 0, sizeof( *header ) );
+
+	header->ident = MESHCACHE_ID;
+	header->version = MESHCACHE_VERSION;
+	header->key = loadmodel_meshcachekey;
+	header->numSurfaces = loadbmodel->numsurfaces;
+	header->subdivLevel = Q_bound( SUBDIVISIONS_MIN, r_subdivisions->value, SUBDIVISIONS_MAX );
+	if( r_fullbright->integer ) {
+		header->flags |= MESHCACHE_FLAG_FULLBRIGHT;
+	}
+	if( r_lighting_grayscale->integer ) {
+		header->flags |= MESHCACHE_FLAG_GRAYSCALE;
+	}
+	if( mapConfig.lightmapArrays ) {
+		header->flags |= MESHCACHE_FLAG_LIGHTMAPARRAYS;
+	}
+	if( r_lighting_vertexlight->integer ) {
+		header->flags |= MESHCACHE_FLAG_VERTEXLIGHT;
+	}
+	header->dataOffset = Q_ALIGN( sizeof( *header ) + sizeof( meshCacheSurface_t ) * header->numSurfaces, MESHCACHE_ALIGN );
+}
+
+/*
+* Mod_MeshCacheArray
+*
+* Returns the address of the given array pointer of the surface mesh and the array size in bytes.
+*/
+static void **Mod_MeshCacheArray( msurface_t *surf, int array, size_t *size ) {
+	mesh_t *mesh = &surf->mesh;
+
+	if( array == MESHCACHE_XYZ ) {
+		*size = mesh->numVerts * sizeof( vec4_t );
+		return ( void ** )&mesh->xyzArray;
+	}
+	if( array == MESHCACHE_NORMALS ) {
+		*size = mesh->numVerts * sizeof( vec4_t );
+		return ( void ** )&mesh->normalsArray;
+	}
+	if( array == MESHCACHE_SVECTORS ) {
+		*size = mesh->numVerts * sizeof( vec4_t );
+		return ( void ** )&mesh->sVectorsArray;
+	}
+	if( array == MESHCACHE_ST ) {
+		*size = mesh->numVerts * sizeof( vec2_t );
+		return ( void ** )&mesh->stArray;
+	}
+	if( array < MESHCACHE_LMLAYERS ) {
+		*size = mesh->numVerts * sizeof( vec2_t );
+		return ( void ** )&mesh->lmstArray[array - MESHCACHE_LMST];
+	}
+	if( array < MESHCACHE_COLORS ) {
+		*size = mesh->numVerts * sizeof( byte_vec4_t );
+		return ( void ** )&mesh->lmlayersArray[array - MESHCACHE_LMLAYERS];
+	}
+	if( array < MESHCACHE_ELEMS ) {
+		*size = mesh->numVerts * sizeof( byte_vec4_t );
+		return ( void ** )&mesh->colorsArray[array - MESHCACHE_COLORS];
+	}
+	if( array == MESHCACHE_ELEMS ) {
+		*size = mesh->numElems * sizeof( elem_t );
+		return ( void ** )&mesh->elems;
+	}
+	*size = surf->numInstances * sizeof( instancePoint_t );
+	return ( void ** )&surf->instances;
+}
+
+/*
+* Mod_MeshCacheArrayRequired
+*
+* Returns whether Mod_CreateMeshForSurface would have created the given array for the face.
+*/
+static bool Mod_MeshCacheArrayRequired( const rdface_t *in, int array ) {
+	int j, numLightmaps;
+
+	if( array < MESHCACHE_LMST ) {
+		return true;
+	}
+	if( array >= MESHCACHE_ELEMS ) {
+		return array == MESHCACHE_ELEMS;
+	}
+
+	if( array >= MESHCACHE_COLORS ) {
+		for( j = 0; j <= array - MESHCACHE_COLORS; j++ ) {
+			if( in->vertexStyles[j] == 255 ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	for( numLightmaps = 0; numLightmaps < MAX_LIGHTMAPS; numLightmaps++ ) {
+		if( in->lightmapStyles[numLightmaps] == 255 || LittleLong( in->lm_texnum[numLightmaps] ) < 0 ) {
+			break;
+		}
+	}
+
+	if( array < MESHCACHE_LMLAYERS ) {
+		return array - MESHCACHE_LMST < numLightmaps;
+	}
+	return mapConfig.lightmapArrays && ( array - MESHCACHE_LMLAYERS ) * 4 < numLightmaps;
+}
+
+/*
+* Mod_LoadMeshCache
+*
+* Reads the whole cache file into a single block and points surface meshes into it.
+* Returns false if the cache is missing or stale, leaving the surfaces untouched.
+*/
+static bool Mod_LoadMeshCache( void ) {
+	unsigned i, j;
+	int file, len;
+	size_t size;
+	uint8_t *block, *data;
+	char path[MAX_QPATH];
+	meshCacheHeader_t header, fileHeader;
+	meshCacheSurface_t *surfs, *in;
+	msurface_t *surf;
+
+	if( !r_meshcache->integer ) {
+		return false;
+	}
+
+	Mod_MeshCachePath( path, sizeof( path ) );
+	len = ri.FS_FOpenFile( path, &file, FS_READ | FS_CACHE );
+	if( len < 0 ) {
+		return false;
+	}
+
+	Mod_InitMeshCacheHeader( &header );
+
+	if( (size_t)len < header.dataOffset
+		|| ri.FS_Read( &fileHeader, sizeof( fileHeader ), file ) != sizeof( fileHeader )
+		|| memcmp( &header, &fileHeader, offsetof( meshCacheHeader_t, dataSize ) )
+		|| fileHeader.dataSize != len - header.dataOffset ) {
+		ri.FS_FCloseFile( file );
+		ri.Com_DPrintf( "Ignoring stale mesh cache %s\n", path );
+		return false;
+	}
+
+	block = Mod_Malloc( loadmodel, len );
+	memcpy( block, &fileHeader, sizeof( fileHeader ) );
+	if( ri.FS_Read( block + sizeof( fileHeader ), len - sizeof( fileHeader ), file ) != (int)( len - sizeof( fileHeader ) ) ) {
+		ri.FS_FCloseFile( file );
+		R_Free( block );
+		return false;
+	}
+	ri.FS_FCloseFile( file );
+
+	surfs = ( meshCacheSurface_t * )( block + sizeof( fileHeader ) );
+	data = block + header.dataOffset;
+
+	// validate everything before touching the surfaces
+	for( i = 0, in = surfs, surf = loadbmodel->surfaces; i < header.numSurfaces; i++, in++, surf++ ) {
+		msurface_t test;
+
+		if( in->facetype != surf->facetype ) {
+			break;
+		}
+
+		memset( &test, 0, sizeof( test ) );
+		test.mesh.numVerts = in->numVerts;
+		test.mesh.numElems = in->numElems;
+		test.numInstances = in->numInstances;
+
+		for( j = 0; j < MESHCACHE_NUM_ARRAYS; j++ ) {
+			Mod_MeshCacheArray( &test, j, &size );
+			if( in->offsets[j] < 0 ) {
+				// everything that is going to be read from the mesh must be there
+				if( size && Mod_MeshCacheArrayRequired( &loadmodel_dsurfaces[i], j ) ) {
+					break;
+				}
+				continue;
+			}
+			if( in->offsets[j] % MESHCACHE_ALIGN || (size_t)in->offsets[j] + size > fileHeader.dataSize ) {
+				break;
+			}
+		}
+		if( j < MESHCACHE_NUM_ARRAYS ) {
+			break;
+		}
+
+		if( in->offsets[MESHCACHE_ELEMS] >= 0 ) {
+			const elem_t *elems = ( const elem_t * )( data + in->offsets[MESHCACHE_ELEMS] );
+
+			for( j = 0; j < in->numElems; j++ ) {
+				if( elems[j] >= in->numVerts ) {
+					break;
+				}
+			}
+			if( j < in->numElems ) {
+				break;
+			}
+		}
+	}
+
+	if( i < header.numSurfaces ) {
+		R_Free( block );
+		ri.Com_DPrintf( "Ignoring corrupt mesh cache %s\n", path );
+		return false;
+	}
+
+	for( i = 0, in = surfs, surf = loadbmodel->surfaces; i < header.numSurfaces; i++, in++, surf++ ) {
+		memset( &surf->mesh, 0, sizeof( surf->mesh ) );
+		surf->mesh.numVerts = in->numVerts;
+		surf->mesh.numElems = in->numElems;
+
+		if( in->numInstances ) {
+			surf->numInstances = in->numInstances;
+		}
+		if( surf->facetype == FACETYPE_PLANAR ) {
+			Vector4Copy( in->plane, surf->plane );
+		}
+
+		for( j = 0; j < MESHCACHE_NUM_ARRAYS; j++ ) {
+			void **array = Mod_MeshCacheArray( surf, j, &size );
+			if( in->offsets[j] >= 0 ) {
+				*array = data + in->offsets[j];
+			}
+		}
+	}
+
+	return true;
+}
+
+/*
+* Mod_WriteMeshCache
+*/
+static void Mod_WriteMeshCache( void ) {
+	unsigned i, j;
+	int file;
+	size_t size, pos, filePos;
+	char path[MAX_QPATH];
+	meshCacheHeader_t header;
+	meshCacheSurface_t *surfs, *out;
+	msurface_t *surf;
+	static const uint8_t zeros[MESHCACHE_ALIGN];
+
+	if( !r_meshcache->integer ) {
+		return;
+	}
+
+	Mod_InitMeshCacheHeader( &header );
+
+	// lay the arrays out first, so that the descriptors can be written in one go
+	surfs = Mod_Malloc( loadmodel, sizeof( *surfs ) * header.numSurfaces );
+
+	pos = 0;
+	for( i = 0, out = surfs, surf = loadbmodel->surfaces; i < header.numSurfaces; i++, out++, surf++ ) {
+		out->facetype = surf->facetype;
+		out->numVerts = surf->mesh.numVerts;
+		out->numElems = surf->mesh.numElems;
+		out->numInstances = surf->numInstances;
+		Vector4Copy( surf->plane, out->plane );
+
+		for( j = 0; j < MESHCACHE_NUM_ARRAYS; j++ ) {
+			void **array = Mod_MeshCacheArray( surf, j, &size );
+
+			if( !*array || !size ) {
+				out->offsets[j] = -1;
+				continue;
+			}
+
+			out->offsets[j] = pos;
+			pos = Q_ALIGN( pos + size, MESHCACHE_ALIGN );
+		}
+	}
+	header.dataSize = pos;
+
+	Mod_MeshCachePath( path, sizeof( path ) );
+	if( ri.FS_FOpenFile( path, &file, FS_WRITE | FS_CACHE ) == -1 ) {
+		Com_Printf( S_COLOR_YELLOW "Could not open %s for writing.\n", path );
+		R_Free( surfs );
+		return;
+	}
+
+	ri.FS_Write( &header, sizeof( header ), file );
+	ri.FS_Write( surfs, sizeof( *surfs ) * header.numSurfaces, file );
+	filePos = sizeof( header ) + sizeof( *surfs ) * header.numSurfaces;
+
+	for( i = 0, out = surfs, surf = loadbmodel->surfaces; i < header.numSurfaces; i++, out++, surf++ ) {
+		for( j = 0; j < MESHCACHE_NUM_ARRAYS; j++ ) {
+			void **array = Mod_MeshCacheArray( surf, j, &size );
+
+			if( out->offsets[j] < 0 ) {
+				continue;
+			}
+
+			// pad to the array offset
+			ri.FS_Write( zeros, header.dataOffset + out->offsets[j] - filePos, file );
+			filePos = header.dataOffset + out->offsets[j];
+
+			ri.FS_Write( *array, size, file );
+			filePos += size;
+		}
+	}
+	ri.FS_Write( zeros, header.dataOffset + header.dataSize - filePos, file );
+
+	ri.FS_FCloseFile( file );
+
+	R_Free( surfs );
+}
+
 /*
 * Mod_LoadPatchGroups
 */
@@ -1651,13 +2081,22 @@ static void Mod_Finish( const lump_t *faces, const lump_t *light, vec3_t gridSiz
 
 	R_SortSuperLightStyles( loadmodel );
 
+	if( !Mod_LoadMeshCache() ) {
+		in = loadmodel_dsurfaces;
+		surf = loadbmodel->surfaces;
+		for( i = 0; i < loadbmodel->numsurfaces; i++, in++, surf++ ) {
+			Mod_CreateMeshForSurface( in, surf, loadmodel_patchgrouprefs[i] );
+		}
+
+		// store the meshes before lightmap coordinates are remapped to the atlas
+		Mod_WriteMeshCache();
+	}
+
 	in = loadmodel_dsurfaces;
 	surf = loadbmodel->surfaces;
 	for( i = 0; i < loadbmodel->numsurfaces; i++, in++, surf++ ) {
 		shader_t *shader;
 
-		Mod_CreateMeshForSurface( in, surf, loadmodel_patchgrouprefs[i] );
-
 		Mod_ApplySuperStylesToFace( in, surf );
 
 		shader = surf->shader;
@@ -1726,6 +2165,8 @@ void Mod_LoadQ3BrushModel( model_t *mod, model_t *parent, void *buffer, bspForma
 	for( i = 0; i < sizeof( dheader_t ) / 4; i++ )
 		( (int *)header )[i] = LittleLong( ( (int *)header )[i] );
 
+	loadmodel_meshcachekey = Mod_MeshCacheKey( header->lumps );
+
 	// load into heap
 	Mod_LoadSubmodels( &header->lumps[LUMP_MODELS] );
 	Mod_LoadVisibility( &header->lumps[LUMP_VISIBILITY] );
@@ -44,6 +44,12 @@ cvar_t *r_dynamiclight;
 cvar_t *r_coronascale;
 cvar_t *r_detailtextures;
 cvar_t *r_subdivisions;
+cvar_t *r_meshcache;
+cvar_t *r_shaderindex;
+cvar_t *r_imagecache;
+cvar_t *r_imagesimd;
+cvar_t *r_autoinstancing;
+cvar_t *r_lightviscache;
 cvar_t *r_showtris;
 cvar_t *r_showtris2D;
 cvar_t *r_draworder;
@@ -1102,6 +1108,12 @@ static void R_Register( const char *screenshotsPrefix ) {
 	r_dynamiclight = ri.Cvar_Get( "r_dynamiclight", "1", CVAR_ARCHIVE );
 	r_coronascale = ri.Cvar_Get( "r_coronascale", "0.4", 0 );
 	r_subdivisions = ri.Cvar_Get( "r_subdivisions", STR_TOSTR( SUBDIVISIONS_DEFAULT ), CVAR_ARCHIVE | CVAR_LATCH_VIDEO );
+	r_meshcache = ri.Cvar_Get( "r_meshcache", "1", CVAR_ARCHIVE );
+	r_shaderindex = ri.Cvar_Get( "r_shaderindex", "1", CVAR_ARCHIVE );
+	r_imagecache = ri.Cvar_Get( "r_imagecache", "1", CVAR_ARCHIVE );
+	r_imagesimd = ri.Cvar_Get( "r_imagesimd", "1", CVAR_ARCHIVE );
+	r_autoinstancing = ri.Cvar_Get( "r_autoinstancing", "1", CVAR_ARCHIVE );
+	r_lightviscache = ri.Cvar_Get( "r_lightviscache", "1", CVAR_ARCHIVE );
 	r_draworder = ri.Cvar_Get( "r_draworder", "0", CVAR_CHEAT );
 
 	r_fastsky = ri.Cvar_Get( "r_fastsky", "0", CVAR_ARCHIVE );
@@ -1232,6 +1244,11 @@ static void R_Register( const char *screenshotsPrefix ) {
 	ri.Cmd_AddCommand( "gfxinfo", R_GfxInfo_f );
 	ri.Cmd_AddCommand( "glslprogramlist", RP_ProgramList_f );
 	ri.Cmd_AddCommand( "cinlist", R_CinList_f );
+	ri.Cmd_AddCommand( "r_sortbench", R_SortBench_f );
+	ri.Cmd_AddCommand( "r_cullbench", R_CullBench_f );
+	ri.Cmd_AddCommand( "r_skinbench", R_SkinBench_f );
+	ri.Cmd_AddCommand( "r_imagecachebench", R_ImageCacheBench_f );
+	ri.Cmd_AddCommand( "r_imagesimdbench", R_ImageSIMDBench_f );
 
 	ri.Cmd_SetCompletionFunc( "shaderdump", R_ShaderDumpCompletion_f );
 }
@@ -1620,6 +1637,11 @@ void R_Shutdown( bool verbose ) {
 	ri.Cmd_RemoveCommand( "shaderlist" );
 	ri.Cmd_RemoveCommand( "glslprogramlist" );
 	ri.Cmd_RemoveCommand( "cinlist" );
+	ri.Cmd_RemoveCommand( "r_sortbench" );
+	ri.Cmd_RemoveCommand( "r_cullbench" );
+	ri.Cmd_RemoveCommand( "r_skinbench" );
+	ri.Cmd_RemoveCommand( "r_imagecachebench" );
+	ri.Cmd_RemoveCommand( "r_imagesimdbench" );
 
 	// free shaders, models, etc.
 
@@ -40,6 +40,25 @@ typedef struct shadercache_s {
 	struct shadercache_s *hash_next;
 } shadercache_t;
 
+#define SHADER_INDEX_FILE_NAME "cache/shaders.index"
+#define SHADER_INDEX_ID ( ( 'X' << 24 ) + ( 'D' << 16 ) + ( 'I' << 8 ) + 'S' )
+#define SHADER_INDEX_VERSION 1
+
+typedef struct {
+	int			 ident;
+	int			 version;
+	unsigned int key;
+	unsigned int numFiles;
+	unsigned int numEntries;
+	unsigned int dataSize;
+} shaderindexheader_t;
+
+typedef struct {
+	unsigned int name; // offsets into the string data
+	unsigned int filename;
+	unsigned int text;
+} shaderindexentry_t;
+
 static shader_t r_shaders[MAX_SHADERS];
 
 static shader_t		  r_shaders_hash_headnode[SHADERS_HASH_SIZE], *r_free_shaders;
@@ -1897,6 +1916,165 @@ static unsigned int Shader_GetCache( const char *name, shadercache_t **cache )
 	return key;
 }
 
+/*
+ * Shader_IndexKey
+ *
+ * Mixes the name, size and timestamp of a script file into the index key.
+ */
+static unsigned int Shader_IndexKey( unsigned int key, const char *filename )
+{
+	char path[MAX_QPATH];
+
+	Q_snprintfz( path, sizeof( path ), "scripts/%s", filename );
+
+	key = key * 31 + COM_SuperFastHash( (const uint8_t *)filename, strlen( filename ) );
+	key = key * 31 + (unsigned int)ri.FS_FileMTime( path );
+	key = key * 31 + (unsigned int)ri.FS_FOpenFile( path, NULL, FS_READ );
+	return key;
+}
+
+/*
+ * Shader_LoadIndex
+ *
+ * Fills the shader cache from the index file with a single read. Returns false
+ * if the index is missing or was built for a different set of script files.
+ */
+static bool Shader_LoadIndex( unsigned int key, unsigned int numFiles )
+{
+	int				   i, file, len;
+	unsigned int	   hashKey;
+	uint8_t *		   block;
+	char *			   data;
+	shaderindexheader_t header;
+	shaderindexentry_t *entries, *e;
+	shadercache_t *	   caches, *cache;
+
+	len = ri.FS_FOpenFile( SHADER_INDEX_FILE_NAME, &file, FS_READ | FS_CACHE );
+	if( len < 0 ) {
+		return false;
+	}
+
+	if( (size_t)len < sizeof( header ) || ri.FS_Read( &header, sizeof( header ), file ) != sizeof( header ) ||
+		header.ident != SHADER_INDEX_ID || header.version != SHADER_INDEX_VERSION || header.key != key ||
+		header.numFiles != numFiles || !header.dataSize ||
+		(size_t)len != sizeof( header ) + header.numEntries * sizeof( *entries ) + header.dataSize ) {
+		ri.FS_FCloseFile( file );
+		return false;
+	}
+
+	block = R_Malloc( len - sizeof( header ) );
+	if( ri.FS_Read( block, len - sizeof( header ), file ) != (int)( len - sizeof( header ) ) ) {
+		ri.FS_FCloseFile( file );
+		R_Free( block );
+		return false;
+	}
+	ri.FS_FCloseFile( file );
+
+	entries = (shaderindexentry_t *)block;
+	data = (char *)( entries + header.numEntries );
+
+	// every string must be terminated within the data
+	if( data[header.dataSize - 1] != '\0' ) {
+		R_Free( block );
+		return false;
+	}
+	for( i = 0, e = entries; i < (int)header.numEntries; i++, e++ ) {
+		if( e->name >= header.dataSize || e->filename >= header.dataSize || e->text >= header.dataSize ) {
+			R_Free( block );
+			return false;
+		}
+	}
+
+	caches = R_Malloc( sizeof( *caches ) * max( header.numEntries, 1 ) );
+	for( i = 0, e = entries, cache = caches; i < (int)header.numEntries; i++, e++, cache++ ) {
+		cache->name = data + e->name;
+		cache->filename = data + e->filename;
+		cache->buffer = data + e->text;
+		cache->offset = 0;
+
+		hashKey = COM_SuperFastHash( (const uint8_t *)cache->name, strlen( cache->name ) ) % SHADERCACHE_HASH_SIZE;
+		cache->hash_next = shadercache_hash[hashKey];
+		shadercache_hash[hashKey] = cache;
+	}
+
+	Com_Printf( "...loaded %u shaders from %s\n", header.numEntries, SHADER_INDEX_FILE_NAME );
+	return true;
+}
+
+/*
+ * Shader_WriteIndex
+ *
+ * Stores the name, source file and compressed text of every cached shader.
+ */
+static void Shader_WriteIndex( unsigned int key, unsigned int numFiles )
+{
+	int				   i, file;
+	size_t			   length;
+	const char *	   ptr;
+	shaderindexheader_t header;
+	shaderindexentry_t *entries, *e;
+	shadercache_t *	   c;
+
+	memset( &header, 0, sizeof( header ) );
+	header.ident = SHADER_INDEX_ID;
+	header.version = SHADER_INDEX_VERSION;
+	header.key = key;
+	header.numFiles = numFiles;
+
+	for( i = 0; i < SHADERCACHE_HASH_SIZE; i++ ) {
+		for( c = shadercache_hash[i]; c; c = c->hash_next ) {
+			header.numEntries++;
+		}
+	}
+
+	if( !header.numEntries ) {
+		return;
+	}
+
+	// lay out the strings
+	entries = R_Malloc( sizeof( *entries ) * header.numEntries );
+	for( i = 0, e = entries; i < SHADERCACHE_HASH_SIZE; i++ ) {
+		for( c = shadercache_hash[i]; c; c = c->hash_next, e++ ) {
+			e->name = header.dataSize;
+			header.dataSize += strlen( c->name ) + 1;
+
+			e->filename = header.dataSize;
+			header.dataSize += strlen( c->filename ) + 1;
+
+			ptr = c->buffer + c->offset;
+			Shader_SkipBlock( &ptr );
+			e->text = header.dataSize;
+			header.dataSize += ( ptr - ( c->buffer + c->offset ) ) + 1;
+		}
+	}
+
+	if( ri.FS_FOpenFile( SHADER_INDEX_FILE_NAME, &file, FS_WRITE | FS_CACHE ) == -1 ) {
+		Com_Printf( S_COLOR_YELLOW "Could not open %s for writing.\n", SHADER_INDEX_FILE_NAME );
+		R_Free( entries );
+		return;
+	}
+
+	ri.FS_Write( &header, sizeof( header ), file );
+	ri.FS_Write( entries, sizeof( *entries ) * header.numEntries, file );
+
+	for( i = 0; i < SHADERCACHE_HASH_SIZE; i++ ) {
+		for( c = shadercache_hash[i]; c; c = c->hash_next ) {
+			ri.FS_Write( c->name, strlen( c->name ) + 1, file );
+			ri.FS_Write( c->filename, strlen( c->filename ) + 1, file );
+
+			ptr = c->buffer + c->offset;
+			Shader_SkipBlock( &ptr );
+			length = ptr - ( c->buffer + c->offset );
+			ri.FS_Write( c->buffer + c->offset, length, file );
+			ri.FS_Write( "", 1, file );
+		}
+	}
+
+	ri.FS_FCloseFile( file );
+
+	R_Free( entries );
+}
+
 /*
  * R_InitShaderCache
  */
@@ -1905,9 +2083,12 @@ static void R_InitShaderCache( void )
 	int			d;
 	int			i, j, k, numfiles;
 	int			numfiles_total;
+	unsigned int key;
 	const char *fileptr;
 	char		shaderPaths[1024];
 	const char *dirs[3] = { "<scripts", ">scripts" };
+	char *		fileList;
+	size_t		fileListSize, fileListLength;
 
 	r_shaderTemplateBuf = NULL;
 
@@ -1915,13 +2096,17 @@ static void R_InitShaderCache( void )
 
 	Com_Printf( "Initializing Shaders:\n" );
 
+	// enumerate shaders, the index is only valid for the exact same set of files
+	key = SHADER_INDEX_VERSION;
+	fileListSize = 1024;
+	fileListLength = 0;
+	fileList = R_Malloc( fileListSize );
+
 	numfiles_total = 0;
 	for( d = 0; d < 2; d++ ) {
-		// enumerate shaders
 		numfiles = ri.FS_GetFileList( dirs[d], ".shader", NULL, 0, 0, 0 );
 		numfiles_total += numfiles;
 
-		// now load them all
 		for( i = 0; i < numfiles; i += k ) {
 			if( ( k = ri.FS_GetFileList( dirs[d], ".shader", shaderPaths, sizeof( shaderPaths ), i, numfiles ) ) ==
 				0 ) {
@@ -1931,20 +2116,44 @@ static void R_InitShaderCache( void )
 
 			fileptr = shaderPaths;
 			for( j = 0; j < k; j++ ) {
-				Shader_MakeCache( fileptr );
+				size_t len = strlen( fileptr ) + 1;
 
-				fileptr += strlen( fileptr ) + 1;
+				if( fileListLength + len + 1 > fileListSize ) {
+					fileListSize = max( fileListSize * 2, fileListLength + len + 1 );
+					fileList = R_Realloc( fileList, fileListSize );
+				}
+				memcpy( fileList + fileListLength, fileptr, len );
+				fileListLength += len;
+
+				key = Shader_IndexKey( key, fileptr );
+
+				fileptr += len;
 				if( !*fileptr ) {
 					break;
 				}
 			}
 		}
 	}
+	fileList[fileListLength] = '\0';
 
 	if( !numfiles_total ) {
+		R_Free( fileList );
 		ri.Com_Error( ERR_DROP, "Could not find any shaders!" );
 	}
 
+	if( !r_shaderindex->integer || !Shader_LoadIndex( key, numfiles_total ) ) {
+		// now load them all
+		for( fileptr = fileList; *fileptr; fileptr += strlen( fileptr ) + 1 ) {
+			Shader_MakeCache( fileptr );
+		}
+
+		if( r_shaderindex->integer ) {
+			Shader_WriteIndex( key, numfiles_total );
+		}
+	}
+
+	R_Free( fileList );
+
 	Com_Printf( "--------------------------------------\n" );
 }
 
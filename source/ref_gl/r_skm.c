@@ -23,6 +23,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "r_local.h"
 #include "iqm.h"
 
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define R_SKM_SSE
+#include <xmmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#define R_SKM_NEON
+#include <arm_neon.h>
+#endif
+
 #define SKMSURF_DISTANCE(s, d) ((s)->flags & SHADER_AUTOSPRITE ? d : 0)
 
 // typedefs
@@ -1032,42 +1040,278 @@ static void R_SkeletalTransformVerts( int numverts, const unsigned int *blends,
 }
 
 /*
-* R_SkeletalTransformNormals
+* R_SkeletalTransformNormalsAndSVecs
 */
-static void R_SkeletalTransformNormals( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+static void R_SkeletalTransformNormalsAndSVecs( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv ) {
 	const float *pose;
 
-	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+	for( ; numverts; numverts--, v += 4, ov += 4, sv += 4, osv += 4, blends++ ) {
 		pose = relbonepose[*blends];
 
 		ov[0] = v[0] * pose[0] + v[1] * pose[4] + v[2] * pose[ 8];
 		ov[1] = v[0] * pose[1] + v[1] * pose[5] + v[2] * pose[ 9];
 		ov[2] = v[0] * pose[2] + v[1] * pose[6] + v[2] * pose[10];
 		ov[3] = 0;
+
+		osv[0] = sv[0] * pose[0] + sv[1] * pose[4] + sv[2] * pose[ 8];
+		osv[1] = sv[0] * pose[1] + sv[1] * pose[5] + sv[2] * pose[ 9];
+		osv[2] = sv[0] * pose[2] + sv[1] * pose[6] + sv[2] * pose[10];
+		osv[3] = sv[3];
 	}
 }
 
+#if defined( R_SKM_SSE )
+
 /*
-* R_SkeletalTransformNormalsAndSVecs
+* R_SkeletalBlendPosesSIMD
 */
-static void R_SkeletalTransformNormalsAndSVecs( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv ) {
+static void R_SkeletalBlendPosesSIMD( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose ) {
+	unsigned int i, j, k;
+	float *pose;
+	const float *b;
+	mskblend_t *blend;
+	__m128 f, c0, c1, c2, c3;
+
+	for( i = 0, j = numbones, blend = blends; i < numblends; i++, j++, blend++ ) {
+		pose = relbonepose[j];
+
+		b = relbonepose[blend->indices[0]];
+		f = _mm_set1_ps( blend->weights[0] * ( 1.0 / 255.0 ) );
+
+		c0 = _mm_mul_ps( f, _mm_loadu_ps( b ) );
+		c1 = _mm_mul_ps( f, _mm_loadu_ps( b + 4 ) );
+		c2 = _mm_mul_ps( f, _mm_loadu_ps( b + 8 ) );
+		c3 = _mm_mul_ps( f, _mm_loadu_ps( b + 12 ) );
+
+		for( k = 1; k < SKM_MAX_WEIGHTS && blend->weights[k]; k++ ) {
+			b = relbonepose[blend->indices[k]];
+			f = _mm_set1_ps( blend->weights[k] * ( 1.0 / 255.0 ) );
+
+			c0 = _mm_add_ps( c0, _mm_mul_ps( f, _mm_loadu_ps( b ) ) );
+			c1 = _mm_add_ps( c1, _mm_mul_ps( f, _mm_loadu_ps( b + 4 ) ) );
+			c2 = _mm_add_ps( c2, _mm_mul_ps( f, _mm_loadu_ps( b + 8 ) ) );
+			c3 = _mm_add_ps( c3, _mm_mul_ps( f, _mm_loadu_ps( b + 12 ) ) );
+		}
+
+		_mm_storeu_ps( pose, c0 );
+		_mm_storeu_ps( pose + 4, c1 );
+		_mm_storeu_ps( pose + 8, c2 );
+		_mm_storeu_ps( pose + 12, c3 );
+	}
+}
+
+/*
+* R_SkeletalTransformVertsSIMD
+*/
+static void R_SkeletalTransformVertsSIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const float *pose;
+	__m128 vv, res;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
+		vv = _mm_loadu_ps( v );
+
+		res = _mm_mul_ps( _mm_shuffle_ps( vv, vv, 0x00 ), _mm_loadu_ps( pose ) );
+		res = _mm_add_ps( res, _mm_mul_ps( _mm_shuffle_ps( vv, vv, 0x55 ), _mm_loadu_ps( pose + 4 ) ) );
+		res = _mm_add_ps( res, _mm_mul_ps( _mm_shuffle_ps( vv, vv, 0xaa ), _mm_loadu_ps( pose + 8 ) ) );
+		res = _mm_add_ps( res, _mm_loadu_ps( pose + 12 ) );
+
+		_mm_storeu_ps( ov, res );
+		ov[3] = 1;
+	}
+}
+
+/*
+* R_SkeletalTransformNormalsSIMD
+*/
+static void R_SkeletalTransformNormalsSIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const float *pose;
+	__m128 vv, res;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
+		vv = _mm_loadu_ps( v );
+
+		res = _mm_mul_ps( _mm_shuffle_ps( vv, vv, 0x00 ), _mm_loadu_ps( pose ) );
+		res = _mm_add_ps( res, _mm_mul_ps( _mm_shuffle_ps( vv, vv, 0x55 ), _mm_loadu_ps( pose + 4 ) ) );
+		res = _mm_add_ps( res, _mm_mul_ps( _mm_shuffle_ps( vv, vv, 0xaa ), _mm_loadu_ps( pose + 8 ) ) );
+
+		_mm_storeu_ps( ov, res );
+		ov[3] = 0;
+	}
+}
+
+/*
+* R_SkeletalTransformNormalsAndSVecsSIMD
+*/
+static void R_SkeletalTransformNormalsAndSVecsSIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv ) {
 	const float *pose;
+	__m128 c0, c1, c2;
+	__m128 vv, svv, res;
 
 	for( ; numverts; numverts--, v += 4, ov += 4, sv += 4, osv += 4, blends++ ) {
 		pose = relbonepose[*blends];
+		c0 = _mm_loadu_ps( pose );
+		c1 = _mm_loadu_ps( pose + 4 );
+		c2 = _mm_loadu_ps( pose + 8 );
+
+		vv = _mm_loadu_ps( v );
+		res = _mm_mul_ps( _mm_shuffle_ps( vv, vv, 0x00 ), c0 );
+		res = _mm_add_ps( res, _mm_mul_ps( _mm_shuffle_ps( vv, vv, 0x55 ), c1 ) );
+		res = _mm_add_ps( res, _mm_mul_ps( _mm_shuffle_ps( vv, vv, 0xaa ), c2 ) );
+		_mm_storeu_ps( ov, res );
+		ov[3] = 0;
+
+		svv = _mm_loadu_ps( sv );
+		res = _mm_mul_ps( _mm_shuffle_ps( svv, svv, 0x00 ), c0 );
+		res = _mm_add_ps( res, _mm_mul_ps( _mm_shuffle_ps( svv, svv, 0x55 ), c1 ) );
+		res = _mm_add_ps( res, _mm_mul_ps( _mm_shuffle_ps( svv, svv, 0xaa ), c2 ) );
+		_mm_storeu_ps( osv, res );
+		osv[3] = sv[3];
+	}
+}
+
+#elif defined( R_SKM_NEON )
+
+/*
+* R_SkeletalBlendPosesSIMD
+*/
+static void R_SkeletalBlendPosesSIMD( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose ) {
+	unsigned int i, j, k;
+	float *pose, f;
+	const float *b;
+	mskblend_t *blend;
+	float32x4_t c0, c1, c2, c3;
+
+	for( i = 0, j = numbones, blend = blends; i < numblends; i++, j++, blend++ ) {
+		pose = relbonepose[j];
+
+		b = relbonepose[blend->indices[0]];
+		f = blend->weights[0] * ( 1.0 / 255.0 );
+
+		c0 = vmulq_n_f32( vld1q_f32( b ), f );
+		c1 = vmulq_n_f32( vld1q_f32( b + 4 ), f );
+		c2 = vmulq_n_f32( vld1q_f32( b + 8 ), f );
+		c3 = vmulq_n_f32( vld1q_f32( b + 12 ), f );
+
+		for( k = 1; k < SKM_MAX_WEIGHTS && blend->weights[k]; k++ ) {
+			b = relbonepose[blend->indices[k]];
+			f = blend->weights[k] * ( 1.0 / 255.0 );
+
+			c0 = vmlaq_n_f32( c0, vld1q_f32( b ), f );
+			c1 = vmlaq_n_f32( c1, vld1q_f32( b + 4 ), f );
+			c2 = vmlaq_n_f32( c2, vld1q_f32( b + 8 ), f );
+			c3 = vmlaq_n_f32( c3, vld1q_f32( b + 12 ), f );
+		}
+
+		vst1q_f32( pose, c0 );
+		vst1q_f32( pose + 4, c1 );
+		vst1q_f32( pose + 8, c2 );
+		vst1q_f32( pose + 12, c3 );
+	}
+}
+
+/*
+* R_SkeletalTransformVertsSIMD
+*/
+static void R_SkeletalTransformVertsSIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const float *pose;
+	float32x4_t res;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
+
+		res = vmlaq_n_f32( vld1q_f32( pose + 12 ), vld1q_f32( pose ), v[0] );
+		res = vmlaq_n_f32( res, vld1q_f32( pose + 4 ), v[1] );
+		res = vmlaq_n_f32( res, vld1q_f32( pose + 8 ), v[2] );
+
+		vst1q_f32( ov, res );
+		ov[3] = 1;
+	}
+}
+
+/*
+* R_SkeletalTransformNormalsSIMD
+*/
+static void R_SkeletalTransformNormalsSIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const float *pose;
+	float32x4_t res;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
+
+		res = vmulq_n_f32( vld1q_f32( pose ), v[0] );
+		res = vmlaq_n_f32( res, vld1q_f32( pose + 4 ), v[1] );
+		res = vmlaq_n_f32( res, vld1q_f32( pose + 8 ), v[2] );
+
+		vst1q_f32( ov, res );
+		ov[3] = 0;
+	}
+}
+
+/*
+* R_SkeletalTransformNormalsAndSVecsSIMD
+*/
+static void R_SkeletalTransformNormalsAndSVecsSIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv ) {
+	const float *pose;
+	float32x4_t c0, c1, c2, res;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, sv += 4, osv += 4, blends++ ) {
+		pose = relbonepose[*blends];
+		c0 = vld1q_f32( pose );
+		c1 = vld1q_f32( pose + 4 );
+		c2 = vld1q_f32( pose + 8 );
+
+		res = vmulq_n_f32( c0, v[0] );
+		res = vmlaq_n_f32( res, c1, v[1] );
+		res = vmlaq_n_f32( res, c2, v[2] );
+		vst1q_f32( ov, res );
+		ov[3] = 0;
+
+		res = vmulq_n_f32( c0, sv[0] );
+		res = vmlaq_n_f32( res, c1, sv[1] );
+		res = vmlaq_n_f32( res, c2, sv[2] );
+		vst1q_f32( osv, res );
+		osv[3] = sv[3];
+	}
+}
+
+#else
+
+/*
+* R_SkeletalTransformNormals
+*/
+static void R_SkeletalTransformNormals( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const float *pose;
+
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		pose = relbonepose[*blends];
 
 		ov[0] = v[0] * pose[0] + v[1] * pose[4] + v[2] * pose[ 8];
 		ov[1] = v[0] * pose[1] + v[1] * pose[5] + v[2] * pose[ 9];
 		ov[2] = v[0] * pose[2] + v[1] * pose[6] + v[2] * pose[10];
 		ov[3] = 0;
-
-		osv[0] = sv[0] * pose[0] + sv[1] * pose[4] + sv[2] * pose[ 8];
-		osv[1] = sv[0] * pose[1] + sv[1] * pose[5] + sv[2] * pose[ 9];
-		osv[2] = sv[0] * pose[2] + sv[1] * pose[6] + sv[2] * pose[10];
-		osv[3] = sv[3];
 	}
 }
 
+static void R_SkeletalBlendPosesSIMD( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose ) {
+	R_SkeletalBlendPoses( numblends, blends, numbones, relbonepose );
+}
+
+static void R_SkeletalTransformVertsSIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	R_SkeletalTransformVerts( numverts, blends, relbonepose, v, ov );
+}
+
+static void R_SkeletalTransformNormalsSIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	R_SkeletalTransformNormals( numverts, blends, relbonepose, v, ov );
+}
+
+static void R_SkeletalTransformNormalsAndSVecsSIMD( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv ) {
+	R_SkeletalTransformNormalsAndSVecs( numverts, blends, relbonepose, v, ov, sv, osv );
+}
+
+#endif
+
 // set the FP precision back to whatever value it was
 #if defined ( _WIN32 ) && ( _MSC_VER >= 1400 ) && defined( NDEBUG )
 # pragma float_control(pop)
@@ -1166,7 +1410,7 @@ static void R_CacheBoneTransformsJob( unsigned first, unsigned items, jobarg_t *
 		}
 
 		// generate matrices for all blend combinations
-		R_SkeletalBlendPoses( skmodel->numblends, skmodel->blends, skmodel->numbones, bonePoseRelativeMat );
+		R_SkeletalBlendPosesSIMD( skmodel->numblends, skmodel->blends, skmodel->numbones, bonePoseRelativeMat );
 	}
 }
 
@@ -1233,15 +1477,15 @@ void R_DrawSkeletalSurf( const entity_t *e, const shader_t *shader, const mfog_t
 		 ( vattribs & VATTRIB_SVECTOR_BIT ) ? true : false );
 
 	if( bonePoseRelativeMat ) {
-		R_SkeletalTransformVerts( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
+		R_SkeletalTransformVertsSIMD( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
 			  ( vec_t * )skmesh->xyzArray[0], ( vec_t * )( dynamicMesh.xyzArray ) );
 
 		if( vattribs & VATTRIB_SVECTOR_BIT ) {
-			R_SkeletalTransformNormalsAndSVecs( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
+			R_SkeletalTransformNormalsAndSVecsSIMD( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
 					( vec_t * )skmesh->normalsArray[0], ( vec_t * )( dynamicMesh.normalsArray ),
 					( vec_t * )skmesh->sVectorsArray[0], ( vec_t * )( dynamicMesh.sVectorsArray ) );
 		} else if( vattribs & VATTRIB_NORMAL_BIT ) {
-			R_SkeletalTransformNormals( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
+			R_SkeletalTransformNormalsSIMD( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
 					( vec_t * )skmesh->normalsArray[0], ( vec_t * )( dynamicMesh.normalsArray ) );
 		}
 	} else {
@@ -1509,3 +1753,139 @@ bool R_AddSkeletalModelToDrawList( const entity_t *e ) {
 
 	return true;
 }
+
+/*
+* R_SkinBenchMaxError
+*/
+static float R_SkinBenchMaxError( const vec_t *a, const vec_t *b, unsigned numfloats ) {
+	unsigned i;
+	float error = 0;
+
+	for( i = 0; i < numfloats; i++ ) {
+		error = max( error, fabs( a[i] - b[i] ) );
+	}
+	return error;
+}
+
+/*
+* R_SkinBench_f
+*
+* r_skinbench <model> [frame] [iterations]
+*
+* Times the scalar and SIMD versions of CPU skinning on every mesh of the given
+* skeletal model, including its level-of-detail meshes, and reports the largest
+* difference between the two.
+*/
+void R_SkinBench_f( void ) {
+	int it, iterations, frame;
+	unsigned i, numMats;
+	model_t *mod;
+	mskmodel_t *skmodel;
+	mskmesh_t *mesh;
+	bonepose_t *poses;
+	dualquat_t dq;
+	mat4_t *mats, *simdMats;
+	vec4_t *out, *simdOut;
+	int64_t start, scalarTime, simdTime;
+
+	if( ri.Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <model> [frame] [iterations]\n", ri.Cmd_Argv( 0 ) );
+		return;
+	}
+
+	mod = Mod_ForName( ri.Cmd_Argv( 1 ), false );
+	if( !mod || mod->type != mod_skeletal ) {
+		Com_Printf( "%s is not a skeletal model\n", ri.Cmd_Argv( 1 ) );
+		return;
+	}
+
+	skmodel = ( mskmodel_t * )mod->extradata;
+	if( !skmodel->numbones || !skmodel->numframes ) {
+		Com_Printf( "%s has no animation\n", mod->name );
+		return;
+	}
+
+	frame = ri.Cmd_Argc() > 2 ? atoi( ri.Cmd_Argv( 2 ) ) : skmodel->numframes / 2;
+	frame = Q_bound( 0, frame, (int)skmodel->numframes - 1 );
+	iterations = ri.Cmd_Argc() > 3 ? atoi( ri.Cmd_Argv( 3 ) ) : 100;
+	iterations = max( iterations, 1 );
+
+	numMats = skmodel->numbones + skmodel->numblends;
+	poses = R_Malloc( sizeof( *poses ) * skmodel->numbones );
+	mats = R_Malloc( sizeof( *mats ) * numMats );
+	simdMats = R_Malloc( sizeof( *simdMats ) * numMats );
+
+	// bone matrices relative to the base pose, as in R_CacheBoneTransformsJob
+	for( i = 0; i < skmodel->numbones; i++ ) {
+		const mskbone_t *bone = skmodel->bones + i;
+		const bonepose_t *bonepose = skmodel->frames[frame].boneposes + i;
+
+		if( bone->parent >= 0 ) {
+			DualQuat_Multiply( poses[bone->parent].dualquat, bonepose->dualquat, poses[i].dualquat );
+		} else {
+			DualQuat_Copy( bonepose->dualquat, poses[i].dualquat );
+		}
+
+		DualQuat_Multiply( poses[i].dualquat, skmodel->invbaseposes[i].dualquat, dq );
+		DualQuat_Normalize( dq );
+		Matrix4_FromDualQuaternion( dq, mats[i] );
+	}
+	memcpy( simdMats, mats, sizeof( *mats ) * skmodel->numbones );
+
+	Com_Printf( "%s, frame %i, %u bones, %u blends, %i iterations\n", mod->name, frame, skmodel->numbones, skmodel->numblends, iterations );
+
+	start = ri.Sys_Microseconds();
+	for( it = 0; it < iterations; it++ ) {
+		R_SkeletalBlendPoses( skmodel->numblends, skmodel->blends, skmodel->numbones, mats );
+	}
+	scalarTime = ri.Sys_Microseconds() - start;
+
+	start = ri.Sys_Microseconds();
+	for( it = 0; it < iterations; it++ ) {
+		R_SkeletalBlendPosesSIMD( skmodel->numblends, skmodel->blends, skmodel->numbones, simdMats );
+	}
+	simdTime = ri.Sys_Microseconds() - start;
+
+	for( i = skmodel->numbones; i < numMats; i++ ) {
+		// the scalar version leaves the last row alone
+		mats[i][3] = simdMats[i][3] = mats[i][7] = simdMats[i][7] = mats[i][11] = simdMats[i][11] = 0;
+		mats[i][15] = simdMats[i][15] = 1;
+	}
+
+	Com_Printf( "blend poses: %.2f usec, SIMD: %.2f usec, max error %g\n", (double)scalarTime / iterations, (double)simdTime / iterations,
+				R_SkinBenchMaxError( mats[0], simdMats[0], numMats * 16 ) );
+
+	for( i = 0, mesh = skmodel->meshes; i < skmodel->nummeshes; i++, mesh++ ) {
+		size_t size = sizeof( vec4_t ) * mesh->numverts * 3;
+
+		out = R_Malloc( size );
+		simdOut = R_Malloc( size );
+
+		start = ri.Sys_Microseconds();
+		for( it = 0; it < iterations; it++ ) {
+			R_SkeletalTransformVerts( mesh->numverts, mesh->vertexBlends, mats, mesh->xyzArray[0], out[0] );
+			R_SkeletalTransformNormalsAndSVecs( mesh->numverts, mesh->vertexBlends, mats, mesh->normalsArray[0],
+				out[mesh->numverts], mesh->sVectorsArray[0], out[mesh->numverts * 2] );
+		}
+		scalarTime = ri.Sys_Microseconds() - start;
+
+		start = ri.Sys_Microseconds();
+		for( it = 0; it < iterations; it++ ) {
+			R_SkeletalTransformVertsSIMD( mesh->numverts, mesh->vertexBlends, mats, mesh->xyzArray[0], simdOut[0] );
+			R_SkeletalTransformNormalsAndSVecsSIMD( mesh->numverts, mesh->vertexBlends, mats, mesh->normalsArray[0],
+				simdOut[mesh->numverts], mesh->sVectorsArray[0], simdOut[mesh->numverts * 2] );
+		}
+		simdTime = ri.Sys_Microseconds() - start;
+
+		Com_Printf( "%s: %u verts, %.2f usec, SIMD: %.2f usec, max error %g\n", mesh->name, mesh->numverts,
+			(double)scalarTime / iterations, (double)simdTime / iterations,
+			R_SkinBenchMaxError( out[0], simdOut[0], mesh->numverts * 12 ) );
+
+		R_Free( out );
+		R_Free( simdOut );
+	}
+
+	R_Free( poses );
+	R_Free( mats );
+	R_Free( simdMats );
+}
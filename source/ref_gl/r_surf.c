@@ -583,76 +583,89 @@ WORLD MODEL
 
 /*
 * R_CullVisLeaves
+*
+* Leaves are frustum culled R_CULL_BATCH at a time, batches without any
+* leaves in the PVS are skipped entirely.
 */
 static void R_CullVisLeaves( unsigned firstLeaf, unsigned numLeaves, unsigned clipFlags ) {
-	unsigned i, j;
+	unsigned i, j, k;
+	unsigned visMask, culled, partial;
 	mleaf_t *leaf;
 	const uint8_t *pvs = rn.pvs;
 	const uint8_t *areabits = rn.areabits;
+	const mbounds_t *bounds = &rsh.worldBrushModel->leafBounds;
 
-	for( i = 0; i < numLeaves; i++ ) {
-		int clipped;
-		unsigned bit, testFlags;
-		cplane_t *clipplane;
-		unsigned l = firstLeaf + i;
+	assert( !( firstLeaf % R_CULL_BATCH ) );
 
-		leaf = &rsh.worldBrushModel->leafs[l];
-		if( leaf->cluster < 0 || !leaf->numVisSurfaces ) {
-			continue;
-		}
+	for( i = 0; i < numLeaves; i += R_CULL_BATCH ) {
+		unsigned batch = min( numLeaves - i, R_CULL_BATCH );
 
-		// check for door connected areas
-		if( areabits ) {
-			if( leaf->area < 0 || !( areabits[leaf->area >> 3] & ( 1 << ( leaf->area & 7 ) ) ) ) {
-				continue; // not visible
+		visMask = 0;
+		for( k = 0; k < batch; k++ ) {
+			leaf = &rsh.worldBrushModel->leafs[firstLeaf + i + k];
+			if( leaf->cluster < 0 || !leaf->numVisSurfaces ) {
+				continue;
 			}
-		}
 
-		if( pvs ) {
-			if( !( pvs[leaf->cluster >> 3] & ( 1 << ( leaf->cluster & 7 ) ) ) ) {
-				continue; // not visible
+			// check for door connected areas
+			if( areabits ) {
+				if( leaf->area < 0 || !( areabits[leaf->area >> 3] & ( 1 << ( leaf->area & 7 ) ) ) ) {
+					continue; // not visible
+				}
 			}
+
+			if( pvs ) {
+				if( !( pvs[leaf->cluster >> 3] & ( 1 << ( leaf->cluster & 7 ) ) ) ) {
+					continue; // not visible
+				}
+			}
+
+			visMask |= 1 << k;
 		}
 
-		// add leaf bounds to pvs bounds
-		for( j = 0; j < 3; j++ ) {
-			rn.pvsMins[j] = min( rn.pvsMins[j], leaf->mins[j] );
-			rn.pvsMaxs[j] = max( rn.pvsMaxs[j], leaf->maxs[j] );
+		if( !visMask ) {
+			continue;
 		}
 
 		// track leaves, which are entirely inside the frustum
-		clipped = 0;
-		testFlags = clipFlags;
-		for( j = sizeof( rn.frustum ) / sizeof( rn.frustum[0] ), bit = 1, clipplane = rn.frustum; j > 0; j--, bit <<= 1, clipplane++ ) {
-			if( testFlags & bit ) {
-				clipped = BoxOnPlaneSide( leaf->mins, leaf->maxs, clipplane );
-				if( clipped == 2 ) {
-					break;
-				} else if( clipped == 1 ) {
-					testFlags &= ~bit; // node is entirely on screen
-				}
+		culled = R_CullBoxBatch( rn.frustum, sizeof( rn.frustum ) / sizeof( rn.frustum[0] ),
+			bounds, firstLeaf + i, clipFlags, &partial );
+
+		for( k = 0; k < batch; k++ ) {
+			unsigned l = firstLeaf + i + k;
+
+			if( !( visMask & ( 1 << k ) ) ) {
+				continue;
 			}
-		}
 
-		if( clipped == 2 ) {
-			continue; // fully clipped
-		}
+			leaf = &rsh.worldBrushModel->leafs[l];
 
-		if( testFlags == 0 ) {
-			// fully visible
-			for( j = 0; j < leaf->numVisSurfaces; j++ ) {
-				assert( leaf->visSurfaces[j] < rn.meshlist->numWorldSurfVis );
-				rn.meshlist->worldSurfFullVis[leaf->visSurfaces[j]] = 1;
+			// add leaf bounds to pvs bounds
+			for( j = 0; j < 3; j++ ) {
+				rn.pvsMins[j] = min( rn.pvsMins[j], leaf->mins[j] );
+				rn.pvsMaxs[j] = max( rn.pvsMaxs[j], leaf->maxs[j] );
 			}
-		} else {
-			// partly visible
-			for( j = 0; j < leaf->numVisSurfaces; j++ ) {
-				assert( leaf->visSurfaces[j] < rn.meshlist->numWorldSurfVis );
-				rn.meshlist->worldSurfVis[leaf->visSurfaces[j]] = 1;
+
+			if( culled & ( 1 << k ) ) {
+				continue; // fully clipped
 			}
-		}
 
-		rn.meshlist->worldLeafVis[l] = 1;
+			if( !( partial & ( 1 << k ) ) ) {
+				// fully visible
+				for( j = 0; j < leaf->numVisSurfaces; j++ ) {
+					assert( leaf->visSurfaces[j] < rn.meshlist->numWorldSurfVis );
+					rn.meshlist->worldSurfFullVis[leaf->visSurfaces[j]] = 1;
+				}
+			} else {
+				// partly visible
+				for( j = 0; j < leaf->numVisSurfaces; j++ ) {
+					assert( leaf->visSurfaces[j] < rn.meshlist->numWorldSurfVis );
+					rn.meshlist->worldSurfVis[leaf->visSurfaces[j]] = 1;
+				}
+			}
+
+			rn.meshlist->worldLeafVis[l] = 1;
+		}
 	}
 }
 
@@ -660,42 +673,64 @@ static void R_CullVisLeaves( unsigned firstLeaf, unsigned numLeaves, unsigned cl
 * R_CullVisSurfaces
 */
 static void R_CullVisSurfaces( unsigned firstSurf, unsigned numSurfs, unsigned clipFlags ) {
-	unsigned i;
+	unsigned i, k;
 	unsigned end;
+	unsigned testMask, culled, partial;
+	const mbounds_t *bounds = &rsh.worldBrushModel->surfBounds;
 
-	end = firstSurf + numSurfs;
+	assert( !( firstSurf % R_CULL_BATCH ) );
 
-	for( i = firstSurf; i < end; i++ ) {
-		msurface_t *surf = rsh.worldBrushModel->surfaces + i;
+	end = firstSurf + numSurfs;
 
-		if( !surf->drawSurf ) {
-			rn.meshlist->worldSurfVis[i] = 0;
-			rn.meshlist->worldSurfFullVis[i] = 0;
-			continue;
-		}
+	for( i = firstSurf; i < end; i += R_CULL_BATCH ) {
+		unsigned batch = min( end - i, R_CULL_BATCH );
 
-		if( rn.meshlist->worldSurfVis[i] ) {
-			// the surface is at partly visible in at least one leaf, frustum cull it
-			if( R_CullBox( surf->mins, surf->maxs, clipFlags ) ) {
-				rn.meshlist->worldSurfVis[i] = 0;
+		// surfaces that are partly visible in at least one leaf need to be frustum culled
+		testMask = 0;
+		for( k = 0; k < batch; k++ ) {
+			if( rsh.worldBrushModel->surfaces[i + k].drawSurf && rn.meshlist->worldSurfVis[i + k] ) {
+				testMask |= 1 << k;
 			}
-			rn.meshlist->worldSurfFullVis[i] = 0;
 		}
-		else {
-			if( rn.meshlist->worldSurfFullVis[i] ) {
-				// a fully visible surface, mark as visible
-				rn.meshlist->worldSurfVis[i] = 1;
-			}
+
+		culled = 0;
+		if( testMask && !r_nocull->integer ) {
+			culled = R_CullBoxBatch( rn.frustum, sizeof( rn.frustum ) / sizeof( rn.frustum[0] ),
+				bounds, i, clipFlags, &partial );
 		}
 
-		if( rn.meshlist->worldSurfVis[i] ) {
-			rn.meshlist->worldDrawSurfVis[surf->drawSurf - 1] = 1;
+		for( k = 0; k < batch; k++ ) {
+			unsigned s = i + k;
+			msurface_t *surf = rsh.worldBrushModel->surfaces + s;
 
-			if( surf->flags & SURF_SKY ) {
-				R_ClipSkySurface( &rn.skyDrawSurface, surf );
+			if( !surf->drawSurf ) {
+				rn.meshlist->worldSurfVis[s] = 0;
+				rn.meshlist->worldSurfFullVis[s] = 0;
+				continue;
 			}
 
-			rf.stats.c_brush_polys++;
+			if( rn.meshlist->worldSurfVis[s] ) {
+				if( culled & ( 1 << k ) ) {
+					rn.meshlist->worldSurfVis[s] = 0;
+				}
+				rn.meshlist->worldSurfFullVis[s] = 0;
+			}
+			else {
+				if( rn.meshlist->worldSurfFullVis[s] ) {
+					// a fully visible surface, mark as visible
+					rn.meshlist->worldSurfVis[s] = 1;
+				}
+			}
+
+			if( rn.meshlist->worldSurfVis[s] ) {
+				rn.meshlist->worldDrawSurfVis[surf->drawSurf - 1] = 1;
+
+				if( surf->flags & SURF_SKY ) {
+					R_ClipSkySurface( &rn.skyDrawSurface, surf );
+				}
+
+				rf.stats.c_brush_polys++;
+			}
 		}
 	}
 }
@@ -105,6 +105,13 @@ void Sys_Thread_Yield( void ) {
 	Sys_Sleep( 0 );
 }
 
+/*
+* Sys_Thread_NumCores
+*/
+int Sys_Thread_NumCores( void ) {
+	return SDL_GetCPUCount();
+}
+
 /*
 * Sys_Atomic_Add
 */
@@ -119,6 +126,20 @@ bool Sys_Atomic_CAS( volatile int *value, int oldval, int newval ) {
 	return SDL_AtomicCAS( ( SDL_atomic_t * )value, newval, oldval ) == SDL_TRUE;
 }
 
+/*
+* Sys_Atomic_LoadPtr
+*/
+void *Sys_Atomic_LoadPtr( void *volatile *ptr ) {
+	return SDL_AtomicGetPtr( ( void ** )ptr );
+}
+
+/*
+* Sys_Atomic_StorePtr
+*/
+void Sys_Atomic_StorePtr( void *volatile *ptr, void *value ) {
+	SDL_AtomicSetPtr( ( void ** )ptr, value );
+}
+
 /*
 * Sys_CondVar_Create
 */
@@ -173,3 +194,14 @@ void Sys_CondVar_Wake( qcondvar_t *cond ) {
 
 	SDL_CondSignal( cond->c );
 }
+
+/*
+* Sys_CondVar_WakeAll
+*/
+void Sys_CondVar_WakeAll( qcondvar_t *cond ) {
+	if( !cond ) {
+		return;
+	}
+
+	SDL_CondBroadcast( cond->c );
+}
@@ -21,3 +21,10 @@ uint64_t Sys_Microseconds( void ) {
 	}
 	return 1000000ULL * ( SDL_GetPerformanceCounter() - base ) / freq;
 }
+
+uint64_t Sys_Nanoseconds( void ) {
+	Uint64 now = SDL_GetPerformanceCounter();
+
+	// split the conversion so that the multiplication can't overflow
+	return ( now / freq ) * 1000000000ULL + ( now % freq ) * 1000000000ULL / freq;
+}
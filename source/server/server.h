@@ -125,6 +125,7 @@ typedef struct client_s {
 	bool reliable;                  // no need for acks, connection is reliable
 	bool mv;                        // send multiview data to the client
 	bool individual_socket;         // client has it's own socket that has to be checked separately
+	bool benchmark;                 // fake client fed with usercmds by sv_benchmark or a usercmd replay
 
 	socket_t socket;
 
@@ -289,6 +290,8 @@ extern cvar_t *sv_http_port;
 extern cvar_t *sv_http_upstream_baseurl;
 extern cvar_t *sv_http_upstream_ip;
 extern cvar_t *sv_http_upstream_realip_header;
+extern cvar_t *sv_http_maxconnections;
+extern cvar_t *sv_http_maxconnections_per_addr;
 #endif
 
 extern cvar_t *sv_skilllevel;
@@ -480,6 +483,42 @@ void SV_DemoGet_f( client_t *client );
 
 bool SV_IsDemoDownloadRequest( const char *request );
 
+//
+// sv_bench.c
+//
+typedef enum {
+	SV_BENCH_OTHER,
+	SV_BENCH_READPACKETS,
+	SV_BENCH_GAMEFRAME,
+	SV_BENCH_SNAPFRAME,
+	SV_BENCH_SENDMESSAGES,
+
+	SV_BENCH_NUM_STAGES
+} sv_bench_stage_t;
+
+bool SV_Bench_Running( void );
+void SV_Bench_Mark( sv_bench_stage_t stage );
+void SV_Bench_WriteSnap( client_t *client );
+void SV_Bench_Run( int numFrames );
+void SV_Bench_Stop( void );
+void SV_Bench_f( void );
+
+//
+// sv_replay.c
+//
+void SV_UcmdRec_Connect( const client_t *client );
+void SV_UcmdRec_Disconnect( const client_t *client );
+void SV_UcmdRec_Ucmd( const client_t *client, const usercmd_t *ucmd );
+void SV_UcmdRec_Command( const client_t *client, const char *cmd );
+void SV_UcmdRec_Stop( void );
+
+void SV_Replay_Frame( void );
+unsigned SV_Replay_FrameTime( unsigned gamemsec );
+void SV_Replay_Stop( void );
+
+void SV_Replay_InitCommands( void );
+void SV_Replay_ShutdownCommands( void );
+
 //
 // sv_motd.c
 //
@@ -0,0 +1,365 @@
+/*
+Copyright (C) 2017 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// sv_bench.c -- headless server benchmark driven by synthetic clients
+#include "server.h"
+
+#define SV_BENCH_DEFAULT_CLIENTS    16
+#define SV_BENCH_DEFAULT_FRAMES     3000
+#define SV_BENCH_RANDOM_SEED        0x5eed
+
+typedef struct {
+	bool running;
+	bool countingAllocs;
+	int64_t *frameTimes;
+	int64_t lastMark;
+	int64_t stageTime[SV_BENCH_NUM_STAGES];     // microseconds
+
+	int numSnaps;
+	int64_t snapBytes;
+	int maxSnapBytes;
+
+	bool scripted[MAX_CLIENTS];     // clients playing the scripted usercmd stream
+} sv_bench_t;
+
+static sv_bench_t sv_bench;
+
+static const char *sv_bench_stageNames[SV_BENCH_NUM_STAGES] = {
+	"other",
+	"read packets",
+	"game frame",
+	"snap frame",
+	"send messages"
+};
+
+/*
+* SV_Bench_Running
+*/
+bool SV_Bench_Running( void ) {
+	return sv_bench.running;
+}
+
+/*
+* SV_Bench_Mark
+*
+* Charges the time elapsed since the previous mark to the given stage.
+*/
+void SV_Bench_Mark( sv_bench_stage_t stage ) {
+	int64_t now;
+
+	if( !sv_bench.running ) {
+		return;
+	}
+
+	now = Sys_Microseconds();
+	sv_bench.stageTime[stage] += now - sv_bench.lastMark;
+	sv_bench.lastMark = now;
+}
+
+/*
+* SV_Bench_WriteSnap
+*
+* Builds and writes the snapshot a real client would receive, without
+* transmitting it. The client is assumed to acknowledge every frame.
+*/
+void SV_Bench_WriteSnap( client_t *client ) {
+	msg_t msg;
+	uint8_t msg_buffer[MAX_MSGLEN];
+
+	MSG_Init( &msg, msg_buffer, sizeof( msg_buffer ) );
+
+	SV_BuildClientFrameSnap( client );
+
+	SV_WriteFrameSnapToClient( client, &msg );
+
+	client->lastframe = sv.framenum;
+
+	sv_bench.numSnaps++;
+	sv_bench.snapBytes += msg.cursize;
+	if( (int)msg.cursize > sv_bench.maxSnapBytes ) {
+		sv_bench.maxSnapBytes = msg.cursize;
+	}
+}
+
+/*
+* SV_Bench_NextRandom
+*/
+static unsigned SV_Bench_NextRandom( unsigned *seed ) {
+	*seed = *seed * 1103515245 + 12345;
+	return ( *seed >> 16 ) & 0x7fff;
+}
+
+/*
+* SV_Bench_ScriptedUcmd
+*
+* Generates a deterministic usercmd stream: run around turning,
+* strafe and jump in bursts and fire every now and then.
+*/
+static void SV_Bench_ScriptedUcmd( int clientNum, int frameNum, usercmd_t *ucmd ) {
+	unsigned seed = SV_BENCH_RANDOM_SEED + clientNum * 7919 + ( frameNum >> 5 );
+	unsigned r = SV_Bench_NextRandom( &seed );
+
+	memset( ucmd, 0, sizeof( *ucmd ) );
+
+	ucmd->angles[YAW] = ANGLE2SHORT( ( clientNum * 45 + frameNum * 3 ) % 360 );
+	ucmd->angles[PITCH] = ANGLE2SHORT( (int)( ( r & 31 ) - 16 ) );
+	ucmd->forwardmove = ( r & 3 ) ? 127 : -127;
+	ucmd->sidemove = ( r & 4 ) ? ( ( r & 8 ) ? 127 : -127 ) : 0;
+	ucmd->upmove = ( ( r & 48 ) == 48 ) ? 127 : 0;
+
+	if( r & 64 ) {
+		ucmd->buttons |= BUTTON_ATTACK;
+	}
+	if( ( r & 384 ) == 384 ) {
+		ucmd->buttons |= BUTTON_SPECIAL;
+	}
+}
+
+/*
+* SV_Bench_ConnectClients
+*/
+static int SV_Bench_ConnectClients( int numClients ) {
+	int i, num;
+	client_t *cl;
+	char userinfo[MAX_INFO_STRING];
+
+	for( i = 0, num = 0; i < numClients; i++ ) {
+		int entNum;
+
+		userinfo[0] = '\0';
+		Info_SetValueForKey( userinfo, "name", va( "bench%i", i ) );
+		Info_SetValueForKey( userinfo, "hand", "2" );
+
+		entNum = SVC_FakeConnect( userinfo, (char *)"loopback", "127.0.0.1" );
+		if( entNum < 1 ) {
+			break;
+		}
+
+		cl = svs.clients + entNum - 1;
+		cl->benchmark = true;
+		sv_bench.scripted[entNum - 1] = true;
+		cl->lastframe = -1;
+		num++;
+
+		// have them play instead of spectate
+		Cmd_TokenizeString( "join" );
+		ge->ClientCommand( cl->edict );
+	}
+
+	return num;
+}
+
+/*
+* SV_Bench_DropClients
+*/
+static void SV_Bench_DropClients( void ) {
+	int i;
+	client_t *cl;
+
+	for( i = 0, cl = svs.clients; i < sv_maxclients->integer; i++, cl++ ) {
+		if( cl->state && cl->benchmark ) {
+			SV_DropClient( cl, DROP_TYPE_GENERAL, NULL );
+			cl->benchmark = false;
+		}
+		sv_bench.scripted[i] = false;
+	}
+}
+
+/*
+* SV_Bench_QueueUcmds
+*
+* Feeds the next usercmd to every synthetic client as if it had just been
+* parsed from the network, timestamped for the upcoming game time.
+*/
+static void SV_Bench_QueueUcmds( int frameNum, int64_t serverTime ) {
+	int i;
+	client_t *cl;
+	usercmd_t *ucmd;
+
+	for( i = 0, cl = svs.clients; i < sv_maxclients->integer; i++, cl++ ) {
+		if( cl->state < CS_SPAWNED || !cl->benchmark || !sv_bench.scripted[i] ) {
+			continue;
+		}
+
+		cl->UcmdReceived++;
+		ucmd = &cl->ucmds[cl->UcmdReceived & CMD_MASK];
+		SV_Bench_ScriptedUcmd( i, frameNum, ucmd );
+		ucmd->serverTimeStamp = serverTime;
+	}
+}
+
+/*
+* SV_Bench_CmpTimes
+*/
+static int SV_Bench_CmpTimes( const void *a, const void *b ) {
+	int64_t ta = *( const int64_t * )a, tb = *( const int64_t * )b;
+	return ta < tb ? -1 : ( ta > tb ? 1 : 0 );
+}
+
+/*
+* SV_Bench_Stop
+*
+* Called when the game shuts down, which may happen in the middle of
+* a benchmark frame if the server drops with an error.
+*/
+void SV_Bench_Stop( void ) {
+	sv_bench.running = false;
+	if( sv_bench.countingAllocs ) {
+		Mem_CountAllocs( false );
+		sv_bench.countingAllocs = false;
+	}
+	if( sv_bench.frameTimes ) {
+		Mem_ZoneFree( sv_bench.frameTimes );
+		sv_bench.frameTimes = NULL;
+	}
+	memset( sv_bench.scripted, 0, sizeof( sv_bench.scripted ) );
+}
+
+/*
+* SV_Bench_Run
+*
+* Runs the given number of server frames back to back with fixed timesteps,
+* then prints per-stage timings, snapshot sizes and allocation counts.
+*/
+void SV_Bench_Run( int numFrames ) {
+	int i, step;
+	int64_t *frameTimes;
+	int64_t start, total;
+	unsigned allocs;
+	size_t poolSize;
+	double seconds;
+
+	step = svc.gameFrameTime;
+	numFrames = max( numFrames, 1 );
+
+	Com_Printf( "Benchmarking %s: %i frames of %i msec\n", sv.mapname, numFrames, step );
+
+	memset( sv_bench.stageTime, 0, sizeof( sv_bench.stageTime ) );
+	sv_bench.numSnaps = 0;
+	sv_bench.snapBytes = 0;
+	sv_bench.maxSnapBytes = 0;
+
+	frameTimes = sv_bench.frameTimes = Mem_ZoneMalloc( sizeof( *frameTimes ) * numFrames );
+
+	Mem_CountAllocs( true );
+	sv_bench.countingAllocs = true;
+	allocs = Mem_NumAllocs();
+	poolSize = Mem_PoolTotalSize( sv_mempool );
+	start = Sys_Microseconds();
+
+	sv_bench.running = true;
+	for( i = 0; i < numFrames && sv.state == ss_game; i++ ) {
+		int64_t frameStart;
+
+		SV_Bench_QueueUcmds( i, svs.gametime + step );
+
+		frameStart = sv_bench.lastMark = Sys_Microseconds();
+		SV_Frame( step, step );
+		if( !sv_bench.running ) {
+			// the game was shut down from within the frame
+			break;
+		}
+		SV_Bench_Mark( SV_BENCH_OTHER );
+
+		frameTimes[i] = sv_bench.lastMark - frameStart;
+	}
+
+	if( !sv_bench.running ) {
+		Com_Printf( "The server went down during the benchmark\n" );
+		return;
+	}
+	sv_bench.running = false;
+
+	total = Sys_Microseconds() - start;
+	allocs = Mem_NumAllocs() - allocs;
+	Mem_CountAllocs( false );
+	sv_bench.countingAllocs = false;
+	numFrames = i;
+
+	SV_Bench_DropClients();
+
+	if( !numFrames ) {
+		Com_Printf( "The server went down during the benchmark\n" );
+		SV_Bench_Stop();
+		return;
+	}
+
+	qsort( frameTimes, numFrames, sizeof( *frameTimes ), SV_Bench_CmpTimes );
+
+	seconds = (double)numFrames * step / 1000.0;
+
+	Com_Printf( "Ran %i frames in %.3f sec (%.1f frames per sec, %.1fx realtime)\n",
+				numFrames, total / 1000000.0, numFrames * 1000000.0 / max( total, 1 ),
+				seconds * 1000000.0 / max( total, 1 ) );
+	Com_Printf( "Frame time: avg %.1f, median %" PRIi64 ", 99th %" PRIi64 ", max %" PRIi64 " usec\n",
+				(double)total / numFrames, frameTimes[numFrames / 2],
+				frameTimes[( numFrames * 99 ) / 100], frameTimes[numFrames - 1] );
+	for( i = 0; i < SV_BENCH_NUM_STAGES; i++ ) {
+		Com_Printf( "  %-14s %8.1f usec/frame\n", sv_bench_stageNames[i], (double)sv_bench.stageTime[i] / numFrames );
+	}
+	if( sv_bench.numSnaps ) {
+		double avgBytes = (double)sv_bench.snapBytes / sv_bench.numSnaps;
+
+		Com_Printf( "Snapshots: %i, avg %.0f bytes, max %i bytes, %.2f KB/s per client\n",
+					sv_bench.numSnaps, avgBytes, sv_bench.maxSnapBytes, avgBytes * 1000.0 / svc.snapFrameTime / 1024.0 );
+	}
+	Com_Printf( "Allocations: %u (%.1f per frame), server pool grew by %" PRIi64 " bytes\n",
+				allocs, (double)allocs / numFrames, (int64_t)Mem_PoolTotalSize( sv_mempool ) - (int64_t)poolSize );
+
+	SV_Bench_Stop();
+}
+
+/*
+* SV_Bench_f
+*
+* sv_benchmark <map> [clients] [frames]
+*
+* Loads the map, connects synthetic clients playing a scripted usercmd
+* stream and runs the benchmark. Combine with +quit on the dedicated server
+* command line for unattended regression runs.
+*/
+void SV_Bench_f( void ) {
+	int numClients, numFrames;
+
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <map> [clients] [frames]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+	if( sv_bench.running ) {
+		return;
+	}
+
+	numClients = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : SV_BENCH_DEFAULT_CLIENTS;
+	numClients = Q_bound( 0, numClients, sv_maxclients->integer );
+	numFrames = Cmd_Argc() > 3 ? atoi( Cmd_Argv( 3 ) ) : SV_BENCH_DEFAULT_FRAMES;
+
+	// go through the regular map command so the usual validation applies
+	srand( SV_BENCH_RANDOM_SEED );
+	Cmd_ExecuteString( va( "map \"%s\"", Cmd_Argv( 1 ) ) );
+	if( sv.state != ss_game ) {
+		Com_Printf( "Couldn't start the benchmark map\n" );
+		return;
+	}
+
+	numClients = SV_Bench_ConnectClients( numClients );
+	Com_Printf( "Connected %i scripted clients\n", numClients );
+
+	SV_Bench_Run( numFrames );
+}
@@ -397,9 +397,14 @@ void SV_InitOperatorCommands( void ) {
 
 	Cmd_AddCommand( "cvarcheck", SV_CvarCheck_f );
 
+	Cmd_AddCommand( "sv_benchmark", SV_Bench_f );
+
+	SV_Replay_InitCommands();
+
 	Cmd_SetCompletionFunc( "map", SV_MapComplete_f );
 	Cmd_SetCompletionFunc( "devmap", SV_MapComplete_f );
 	Cmd_SetCompletionFunc( "gamemap", SV_MapComplete_f );
+	Cmd_SetCompletionFunc( "sv_benchmark", SV_MapComplete_f );
 }
 
 /*
@@ -429,4 +434,8 @@ void SV_ShutdownOperatorCommands( void ) {
 	}
 
 	Cmd_RemoveCommand( "cvarcheck" );
+
+	Cmd_RemoveCommand( "sv_benchmark" );
+
+	SV_Replay_ShutdownCommands();
 }
@@ -184,6 +184,8 @@ void SV_DropClient( client_t *drop, int type, const char *format, ... ) {
 		reason = NULL;
 	}
 
+	SV_UcmdRec_Disconnect( drop );
+
 	// remove the rating of the client
 	if( drop->edict ) {
 		ge->RemoveRating( drop->edict );
@@ -464,6 +466,8 @@ static void SV_Begin_f( client_t *client ) {
 
 	// call the game begin function
 	ge->ClientBegin( client->edict );
+
+	SV_UcmdRec_Connect( client );
 }
 
 //=============================================================================
@@ -840,6 +844,7 @@ static void SV_ExecuteUserCommand( client_t *client, const char *s ) {
 	}
 
 	if( client->state >= CS_SPAWNED && !u->name && sv.state == ss_game ) {
+		SV_UcmdRec_Command( client, s );
 		ge->ClientCommand( client->edict );
 	}
 }
@@ -899,7 +904,8 @@ void SV_ExecuteClientThinks( int clientNum ) {
 		return;
 	}
 
-	if( client->edict->r.svflags & SVF_FAKECLIENT ) {
+	// benchmark clients come with server-generated usercmds
+	if( ( client->edict->r.svflags & SVF_FAKECLIENT ) && !client->benchmark ) {
 		return;
 	}
 
@@ -920,6 +926,8 @@ void SV_ExecuteClientThinks( int clientNum ) {
 
 		ge->ClientThink( client->edict, ucmd, timeDelta );
 
+		SV_UcmdRec_Ucmd( client, ucmd );
+
 		client->UcmdTime = ucmd->serverTimeStamp;
 	}
 
@@ -518,6 +518,9 @@ void SV_InitGameProgs( void ) {
 
 	import.Mem_Alloc = PF_MemAlloc;
 	import.Mem_Free = PF_MemFree;
+	import.Mem_ScratchAlloc = _Mem_ScratchAlloc;
+	import.Mem_ScratchMark = Mem_ScratchMark;
+	import.Mem_ScratchFreeToMark = Mem_ScratchFreeToMark;
 
 	import.Cvar_Get = Cvar_Get;
 	import.Cvar_Set = Cvar_Set;
@@ -553,6 +556,13 @@ void SV_InitGameProgs( void ) {
 	import.MM_SendQuery = SV_MM_SendQuery;
 	import.MM_GameState = SV_MM_GameState;
 
+	import.Jobs_NumWorkers = QJobs_NumWorkers;
+	import.Jobs_Schedule = QJobs_Schedule;
+	import.Jobs_Wait = QJobs_Wait;
+
+	import.Prof_Enter = Prof_Enter;
+	import.Prof_Leave = Prof_Leave;
+
 	// clear module manifest string
 	assert( sizeof( manifest ) >= MAX_INFO_STRING );
 	memset( manifest, 0, sizeof( manifest ) );
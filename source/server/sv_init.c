@@ -438,6 +438,10 @@ void SV_ShutdownGame( const char *finalmsg, bool reconnect ) {
 		SV_Demo_Stop_f();
 	}
 
+	SV_UcmdRec_Stop();
+	SV_Replay_Stop();
+	SV_Bench_Stop();
+
 	if( svs.clients ) {
 		SV_FinalMessage( finalmsg, reconnect );
 	}
@@ -510,6 +514,9 @@ void SV_Map( const char *level, bool devmap ) {
 		SV_Demo_Stop_f();
 	}
 
+	SV_UcmdRec_Stop();
+	SV_Replay_Stop();
+
 	// skip the end-of-unit flag if necessary
 	if( level[0] == '*' ) {
 		level++;
@@ -57,6 +57,8 @@ cvar_t *sv_http_port;
 cvar_t *sv_http_upstream_baseurl;
 cvar_t *sv_http_upstream_ip;
 cvar_t *sv_http_upstream_realip_header;
+cvar_t *sv_http_maxconnections;
+cvar_t *sv_http_maxconnections_per_addr;
 #endif
 
 cvar_t *sv_showclamp;
@@ -389,7 +391,7 @@ static bool SV_RunGameFrame( int msec ) {
 	}
 
 	// if there aren't pending packets to be sent, we can sleep
-	if( dedicated->integer && !sentFragments && !refreshSnapshot ) {
+	if( dedicated->integer && !sentFragments && !refreshSnapshot && !SV_Bench_Running() ) {
 		int sleeptime = min( WORLDFRAMETIME - ( accTime + 1 ), sv.nextSnapTime - ( svs.gametime + 1 ) );
 
 		if( sleeptime > 0 ) {
@@ -433,7 +435,11 @@ static bool SV_RunGameFrame( int msec ) {
 			time_before_game = Sys_Milliseconds();
 		}
 
+		SV_Bench_Mark( SV_BENCH_OTHER );
+		Prof_Enter( "G_RunFrame" );
 		ge->RunFrame( moduleTime, svs.gametime );
+		Prof_Leave();
+		SV_Bench_Mark( SV_BENCH_GAMEFRAME );
 
 		if( host_speeds->integer ) {
 			time_after_game = Sys_Milliseconds();
@@ -446,7 +452,11 @@ static bool SV_RunGameFrame( int msec ) {
 
 		// set up for sending a snapshot
 		sv.framenum++;
+		SV_Bench_Mark( SV_BENCH_OTHER );
+		Prof_Enter( "G_SnapFrame" );
 		ge->SnapFrame();
+		Prof_Leave();
+		SV_Bench_Mark( SV_BENCH_SNAPFRAME );
 
 		// set time for next snapshot
 		extraSnapTime = (int)( svs.gametime - sv.nextSnapTime );
@@ -634,14 +644,24 @@ void SV_Frame( unsigned realmsec, unsigned gamemsec ) {
 		return;
 	}
 
+	// recordings may be played back faster or slower than real time
+	gamemsec = SV_Replay_FrameTime( gamemsec );
+
 	svs.realtime += realmsec;
 	svs.gametime += gamemsec;
 
 	// check timeouts
 	SV_CheckTimeouts();
 
+	// feed recorded clients
+	SV_Replay_Frame();
+
 	// get packets from clients
+	SV_Bench_Mark( SV_BENCH_OTHER );
+	Prof_Enter( "SV_ReadPackets" );
 	SV_ReadPackets();
+	Prof_Leave();
+	SV_Bench_Mark( SV_BENCH_READPACKETS );
 
 	// apply latched userinfo changes
 	SV_CheckLatchedUserinfoChanges();
@@ -649,7 +669,11 @@ void SV_Frame( unsigned realmsec, unsigned gamemsec ) {
 	// let everything in the world think and move
 	if( SV_RunGameFrame( gamemsec ) ) {
 		// send messages back to the clients that had packets read this frame
+		SV_Bench_Mark( SV_BENCH_OTHER );
+		Prof_Enter( "SV_SendClientMessages" );
 		SV_SendClientMessages();
+		Prof_Leave();
+		SV_Bench_Mark( SV_BENCH_SENDMESSAGES );
 
 		// write snap to server demo file
 		SV_Demo_WriteSnap();
@@ -800,6 +824,8 @@ void SV_Init( void ) {
 	sv_http_upstream_baseurl =  Cvar_Get( "sv_http_upstream_baseurl", "", CVAR_ARCHIVE | CVAR_LATCH );
 	sv_http_upstream_realip_header = Cvar_Get( "sv_http_upstream_realip_header", "", CVAR_ARCHIVE );
 	sv_http_upstream_ip = Cvar_Get( "sv_http_upstream_ip", "", CVAR_ARCHIVE );
+	sv_http_maxconnections = Cvar_Get( "sv_http_maxconnections", "64", CVAR_ARCHIVE | CVAR_LATCH );
+	sv_http_maxconnections_per_addr = Cvar_Get( "sv_http_maxconnections_per_addr", "3", CVAR_ARCHIVE );
 #endif
 
 	rcon_password =         Cvar_Get( "rcon_password", "", 0 );
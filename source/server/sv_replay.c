@@ -0,0 +1,609 @@
+/*
+Copyright (C) 2017 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// sv_replay.c -- usercmd stream recording and playback
+#include "server.h"
+
+/*
+* File layout:
+*
+* header: "UCMD", int32 version, string mapname
+* records: uint8 type, ubase128 msecs since the previous record, uint8 client, payload
+*   UCR_CONNECT: string userinfo
+*   UCR_DISCONNECT: nothing
+*   UCR_UCMD: usercmd delta from the client's previous one, with the
+*     timestamp stored as its age at execution time
+*   UCR_COMMAND: string command
+* trailer: uint8 UCR_END, int32 total duration in msecs
+*/
+
+#define UCR_MAGIC           "UCMD"
+#define UCR_VERSION         1
+#define UCR_DIR             "replays"
+#define UCR_EXTENSION       ".ucr"
+
+#define UCR_BUFFER_SIZE     0x10000
+#define UCR_MAX_RECORD      ( MAX_STRING_CHARS + 64 )
+
+enum {
+	UCR_CONNECT = 1,
+	UCR_DISCONNECT,
+	UCR_UCMD,
+	UCR_COMMAND,
+	UCR_END
+};
+
+typedef struct {
+	int file;
+	char *filename;
+	int64_t basetime;
+	int64_t lasttime;
+	int numRecords;
+
+	bool recorded[MAX_CLIENTS];
+	usercmd_t lastcmd[MAX_CLIENTS];
+
+	msg_t msg;
+	uint8_t msgData[UCR_BUFFER_SIZE];
+} sv_ucmdrec_t;
+
+typedef struct {
+	bool active;
+	uint8_t *data;
+	msg_t msg;
+	int64_t basetime;
+	int64_t nexttime;
+	int duration;
+	float speed;                // game time advances this much faster than real time
+	float frac;                 // fractional msecs left over from scaling
+
+	int slots[MAX_CLIENTS];     // recorded client -> server slot + 1
+	usercmd_t lastcmd[MAX_CLIENTS];
+} sv_replay_t;
+
+static sv_ucmdrec_t *sv_ucmdrec;
+static sv_replay_t sv_replay;
+
+/*
+=============================================================================
+
+RECORDING
+
+=============================================================================
+*/
+
+/*
+* SV_UcmdRec_Flush
+*/
+static void SV_UcmdRec_Flush( bool force ) {
+	msg_t *msg = &sv_ucmdrec->msg;
+
+	if( !msg->cursize ) {
+		return;
+	}
+	if( !force && msg->cursize + UCR_MAX_RECORD < msg->maxsize ) {
+		return;
+	}
+
+	FS_Write( msg->data, msg->cursize, sv_ucmdrec->file );
+	MSG_Clear( msg );
+}
+
+/*
+* SV_UcmdRec_BeginRecord
+*/
+static msg_t *SV_UcmdRec_BeginRecord( int type, int clientNum ) {
+	msg_t *msg = &sv_ucmdrec->msg;
+	int64_t time = svs.gametime - sv_ucmdrec->basetime;
+
+	MSG_WriteUint8( msg, type );
+	MSG_WriteUintBase128( msg, time - sv_ucmdrec->lasttime );
+	MSG_WriteUint8( msg, clientNum );
+
+	sv_ucmdrec->lasttime = time;
+	sv_ucmdrec->numRecords++;
+	return msg;
+}
+
+/*
+* SV_UcmdRec_Recordable
+*/
+static int SV_UcmdRec_Recordable( const client_t *client ) {
+	int clientNum = client - svs.clients;
+
+	if( !sv_ucmdrec || !client->edict || ( client->edict->r.svflags & SVF_FAKECLIENT ) ) {
+		return -1;
+	}
+	return clientNum;
+}
+
+/*
+* SV_UcmdRec_Connect
+*
+* Called when a client enters the game.
+*/
+void SV_UcmdRec_Connect( const client_t *client ) {
+	int clientNum = SV_UcmdRec_Recordable( client );
+
+	if( clientNum < 0 ) {
+		return;
+	}
+
+	MSG_WriteString( SV_UcmdRec_BeginRecord( UCR_CONNECT, clientNum ), client->userinfo );
+	memset( &sv_ucmdrec->lastcmd[clientNum], 0, sizeof( usercmd_t ) );
+	sv_ucmdrec->recorded[clientNum] = true;
+
+	SV_UcmdRec_Flush( false );
+}
+
+/*
+* SV_UcmdRec_Disconnect
+*/
+void SV_UcmdRec_Disconnect( const client_t *client ) {
+	int clientNum = SV_UcmdRec_Recordable( client );
+
+	if( clientNum < 0 || !sv_ucmdrec->recorded[clientNum] ) {
+		return;
+	}
+
+	SV_UcmdRec_BeginRecord( UCR_DISCONNECT, clientNum );
+	sv_ucmdrec->recorded[clientNum] = false;
+
+	SV_UcmdRec_Flush( false );
+}
+
+/*
+* SV_UcmdRec_Ucmd
+*
+* Called for each usercmd as it gets executed.
+*/
+void SV_UcmdRec_Ucmd( const client_t *client, const usercmd_t *ucmd ) {
+	int clientNum = SV_UcmdRec_Recordable( client );
+	usercmd_t cmd;
+
+	if( clientNum < 0 || !sv_ucmdrec->recorded[clientNum] ) {
+		return;
+	}
+
+	cmd = *ucmd;
+	cmd.serverTimeStamp = svs.gametime - ucmd->serverTimeStamp;
+
+	MSG_WriteDeltaUsercmd( SV_UcmdRec_BeginRecord( UCR_UCMD, clientNum ), &sv_ucmdrec->lastcmd[clientNum], &cmd );
+	sv_ucmdrec->lastcmd[clientNum] = cmd;
+
+	SV_UcmdRec_Flush( false );
+}
+
+/*
+* SV_UcmdRec_Command
+*
+* Called for client commands that are passed on to the game module.
+*/
+void SV_UcmdRec_Command( const client_t *client, const char *cmd ) {
+	int clientNum = SV_UcmdRec_Recordable( client );
+
+	if( clientNum < 0 || !sv_ucmdrec->recorded[clientNum] ) {
+		return;
+	}
+
+	MSG_WriteString( SV_UcmdRec_BeginRecord( UCR_COMMAND, clientNum ), cmd );
+
+	SV_UcmdRec_Flush( false );
+}
+
+/*
+* SV_UcmdRec_Start_f
+*/
+static void SV_UcmdRec_Start_f( void ) {
+	int i, size;
+	client_t *cl;
+
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <name>\n", Cmd_Argv( 0 ) );
+		return;
+	}
+	if( sv_ucmdrec ) {
+		Com_Printf( "Already recording\n" );
+		return;
+	}
+	if( sv.state != ss_game ) {
+		Com_Printf( "Must be in a level to record\n" );
+		return;
+	}
+
+	sv_ucmdrec = Mem_ZoneMalloc( sizeof( *sv_ucmdrec ) );
+
+	size = strlen( UCR_DIR ) + 1 + strlen( Cmd_Argv( 1 ) ) + strlen( UCR_EXTENSION ) + 1;
+	sv_ucmdrec->filename = Mem_ZoneMalloc( size );
+	Q_snprintfz( sv_ucmdrec->filename, size, "%s/%s", UCR_DIR, Cmd_Argv( 1 ) );
+	COM_SanitizeFilePath( sv_ucmdrec->filename );
+	COM_DefaultExtension( sv_ucmdrec->filename, UCR_EXTENSION, size );
+
+	if( !COM_ValidateRelativeFilename( sv_ucmdrec->filename ) ||
+		FS_FOpenFile( sv_ucmdrec->filename, &sv_ucmdrec->file, FS_WRITE ) == -1 ) {
+		Com_Printf( "Error: Couldn't open file: %s\n", sv_ucmdrec->filename );
+		Mem_ZoneFree( sv_ucmdrec->filename );
+		Mem_ZoneFree( sv_ucmdrec );
+		sv_ucmdrec = NULL;
+		return;
+	}
+
+	MSG_Init( &sv_ucmdrec->msg, sv_ucmdrec->msgData, sizeof( sv_ucmdrec->msgData ) );
+	MSG_WriteData( &sv_ucmdrec->msg, UCR_MAGIC, 4 );
+	MSG_WriteInt32( &sv_ucmdrec->msg, UCR_VERSION );
+	MSG_WriteString( &sv_ucmdrec->msg, sv.mapname );
+
+	sv_ucmdrec->basetime = svs.gametime;
+
+	// clients already in the game enter right away, those on a team rejoin one
+	for( i = 0, cl = svs.clients; i < sv_maxclients->integer; i++, cl++ ) {
+		if( cl->state < CS_SPAWNED ) {
+			continue;
+		}
+
+		SV_UcmdRec_Connect( cl );
+		if( cl->edict->s.team ) { // not a spectator
+			SV_UcmdRec_Command( cl, "join" );
+		}
+	}
+
+	Com_Printf( "Recording usercmds: %s\n", sv_ucmdrec->filename );
+}
+
+/*
+* SV_UcmdRec_Stop
+*/
+void SV_UcmdRec_Stop( void ) {
+	int64_t duration;
+
+	if( !sv_ucmdrec ) {
+		return;
+	}
+
+	duration = svs.gametime - sv_ucmdrec->basetime;
+
+	MSG_WriteUint8( &sv_ucmdrec->msg, UCR_END );
+	MSG_WriteInt32( &sv_ucmdrec->msg, (int)duration );
+	SV_UcmdRec_Flush( true );
+
+	FS_FCloseFile( sv_ucmdrec->file );
+
+	Com_Printf( "Stopped recording usercmds: %s, %i records, %.1f seconds\n",
+				sv_ucmdrec->filename, sv_ucmdrec->numRecords, duration / 1000.0 );
+
+	Mem_ZoneFree( sv_ucmdrec->filename );
+	Mem_ZoneFree( sv_ucmdrec );
+	sv_ucmdrec = NULL;
+}
+
+/*
+=============================================================================
+
+PLAYBACK
+
+=============================================================================
+*/
+
+/*
+* SV_Replay_Connect
+*/
+static void SV_Replay_Connect( int clientNum, const char *recordedUserinfo ) {
+	int entNum;
+	client_t *cl;
+	char userinfo[MAX_INFO_STRING];
+
+	Q_strncpyz( userinfo, recordedUserinfo, sizeof( userinfo ) );
+	Info_RemoveKey( userinfo, "cl_mm_session" );
+
+	entNum = SVC_FakeConnect( userinfo, (char *)"loopback", "127.0.0.1" );
+	if( entNum < 1 ) {
+		Com_Printf( "Replay: no free slot for recorded client %i\n", clientNum );
+		return;
+	}
+
+	cl = svs.clients + entNum - 1;
+	cl->benchmark = true;
+	cl->lastframe = -1;
+
+	sv_replay.slots[clientNum] = entNum;
+	memset( &sv_replay.lastcmd[clientNum], 0, sizeof( usercmd_t ) );
+}
+
+/*
+* SV_Replay_Client
+*/
+static client_t *SV_Replay_Client( int clientNum ) {
+	client_t *cl;
+
+	if( !sv_replay.slots[clientNum] ) {
+		return NULL;
+	}
+
+	cl = svs.clients + sv_replay.slots[clientNum] - 1;
+	if( cl->state < CS_SPAWNED || !cl->benchmark ) {
+		sv_replay.slots[clientNum] = 0;
+		return NULL;
+	}
+	return cl;
+}
+
+/*
+* SV_Replay_Stop
+*/
+void SV_Replay_Stop( void ) {
+	int i;
+	client_t *cl;
+
+	if( !sv_replay.active ) {
+		return;
+	}
+
+	for( i = 0; i < MAX_CLIENTS; i++ ) {
+		if( ( cl = SV_Replay_Client( i ) ) != NULL ) {
+			SV_DropClient( cl, DROP_TYPE_GENERAL, NULL );
+			cl->benchmark = false;
+		}
+	}
+
+	FS_FreeFile( sv_replay.data );
+	memset( &sv_replay, 0, sizeof( sv_replay ) );
+}
+
+/*
+* SV_Replay_PeekTime
+*
+* Advances the due time to that of the next record.
+*/
+static void SV_Replay_PeekTime( void ) {
+	msg_t *msg = &sv_replay.msg;
+	size_t readcount = msg->readcount;
+
+	if( MSG_ReadUint8( msg ) == UCR_END ) {
+		sv_replay.nexttime = sv_replay.duration;
+	} else {
+		sv_replay.nexttime += MSG_ReadUintBase128( msg );
+	}
+	msg->readcount = readcount;
+}
+
+/*
+* SV_Replay_FrameTime
+*
+* Scales the game time of a server frame by the playback speed.
+*/
+unsigned SV_Replay_FrameTime( unsigned gamemsec ) {
+	float msec;
+
+	if( !sv_replay.active || sv_replay.speed == 1.0f ) {
+		return gamemsec;
+	}
+
+	msec = gamemsec * sv_replay.speed + sv_replay.frac;
+	sv_replay.frac = msec - (unsigned)msec;
+	return (unsigned)msec;
+}
+
+/*
+* SV_Replay_Frame
+*
+* Feeds all records that are due by the current game time.
+*/
+void SV_Replay_Frame( void ) {
+	msg_t *msg = &sv_replay.msg;
+
+	if( !sv_replay.active ) {
+		return;
+	}
+
+	while( sv_replay.basetime + sv_replay.nexttime <= svs.gametime ) {
+		int type, clientNum;
+		client_t *cl;
+		usercmd_t *ucmd;
+
+		type = MSG_ReadUint8( msg );
+		if( type == UCR_END || msg->readcount > msg->cursize ) {
+			Com_Printf( "Replay finished\n" );
+			SV_Replay_Stop();
+			return;
+		}
+
+		MSG_ReadUintBase128( msg ); // already accounted for in nexttime
+		clientNum = MSG_ReadUint8( msg );
+
+		cl = SV_Replay_Client( clientNum );
+
+		switch( type ) {
+			case UCR_CONNECT:
+				if( cl ) {
+					SV_DropClient( cl, DROP_TYPE_GENERAL, NULL );
+				}
+				SV_Replay_Connect( clientNum, MSG_ReadString( msg ) );
+				break;
+
+			case UCR_DISCONNECT:
+				if( cl ) {
+					SV_DropClient( cl, DROP_TYPE_GENERAL, NULL );
+					cl->benchmark = false;
+				}
+				sv_replay.slots[clientNum] = 0;
+				break;
+
+			case UCR_UCMD:
+				MSG_ReadDeltaUsercmd( msg, &sv_replay.lastcmd[clientNum], &sv_replay.lastcmd[clientNum] );
+				if( cl ) {
+					cl->UcmdReceived++;
+					ucmd = &cl->ucmds[cl->UcmdReceived & CMD_MASK];
+					*ucmd = sv_replay.lastcmd[clientNum];
+					ucmd->serverTimeStamp = svs.gametime - sv_replay.lastcmd[clientNum].serverTimeStamp;
+				}
+				break;
+
+			case UCR_COMMAND:
+				Cmd_TokenizeString( MSG_ReadString( msg ) );
+				if( cl ) {
+					ge->ClientCommand( cl->edict );
+				}
+				break;
+
+			default:
+				Com_Printf( "Replay: bad record type %i\n", type );
+				SV_Replay_Stop();
+				return;
+		}
+
+		SV_Replay_PeekTime();
+	}
+}
+
+/*
+* SV_Replay_Start_f
+*
+* sv_ucmdreplay <name> [speed]
+*
+* Plays the recording back as part of the regular server frame, with game
+* time scaled by the speed factor (1 is real time). Speed 0 runs it through
+* the benchmark as fast as possible.
+*/
+static void SV_Replay_Start_f( void ) {
+	int length, version;
+	size_t readcount;
+	char filename[MAX_QPATH];
+	char mapname[MAX_QPATH];
+	bool benchmark;
+	float speed;
+	uint8_t *data;
+
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <name> [speed: 1 realtime, 0 benchmark]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+	if( sv_replay.active || SV_Bench_Running() ) {
+		Com_Printf( "Already replaying\n" );
+		return;
+	}
+
+	speed = Cmd_Argc() > 2 ? atof( Cmd_Argv( 2 ) ) : 1.0f;
+	if( speed < 0 ) {
+		Com_Printf( "Speed can't be negative\n" );
+		return;
+	}
+
+	// the benchmark steps the frames itself, so it doesn't need any scaling
+	benchmark = speed == 0;
+	if( benchmark ) {
+		speed = 1.0f;
+	}
+
+	Q_snprintfz( filename, sizeof( filename ), "%s/%s", UCR_DIR, Cmd_Argv( 1 ) );
+	COM_SanitizeFilePath( filename );
+	COM_DefaultExtension( filename, UCR_EXTENSION, sizeof( filename ) );
+
+	length = FS_LoadFile( filename, (void **)&data, NULL, 0 );
+	if( !data ) {
+		Com_Printf( "Couldn't load %s\n", filename );
+		return;
+	}
+
+	memset( &sv_replay, 0, sizeof( sv_replay ) );
+	sv_replay.data = data;
+	MSG_Init( &sv_replay.msg, data, length );
+	sv_replay.msg.cursize = length;
+
+	version = 0;
+	if( length > 9 && !memcmp( data, UCR_MAGIC, 4 ) && data[length - 5] == UCR_END ) {
+		sv_replay.msg.readcount = 4;
+		version = MSG_ReadInt32( &sv_replay.msg );
+		Q_strncpyz( mapname, MSG_ReadString( &sv_replay.msg ), sizeof( mapname ) );
+		readcount = sv_replay.msg.readcount;
+
+		sv_replay.msg.readcount = length - 4;
+		sv_replay.duration = MSG_ReadInt32( &sv_replay.msg );
+		sv_replay.msg.readcount = readcount;
+	}
+	if( version != UCR_VERSION ) {
+		Com_Printf( "%s is not a complete usercmd recording\n", filename );
+		FS_FreeFile( data );
+		memset( &sv_replay, 0, sizeof( sv_replay ) );
+		return;
+	}
+
+	Cmd_ExecuteString( va( "map \"%s\"", mapname ) );
+	if( sv.state != ss_game ) {
+		Com_Printf( "Couldn't start the replay map %s\n", mapname );
+		FS_FreeFile( data );
+		memset( &sv_replay, 0, sizeof( sv_replay ) );
+		return;
+	}
+
+	// the map command has reset the state, pick it up again
+	sv_replay.active = true;
+	sv_replay.basetime = svs.gametime;
+	sv_replay.speed = speed;
+
+	SV_Replay_PeekTime();
+
+	Com_Printf( "Replaying %s on %s, %.1f seconds%s\n", filename, mapname, sv_replay.duration / 1000.0,
+				benchmark ? " as fast as possible" : va( " at %gx speed", speed ) );
+
+	if( benchmark ) {
+		SV_Bench_Run( sv_replay.duration / max( svc.gameFrameTime, 1 ) + 1 );
+		SV_Replay_Stop();
+	}
+}
+
+/*
+* SV_UcmdRec_Stop_f
+*/
+static void SV_UcmdRec_Stop_f( void ) {
+	if( !sv_ucmdrec ) {
+		Com_Printf( "No usercmd recording in progress\n" );
+	}
+	SV_UcmdRec_Stop();
+}
+
+/*
+* SV_Replay_Stop_f
+*/
+static void SV_Replay_Stop_f( void ) {
+	if( !sv_replay.active ) {
+		Com_Printf( "No usercmd replay in progress\n" );
+	}
+	SV_Replay_Stop();
+}
+
+/*
+* SV_Replay_InitCommands
+*/
+void SV_Replay_InitCommands( void ) {
+	Cmd_AddCommand( "sv_ucmdrecord", SV_UcmdRec_Start_f );
+	Cmd_AddCommand( "sv_ucmdrecordstop", SV_UcmdRec_Stop_f );
+	Cmd_AddCommand( "sv_ucmdreplay", SV_Replay_Start_f );
+	Cmd_AddCommand( "sv_ucmdreplaystop", SV_Replay_Stop_f );
+}
+
+/*
+* SV_Replay_ShutdownCommands
+*/
+void SV_Replay_ShutdownCommands( void ) {
+	Cmd_RemoveCommand( "sv_ucmdrecord" );
+	Cmd_RemoveCommand( "sv_ucmdrecordstop" );
+	Cmd_RemoveCommand( "sv_ucmdreplay" );
+	Cmd_RemoveCommand( "sv_ucmdreplaystop" );
+}
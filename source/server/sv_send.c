@@ -411,6 +411,9 @@ void SV_SendClientMessages( void ) {
 		}
 
 		if( client->edict && ( client->edict->r.svflags & SVF_FAKECLIENT ) ) {
+			if( client->benchmark && client->state == CS_SPAWNED ) {
+				SV_Bench_WriteSnap( client );
+			}
 			client->lastSentFrameNum = sv.framenum;
 			continue;
 		}
@@ -24,8 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #ifdef HTTP_SUPPORT
 
-#define MAX_INCOMING_HTTP_CONNECTIONS           48
-#define MAX_INCOMING_HTTP_CONNECTIONS_PER_ADDR  3
+#define MAX_INCOMING_HTTP_CONNECTIONS           4096
 
 #define MAX_INCOMING_CONTENT_LENGTH             0x2800
 
@@ -33,6 +32,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define INCOMING_HTTP_CONNECTION_SEND_TIMEOUT   15 // seconds
 
 #define HTTP_SERVER_SLEEP_TIME                  50 // milliseconds
+#define HTTP_SERVER_QUERY_SLEEP_TIME            5 // milliseconds, while waiting for the game module
 
 typedef enum {
 	HTTP_CONN_STATE_NONE = 0,
@@ -97,6 +97,7 @@ typedef struct {
 
 	int file;
 	int fileno;
+	size_t file_length;
 	size_t file_data_offset;
 	size_t file_send_pos;
 	char *filename;
@@ -109,6 +110,7 @@ typedef struct sv_http_connection_s {
 
 	socket_t socket;
 	netadr_t address;
+	int poll_events;
 
 	int64_t last_active;
 
@@ -131,11 +133,13 @@ typedef unsigned (*queueCmdHandler_t)( const void * );
 static bool sv_http_initialized = false;
 static volatile bool sv_http_running = false;
 
-static sv_http_connection_t sv_http_connections[MAX_INCOMING_HTTP_CONNECTIONS];
+static int sv_http_max_connections;
+static sv_http_connection_t *sv_http_connections;
 static sv_http_connection_t sv_http_connection_headnode, *sv_free_http_connections;
 
 static socket_t sv_socket_http;
 static socket_t sv_socket_http6;
+static net_poll_t *sv_http_poll;
 
 static netadr_t sv_web_upstream_addr;
 
@@ -229,6 +233,7 @@ static void SV_Web_ResetResponse( sv_http_response_t *response ) {
 		response->file = 0;
 	}
 	response->fileno = -1;
+	response->file_length = 0;
 	response->file_data_offset = 0;
 	response->file_send_pos = 0;
 
@@ -266,6 +271,7 @@ static sv_http_connection_t *SV_Web_AllocConnection( void ) {
 	con->state = HTTP_CONN_STATE_NONE;
 	con->close_after_resp = false;
 	con->is_upstream = false;
+	con->poll_events = 0;
 	return con;
 }
 
@@ -287,19 +293,32 @@ static void SV_Web_FreeConnection( sv_http_connection_t *con ) {
 	sv_free_http_connections = con;
 }
 
+/*
+* SV_Web_CloseConnection
+*/
+static void SV_Web_CloseConnection( sv_http_connection_t *con ) {
+	if( con->socket.open ) {
+		NET_PollRemove( sv_http_poll, &con->socket );
+		NET_CloseSocket( &con->socket );
+	}
+	SV_Web_FreeConnection( con );
+}
+
 /*
 * SV_Web_InitConnections
 */
 static void SV_Web_InitConnections( void ) {
-	unsigned int i;
+	int i;
 
-	memset( sv_http_connections, 0, sizeof( sv_http_connections ) );
+	sv_http_max_connections = Q_bound( 1, sv_http_maxconnections->integer, MAX_INCOMING_HTTP_CONNECTIONS );
+	sv_http_connections = Mem_ZoneMalloc( sizeof( *sv_http_connections ) * sv_http_max_connections );
+	memset( sv_http_connections, 0, sizeof( *sv_http_connections ) * sv_http_max_connections );
 
 	// link decals
 	sv_free_http_connections = sv_http_connections;
 	sv_http_connection_headnode.prev = &sv_http_connection_headnode;
 	sv_http_connection_headnode.next = &sv_http_connection_headnode;
-	for( i = 0; i < MAX_INCOMING_HTTP_CONNECTIONS - 2; i++ ) {
+	for( i = 0; i < sv_http_max_connections - 1; i++ ) {
 		sv_http_connections[i].next = &sv_http_connections[i + 1];
 	}
 }
@@ -314,10 +333,7 @@ static void SV_Web_ShutdownConnections( void ) {
 	hnode = &sv_http_connection_headnode;
 	for( con = hnode->prev; con != hnode; con = next ) {
 		next = con->prev;
-		if( con->open ) {
-			NET_CloseSocket( &con->socket );
-			SV_Web_FreeConnection( con );
-		}
+		SV_Web_CloseConnection( con );
 	}
 }
 
@@ -446,12 +462,11 @@ static unsigned SV_Web_ConnectionLimitReached( const netadr_t *addr ) {
 	cnt = 0;
 	for( con = hnode->prev; con != hnode; con = next ) {
 		next = con->prev;
-		if( NET_CompareAddress( addr, &con->address ) ) {
-			if( cnt >= MAX_INCOMING_HTTP_CONNECTIONS_PER_ADDR ) {
+		if( NET_CompareBaseAddress( addr, &con->address ) ) {
+			if( ++cnt >= (unsigned)sv_http_maxconnections_per_addr->integer ) {
 				return true;
 			}
 		}
-		cnt++;
 	}
 	return false;
 }
@@ -539,28 +554,34 @@ typedef struct {
 * SV_Web_IssueQueryInCmd
 */
 static void SV_Web_IssueQueryInCmd( sv_http_response_t *response, http_query_method_t method, const char *resource, const char *query_string ) {
-	queryInCmd_t cmd;
-	cmd.id = CMD_QUERY_IN;
-	cmd.response = response;
-	cmd.request_id = response->request_id;
-	cmd.method = method;
-	cmd.resource = ( char * )resource;
-	cmd.query_string = ( char * )query_string;
-	QBufPipe_WriteCmd( sv_http_incoming_queue, &cmd, sizeof( cmd ) );
+	queryInCmd_t *cmd = QBufPipe_AllocCmd( sv_http_incoming_queue, sizeof( *cmd ) );
+	if( !cmd ) {
+		return;
+	}
+	cmd->id = CMD_QUERY_IN;
+	cmd->response = response;
+	cmd->request_id = response->request_id;
+	cmd->method = method;
+	cmd->resource = ( char * )resource;
+	cmd->query_string = ( char * )query_string;
+	QBufPipe_CommitCmd( sv_http_incoming_queue, sizeof( *cmd ) );
 }
 
 /*
 * SV_Web_IssueQueryOutCmd
 */
 static void SV_Web_IssueQueryOutCmd( void *response, uint64_t request_id, http_response_code_t code, char *content, size_t content_length ) {
-	queryOutCmd_t cmd;
-	cmd.id = CMD_QUERY_OUT;
-	cmd.response = response;
-	cmd.request_id = request_id;
-	cmd.code = code;
-	cmd.content = content;
-	cmd.content_length = content_length;
-	QBufPipe_WriteCmd( sv_http_outgoing_queue, &cmd, sizeof( cmd ) );
+	queryOutCmd_t *cmd = QBufPipe_AllocCmd( sv_http_outgoing_queue, sizeof( *cmd ) );
+	if( !cmd ) {
+		return;
+	}
+	cmd->id = CMD_QUERY_OUT;
+	cmd->response = response;
+	cmd->request_id = request_id;
+	cmd->code = code;
+	cmd->content = content;
+	cmd->content_length = content_length;
+	QBufPipe_CommitCmd( sv_http_outgoing_queue, sizeof( *cmd ) );
 }
 
 /*
@@ -725,6 +746,51 @@ static void SV_Web_ParseStartLine( sv_http_request_t *request, char *line ) {
 	}
 }
 
+/*
+* SV_Web_ParseRange
+*
+* Only a single byte range is supported: "bytes=first-last", "bytes=first-" or "bytes=-suffix".
+* Anything else is ignored and the whole entity is sent, as permitted by RFC 7233.
+*/
+static void SV_Web_ParseRange( sv_http_request_t *request, const char *value ) {
+	const char *p;
+	char *end;
+	long first = -1, last = -1;
+
+	if( Q_strnicmp( value, "bytes=", 6 ) || strchr( value, ',' ) ) {
+		return;
+	}
+
+	p = value + 6;
+	while( *p == ' ' ) {
+		p++;
+	}
+	if( *p >= '0' && *p <= '9' ) {
+		first = strtol( p, &end, 10 );
+		p = end;
+	}
+	if( *p != '-' ) {
+		return;
+	}
+	p++;
+	if( *p >= '0' && *p <= '9' ) {
+		last = strtol( p, &end, 10 );
+		p = end;
+	}
+	while( *p == ' ' ) {
+		p++;
+	}
+
+	if( *p || ( first < 0 && last < 0 ) || ( first >= 0 && last >= 0 && last < first ) ) {
+		return;
+	}
+
+	// first < 0 means the last 'last' bytes, last < 0 means till the end of the file
+	request->partial = true;
+	request->partial_content_range.begin = first;
+	request->partial_content_range.end = last;
+}
+
 /*
 * SV_Web_AnalyzeHeader
 */
@@ -749,55 +815,7 @@ static void SV_Web_AnalyzeHeader( sv_http_request_t *request, const char *key, c
 		}
 	} else if( !Q_stricmp( key, "Range" )
 			   && ( request->method == HTTP_METHOD_GET || request->method == HTTP_METHOD_HEAD ) ) {
-		const char *delim = strchr( value, '-' );
-
-		if( Q_strnicmp( value, "bytes=", 6 ) || !delim ) {
-			request->error = HTTP_RESP_BAD_REQUEST;
-		} else {
-			bool neg_end = false;
-			const char *p = value;
-
-			// first byte pos
-			while( *p && p < delim ) {
-				if( *p >= '0' && *p <= '9' ) {
-					stream->content_range.begin = stream->content_range.begin * 10 + *p - '0';
-				}
-				p++;
-			}
-			p++;
-
-			// last byte pos
-			if( *p == '-' ) {
-				if( value != delim ) {
-					request->error = HTTP_RESP_REQUESTED_RANGE_NOT_SATISFIABLE;
-					return;
-				}
-				neg_end = true;
-				p++;
-			}
-			while( *p ) {
-				if( *p >= '0' && *p <= '9' ) {
-					stream->content_range.end = stream->content_range.end * 10 + *p++ - '0';
-				}
-			}
-
-			// partial content request
-			if( neg_end && stream->content_range.end ) {
-				// bytes=-100
-				request->partial = true;
-				stream->content_range.end = -stream->content_range.end;
-			} else if( stream->content_range.end >= stream->content_range.begin ) {
-				// bytes=200-300
-				request->partial = true;
-			} else if( stream->content_range.begin >= 0 && *( delim + 1 ) == '\0' ) {
-				// bytes=200-
-				request->partial = true;
-			}
-
-			if( request->partial ) {
-				request->partial_content_range = stream->content_range;
-			}
-		}
+		SV_Web_ParseRange( request, value );
 	} else if( !Q_stricmp( key, "X-Client" ) ) {
 		request->clientNum = atoi( value );
 	} else if( !Q_stricmp( key, "X-Session" ) ) {
@@ -1112,24 +1130,32 @@ static void SV_Web_RespondToQuery( sv_http_connection_t *con ) {
 
 		// serve range requests
 		if( request->partial && response->file ) {
-			// seek to first byte pos and clamp the last byte pos to content length
-			if( request->partial_content_range.begin > 0 ) {
-				FS_Seek( response->file, request->partial_content_range.begin, FS_SEEK_SET );
-				// range.end may be set to 0 for 'bytes=100-' style requests
-				response->stream.content_range.end = request->partial_content_range.end
-													 ? request->partial_content_range.end : content_length;
-
-			} else if( request->partial_content_range.end < 0 ) {
-				// seek to N last bytes in the file
-				FS_Seek( response->file, request->partial_content_range.end, FS_SEEK_END );
-				response->stream.content_range.end = -request->partial_content_range.end;
+			long first = request->partial_content_range.begin;
+			long last = request->partial_content_range.end;
+			long length = (long)content_length;
+
+			if( first < 0 ) {
+				// the last N bytes of the file
+				first = last >= length ? 0 : length - last;
+				last = last > 0 ? length - 1 : -1;
+			} else if( last < 0 || last >= length ) {
+				last = length - 1;
 			}
 
-			// Content-Range header values
-			response->file_send_pos = FS_Tell( response->file );
-			response->stream.content_range.begin = response->file_send_pos;
-			response->stream.content_range.end = min( (int)content_length, response->stream.content_range.end );
-			response->code = HTTP_RESP_PARTIAL_CONTENT;
+			if( first >= length || last < first ) {
+				// don't send the file body with the error response
+				response->code = HTTP_RESP_REQUESTED_RANGE_NOT_SATISFIABLE;
+				response->file_length = content_length;
+				FS_FCloseFile( response->file );
+				response->file = 0;
+				con->close_after_resp = true;
+			} else {
+				// sendfile offsets are relative to the start of the file data
+				response->file_send_pos = first;
+				response->stream.content_range.begin = first;
+				response->stream.content_range.end = last;
+				response->code = HTTP_RESP_PARTIAL_CONTENT;
+			}
 		}
 
 		if( request->method == HTTP_METHOD_HEAD && response->file ) {
@@ -1148,22 +1174,23 @@ static void SV_Web_RespondToQuery( sv_http_connection_t *con ) {
 				sizeof( resp_stream->header_buf ) );
 
 	if( response->code == HTTP_RESP_REQUESTED_RANGE_NOT_SATISFIABLE ) {
-		int file_length = FS_FOpenBaseFile( request->resource, NULL, FS_READ );
-
-		// in accordance with RFC 2616, send the Content-Range entity header,
+		// in accordance with RFC 7233, send the Content-Range entity header,
 		// specifying the length of the resource
-		if( file_length < 0 ) {
-			Q_strncatz( resp_stream->header_buf, "Content-Range: bytes */*\r\n",
-						sizeof( resp_stream->header_buf ) );
-		} else {
-			Q_snprintfz( vastr, sizeof( vastr ), "Content-Range: bytes */%" PRIuPTR "\r\n", (uintptr_t)content_length );
-			Q_strncatz( resp_stream->header_buf, vastr, sizeof( resp_stream->header_buf ) );
-		}
+		Q_snprintfz( vastr, sizeof( vastr ), "Content-Range: bytes */%" PRIuPTR "\r\n", (uintptr_t)response->file_length );
+		Q_strncatz( resp_stream->header_buf, vastr, sizeof( resp_stream->header_buf ) );
 	} else if( response->code == HTTP_RESP_PARTIAL_CONTENT ) {
 		Q_snprintfz( vastr, sizeof( vastr ), "Content-Range: bytes %" PRIuPTR "-%" PRIuPTR "/%" PRIuPTR "\r\n",
 					(uintptr_t)response->stream.content_range.begin, (uintptr_t)response->stream.content_range.end, (uintptr_t)content_length );
 		Q_strncatz( resp_stream->header_buf, vastr, sizeof( resp_stream->header_buf ) );
-		content_length = response->stream.content_range.end - response->stream.content_range.begin;
+		content_length = response->stream.content_range.end - response->stream.content_range.begin + 1;
+	}
+
+	if( con->close_after_resp ) {
+		Q_strncatz( resp_stream->header_buf, "Connection: close\r\n", sizeof( resp_stream->header_buf ) );
+	} else {
+		Q_snprintfz( vastr, sizeof( vastr ), "Connection: keep-alive\r\nKeep-Alive: timeout=%i\r\n",
+					 INCOMING_HTTP_CONNECTION_RECV_TIMEOUT );
+		Q_strncatz( resp_stream->header_buf, vastr, sizeof( resp_stream->header_buf ) );
 	}
 
 	if( response->code >= HTTP_RESP_BAD_REQUEST || !content_length ) {
@@ -1190,6 +1217,13 @@ static void SV_Web_RespondToQuery( sv_http_connection_t *con ) {
 	Q_strncatz( resp_stream->header_buf, "\r\n", sizeof( resp_stream->header_buf ) );
 
 	header_length = strlen( resp_stream->header_buf );
+
+	// responses to HEAD requests carry the headers of the GET response, but no body
+	if( request->method == HTTP_METHOD_HEAD ) {
+		content = NULL;
+		content_length = 0;
+	}
+
 	if( content && content_length ) {
 		if( content_length + header_length < sizeof( resp_stream->header_buf ) ) {
 			resp_stream->content = resp_stream->header_buf + header_length;
@@ -1373,9 +1407,434 @@ static void SV_Web_Listen( socket_t *socket ) {
 		con->open = true;
 		con->state = HTTP_CONN_STATE_RECV;
 		con->is_upstream = is_upstream;
+
+		if( !NET_PollAdd( sv_http_poll, &con->socket, NET_POLL_READ, con ) ) {
+			Com_DPrintf( "HTTP connection poll error: %s\n", NET_ErrorString() );
+			NET_CloseSocket( &con->socket );
+			SV_Web_FreeConnection( con );
+			continue;
+		}
+		con->poll_events = NET_POLL_READ;
+	}
+}
+
+/*
+* SV_Web_UpdatePollEvents
+*
+* Connections only wait for the events their current state needs, so idle
+* keep-alive connections don't wake the server thread.
+*/
+static void SV_Web_UpdatePollEvents( sv_http_connection_t *con ) {
+	int events;
+
+	switch( con->state ) {
+		case HTTP_CONN_STATE_RECV:
+			events = NET_POLL_READ;
+			break;
+		case HTTP_CONN_STATE_RESP:
+			// waiting for the game module doesn't involve the socket
+			events = con->response.content_state == CONTENT_STATE_AWAITING ? 0 : NET_POLL_WRITE;
+			break;
+		case HTTP_CONN_STATE_SEND:
+			events = NET_POLL_WRITE;
+			break;
+		default:
+			events = 0;
+			break;
+	}
+
+	if( events == con->poll_events ) {
+		return;
+	}
+
+	if( !NET_PollModify( sv_http_poll, &con->socket, events, con ) ) {
+		Com_DPrintf( "HTTP connection poll error: %s\n", NET_ErrorString() );
+		con->open = false;
+		return;
+	}
+	con->poll_events = events;
+}
+
+/*
+* SV_Web_PollEvent
+*/
+static void SV_Web_PollEvent( int events, void *privatep ) {
+	sv_http_connection_t *con;
+
+	if( privatep == &sv_socket_http || privatep == &sv_socket_http6 ) {
+		SV_Web_Listen( ( socket_t * )privatep );
+		return;
+	}
+
+	con = ( sv_http_connection_t * )privatep;
+	if( !con->open ) {
+		return;
+	}
+
+	// hangups are reported regardless of the events the connection waits for,
+	// so they must be handled here or the poll keeps returning immediately
+	if( events & NET_POLL_ERROR ) {
+		Com_DPrintf( "HTTP connection closed by %s\n", NET_AddressToString( &con->address ) );
+		con->open = false;
+		return;
+	}
+
+	if( ( events & NET_POLL_READ ) && con->state == HTTP_CONN_STATE_RECV ) {
+		SV_Web_ReceiveRequest( &con->socket, con );
+	}
+
+	// start responding as soon as the request is complete, without another trip through the poll
+	if( con->open && con->state != HTTP_CONN_STATE_RECV ) {
+		SV_Web_WriteResponse( &con->socket, con );
+	}
+}
+
+// ============================================================================
+// Load test
+// Downloads a file over a number of local connections to measure aggregate throughput.
+// Runs in its own thread so that neither the game nor the web server thread are blocked.
+
+#define HTTP_LOADTEST_TIMEOUT                   60000 // milliseconds
+
+typedef struct {
+	socket_t socket;
+	bool connected;
+	bool done;
+	int events;
+	int requests;
+	size_t request_p;
+	char header_buf[0x1000];
+	size_t header_buf_p;
+	bool header_done;
+	int64_t content_left;
+} sv_http_loadtest_con_t;
+
+static struct {
+	qthread_t *thread;
+	volatile bool running;
+	volatile bool quit;
+	net_poll_t *poll;
+	sv_http_loadtest_con_t *cons;
+	int numCons;
+	char session[HTTP_CLIENT_SESSION_SIZE];
+	char request[MAX_STRING_CHARS];
+	size_t request_length;
+	int requests_per_con;
+	int active;
+	int completed;
+	int failed;
+	uint64_t bytes;
+} sv_http_loadtest;
+
+/*
+* SV_Web_LoadTestFinish
+*/
+static void SV_Web_LoadTestFinish( sv_http_loadtest_con_t *con, bool failed ) {
+	if( con->done ) {
+		return;
+	}
+
+	if( failed ) {
+		sv_http_loadtest.failed++;
+	}
+
+	con->done = true;
+	sv_http_loadtest.active--;
+	NET_PollRemove( sv_http_loadtest.poll, &con->socket );
+	NET_CloseSocket( &con->socket );
+}
+
+/*
+* SV_Web_LoadTestReadHeader
+*
+* Returns the number of body bytes that came along with the header.
+*/
+static int SV_Web_LoadTestReadHeader( sv_http_loadtest_con_t *con, int received ) {
+	char *end;
+	const char *p;
+	size_t header_length;
+
+	con->header_buf_p += received;
+	con->header_buf[con->header_buf_p] = '\0';
+
+	end = strstr( con->header_buf, "\r\n\r\n" );
+	if( !end ) {
+		if( con->header_buf_p >= sizeof( con->header_buf ) - 1 ) {
+			SV_Web_LoadTestFinish( con, true );
+		}
+		return 0;
+	}
+
+	header_length = end + 4 - con->header_buf;
+	*end = '\0';
+
+	p = strchr( con->header_buf, ' ' );
+	if( !p || atoi( p + 1 ) != HTTP_RESP_OK ) {
+		SV_Web_LoadTestFinish( con, true );
+		return 0;
+	}
+
+	p = Q_strlocate( con->header_buf, "Content-Length:", 0 );
+	if( !p ) {
+		SV_Web_LoadTestFinish( con, true );
+		return 0;
+	}
+
+	con->header_done = true;
+	con->content_left = atoll( p + strlen( "Content-Length:" ) );
+	return con->header_buf_p - header_length;
+}
+
+/*
+* SV_Web_LoadTestEvent
+*/
+static void SV_Web_LoadTestEvent( int events, void *privatep ) {
+	int ret, events_wanted;
+	bool received = false;
+	static char recvbuf[0x10000];
+	sv_http_loadtest_con_t *con = privatep;
+
+	if( con->done ) {
+		return;
+	}
+
+	if( !con->connected ) {
+		connection_status_t status = NET_CheckConnect( &con->socket );
+		if( status == CONNECTION_FAILED ) {
+			SV_Web_LoadTestFinish( con, true );
+			return;
+		}
+		if( status != CONNECTION_SUCCEEDED ) {
+			return;
+		}
+		con->connected = true;
+	}
+
+	if( ( events & NET_POLL_WRITE ) && con->request_p < sv_http_loadtest.request_length ) {
+		ret = NET_Send( &con->socket, sv_http_loadtest.request + con->request_p,
+						sv_http_loadtest.request_length - con->request_p, &con->socket.remoteAddress );
+		if( ret < 0 ) {
+			SV_Web_LoadTestFinish( con, true );
+			return;
+		}
+		con->request_p += ret;
+	}
+
+	if( events & NET_POLL_READ ) {
+		while( true ) {
+			if( !con->header_done ) {
+				ret = NET_Get( &con->socket, NULL, con->header_buf + con->header_buf_p,
+							   sizeof( con->header_buf ) - con->header_buf_p - 1 );
+			} else {
+				ret = NET_Get( &con->socket, NULL, recvbuf, min( (int64_t)sizeof( recvbuf ), con->content_left ) );
+			}
+
+			if( ret < 0 ) {
+				SV_Web_LoadTestFinish( con, true );
+				return;
+			}
+			if( ret == 0 ) {
+				if( !received ) {
+					// readable, but no data: closed on the other end
+					SV_Web_LoadTestFinish( con, true );
+					return;
+				}
+				break;
+			}
+			received = true;
+
+			if( !con->header_done ) {
+				ret = SV_Web_LoadTestReadHeader( con, ret );
+				if( con->done || !con->header_done ) {
+					continue;
+				}
+			}
+
+			con->content_left -= ret;
+			sv_http_loadtest.bytes += ret;
+
+			if( con->content_left <= 0 ) {
+				sv_http_loadtest.completed++;
+				if( ++con->requests >= sv_http_loadtest.requests_per_con ) {
+					SV_Web_LoadTestFinish( con, false );
+					return;
+				}
+
+				// issue the next request over the same connection
+				con->request_p = 0;
+				con->header_buf_p = 0;
+				con->header_done = false;
+				break;
+			}
+		}
+	}
+
+	events_wanted = NET_POLL_READ;
+	if( con->request_p < sv_http_loadtest.request_length ) {
+		events_wanted |= NET_POLL_WRITE;
+	}
+	if( events_wanted != con->events ) {
+		NET_PollModify( sv_http_loadtest.poll, &con->socket, events_wanted, con );
+		con->events = events_wanted;
 	}
 }
 
+/*
+* SV_Web_LoadTestThread
+*/
+static void *SV_Web_LoadTestThread( void *param ) {
+	int i;
+	int64_t start, elapsed;
+	sv_http_loadtest_con_t *con;
+
+	start = Sys_Milliseconds();
+
+	for( i = 0, con = sv_http_loadtest.cons; i < sv_http_loadtest.numCons; i++, con++ ) {
+		if( !con->done ) {
+			con->events = NET_POLL_READ | NET_POLL_WRITE;
+			NET_PollAdd( sv_http_loadtest.poll, &con->socket, con->events, con );
+		}
+	}
+
+	while( sv_http_loadtest.active > 0 && !sv_http_loadtest.quit && Sys_Milliseconds() - start < HTTP_LOADTEST_TIMEOUT ) {
+		NET_Poll( sv_http_loadtest.poll, 10, SV_Web_LoadTestEvent );
+	}
+
+	elapsed = max( Sys_Milliseconds() - start, 1 );
+
+	for( i = 0, con = sv_http_loadtest.cons; i < sv_http_loadtest.numCons; i++, con++ ) {
+		SV_Web_LoadTestFinish( con, true );
+	}
+
+	NET_DestroyPoll( &sv_http_loadtest.poll );
+	Mem_ZoneFree( sv_http_loadtest.cons );
+	sv_http_loadtest.cons = NULL;
+	SV_Web_RemoveGameClient( sv_http_loadtest.session );
+
+	Com_Printf( "%i connections, %i/%i requests completed, %i failed\n", sv_http_loadtest.numCons, sv_http_loadtest.completed,
+				sv_http_loadtest.numCons * sv_http_loadtest.requests_per_con, sv_http_loadtest.failed );
+	Com_Printf( "%.2f MB in %.3f s: %.2f MB/s, %.1f requests/s\n", sv_http_loadtest.bytes / ( 1024.0 * 1024.0 ),
+				elapsed / 1000.0, sv_http_loadtest.bytes / ( 1024.0 * 1024.0 ) * 1000.0 / elapsed,
+				sv_http_loadtest.completed * 1000.0 / elapsed );
+
+	sv_http_loadtest.running = false;
+	return NULL;
+}
+
+/*
+* SV_Web_StopLoadTest
+*
+* Joins the load test thread, cancelling the test if it's still running.
+*/
+static void SV_Web_StopLoadTest( void ) {
+	if( !sv_http_loadtest.thread ) {
+		return;
+	}
+
+	sv_http_loadtest.quit = true;
+	QThread_Join( sv_http_loadtest.thread );
+	sv_http_loadtest.thread = NULL;
+}
+
+/*
+* SV_Web_LoadTest_f
+*/
+static void SV_Web_LoadTest_f( void ) {
+	int i, numCons;
+	const char *filename;
+	netadr_t address, bindAddress;
+	sv_http_loadtest_con_t *con;
+
+	if( Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <file> [connections] [requests per connection]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	if( !sv_http_running ) {
+		Com_Printf( "Web server is not running\n" );
+		return;
+	}
+
+	if( sv_http_loadtest.running ) {
+		Com_Printf( "A load test is already running\n" );
+		return;
+	}
+
+	// reap the thread of the previous test
+	SV_Web_StopLoadTest();
+
+	filename = Cmd_Argv( 1 );
+	if( FS_FOpenBaseFile( filename, NULL, FS_READ ) < 0 ) {
+		Com_Printf( "File not found: %s\n", filename );
+		return;
+	}
+
+	numCons = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 16;
+	numCons = Q_bound( 1, numCons, sv_http_max_connections );
+
+	memset( &sv_http_loadtest, 0, sizeof( sv_http_loadtest ) );
+	sv_http_loadtest.requests_per_con = max( 1, Cmd_Argc() > 3 ? atoi( Cmd_Argv( 3 ) ) : 4 );
+
+	if( sv_socket_http.address.type == NA_IP ) {
+		NET_StringToAddress( "127.0.0.1", &address );
+	} else {
+		NET_StringToAddress( "::1", &address );
+	}
+	NET_SetAddressPort( &address, sv_http_port->integer );
+	NET_InitAddress( &bindAddress, address.type );
+
+	// requests must come with a valid session
+	for( i = 0; i < HTTP_CLIENT_SESSION_SIZE - 1; i++ ) {
+		sv_http_loadtest.session[i] = 'A' + rand() % 26;
+	}
+	sv_http_loadtest.session[i] = '\0';
+	if( !SV_Web_AddGameClient( sv_http_loadtest.session, 0, &address ) ) {
+		Com_Printf( "Couldn't register load test session\n" );
+		return;
+	}
+
+	Q_snprintfz( sv_http_loadtest.request, sizeof( sv_http_loadtest.request ),
+				 "GET /files/%s HTTP/1.1\r\nHost: localhost\r\nX-Client: 0\r\nX-Session: %s\r\n\r\n", filename, sv_http_loadtest.session );
+	sv_http_loadtest.request_length = strlen( sv_http_loadtest.request );
+
+	sv_http_loadtest.poll = NET_CreatePoll();
+	if( !sv_http_loadtest.poll ) {
+		Com_Printf( "Couldn't create poll set: %s\n", NET_ErrorString() );
+		SV_Web_RemoveGameClient( sv_http_loadtest.session );
+		return;
+	}
+
+	sv_http_loadtest.numCons = numCons;
+	sv_http_loadtest.cons = Mem_ZoneMalloc( sizeof( *sv_http_loadtest.cons ) * numCons );
+	memset( sv_http_loadtest.cons, 0, sizeof( *sv_http_loadtest.cons ) * numCons );
+
+	for( i = 0, con = sv_http_loadtest.cons; i < numCons; i++, con++ ) {
+		connection_status_t status;
+
+		con->done = true;
+		if( !NET_OpenSocket( &con->socket, SOCKET_TCP, &bindAddress, false ) ) {
+			sv_http_loadtest.failed++;
+			continue;
+		}
+
+		status = NET_Connect( &con->socket, &address );
+		if( status == CONNECTION_FAILED ) {
+			NET_CloseSocket( &con->socket );
+			sv_http_loadtest.failed++;
+			continue;
+		}
+
+		con->connected = status == CONNECTION_SUCCEEDED;
+		con->done = false;
+		sv_http_loadtest.active++;
+	}
+
+	Com_Printf( "Load test started, results will be printed when it's done\n" );
+
+	sv_http_loadtest.running = true;
+	sv_http_loadtest.thread = QThread_Create( SV_Web_LoadTestThread, NULL );
+}
+
 /*
 * SV_Web_Init
 */
@@ -1384,8 +1843,6 @@ void SV_Web_Init( void ) {
 	sv_http_running = false;
 	sv_http_request_autoicr = 1;
 
-	SV_Web_InitConnections();
-
 	if( !sv_http->integer ) {
 		return;
 	}
@@ -1399,6 +1856,24 @@ void SV_Web_Init( void ) {
 		return;
 	}
 
+	sv_http_poll = NET_CreatePoll();
+	if( !sv_http_poll ) {
+		Com_Printf( "Error: Couldn't create web server poll set: %s\n", NET_ErrorString() );
+		NET_CloseSocket( &sv_socket_http );
+		NET_CloseSocket( &sv_socket_http6 );
+		sv_http_initialized = false;
+		return;
+	}
+
+	if( sv_socket_http.address.type == NA_IP ) {
+		NET_PollAdd( sv_http_poll, &sv_socket_http, NET_POLL_READ, &sv_socket_http );
+	}
+	if( sv_socket_http6.address.type == NA_IP6 ) {
+		NET_PollAdd( sv_http_poll, &sv_socket_http6, NET_POLL_READ, &sv_socket_http6 );
+	}
+
+	SV_Web_InitConnections();
+
 	sv_http_running = true;
 
 	SV_Web_InitQueues();
@@ -1406,6 +1881,8 @@ void SV_Web_Init( void ) {
 	Trie_Create( TRIE_CASE_SENSITIVE, &sv_http_clients );
 	sv_http_clients_mutex = QMutex_Create();
 	sv_http_thread = QThread_Create( SV_Web_ThreadProc, NULL );
+
+	Cmd_AddCommand( "sv_http_loadtest", SV_Web_LoadTest_f );
 }
 
 /*
@@ -1413,10 +1890,8 @@ void SV_Web_Init( void ) {
 */
 static void SV_Web_Frame( void ) {
 	sv_http_connection_t *con, *next, *hnode = &sv_http_connection_headnode;
-	socket_t *sockets[MAX_INCOMING_HTTP_CONNECTIONS + 1];
-	void *connections[MAX_INCOMING_HTTP_CONNECTIONS];
-	int num_sockets = 0;
 	bool upstream_is_set;
+	bool awaiting;
 
 	if( !sv_http_initialized ) {
 		return;
@@ -1434,50 +1909,26 @@ static void SV_Web_Frame( void ) {
 		}
 	}
 
-	// accept new connections
-	if( sv_socket_http.address.type == NA_IP ) {
-		SV_Web_Listen( &sv_socket_http );
-	}
-	if( sv_socket_http6.address.type == NA_IP6 ) {
-		SV_Web_Listen( &sv_socket_http6 );
-	}
+	// read query results from the game module
+	SV_Web_ReadOutgoingQueueCmds();
 
-	// handle incoming data
-	num_sockets = 0;
+	// game module responses don't generate socket events, so kick them off here
+	awaiting = false;
 	for( con = hnode->prev; con != hnode; con = next ) {
 		next = con->prev;
-		switch( con->state ) {
-			case HTTP_CONN_STATE_RECV:
-			case HTTP_CONN_STATE_RESP:
-			case HTTP_CONN_STATE_SEND:
-				sockets[num_sockets] = &con->socket;
-				connections[num_sockets] = con;
-				num_sockets++;
-				break;
-			default:
-				break;
+		if( con->open && con->state == HTTP_CONN_STATE_RESP ) {
+			if( con->response.content_state == CONTENT_STATE_AWAITING ) {
+				awaiting = true;
+			} else {
+				SV_Web_WriteResponse( &con->socket, con );
+			}
 		}
 	}
-	sockets[num_sockets] = NULL;
-
-	// read query results from the game module
-	SV_Web_ReadOutgoingQueueCmds();
 
-	if( num_sockets != 0 ) {
-		NET_Monitor( HTTP_SERVER_SLEEP_TIME, sockets,
-					 ( void ( * )( socket_t *, void* ) )SV_Web_ReceiveRequest,
-					 ( void ( * )( socket_t *, void* ) )SV_Web_WriteResponse,
-					 NULL, connections );
-	} else {
-		// sleep on network sockets if got nothing else to do
-		if( sv_socket_http.address.type == NA_IP ) {
-			sockets[num_sockets++] = &sv_socket_http;
-		}
-		if( sv_socket_http6.address.type == NA_IP6 ) {
-			sockets[num_sockets++] = &sv_socket_http6;
-		}
-		sockets[num_sockets] = NULL;
-		NET_Sleep( HTTP_SERVER_SLEEP_TIME, sockets );
+	// accept new connections and handle incoming and outgoing data
+	if( NET_Poll( sv_http_poll, awaiting ? HTTP_SERVER_QUERY_SLEEP_TIME : HTTP_SERVER_SLEEP_TIME, SV_Web_PollEvent ) < 0 ) {
+		Com_DPrintf( "HTTP poll error: %s\n", NET_ErrorString() );
+		Sys_Sleep( HTTP_SERVER_SLEEP_TIME );
 	}
 
 	// close dead connections
@@ -1508,9 +1959,12 @@ static void SV_Web_Frame( void ) {
 			}
 		}
 
+		if( con->open ) {
+			SV_Web_UpdatePollEvents( con );
+		}
+
 		if( !con->open ) {
-			NET_CloseSocket( &con->socket );
-			SV_Web_FreeConnection( con );
+			SV_Web_CloseConnection( con );
 		}
 	}
 }
@@ -1549,14 +2003,28 @@ void SV_Web_Shutdown( void ) {
 		return;
 	}
 
+	Cmd_RemoveCommand( "sv_http_loadtest" );
+	SV_Web_StopLoadTest();
+
 	sv_http_running = false;
 	QThread_Join( sv_http_thread );
 
 	SV_Web_DestroyQueues();
 
+	if( sv_socket_http.open ) {
+		NET_PollRemove( sv_http_poll, &sv_socket_http );
+	}
+	if( sv_socket_http6.open ) {
+		NET_PollRemove( sv_http_poll, &sv_socket_http6 );
+	}
+	NET_DestroyPoll( &sv_http_poll );
+
 	NET_CloseSocket( &sv_socket_http );
 	NET_CloseSocket( &sv_socket_http6 );
 
+	Mem_ZoneFree( sv_http_connections );
+	sv_http_connections = NULL;
+
 	sv_http_initialized = false;
 }
 
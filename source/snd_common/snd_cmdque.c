@@ -63,6 +63,26 @@ static void S_EnqueueCmd( sndCmdPipe_t *queue, const void *cmd, unsigned cmd_siz
 	trap_BufPipe_WriteCmd( queue, cmd, cmd_size );
 }
 
+/*
+* S_AllocCmd
+*
+* Returns room for the command right in the pipe, to be filled in and
+* then passed to S_CommitCmd. Returns NULL if the command is dropped.
+*/
+static void *S_AllocCmd( sndCmdPipe_t *queue, unsigned cmd_size ) {
+	if( !queue ) {
+		return NULL;
+	}
+	return trap_BufPipe_AllocCmd( queue, cmd_size );
+}
+
+/*
+* S_CommitCmd
+*/
+static void S_CommitCmd( sndCmdPipe_t *queue, unsigned cmd_size ) {
+	trap_BufPipe_CommitCmd( queue, cmd_size );
+}
+
 /*
 * S_IssueInitCmd
 */
@@ -161,19 +181,24 @@ void S_IssueSetEntitySpatializationCmd( sndCmdPipe_t *queue, const smdCmdSpatial
 void S_IssueSetListenerCmd( sndCmdPipe_t *queue, const vec3_t origin,
 							const vec3_t velocity, const mat3_t axis, bool avidump ) {
 	unsigned i;
+	sndCmdSetListener_t *cmd;
+
+	cmd = S_AllocCmd( queue, sizeof( *cmd ) );
+	if( !cmd ) {
+		return;
+	}
 
-	sndCmdSetListener_t cmd;
-	cmd.id = SND_CMD_SET_LISTENER;
-	cmd.avidump = (int)avidump;
+	cmd->id = SND_CMD_SET_LISTENER;
+	cmd->avidump = (int)avidump;
 	for( i = 0; i < 3; i++ ) {
-		cmd.origin[i] = origin[i];
-		cmd.velocity[i] = velocity[i];
+		cmd->origin[i] = origin[i];
+		cmd->velocity[i] = velocity[i];
 	}
 	for( i = 0; i < 9; i++ ) {
-		cmd.axis[i] = axis[i];
+		cmd->axis[i] = axis[i];
 	}
 
-	S_EnqueueCmd( queue, &cmd, sizeof( cmd ) );
+	S_CommitCmd( queue, sizeof( *cmd ) );
 }
 
 /*
@@ -378,25 +403,30 @@ void S_IssueSetMulEntitySpatializationCmd( sndCmdPipe_t *queue, unsigned numEnts
 
 	for( j = 0; j < numEnts; ) {
 		unsigned n;
-		sndCmdSetMulEntitySpatialization_t cmd;
+		sndCmdSetMulEntitySpatialization_t *cmd;
+
+		cmd = S_AllocCmd( queue, sizeof( *cmd ) );
+		if( !cmd ) {
+			return;
+		}
 
-		cmd.id = SND_CMD_SET_MUL_ENTITY_SPATIALIZATION;
-		cmd.numents = numEnts - j;
-		if( cmd.numents > SND_SPATIALIZE_ENTS_MAX ) {
-			cmd.numents = SND_SPATIALIZE_ENTS_MAX;
+		cmd->id = SND_CMD_SET_MUL_ENTITY_SPATIALIZATION;
+		cmd->numents = numEnts - j;
+		if( cmd->numents > SND_SPATIALIZE_ENTS_MAX ) {
+			cmd->numents = SND_SPATIALIZE_ENTS_MAX;
 		}
 
-		for( n = 0; n < cmd.numents; n++ ) {
-			cmd.entnum[n] = spat[n].entnum;
+		for( n = 0; n < cmd->numents; n++ ) {
+			cmd->entnum[n] = spat[j + n].entnum;
 			for( i = 0; i < 3; i++ ) {
-				cmd.origin[n][i] = spat[n].origin[i];
-				cmd.velocity[n][i] = spat[n].velocity[i];
+				cmd->origin[n][i] = spat[j + n].origin[i];
+				cmd->velocity[n][i] = spat[j + n].velocity[i];
 			}
 		}
 
-		S_EnqueueCmd( queue, &cmd, sizeof( cmd ) );
+		j += cmd->numents;
 
-		j += cmd.numents;
+		S_CommitCmd( queue, sizeof( *cmd ) );
 	}
 }
 
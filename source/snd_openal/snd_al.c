@@ -708,7 +708,9 @@ static int S_EnqueuedCmdsWaiter( sndCmdPipe_t *queue, pipeCmdHandler_t *cmdHandl
 
 	if( timeout || now >= s_last_update_time + UPDATE_MSEC ) {
 		s_last_update_time = now;
+		trap_Prof_Enter( "S_Update" );
 		S_Update();
+		trap_Prof_Leave();
 	}
 
 	return read;
@@ -229,6 +229,14 @@ static inline void trap_BufPipe_WriteCmd( qbufPipe_t *queue, const void *cmd, un
 	SOUND_IMPORT.BufPipe_WriteCmd( queue, cmd, cmd_size );
 }
 
+static inline void *trap_BufPipe_AllocCmd( qbufPipe_t *queue, unsigned cmd_size ) {
+	return SOUND_IMPORT.BufPipe_AllocCmd( queue, cmd_size );
+}
+
+static inline void trap_BufPipe_CommitCmd( qbufPipe_t *queue, unsigned cmd_size ) {
+	SOUND_IMPORT.BufPipe_CommitCmd( queue, cmd_size );
+}
+
 static inline int trap_BufPipe_ReadCmds( qbufPipe_t *queue, unsigned( **cmdHandlers )( const void * ) ) {
 	return SOUND_IMPORT.BufPipe_ReadCmds( queue, cmdHandlers );
 }
@@ -237,3 +245,26 @@ static inline void trap_BufPipe_Wait( qbufPipe_t *queue, int ( *read )( qbufPipe
 									  unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec ) {
 	SOUND_IMPORT.BufPipe_Wait( queue, read, cmdHandlers, timeout_msec );
 }
+
+// job system
+static inline int trap_Jobs_NumWorkers( void ) {
+	return SOUND_IMPORT.Jobs_NumWorkers();
+}
+
+static inline void trap_Jobs_Schedule( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+									   unsigned items, unsigned granularity, volatile int *counter ) {
+	SOUND_IMPORT.Jobs_Schedule( func, arg, items, granularity, counter );
+}
+
+static inline void trap_Jobs_Wait( volatile int *counter ) {
+	SOUND_IMPORT.Jobs_Wait( counter );
+}
+
+// profiler
+static inline void trap_Prof_Enter( const char *name ) {
+	SOUND_IMPORT.Prof_Enter( name );
+}
+
+static inline void trap_Prof_Leave( void ) {
+	SOUND_IMPORT.Prof_Leave();
+}
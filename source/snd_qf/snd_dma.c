@@ -1189,9 +1189,10 @@ static void S_Update( void ) {
 	int i;
 	int total;
 	channel_t *ch;
+	static int volumeModCount;
 
 	// rebuild scale tables if volume is modified
-	if( s_volume->modified ) {
+	if( Cvar_CheckModificationCount( s_volume, &volumeModCount ) ) {
 		S_InitScaletable();
 	}
 
@@ -1637,7 +1638,9 @@ static int S_EnqueuedCmdsWaiter( sndCmdPipe_t *queue, pipeCmdHandler_t *cmdHandl
 
 	if( timeout || now >= s_last_update_time + UPDATE_MSEC ) {
 		s_last_update_time = now;
+		trap_Prof_Enter( "S_Update" );
 		S_Update();
+		trap_Prof_Leave();
 	}
 
 	return read;
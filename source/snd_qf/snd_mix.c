@@ -483,7 +483,6 @@ void S_InitScaletable( void ) {
 	int i, j;
 	int scale;
 
-	s_volume->modified = false;
 	for( i = 0; i < 32; i++ ) {
 		scale = i * 8 * 256 * s_volume->value;
 		for( j = 0; j < 256; j++ )
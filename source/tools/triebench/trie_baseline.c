@@ -0,0 +1,317 @@
+/*
+Copyright (C) 2008 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include <assert.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trie_baseline.h"
+
+// one node per character, children are kept in sorted sibling lists
+
+typedef struct trie_baseline_node_s {
+	int depth;
+	char letter;
+	struct trie_baseline_node_s *child;
+	struct trie_baseline_node_s *sibling;
+	int data_is_set;
+	void *data;
+} trie_baseline_node_t;
+
+struct trie_baseline_s {
+	trie_baseline_node_t *root;
+	unsigned int size;
+	unsigned int numNodes;
+	trie_casing_t casing;
+};
+
+/*
+* TrieBaseline_LetterCompare
+*/
+static inline int TrieBaseline_LetterCompare( char left, char right, trie_casing_t casing ) {
+	if( casing == TRIE_CASE_SENSITIVE ) {
+		return ( (int) left ) - ( (int) right );
+	}
+	return ( (int) tolower( left ) ) - ( (int) tolower( right ) );
+}
+
+/*
+* TrieBaseline_CreateNode
+*/
+static trie_baseline_node_t *TrieBaseline_CreateNode( trie_baseline_t *trie, int depth, char letter, trie_baseline_node_t *sibling ) {
+	trie_baseline_node_t *node = ( trie_baseline_node_t * )malloc( sizeof( *node ) );
+
+	assert( node );
+	node->depth = depth;
+	node->letter = letter;
+	node->child = NULL;
+	node->sibling = sibling;
+	node->data_is_set = 0;
+	node->data = NULL;
+	trie->numNodes++;
+	return node;
+}
+
+/*
+* TrieBaseline_Destroy_Rec
+*/
+static void TrieBaseline_Destroy_Rec( trie_baseline_node_t *node ) {
+	if( node->sibling ) {
+		TrieBaseline_Destroy_Rec( node->sibling );
+	}
+	if( node->child ) {
+		TrieBaseline_Destroy_Rec( node->child );
+	}
+	free( node );
+}
+
+/*
+* TrieBaseline_Find_Rec
+*/
+static trie_baseline_node_t *TrieBaseline_Find_Rec( trie_baseline_node_t *node, const char *key, trie_find_mode_t mode, trie_casing_t casing ) {
+	if( !TrieBaseline_LetterCompare( *key, node->letter, casing ) ) {
+		// prefix matches
+		if( !*key || !*( key + 1 ) ) {
+			// end of key reached, see if node contains data
+			return mode == TRIE_PREFIX_MATCH || node->data_is_set ? node : NULL;
+		}
+		if( node->child ) {
+			return TrieBaseline_Find_Rec( node->child, key + 1, mode, casing );
+		}
+		return NULL;
+	}
+
+	if( node->sibling && TrieBaseline_LetterCompare( node->sibling->letter, *key, casing ) <= 0 ) {
+		// prefix does not match, but we might have a matching sibling
+		return TrieBaseline_Find_Rec( node->sibling, key, mode, casing );
+	}
+
+	if( !node->depth ) {
+		// node is root
+		if( !*key ) {
+			return mode == TRIE_PREFIX_MATCH || node->data_is_set ? node : NULL;
+		}
+		if( node->child ) {
+			return TrieBaseline_Find_Rec( node->child, key, mode, casing );
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* TrieBaseline_Insert_Rec
+*/
+static trie_error_t TrieBaseline_Insert_Rec( trie_baseline_t *trie, trie_baseline_node_t *node, const char *key, void *data ) {
+	trie_casing_t casing = trie->casing;
+
+	if( !node->depth || !TrieBaseline_LetterCompare( *key, node->letter, casing ) ) {
+		// node is root or prefix matches
+		if( ( !node->depth && !*key ) || ( node->depth && !*( key + 1 ) ) ) {
+			// end of key reached, set data
+			if( node->data_is_set ) {
+				return TRIE_DUPLICATE_KEY;
+			}
+			node->data = data;
+			node->data_is_set = 1;
+			return TRIE_OK;
+		} else {
+			const char *nextKey = node->depth ? key + 1 : key;
+
+			if( !node->child || TrieBaseline_LetterCompare( node->child->letter, *nextKey, casing ) > 0 ) {
+				// no matching child, create one
+				node->child = TrieBaseline_CreateNode( trie, node->depth + 1, *nextKey, node->child );
+			}
+			return TrieBaseline_Insert_Rec( trie, node->child, nextKey, data );
+		}
+	}
+
+	if( !node->sibling || TrieBaseline_LetterCompare( node->sibling->letter, *key, casing ) > 0 ) {
+		node->sibling = TrieBaseline_CreateNode( trie, node->depth, *key, node->sibling );
+	}
+	return TrieBaseline_Insert_Rec( trie, node->sibling, key, data );
+}
+
+/*
+* TrieBaseline_NoOfKeys
+*/
+static unsigned int TrieBaseline_NoOfKeys( const trie_baseline_node_t *node, int addSiblings ) {
+	unsigned int noOfKeys = node->data_is_set ? 1 : 0;
+
+	if( addSiblings && node->sibling ) {
+		noOfKeys += TrieBaseline_NoOfKeys( node->sibling, 1 );
+	}
+	if( node->child ) {
+		noOfKeys += TrieBaseline_NoOfKeys( node->child, 1 );
+	}
+	return noOfKeys;
+}
+
+/*
+* TrieBaseline_Dump_Rec
+*/
+static void TrieBaseline_Dump_Rec( const trie_baseline_node_t *node, trie_dump_what_t what, int dumpSiblings,
+								   const char *key_prev, trie_key_value_t **key_value_vector ) {
+	char *key = NULL;
+	int keyDumped = 0;
+
+	if( what & TRIE_DUMP_KEYS ) {
+		key = ( char * )malloc( node->depth + 1 );
+		strncpy( key, key_prev, node->depth );
+		if( node->depth ) {
+			key[node->depth - 1] = node->letter;
+		}
+		key[node->depth] = '\0';
+	}
+
+	if( node->data_is_set ) {
+		if( what & TRIE_DUMP_KEYS ) {
+			keyDumped = 1;
+			( *key_value_vector )->key = key;
+		} else {
+			( *key_value_vector )->key = NULL;
+		}
+		( *key_value_vector )->value = ( what & TRIE_DUMP_VALUES ) ? node->data : NULL;
+		++( *key_value_vector );
+	}
+
+	if( node->child ) {
+		TrieBaseline_Dump_Rec( node->child, what, 1, key, key_value_vector );
+	}
+	if( dumpSiblings && node->sibling ) {
+		TrieBaseline_Dump_Rec( node->sibling, what, 1, key, key_value_vector );
+	}
+
+	if( key && !keyDumped ) {
+		free( key );
+	}
+}
+
+/*
+* TrieBaseline_Create
+*/
+void TrieBaseline_Create( trie_casing_t casing, trie_baseline_t **trie ) {
+	*trie = ( trie_baseline_t * )malloc( sizeof( trie_baseline_t ) );
+	( *trie )->size = 0;
+	( *trie )->numNodes = 0;
+	( *trie )->casing = casing;
+	( *trie )->root = TrieBaseline_CreateNode( *trie, 0, '\0', NULL );
+}
+
+/*
+* TrieBaseline_Destroy
+*/
+void TrieBaseline_Destroy( trie_baseline_t *trie ) {
+	if( trie ) {
+		TrieBaseline_Destroy_Rec( trie->root );
+		free( trie );
+	}
+}
+
+/*
+* TrieBaseline_Insert
+*/
+trie_error_t TrieBaseline_Insert( trie_baseline_t *trie, const char *key, void *data ) {
+	if( TrieBaseline_Insert_Rec( trie, trie->root, key, data ) != TRIE_OK ) {
+		return TRIE_DUPLICATE_KEY;
+	}
+	trie->size++;
+	return TRIE_OK;
+}
+
+/*
+* TrieBaseline_Replace
+*/
+trie_error_t TrieBaseline_Replace( trie_baseline_t *trie, const char *key, void *data_new, void **data_old ) {
+	trie_baseline_node_t *node = TrieBaseline_Find_Rec( trie->root, key, TRIE_EXACT_MATCH, trie->casing );
+
+	if( !node ) {
+		return TRIE_KEY_NOT_FOUND;
+	}
+	*data_old = node->data;
+	node->data = data_new;
+	return TRIE_OK;
+}
+
+/*
+* TrieBaseline_Find
+*/
+trie_error_t TrieBaseline_Find( const trie_baseline_t *trie, const char *key, void **data ) {
+	const trie_baseline_node_t *node = TrieBaseline_Find_Rec( trie->root, key, TRIE_EXACT_MATCH, trie->casing );
+
+	if( !node ) {
+		*data = NULL;
+		return TRIE_KEY_NOT_FOUND;
+	}
+	*data = node->data;
+	return TRIE_OK;
+}
+
+/*
+* TrieBaseline_Dump
+*/
+trie_error_t TrieBaseline_Dump( const trie_baseline_t *trie, const char *prefix, trie_dump_what_t what, trie_dump_t **dump ) {
+	trie_baseline_node_t *node = TrieBaseline_Find_Rec( trie->root, prefix, TRIE_PREFIX_MATCH, trie->casing );
+
+	*dump = ( trie_dump_t * )malloc( sizeof( trie_dump_t ) );
+	( *dump )->what = what;
+	( *dump )->key_storage = NULL;
+
+	if( !node ) {
+		( *dump )->key_value_vector = NULL;
+		( *dump )->size = 0;
+		return TRIE_OK;
+	}
+
+	( *dump )->size = TrieBaseline_NoOfKeys( node, 0 );
+	( *dump )->key_value_vector = ( trie_key_value_t * )malloc( sizeof( trie_key_value_t ) * ( ( *dump )->size + 1 ) );
+	TrieBaseline_Dump_Rec( node, what, 0, prefix, &( *dump )->key_value_vector );
+	( *dump )->key_value_vector -= ( *dump )->size;
+	return TRIE_OK;
+}
+
+/*
+* TrieBaseline_FreeDump
+*/
+void TrieBaseline_FreeDump( trie_dump_t *dump ) {
+	unsigned int i;
+
+	if( !dump ) {
+		return;
+	}
+
+	for( i = 0; i < dump->size; i++ ) {
+		if( dump->key_value_vector[i].key ) {
+			free( ( char * )dump->key_value_vector[i].key );
+		}
+	}
+	free( dump->key_value_vector );
+	free( dump );
+}
+
+/*
+* TrieBaseline_GetMemoryUsage
+*
+* Doesn't account for the allocator overhead, which dominates for nodes this small.
+*/
+size_t TrieBaseline_GetMemoryUsage( const trie_baseline_t *trie ) {
+	return sizeof( *trie ) + trie->numNodes * sizeof( trie_baseline_node_t );
+}
@@ -0,0 +1,43 @@
+/*
+Copyright (C) 2008 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifndef Q_TRIE_BASELINE_H
+#define Q_TRIE_BASELINE_H
+
+#include <stddef.h>
+
+#include "../../qalgo/q_trie.h"
+
+// the character-per-node trie which q_trie used to be, kept only
+// so that triebench can compare the current one against it
+
+struct trie_baseline_s;
+typedef struct trie_baseline_s trie_baseline_t;
+
+void TrieBaseline_Create( trie_casing_t casing, trie_baseline_t **trie );
+void TrieBaseline_Destroy( trie_baseline_t *trie );
+trie_error_t TrieBaseline_Insert( trie_baseline_t *trie, const char *key, void *data );
+trie_error_t TrieBaseline_Replace( trie_baseline_t *trie, const char *key, void *data_new, void **data_old );
+trie_error_t TrieBaseline_Find( const trie_baseline_t *trie, const char *key, void **data );
+trie_error_t TrieBaseline_Dump( const trie_baseline_t *trie, const char *prefix, trie_dump_what_t what, trie_dump_t **dump );
+void TrieBaseline_FreeDump( trie_dump_t *dump );
+size_t TrieBaseline_GetMemoryUsage( const trie_baseline_t *trie );
+
+#endif // Q_TRIE_BASELINE_H
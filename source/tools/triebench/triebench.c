@@ -0,0 +1,268 @@
+/*
+Copyright (C) 2008 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+/*
+** TRIEBENCH.C
+**
+** Times q_trie against the character-per-node trie it replaced on a list of
+** names, one per line, e.g. the output of "unzip -Z1" on the game's pk3 files.
+** Both tries are case insensitive like the pack file tries, and the tool fails
+** if they disagree on any lookup or directory listing.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../qalgo/q_trie.h"
+#include "trie_baseline.h"
+
+#define MAX_NAME_LENGTH     1024
+
+/*
+* Bench_Milliseconds
+*/
+static double Bench_Milliseconds( clock_t start ) {
+	return ( clock() - start ) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/*
+* Bench_Directory
+*
+* Returns the directory part of the name, including the trailing slash
+*/
+static const char *Bench_Directory( const char *name, char *dir, size_t size ) {
+	char *slash;
+
+	strncpy( dir, name, size - 1 );
+	dir[size - 1] = '\0';
+	slash = strrchr( dir, '/' );
+	if( slash ) {
+		slash[1] = '\0';
+	} else {
+		dir[0] = '\0';
+	}
+	return dir;
+}
+
+/*
+* Bench_ReadNames
+*/
+static trie_key_value_t *Bench_ReadNames( const char *filename, int *numNames ) {
+	FILE *f;
+	int num = 0, max = 0;
+	char line[MAX_NAME_LENGTH];
+	trie_key_value_t *names = NULL;
+
+	f = fopen( filename, "r" );
+	if( !f ) {
+		return NULL;
+	}
+
+	while( fgets( line, sizeof( line ), f ) ) {
+		size_t len = strcspn( line, "\r\n" );
+
+		line[len] = '\0';
+		if( !len || line[len - 1] == '/' ) {
+			// skip directory entries
+			continue;
+		}
+
+		if( num == max ) {
+			max = max ? max * 2 : 1024;
+			names = ( trie_key_value_t * )realloc( names, max * sizeof( *names ) );
+		}
+		names[num].key = strcpy( ( char * )malloc( len + 1 ), line );
+		names[num].value = &names[num];
+		num++;
+	}
+
+	fclose( f );
+
+	*numNames = num;
+	return names;
+}
+
+int main( int argc, char **argv ) {
+	int i, j, numNames, iterations, errors;
+	size_t memInsert, memBulk, memBaseline;
+	clock_t start;
+	double insertTime, bulkTime, findTime, dumpTime;
+	double baseInsertTime, baseFindTime, baseDumpTime;
+	unsigned int numDumps;
+	trie_key_value_t *names;
+	trie_t *trie = NULL, *bulk = NULL;
+	trie_baseline_t *baseline = NULL;
+	trie_dump_t *dump, *baseDump;
+	char dir[MAX_NAME_LENGTH];
+	void *data, *baseData;
+
+	if( argc < 2 ) {
+		fprintf( stderr, "Usage: %s <namelist> [iterations]\n", argv[0] );
+		return 1;
+	}
+
+	iterations = argc > 2 ? atoi( argv[2] ) : 10;
+	if( iterations < 1 ) {
+		iterations = 1;
+	}
+
+	names = Bench_ReadNames( argv[1], &numNames );
+	if( !names || !numNames ) {
+		fprintf( stderr, "No names in %s\n", argv[1] );
+		return 1;
+	}
+
+	// the old trie, one name at a time, the way paks used to be indexed
+	start = clock();
+	for( i = 0; i < iterations; i++ ) {
+		if( baseline ) {
+			TrieBaseline_Destroy( baseline );
+		}
+		TrieBaseline_Create( TRIE_CASE_INSENSITIVE, &baseline );
+		for( j = 0; j < numNames; j++ ) {
+			if( TrieBaseline_Replace( baseline, names[j].key, names[j].value, &data ) == TRIE_KEY_NOT_FOUND ) {
+				TrieBaseline_Insert( baseline, names[j].key, names[j].value );
+			}
+		}
+	}
+	baseInsertTime = Bench_Milliseconds( start );
+	memBaseline = TrieBaseline_GetMemoryUsage( baseline );
+
+	// the same with the current trie
+	start = clock();
+	for( i = 0; i < iterations; i++ ) {
+		if( trie ) {
+			Trie_Destroy( trie );
+		}
+		Trie_Create( TRIE_CASE_INSENSITIVE, &trie );
+		for( j = 0; j < numNames; j++ ) {
+			if( Trie_Replace( trie, names[j].key, names[j].value, &data ) == TRIE_KEY_NOT_FOUND ) {
+				Trie_Insert( trie, names[j].key, names[j].value );
+			}
+		}
+	}
+	insertTime = Bench_Milliseconds( start );
+	Trie_GetMemoryUsage( trie, &memInsert );
+
+	start = clock();
+	for( i = 0; i < iterations; i++ ) {
+		if( bulk ) {
+			Trie_Destroy( bulk );
+		}
+		Trie_Create( TRIE_CASE_INSENSITIVE, &bulk );
+		Trie_InsertBulk( bulk, names, numNames );
+	}
+	bulkTime = Bench_Milliseconds( start );
+	Trie_GetMemoryUsage( bulk, &memBulk );
+
+	start = clock();
+	for( i = 0; i < iterations; i++ ) {
+		for( j = 0; j < numNames; j++ ) {
+			TrieBaseline_Find( baseline, names[j].key, &data );
+		}
+	}
+	baseFindTime = Bench_Milliseconds( start );
+
+	start = clock();
+	for( i = 0; i < iterations; i++ ) {
+		for( j = 0; j < numNames; j++ ) {
+			Trie_Find( bulk, names[j].key, TRIE_EXACT_MATCH, &data );
+		}
+	}
+	findTime = Bench_Milliseconds( start );
+
+	// list the directory of every 16th name, like FS_GetFileList does
+	numDumps = 0;
+	start = clock();
+	for( i = 0; i < iterations; i++ ) {
+		for( j = 0; j < numNames; j += 16 ) {
+			if( TrieBaseline_Dump( baseline, Bench_Directory( names[j].key, dir, sizeof( dir ) ), TRIE_DUMP_VALUES, &dump ) == TRIE_OK ) {
+				TrieBaseline_FreeDump( dump );
+			}
+			numDumps++;
+		}
+	}
+	baseDumpTime = Bench_Milliseconds( start );
+
+	start = clock();
+	for( i = 0; i < iterations; i++ ) {
+		for( j = 0; j < numNames; j += 16 ) {
+			if( Trie_Dump( bulk, Bench_Directory( names[j].key, dir, sizeof( dir ) ), TRIE_DUMP_VALUES, &dump ) == TRIE_OK ) {
+				Trie_FreeDump( dump );
+			}
+		}
+	}
+	dumpTime = Bench_Milliseconds( start );
+
+	// both tries must give the same answers
+	errors = 0;
+	for( j = 0; j < numNames; j++ ) {
+		if( Trie_Find( trie, names[j].key, TRIE_EXACT_MATCH, &data ) != TrieBaseline_Find( baseline, names[j].key, &baseData )
+			|| data != baseData ) {
+			errors++;
+		}
+		if( Trie_Find( bulk, names[j].key, TRIE_EXACT_MATCH, &data ) != TRIE_OK || data != baseData ) {
+			errors++;
+		}
+	}
+	for( j = 0; j < numNames; j += 16 ) {
+		Bench_Directory( names[j].key, dir, sizeof( dir ) );
+		Trie_Dump( bulk, dir, TRIE_DUMP_BOTH, &dump );
+		TrieBaseline_Dump( baseline, dir, TRIE_DUMP_BOTH, &baseDump );
+		if( dump->size != baseDump->size ) {
+			errors++;
+		} else {
+			for( i = 0; i < (int)dump->size; i++ ) {
+				if( dump->key_value_vector[i].value != baseDump->key_value_vector[i].value
+					|| strcmp( dump->key_value_vector[i].key, baseDump->key_value_vector[i].key ) ) {
+					errors++;
+					break;
+				}
+			}
+		}
+		Trie_FreeDump( dump );
+		TrieBaseline_FreeDump( baseDump );
+	}
+
+	printf( "%i names, %i iterations\n", numNames, iterations );
+	printf( "baseline insert: %.3f ms per pass, %u KiB\n", baseInsertTime / iterations, (unsigned)( memBaseline >> 10 ) );
+	printf( "baseline find:   %.3f usec per name\n", baseFindTime * 1000.0 / iterations / numNames );
+	printf( "baseline dump:   %.3f usec per directory\n", baseDumpTime * 1000.0 / numDumps );
+	printf( "insert: %.3f ms per pass, %u KiB\n", insertTime / iterations, (unsigned)( memInsert >> 10 ) );
+	printf( "bulk:   %.3f ms per pass, %u KiB\n", bulkTime / iterations, (unsigned)( memBulk >> 10 ) );
+	printf( "find:   %.3f usec per name\n", findTime * 1000.0 / iterations / numNames );
+	printf( "dump:   %.3f usec per directory\n", dumpTime * 1000.0 / numDumps );
+
+	TrieBaseline_Destroy( baseline );
+	Trie_Destroy( trie );
+	Trie_Destroy( bulk );
+	for( j = 0; j < numNames; j++ ) {
+		free( ( void * )names[j].key );
+	}
+	free( names );
+
+	if( errors ) {
+		printf( "%i mismatches against the baseline\n", errors );
+		return 1;
+	}
+	return 0;
+}
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <pthread.h>
 #include <sched.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 struct qthread_s {
 	pthread_t t;
@@ -120,6 +121,13 @@ void Sys_Thread_Yield( void ) {
 	sched_yield();
 }
 
+/*
+* Sys_Thread_NumCores
+*/
+int Sys_Thread_NumCores( void ) {
+	return sysconf( _SC_NPROCESSORS_ONLN );
+}
+
 /*
 * Sys_Atomic_Add
 */
@@ -134,6 +142,20 @@ bool Sys_Atomic_CAS( volatile int *value, int oldval, int newval ) {
 	return __sync_bool_compare_and_swap( value, oldval, newval );
 }
 
+/*
+* Sys_Atomic_LoadPtr
+*/
+void *Sys_Atomic_LoadPtr( void *volatile *ptr ) {
+	return __atomic_load_n( ptr, __ATOMIC_ACQUIRE );
+}
+
+/*
+* Sys_Atomic_StorePtr
+*/
+void Sys_Atomic_StorePtr( void *volatile *ptr, void *value ) {
+	__atomic_store_n( ptr, value, __ATOMIC_RELEASE );
+}
+
 /*
 * Sys_CondVar_Create
 */
@@ -184,6 +206,10 @@ bool Sys_CondVar_Wait( qcondvar_t *cond, qmutex_t *mutex, unsigned int timeout_m
 	ts.tv_nsec = tp.tv_usec * 1000;
 	ts.tv_sec += timeout_msec / 1000;
 	ts.tv_nsec += ( timeout_msec % 1000 ) * 1000000;
+	if( ts.tv_nsec >= 1000000000 ) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
 
 	return pthread_cond_timedwait( &cond->c, &mutex->m, &ts ) == 0;
 }
@@ -197,3 +223,13 @@ void Sys_CondVar_Wake( qcondvar_t *cond ) {
 	}
 	pthread_cond_signal( &cond->c );
 }
+
+/*
+* Sys_CondVar_WakeAll
+*/
+void Sys_CondVar_WakeAll( qcondvar_t *cond ) {
+	if( !cond ) {
+		return;
+	}
+	pthread_cond_broadcast( &cond->c );
+}
@@ -1,4 +1,5 @@
 #include <sys/time.h>
+#include <time.h>
 #include "../qcommon/qcommon.h"
 
 #if defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0 && defined(CLOCK_MONOTONIC)
@@ -42,3 +43,20 @@ uint64_t Sys_Microseconds( void ) {
 int64_t Sys_Milliseconds( void ) {
 	return Sys_Microseconds() / 1000;
 }
+
+/*
+* Sys_Nanoseconds
+*
+* Monotonic time with an arbitrary base, for measuring short intervals.
+*/
+uint64_t Sys_Nanoseconds( void ) {
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+	struct timeval tp;
+	gettimeofday( &tp, NULL );
+	return ( (uint64_t)tp.tv_sec * 1000000 + tp.tv_usec ) * 1000;
+#endif
+}
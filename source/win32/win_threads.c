@@ -36,6 +36,7 @@ struct qcondvar_s {
 
 static void( WINAPI * pInitializeConditionVariable )( PCONDITION_VARIABLE ConditionVariable );
 static void( WINAPI * pWakeConditionVariable )( PCONDITION_VARIABLE ConditionVariable );
+static void( WINAPI * pWakeAllConditionVariable )( PCONDITION_VARIABLE ConditionVariable );
 static BOOL( WINAPI * pSleepConditionVariableCS )( PCONDITION_VARIABLE ConditionVariable,
 												   PCRITICAL_SECTION CriticalSection, DWORD dwMilliseconds );
 
@@ -173,6 +174,16 @@ void Sys_Thread_Yield( void ) {
 	Sys_Sleep( 0 );
 }
 
+/*
+* Sys_Thread_NumCores
+*/
+int Sys_Thread_NumCores( void ) {
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+	return info.dwNumberOfProcessors;
+}
+
 /*
 * Sys_Atomic_Add
 */
@@ -187,6 +198,20 @@ bool Sys_Atomic_CAS( volatile int *value, int oldval, int newval ) {
 	return InterlockedCompareExchange( (volatile LONG*)value, newval, oldval ) == oldval;
 }
 
+/*
+* Sys_Atomic_LoadPtr
+*/
+void *Sys_Atomic_LoadPtr( void *volatile *ptr ) {
+	return InterlockedCompareExchangePointer( (volatile PVOID*)ptr, NULL, NULL );
+}
+
+/*
+* Sys_Atomic_StorePtr
+*/
+void Sys_Atomic_StorePtr( void *volatile *ptr, void *value ) {
+	InterlockedExchangePointer( (volatile PVOID*)ptr, value );
+}
+
 /*
 * Sys_CondVar_Create
 */
@@ -273,6 +298,24 @@ void Sys_CondVar_Wake( qcondvar_t *cond ) {
 	}
 }
 
+/*
+* Sys_CondVar_WakeAll
+*
+* The event fallback only releases a single waiter, the others
+* are expected to wait with a timeout.
+*/
+void Sys_CondVar_WakeAll( qcondvar_t *cond ) {
+	if( !cond ) {
+		return;
+	}
+
+	if( cond->e ) {
+		SetEvent( cond->e );
+	} else {
+		pWakeAllConditionVariable( &cond->c );
+	}
+}
+
 /*
 * Sys_InitThreads
 */
@@ -282,6 +325,7 @@ void Sys_InitThreads( void ) {
 	if( kernel32Dll ) {
 		pInitializeConditionVariable = ( void * )GetProcAddress( kernel32Dll, "InitializeConditionVariable" );
 		pWakeConditionVariable = ( void * )GetProcAddress( kernel32Dll, "WakeConditionVariable" );
+		pWakeAllConditionVariable = ( void * )GetProcAddress( kernel32Dll, "WakeAllConditionVariable" );
 		pSleepConditionVariableCS = ( void * )GetProcAddress( kernel32Dll, "SleepConditionVariableCS" );
 	}
 #endif
@@ -92,4 +92,21 @@ uint64_t Sys_Microseconds( void ) {
 	} else {
 		return (uint64_t)( Sys_Milliseconds_TGT() + milli_offset ) * 1000;
 	}
-}
\ No newline at end of file
+}
+
+/*
+* Sys_Nanoseconds
+*
+* Monotonic time with an arbitrary base, for measuring short intervals.
+*/
+uint64_t Sys_Nanoseconds( void ) {
+	int64_t p_now;
+
+	if( !hwtimer ) {
+		return (uint64_t)Sys_Milliseconds_TGT() * 1000000;
+	}
+
+	// split the conversion so that the multiplication can't overflow
+	QueryPerformanceCounter( (LARGE_INTEGER *) &p_now );
+	return (uint64_t)( p_now / hwtimer_freq ) * 1000000000 + (uint64_t)( p_now % hwtimer_freq ) * 1000000000 / hwtimer_freq;
+}